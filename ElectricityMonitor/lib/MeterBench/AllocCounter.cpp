@@ -0,0 +1,51 @@
+#include "AllocCounter.h"
+#include <new>
+#include <stdlib.h>
+
+static volatile uint32_t allocCount = 0;
+static volatile uint64_t allocBytes = 0;
+
+static void counted(size_t size) {
+    allocCount = allocCount + 1;
+    allocBytes = allocBytes + size;
+}
+
+AllocStats allocStats() {
+    AllocStats stats;
+    stats.count = allocCount;
+    stats.bytes = allocBytes;
+    return stats;
+}
+
+void *operator new(size_t size) {
+    counted(size);
+    void *ptr = malloc(size ? size : 1);
+    if (ptr == nullptr) {
+#if defined(__cpp_exceptions)
+        throw std::bad_alloc();
+#else
+        abort();
+#endif
+    }
+    return ptr;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    free(ptr);
+}
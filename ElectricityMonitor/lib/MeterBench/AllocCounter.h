@@ -0,0 +1,17 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Heap allocations since start, counted by replacing the global operator
+// new. Only C++ allocations are seen: what the C library allocates for
+// itself (fopen()'s buffer, say) is not.
+struct AllocStats {
+    uint32_t count;
+    uint64_t bytes;
+};
+
+AllocStats allocStats();
+
+#endif
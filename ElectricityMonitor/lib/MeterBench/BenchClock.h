@@ -0,0 +1,51 @@
+#ifndef BENCH_CLOCK_H
+#define BENCH_CLOCK_H
+
+#include <stdint.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Arduino.h>
+#include <esp_timer.h>
+#else
+#include <chrono>
+#endif
+
+// Wall time of a stretch of code, in nanoseconds. On the board short runs
+// are timed with the CPU cycle counter and long ones with esp_timer: the
+// 32-bit counter wraps after about 18 s at 240 MHz, esp_timer only has
+// microseconds.
+class BenchStopwatch {
+public:
+    void start() {
+#if defined(ARDUINO_ARCH_ESP32)
+        startUs = esp_timer_get_time();
+        startCycles = ESP.getCycleCount();
+#else
+        startTime = std::chrono::steady_clock::now();
+#endif
+    }
+
+    uint64_t elapsedNs() const {
+#if defined(ARDUINO_ARCH_ESP32)
+        uint32_t cycles = ESP.getCycleCount() - startCycles;
+        int64_t us = esp_timer_get_time() - startUs;
+        if (us < 10000000) {
+            return (uint64_t)cycles * 1000 / getCpuFrequencyMhz();
+        }
+        return (uint64_t)us * 1000;
+#else
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - startTime).count();
+#endif
+    }
+
+private:
+#if defined(ARDUINO_ARCH_ESP32)
+    int64_t startUs;
+    uint32_t startCycles;
+#else
+    std::chrono::steady_clock::time_point startTime;
+#endif
+};
+
+#endif
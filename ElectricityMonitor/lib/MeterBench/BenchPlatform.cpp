@@ -0,0 +1,63 @@
+#include "BenchPlatform.h"
+#include <string.h>
+#include <MonitorApp.h>
+
+// Plenty, so the relay stays on and every reading is billed
+static const double BENCH_REMAINING_UNITS = 1000;
+
+BenchPlatform::BenchPlatform(uint32_t startEpoch)
+    : app(nullptr),
+      clockMs(0),
+      startEpoch(startEpoch),
+      creditDue(false),
+      streamOpen(false),
+      streamEventDue(false),
+      updateDue(false),
+      updateUid(""),
+      bytesSent(0),
+      sent(0),
+      nvsWriteCount(0) {}
+
+void BenchPlatform::advance(uint32_t ms) {
+    clockMs += ms;
+    if (streamOpen) {
+        streamEventDue = true;
+    }
+}
+
+void BenchPlatform::deliver() {
+    if (app == nullptr) {
+        return;
+    }
+    if (creditDue) {
+        creditDue = false;
+        app->creditAnswered();
+        app->applyRemainingUnits(BENCH_REMAINING_UNITS, "bench");
+    }
+    if (streamEventDue) {
+        streamEventDue = false;
+        app->creditStreamEvent();
+    }
+    if (updateDue) {
+        updateDue = false;
+        app->updateAnswered(updateUid, true);
+    }
+}
+
+void BenchPlatform::requestCredit(const char *path) {
+    (void)path;
+    creditDue = true;
+}
+
+void BenchPlatform::openCreditStream(const char *path) {
+    (void)path;
+    streamOpen = true;
+    streamEventDue = true;
+}
+
+void BenchPlatform::sendUpdate(const char *path, const char *json, const char *uid) {
+    bytesSent += strlen(path) + strlen(json);
+    sent++;
+    updateUid = uid;
+    updateDue = true;
+}
@@ -0,0 +1,67 @@
+#ifndef BENCH_PLATFORM_H
+#define BENCH_PLATFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <MonitorPlatform.h>
+
+// The least MonitorPlatform that keeps MonitorApp on its online path, so a
+// benchmark times MonitorApp and not a fake network: always connected,
+// every request answered (successfully) on the next deliver(), NVS writes
+// counted and dropped. Nothing here allocates.
+class BenchPlatform : public MonitorPlatform {
+public:
+    explicit BenchPlatform(uint32_t startEpoch);
+
+    void attach(MonitorListener *target) { app = target; }
+
+    // Move the clock on; an open credit stream gets its keep-alive
+    void advance(uint32_t ms);
+
+    // Answer what the last pass sent, as FirebaseClient's loop would
+    void deliver();
+
+    // Path and JSON body of every update sent, the HTTP framing aside
+    uint64_t payloadBytes() const { return bytesSent; }
+    uint32_t updatesSent() const { return sent; }
+    uint32_t nvsWrites() const { return nvsWriteCount; }
+
+    uint32_t nowMs() override { return clockMs; }
+    uint32_t epoch() override { return startEpoch + clockMs / 1000; }
+
+    bool wifiConnected() override { return true; }
+    bool firebaseReady() override { return true; }
+    void reconnect() override {}
+    void restartFirebase() override {}
+
+    void requestCredit(const char *path) override;
+    void openCreditStream(const char *path) override;
+    void sendUpdate(const char *path, const char *json, const char *uid) override;
+
+    void setRelay(bool) override {}
+    void setStatusLed(bool) override {}
+
+    float loadFloat(const char *, float fallback) override { return fallback; }
+    void saveFloat(const char *, float) override { nvsWriteCount++; }
+    uint64_t loadU64(const char *, uint64_t fallback) override { return fallback; }
+    void saveU64(const char *, uint64_t) override { nvsWriteCount++; }
+    bool loadBytes(const char *, void *, size_t) override { return false; }
+    void saveBytes(const char *, const void *, size_t) override { nvsWriteCount++; }
+
+private:
+    MonitorListener *app;
+    uint32_t clockMs;
+    uint32_t startEpoch;
+
+    bool creditDue;
+    bool streamOpen;
+    bool streamEventDue;
+    bool updateDue;
+    const char *updateUid;     // a literal, as MonitorApp passes them
+
+    uint64_t bytesSent;
+    uint32_t sent;
+    uint32_t nvsWriteCount;
+};
+
+#endif
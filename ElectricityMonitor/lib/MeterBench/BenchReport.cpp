@@ -0,0 +1,8 @@
+#include "BenchReport.h"
+#include <stdio.h>
+
+void benchReport(const char *name, double value, const char *unit) {
+    printf("BENCH {\"firmware\":\"%s\",\"target\":\"%s\",\"name\":\"%s\",\"value\":%.3f,\"unit\":\"%s\"}\n",
+           BENCH_FIRMWARE, BENCH_TARGET, name, value, unit);
+    fflush(stdout);
+}
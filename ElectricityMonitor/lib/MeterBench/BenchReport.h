@@ -0,0 +1,26 @@
+#ifndef BENCH_REPORT_H
+#define BENCH_REPORT_H
+
+#include <stdint.h>
+
+// Build flags set FIRMWARE_REV to `git describe` (see platformio.ini)
+#define BENCH_STRINGIFY_(x) #x
+#define BENCH_STRINGIFY(x) BENCH_STRINGIFY_(x)
+#ifdef FIRMWARE_REV
+#define BENCH_FIRMWARE BENCH_STRINGIFY(FIRMWARE_REV)
+#else
+#define BENCH_FIRMWARE "unknown"
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32)
+#define BENCH_TARGET "esp32"
+#else
+#define BENCH_TARGET "native"
+#endif
+
+// One result per line, as JSON after a "BENCH " prefix, so a script can
+// grep them out of the test runner's output and track them across builds:
+//   BENCH {"firmware":"6ea9399","target":"native","name":"meter_engine","value":9.41,"unit":"ns/sample"}
+void benchReport(const char *name, double value, const char *unit);
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef BASE64_H
+#define BASE64_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Standard base64 with padding, for binary blobs that go up as RTDB
+// strings. Writes a terminated string into out and returns its length, or
+// 0 if out is too small (it needs 4 * ceil(n / 3) + 1 bytes).
+inline size_t base64Encode(const uint8_t *in, size_t n, char *out, size_t outSize) {
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t needed = (n + 2) / 3 * 4;
+    if (outSize < needed + 1) {
+        return 0;
+    }
+
+    size_t o = 0;
+    for (size_t i = 0; i < n; i += 3) {
+        uint32_t chunk = (uint32_t)in[i] << 16;
+        if (i + 1 < n) chunk |= (uint32_t)in[i + 1] << 8;
+        if (i + 2 < n) chunk |= in[i + 2];
+        out[o++] = alphabet[(chunk >> 18) & 0x3F];
+        out[o++] = alphabet[(chunk >> 12) & 0x3F];
+        out[o++] = i + 1 < n ? alphabet[(chunk >> 6) & 0x3F] : '=';
+        out[o++] = i + 2 < n ? alphabet[chunk & 0x3F] : '=';
+    }
+    out[o] = '\0';
+    return o;
+}
+
+// The reverse, for clients and tests. Returns the bytes decoded, or 0 if
+// text isn't padded base64 or out is too small.
+inline size_t base64Decode(const char *text, uint8_t *out, size_t outSize) {
+    size_t n = 0;
+    while (text[n] != '\0') n++;
+    if (n % 4 != 0) {
+        return 0;
+    }
+
+    size_t o = 0;
+    for (size_t i = 0; i < n; i += 4) {
+        uint32_t chunk = 0;
+        int padding = 0;
+        for (size_t k = 0; k < 4; k++) {
+            char c = text[i + k];
+            uint32_t value;
+            if (c >= 'A' && c <= 'Z') value = c - 'A';
+            else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+            else if (c >= '0' && c <= '9') value = c - '0' + 52;
+            else if (c == '+') value = 62;
+            else if (c == '/') value = 63;
+            else if (c == '=' && i + 4 == n && k >= 2) { value = 0; padding++; }
+            else return 0;
+            if (padding > 0 && c != '=') return 0;   // data after the padding
+            chunk = chunk << 6 | value;
+        }
+        size_t bytes = 3 - padding;
+        if (o + bytes > outSize) {
+            return 0;
+        }
+        out[o++] = (uint8_t)(chunk >> 16);
+        if (bytes > 1) out[o++] = (uint8_t)(chunk >> 8);
+        if (bytes > 2) out[o++] = (uint8_t)chunk;
+    }
+    return o;
+}
+
+#endif
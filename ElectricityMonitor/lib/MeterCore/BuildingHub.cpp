@@ -0,0 +1,318 @@
+#include "BuildingHub.h"
+#include <stdio.h>
+#include <string.h>
+#include "EventLog.h"
+#include "TelemetryPaths.h"
+
+static const char *MERGED_UID = "buildingUpdate";
+
+BuildingHub::BuildingHub(MonitorPlatform &board)
+    : board(board),
+      tenantCount(0),
+      creditAnswering(NO_TENANT),
+      mergedLength(0),
+      updateInFlight(false),
+      updateSentAt(0),
+      sent(0),
+      merged(0) {
+    updatePath[0] = '\0';
+    for (uint8_t c = 0; c < MAX_METER_CHANNELS; c++) {
+        ports[c].bind(this, c);
+        listeners[c] = nullptr;
+        segments[c].uid = nullptr;
+        inFlightUids[c] = nullptr;
+    }
+    for (uint8_t kind = 0; kind < REQUEST_KINDS; kind++) {
+        RequestQueue &queue = requests[kind];
+        for (uint8_t c = 0; c < MAX_METER_CHANNELS; c++) {
+            queue.wanted[c] = false;
+            queue.path[c][0] = '\0';
+        }
+        queue.inFlight = NO_TENANT;
+        queue.lastServed = 0;
+        queue.sentAt = 0;
+    }
+}
+
+void BuildingHub::configure(const BuildingHubConfig &config, uint8_t tenants) {
+    cfg = config;
+    tenantCount = tenants > MAX_METER_CHANNELS ? MAX_METER_CHANNELS : tenants;
+    buildingPath(cfg.buildingId, updatePath, sizeof(updatePath));
+}
+
+void BuildingHub::attach(uint8_t channel, MonitorListener *tenant) {
+    if (channel < MAX_METER_CHANNELS) {
+        listeners[channel] = tenant;
+    }
+}
+
+void BuildingHub::pass() {
+    uint32_t now = board.nowMs();
+    // A credit error answers without a value; nothing more is coming for it
+    creditAnswering = NO_TENANT;
+
+    for (uint8_t kind = 0; kind < REQUEST_KINDS; kind++) {
+        RequestQueue &queue = requests[kind];
+        if (queue.inFlight != NO_TENANT && now - queue.sentAt >= cfg.requestTimeoutMs) {
+            LOG_WARN("No answer to channel %u's %s read - moving on", (unsigned)queue.inFlight,
+                     kind == REQUEST_CREDIT ? "credit" : "calibration");
+            queue.inFlight = NO_TENANT;
+        }
+        if (queue.inFlight == NO_TENANT) {
+            sendNextRequest((RequestKind)kind);
+        }
+    }
+
+    // The tenants time out their own part and send it again
+    if (updateInFlight && now - updateSentAt >= cfg.updateAckTimeoutMs) {
+        LOG_WARN("No answer to the building update");
+        updateInFlight = false;
+    }
+    if (!updateInFlight && mergedLength > 0) {
+        flushUpdate();
+    }
+}
+
+void BuildingHub::queueRequest(RequestKind kind, uint8_t channel, const char *path) {
+    RequestQueue &queue = requests[kind];
+    size_t n = strlen(path);
+    if (n >= REQUEST_PATH_CHARS) {
+        LOG_ERROR("Channel %u's request path is too long", (unsigned)channel);
+        return;
+    }
+    memcpy(queue.path[channel], path, n + 1);
+    queue.wanted[channel] = true;
+}
+
+// Round-robin from the channel after the last one served, so a tenant that
+// asks every pass can't starve the others
+void BuildingHub::sendNextRequest(RequestKind kind) {
+    RequestQueue &queue = requests[kind];
+    for (uint8_t step = 1; step <= tenantCount; step++) {
+        uint8_t c = (uint8_t)((queue.lastServed + step) % tenantCount);
+        if (!queue.wanted[c]) {
+            continue;
+        }
+        queue.wanted[c] = false;
+        queue.inFlight = c;
+        queue.lastServed = c;
+        queue.sentAt = board.nowMs();
+        if (kind == REQUEST_CREDIT) {
+            board.requestCredit(queue.path[c]);
+        } else {
+            board.requestCalibration(queue.path[c]);
+        }
+        return;
+    }
+}
+
+// The tenant's fields are appended as ",<fields>"; a tenant that sends again
+// before the last one went out (its own ack timeout) replaces it
+void BuildingHub::tenantUpdate(uint8_t channel, const char *json, const char *uid) {
+    size_t length = strlen(json);
+    if (length < 2 || json[0] != '{' || json[length - 1] != '}') {
+        LOG_ERROR("Channel %u sent an update that isn't a JSON object", (unsigned)channel);
+        return;
+    }
+    dropSegment(channel);
+    size_t fields = length - 2;
+    if (fields == 0) {
+        return;
+    }
+    if (mergedLength + 1 + fields > MERGED_CAPACITY) {
+        LOG_ERROR("Building update full - channel %u's update dropped", (unsigned)channel);
+        return;
+    }
+
+    Segment &segment = segments[channel];
+    segment.uid = uid;
+    segment.offset = mergedLength;
+    segment.length = 1 + fields;
+    mergedJson[mergedLength] = ',';
+    memcpy(mergedJson + mergedLength + 1, json + 1, fields);
+    mergedLength += segment.length;
+}
+
+void BuildingHub::dropSegment(uint8_t channel) {
+    Segment &segment = segments[channel];
+    if (segment.uid == nullptr) {
+        return;
+    }
+    size_t end = segment.offset + segment.length;
+    memmove(mergedJson + segment.offset, mergedJson + end, mergedLength - end);
+    mergedLength -= segment.length;
+    for (uint8_t c = 0; c < MAX_METER_CHANNELS; c++) {
+        if (segments[c].uid != nullptr && segments[c].offset > segment.offset) {
+            segments[c].offset -= segment.length;
+        }
+    }
+    segment.uid = nullptr;
+}
+
+// The first segment's leading comma becomes the opening brace
+void BuildingHub::flushUpdate() {
+    if (!board.wifiConnected() || !board.firebaseReady()) {
+        return;
+    }
+    mergedJson[0] = '{';
+    mergedJson[mergedLength] = '}';
+    mergedJson[mergedLength + 1] = '\0';
+
+    uint8_t carried = 0;
+    for (uint8_t c = 0; c < MAX_METER_CHANNELS; c++) {
+        inFlightUids[c] = segments[c].uid;
+        if (segments[c].uid != nullptr) carried++;
+        segments[c].uid = nullptr;
+    }
+    updateInFlight = true;
+    updateSentAt = board.nowMs();
+    sent++;
+    merged += carried;
+
+    LOG_DEBUG("Building update: %u unit(s), %u bytes", (unsigned)carried, (unsigned)(mergedLength + 1));
+    // The board copies the JSON before it returns
+    mergedLength = 0;
+    board.sendUpdate(updatePath, mergedJson, MERGED_UID);
+}
+
+void BuildingHub::restartFirebase() {
+    board.restartFirebase();
+    // Whatever was in flight is gone; the tenants time out their part
+    updateInFlight = false;
+    for (uint8_t kind = 0; kind < REQUEST_KINDS; kind++) {
+        requests[kind].inFlight = NO_TENANT;
+    }
+}
+
+void BuildingHub::creditAnswered() {
+    RequestQueue &queue = requests[REQUEST_CREDIT];
+    creditAnswering = queue.inFlight;
+    queue.inFlight = NO_TENANT;
+    if (creditAnswering != NO_TENANT && listeners[creditAnswering] != nullptr) {
+        listeners[creditAnswering]->creditAnswered();
+    }
+}
+
+// A get's value goes to whoever asked; otherwise it is the stream's, which
+// only a single tenant has
+void BuildingHub::applyRemainingUnits(double units, const char *source) {
+    uint8_t target = creditAnswering;
+    creditAnswering = NO_TENANT;
+    if (target == NO_TENANT && tenantCount == 1) {
+        target = 0;
+    }
+    if (target != NO_TENANT && listeners[target] != nullptr) {
+        listeners[target]->applyRemainingUnits(units, source);
+    }
+}
+
+void BuildingHub::creditStreamEvent() {
+    if (tenantCount == 1 && listeners[0] != nullptr) {
+        listeners[0]->creditStreamEvent();
+    }
+}
+
+void BuildingHub::creditStreamClosed() {
+    if (tenantCount == 1 && listeners[0] != nullptr) {
+        listeners[0]->creditStreamClosed();
+    }
+}
+
+void BuildingHub::updateAnswered(const char *uid, bool ok, int errorCode) {
+    if (!updateInFlight || strcmp(uid, MERGED_UID) != 0) {
+        return;
+    }
+    updateInFlight = false;
+    const char *carried[MAX_METER_CHANNELS];
+    memcpy(carried, inFlightUids, sizeof(carried));
+    for (uint8_t c = 0; c < MAX_METER_CHANNELS; c++) {
+        inFlightUids[c] = nullptr;
+    }
+    for (uint8_t c = 0; c < MAX_METER_CHANNELS; c++) {
+        if (carried[c] != nullptr && listeners[c] != nullptr) {
+            listeners[c]->updateAnswered(carried[c], ok, errorCode);
+        }
+    }
+}
+
+void BuildingHub::calibrationAnswered(const char *text) {
+    RequestQueue &queue = requests[REQUEST_CALIBRATION];
+    uint8_t target = queue.inFlight;
+    queue.inFlight = NO_TENANT;
+    if (target != NO_TENANT && listeners[target] != nullptr) {
+        listeners[target]->calibrationAnswered(text);
+    }
+}
+
+// Every tenant's scheduler notices the link is down; one reconnect will do
+void BuildingHub::TenantPort::reconnect() {
+    if (channel == 0) {
+        hub->board.reconnect();
+    }
+}
+
+// A failed building update reaches every tenant it carried, and each counts
+// it; channel 0's count alone decides when to restart
+void BuildingHub::TenantPort::restartFirebase() {
+    if (channel == 0) {
+        hub->restartFirebase();
+    }
+}
+
+void BuildingHub::TenantPort::openCreditStream(const char *path) {
+    if (hub->tenantCount == 1) {
+        hub->board.openCreditStream(path);
+    }
+}
+
+// The path is the building's for every tenant (publishUnderBuilding)
+void BuildingHub::TenantPort::sendUpdate(const char *path, const char *json, const char *uid) {
+    (void)path;
+    hub->tenantUpdate(channel, json, uid);
+}
+
+void BuildingHub::TenantPort::setStatusLed(bool on) {
+    if (channel == 0) {
+        hub->board.setStatusLed(on);
+    }
+}
+
+// "ldgCreditMws" for channel 0, "2ldgCreditMws" for channel 2: NVS keys
+// are 15 characters at most and ours are 13
+const char *BuildingHub::TenantPort::nvsKey(const char *key, char *out, size_t size) {
+    if (channel == 0) {
+        return key;
+    }
+    snprintf(out, size, "%u%s", (unsigned)channel, key);
+    return out;
+}
+
+float BuildingHub::TenantPort::loadFloat(const char *key, float fallback) {
+    char prefixed[16];
+    return hub->board.loadFloat(nvsKey(key, prefixed, sizeof(prefixed)), fallback);
+}
+
+void BuildingHub::TenantPort::saveFloat(const char *key, float value) {
+    char prefixed[16];
+    hub->board.saveFloat(nvsKey(key, prefixed, sizeof(prefixed)), value);
+}
+
+uint64_t BuildingHub::TenantPort::loadU64(const char *key, uint64_t fallback) {
+    char prefixed[16];
+    return hub->board.loadU64(nvsKey(key, prefixed, sizeof(prefixed)), fallback);
+}
+
+void BuildingHub::TenantPort::saveU64(const char *key, uint64_t value) {
+    char prefixed[16];
+    hub->board.saveU64(nvsKey(key, prefixed, sizeof(prefixed)), value);
+}
+
+bool BuildingHub::TenantPort::loadBytes(const char *key, void *out, size_t size) {
+    char prefixed[16];
+    return hub->board.loadBytes(nvsKey(key, prefixed, sizeof(prefixed)), out, size);
+}
+
+void BuildingHub::TenantPort::saveBytes(const char *key, const void *data, size_t size) {
+    char prefixed[16];
+    hub->board.saveBytes(nvsKey(key, prefixed, sizeof(prefixed)), data, size);
+}
@@ -0,0 +1,158 @@
+#ifndef BUILDING_HUB_H
+#define BUILDING_HUB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "MonitorPlatform.h"
+#include "SampleSource.h"
+#include "UpdateBatch.h"
+
+struct BuildingHubConfig {
+    const char *buildingId = "building_002";
+    uint32_t updateAckTimeoutMs = 30000;
+    // Credit and calibration gets; the tenant's own scheduler gives up sooner
+    uint32_t requestTimeoutMs = 5000;
+};
+
+// One board, one WiFi association and one TLS session shared by the units
+// of a building. Each unit keeps its own MonitorApp (credit, hourly buffer,
+// rollups, telemetry log), built on port(channel) instead of the board's
+// platform; the hub sits between the MonitorApps and the board:
+//
+// - Updates: each tenant publishes under the building (MonitorConfig::
+//   publishUnderBuilding), and the hub merges whatever the tenants sent
+//   since the last one into a single multi-location update to
+//   /buildings/<building>/. One is in flight at a time; its answer goes back
+//   to every tenant it carried, under the tenant's own uid.
+// - Credit and calibration gets are sent one at a time, round-robin, and
+//   each answer goes to the tenant that asked.
+// - The credit stream needs a connection per path, so with more than one
+//   tenant there is none and credit is polled. A single tenant keeps it.
+// - The status LED, WiFi reconnects and Firebase restarts are channel 0's
+//   (a failed building update is every tenant's error, but one restart
+//   does for all); each tenant's relay is its channel's; NVS keys of
+//   channels above 0 get the channel digit in front, so channel 0 keeps a
+//   single-unit board's keys.
+//
+// Single-threaded like MonitorApp: run every tenant's pass(), then the hub's.
+class BuildingHub : public MonitorListener {
+public:
+    static const uint8_t NO_TENANT = 0xFF;
+    static const size_t MERGED_CAPACITY = MAX_METER_CHANNELS * UpdateBatch::CAPACITY;
+    static const size_t REQUEST_PATH_CHARS = 96;
+
+    explicit BuildingHub(MonitorPlatform &board);
+
+    void configure(const BuildingHubConfig &config, uint8_t tenants);
+    uint8_t tenants() const { return tenantCount; }
+
+    // The platform tenant channel's MonitorApp runs on, and where its answers go
+    MonitorPlatform &port(uint8_t channel) { return ports[channel < MAX_METER_CHANNELS ? channel : 0]; }
+    void attach(uint8_t channel, MonitorListener *tenant);
+
+    // Send the merged update and the next queued get, and give up on ones
+    // unanswered for too long
+    void pass();
+
+    // Firebase answers, from the board's callbacks
+    void creditAnswered() override;
+    void applyRemainingUnits(double units, const char *source) override;
+    void creditStreamEvent() override;
+    void creditStreamClosed() override;
+    void updateAnswered(const char *uid, bool ok, int errorCode = 0) override;
+    void calibrationAnswered(const char *text) override;
+
+    bool updatePending() const { return updateInFlight; }
+    uint32_t updatesSent() const { return sent; }
+    uint32_t tenantUpdatesMerged() const { return merged; }
+
+private:
+    // MonitorPlatform for one tenant, forwarding to the hub and the board
+    class TenantPort : public MonitorPlatform {
+    public:
+        TenantPort() : hub(nullptr), channel(0) {}
+        void bind(BuildingHub *owner, uint8_t index) { hub = owner; channel = index; }
+
+        uint32_t nowMs() override { return hub->board.nowMs(); }
+        uint32_t epoch() override { return hub->board.epoch(); }
+        uint32_t nowUs() override { return hub->board.nowUs(); }
+        uint32_t heapFree() override { return hub->board.heapFree(); }
+        uint32_t heapLowWater() override { return hub->board.heapLowWater(); }
+
+        bool wifiConnected() override { return hub->board.wifiConnected(); }
+        bool firebaseReady() override { return hub->board.firebaseReady(); }
+        uint32_t localIp() override { return hub->board.localIp(); }
+        void reconnect() override;
+        void restartFirebase() override;
+
+        void requestCredit(const char *path) override { hub->queueRequest(REQUEST_CREDIT, channel, path); }
+        void openCreditStream(const char *path) override;
+        void requestCalibration(const char *path) override { hub->queueRequest(REQUEST_CALIBRATION, channel, path); }
+        void sendUpdate(const char *path, const char *json, const char *uid) override;
+
+        void setRelay(bool on) override { hub->board.setChannelRelay(channel, on); }
+        void setStatusLed(bool on) override;
+
+        float loadFloat(const char *key, float fallback) override;
+        void saveFloat(const char *key, float value) override;
+        uint64_t loadU64(const char *key, uint64_t fallback) override;
+        void saveU64(const char *key, uint64_t value) override;
+        bool loadBytes(const char *key, void *out, size_t size) override;
+        void saveBytes(const char *key, const void *data, size_t size) override;
+
+    private:
+        const char *nvsKey(const char *key, char *out, size_t size);
+
+        BuildingHub *hub;
+        uint8_t channel;
+    };
+
+    enum RequestKind { REQUEST_CREDIT, REQUEST_CALIBRATION, REQUEST_KINDS };
+
+    // One kind of get: which tenants want one, and whose is in flight
+    struct RequestQueue {
+        bool wanted[MAX_METER_CHANNELS];
+        char path[MAX_METER_CHANNELS][REQUEST_PATH_CHARS];
+        uint8_t inFlight;
+        uint8_t lastServed;
+        uint32_t sentAt;
+    };
+
+    // A tenant's update waiting in mergedJson, as ",<fields>"
+    struct Segment {
+        const char *uid;       // nullptr when the tenant has none waiting
+        size_t offset;
+        size_t length;
+    };
+
+    void queueRequest(RequestKind kind, uint8_t channel, const char *path);
+    void sendNextRequest(RequestKind kind);
+    void tenantUpdate(uint8_t channel, const char *json, const char *uid);
+    void dropSegment(uint8_t channel);
+    void flushUpdate();
+    void restartFirebase();
+
+    MonitorPlatform &board;
+    BuildingHubConfig cfg;
+    uint8_t tenantCount;
+    char updatePath[64];
+    TenantPort ports[MAX_METER_CHANNELS];
+    MonitorListener *listeners[MAX_METER_CHANNELS];
+
+    RequestQueue requests[REQUEST_KINDS];
+    uint8_t creditAnswering;       // whose remaining_units the board is about to deliver
+
+    // Tenants' updates merged as they arrive; one extra byte for the closing brace
+    char mergedJson[MERGED_CAPACITY + 2];
+    size_t mergedLength;
+    Segment segments[MAX_METER_CHANNELS];
+
+    bool updateInFlight;
+    const char *inFlightUids[MAX_METER_CHANNELS];   // nullptr if not carried
+    uint32_t updateSentAt;
+
+    uint32_t sent;
+    uint32_t merged;
+};
+
+#endif
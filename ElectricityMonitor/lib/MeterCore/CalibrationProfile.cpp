@@ -0,0 +1,157 @@
+#include "CalibrationProfile.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+bool CalibrationTable::add(float input, float gain, float offset) {
+    if (count >= MAX_POINTS || !(input >= 0) || !(gain > 0) || !isfinite(input) ||
+        !isfinite(gain) || !isfinite(offset)) {
+        return false;
+    }
+    uint8_t at = count;
+    while (at > 0 && points[at - 1].input > input) {
+        at--;
+    }
+    if (at > 0 && points[at - 1].input == input) {
+        return false;
+    }
+    for (uint8_t k = count; k > at; k--) {
+        points[k] = points[k - 1];
+    }
+    points[at].input = input;
+    points[at].gain = gain;
+    points[at].offset = offset;
+    count++;
+    return true;
+}
+
+float CalibrationTable::scale(float rms) const {
+    if (count == 0) {
+        return 1.0f;
+    }
+    uint8_t k = 0;
+    for (uint8_t j = 1; j < count; j++) {
+        k += rms >= points[j].input;
+    }
+
+    const CalibrationPoint &a = points[k];
+    const CalibrationPoint &b = points[k + 1 < count ? k + 1 : k];
+    float span = b.input - a.input;
+    float t = span > 0 ? (rms - a.input) / span : 0;
+    t = t < 0 ? 0 : (t > 1 ? 1 : t);
+    float gain = a.gain + t * (b.gain - a.gain);
+    float offset = a.offset + t * (b.offset - a.offset);
+
+    if (!(rms > 0)) {
+        return gain;
+    }
+    float calibrated = gain * rms + offset;
+    return calibrated > 0 ? calibrated / rms : 0;
+}
+
+bool CalibrationTable::operator==(const CalibrationTable &other) const {
+    if (count != other.count) {
+        return false;
+    }
+    for (uint8_t k = 0; k < count; k++) {
+        if (points[k].input != other.points[k].input || points[k].gain != other.points[k].gain ||
+            points[k].offset != other.points[k].offset) {
+            return false;
+        }
+    }
+    return true;
+}
+
+CalibrationProfile CalibrationProfile::flat(float voltageGain, float currentGain) {
+    CalibrationProfile profile;
+    profile.voltage.add(0, voltageGain);
+    profile.current.add(0, currentGain);
+    return profile;
+}
+
+bool CalibrationProfile::operator==(const CalibrationProfile &other) const {
+    return version == other.version && voltage == other.voltage && current == other.current;
+}
+
+static const char *skipSpaces(const char *p) {
+    while (*p == ' ' || *p == '\t') p++;
+    return p;
+}
+
+bool parseCalibrationProfile(const char *text, CalibrationProfile &out) {
+    CalibrationProfile profile;
+    const char *p = text;
+    int points = 0;
+
+    while (true) {
+        p = skipSpaces(p);
+        if (*p == '\0') {
+            break;
+        }
+        if (*p == ';') {
+            p++;
+            continue;
+        }
+
+        CalibrationTable *table;
+        if (*p == 'v' || *p == 'V') {
+            table = &profile.voltage;
+        } else if (*p == 'i' || *p == 'I') {
+            table = &profile.current;
+        } else {
+            return false;
+        }
+        p++;
+
+        float values[3] = { 0, 0, 0 };
+        int found = 0;
+        while (found < 3) {
+            p = skipSpaces(p);
+            char *end;
+            double value = strtod(p, &end);
+            if (end == p) {
+                break;
+            }
+            values[found++] = (float)value;
+            p = end;
+        }
+        p = skipSpaces(p);
+        if (found < 2 || (*p != ';' && *p != '\0') || !table->add(values[0], values[1], values[2])) {
+            return false;
+        }
+        points++;
+    }
+
+    if (points == 0) {
+        return false;
+    }
+    out = profile;
+    return true;
+}
+
+static size_t formatTable(char channel, const CalibrationTable &table, char *out, size_t size, size_t used) {
+    for (uint8_t k = 0; k < table.count && used < size; k++) {
+        const CalibrationPoint &point = table.points[k];
+        int n = snprintf(out + used, size - used, "%s%c %.7g %.7g %.7g", used > 0 ? "; " : "",
+                         channel, point.input, point.gain, point.offset);
+        if (n < 0 || (size_t)n >= size - used) {
+            return size;
+        }
+        used += n;
+    }
+    return used;
+}
+
+size_t formatCalibrationProfile(const CalibrationProfile &profile, char *out, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    out[0] = '\0';
+    size_t used = formatTable('v', profile.voltage, out, size, 0);
+    used = formatTable('i', profile.current, out, size, used);
+    if (used >= size) {
+        out[0] = '\0';
+        return 0;
+    }
+    return used;
+}
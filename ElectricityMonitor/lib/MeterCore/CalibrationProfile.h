@@ -0,0 +1,74 @@
+#ifndef CALIBRATION_PROFILE_H
+#define CALIBRATION_PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "SampleRing.h"
+
+// At this uncalibrated RMS reading the true value is gain * reading + offset
+struct CalibrationPoint {
+    float input;
+    float gain;
+    float offset;
+};
+
+// Piecewise-linear calibration of one channel. Gain and offset are
+// interpolated between points by the uncalibrated RMS and held flat past
+// the first and last point, so a single point is a plain factor. The
+// ACS712 reads a few percent differently at a phone charger than at a
+// kettle; a point per current range takes that out.
+struct CalibrationTable {
+    static const uint8_t MAX_POINTS = 6;
+
+    uint8_t count;
+    CalibrationPoint points[MAX_POINTS];   // by rising input
+
+    CalibrationTable() : count(0) {}
+
+    // Keeps the points in order; false if full, out of range or a repeat input
+    bool add(float input, float gain, float offset = 0);
+
+    // Calibrated / uncalibrated RMS at rms, the factor the channel's sums are
+    // scaled by. 1 for an empty table. The segment is found by counting the
+    // points below rms, with no early exit, so a lookup costs the same
+    // whatever the load.
+    float scale(float rms) const;
+
+    bool operator==(const CalibrationTable &other) const;
+};
+
+// Both channels' tables, in the units the uncalibrated readings come in:
+// volts at the ADC pin for voltage, amps at the sensor's nominal 66 mV/A for
+// current. Kept in NVS under "calProfile"; an empty table leaves its
+// channel as the MeterConfig scale has it.
+struct CalibrationProfile {
+    static const uint8_t VERSION = 1;
+
+    uint8_t version;
+    CalibrationTable voltage;
+    CalibrationTable current;
+
+    CalibrationProfile() : version(VERSION) {}
+
+    // One factor per channel, as the calibration used to be compiled in
+    static CalibrationProfile flat(float voltageGain, float currentGain);
+
+    bool operator==(const CalibrationProfile &other) const;
+    bool operator!=(const CalibrationProfile &other) const { return !(*this == other); }
+};
+
+// The profile as text, for the serial console and the RTDB:
+//   "v 0.8554 268.85 0; i 0.12 0.6767 0; i 0.95 0.7012 -0.02"
+// One "<channel> <input> <gain> [offset]" point per ';'. Parsing fails on
+// anything malformed, leaving out untouched.
+bool parseCalibrationProfile(const char *text, CalibrationProfile &out);
+size_t formatCalibrationProfile(const CalibrationProfile &profile, char *out, size_t size);
+
+// Longest text formatCalibrationProfile() writes, terminator included
+const size_t CALIBRATION_TEXT_CHARS = 2 * CalibrationTable::MAX_POINTS * 48;
+
+// A new profile, from the network task to the metering task that owns the
+// engine (see takeCalibration() in MeterEngine.h)
+typedef SampleRing<CalibrationProfile, 2> CalibrationMailbox;
+
+#endif
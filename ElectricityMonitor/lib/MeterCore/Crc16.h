@@ -0,0 +1,20 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF). Bitwise rather than
+// table-driven: records are a few dozen bytes and written once a minute,
+// so 512 bytes of table buy nothing here.
+inline uint16_t crc16Ccitt(const uint8_t *data, size_t length, uint16_t crc = 0xFFFF) {
+    for (size_t k = 0; k < length; k++) {
+        crc ^= (uint16_t)data[k] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+#endif
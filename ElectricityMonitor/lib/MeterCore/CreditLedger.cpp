@@ -0,0 +1,33 @@
+#include "CreditLedger.h"
+
+void CreditLedger::restore(const LedgerState &saved) {
+    counters = saved;
+    // A corrupt save must not leave more billed than was ever consumed
+    if (counters.billedMws > counters.consumedMws) {
+        counters.billedMws = counters.consumedMws;
+    }
+}
+
+void CreditLedger::consume(uint64_t mws) {
+    counters.consumedMws += mws;
+}
+
+int64_t CreditLedger::balanceMws() const {
+    return (int64_t)counters.creditedMws - (int64_t)counters.consumedMws;
+}
+
+void CreditLedger::billed(uint64_t mws) {
+    uint64_t unbilled = unbilledMws();
+    counters.billedMws += mws < unbilled ? mws : unbilled;
+}
+
+int64_t CreditLedger::reconcile(int64_t serverRemainingMws) {
+    // What the server has credited, as far as we can tell from its side
+    int64_t credited = serverRemainingMws + (int64_t)counters.billedMws;
+    if (credited < 0) {
+        credited = 0;
+    }
+    int64_t delta = credited - (int64_t)counters.creditedMws;
+    counters.creditedMws = (uint64_t)credited;
+    return delta;
+}
@@ -0,0 +1,54 @@
+#ifndef CREDIT_LEDGER_H
+#define CREDIT_LEDGER_H
+
+#include <stdint.h>
+#include "EnergyCounter.h"
+
+// Counters persisted to NVS. consumedMws and billedMws only ever grow;
+// creditedMws follows the server, so reconcile() lowers it on a correction.
+struct LedgerState {
+    uint64_t creditedMws = 0;   // all credit ever bought, milli-watt-seconds
+    uint64_t consumedMws = 0;   // energy drawn on credit
+    uint64_t billedMws = 0;     // the part of consumedMws Firebase has acknowledged
+};
+
+// Prepaid credit kept on the device, so the relay is cut locally the moment
+// the balance (credited - consumed) reaches zero, online or not.
+//
+// Firebase keeps remaining_units, which the dashboard tops up. The device
+// never overwrites it: drawn energy goes up as a server-side increment of
+// unbilledMws(), and a top-up is picked up by delta when a new
+// remaining_units arrives (reconcile()). Both writers only add to the value,
+// so neither can undo the other.
+//
+// Pure logic; the sketch does the persisting.
+class CreditLedger {
+public:
+    void restore(const LedgerState &saved);
+    const LedgerState &state() const { return counters; }
+
+    // Energy drawn while the relay was on
+    void consume(uint64_t mws);
+
+    int64_t balanceMws() const;
+    bool hasCredit() const { return balanceMws() > 0; }
+
+    // Consumption not yet deducted from remaining_units on the server
+    uint64_t unbilledMws() const { return counters.consumedMws - counters.billedMws; }
+
+    // The server acknowledged a deduction of this much
+    void billed(uint64_t mws);
+
+    // remaining_units as the server reports it, i.e. with everything billed
+    // so far already deducted. Anything else that changed it is a top-up (or
+    // a correction, if negative); returns that change.
+    int64_t reconcile(int64_t serverRemainingMws);
+
+    static int64_t toMws(double kwh) { return kwhToMws(kwh); }
+    static double toKwh(int64_t mws) { return mwsToKwh(mws); }
+
+private:
+    LedgerState counters;
+};
+
+#endif
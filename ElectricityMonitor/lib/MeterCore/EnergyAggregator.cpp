@@ -0,0 +1,121 @@
+#include "EnergyAggregator.h"
+#include <time.h>
+
+void AggregateBucket::add(const MeterReading &reading, uint8_t readingFlags) {
+    samples++;
+    energyMws += reading.energyMws;
+    powerSec += reading.realPower * reading.durationSec;
+    apparentSec += reading.apparentPower * reading.durationSec;
+    currentSec += reading.currentRms * reading.durationSec;
+    voltageSec += reading.voltageRms * reading.durationSec;
+    seconds += reading.durationSec;
+    if (reading.realPower > peakPower) {
+        peakPower = reading.realPower;
+    }
+    flags |= readingFlags;
+}
+
+void AggregateBucket::merge(const AggregateBucket &other) {
+    samples += other.samples;
+    energyMws += other.energyMws;
+    powerSec += other.powerSec;
+    apparentSec += other.apparentSec;
+    currentSec += other.currentSec;
+    voltageSec += other.voltageSec;
+    seconds += other.seconds;
+    if (other.peakPower > peakPower) {
+        peakPower = other.peakPower;
+    }
+    flags |= other.flags;
+}
+
+// Minute, quarter and hour boundaries from the local time of t, so zones
+// with half-hour offsets land right. A day's end comes from mktime(), as
+// days around a DST change aren't 86400 s.
+void EnergyAggregator::bounds(AggregateLevel level, uint32_t t, uint32_t *start, uint32_t *end) {
+    time_t seconds = t;
+    struct tm timeinfo;
+    localtime_r(&seconds, &timeinfo);
+    switch (level) {
+    case AGG_MINUTE:
+        *start = t - timeinfo.tm_sec;
+        *end = *start + 60;
+        break;
+    case AGG_QUARTER:
+        *start = t - (timeinfo.tm_min % 15) * 60 - timeinfo.tm_sec;
+        *end = *start + 900;
+        break;
+    case AGG_HOUR:
+        *start = t - timeinfo.tm_min * 60 - timeinfo.tm_sec;
+        *end = *start + 3600;
+        break;
+    default: {
+        timeinfo.tm_hour = 0;
+        timeinfo.tm_min = 0;
+        timeinfo.tm_sec = 0;
+        timeinfo.tm_isdst = -1;
+        *start = (uint32_t)mktime(&timeinfo);
+        timeinfo.tm_mday++;
+        timeinfo.tm_isdst = -1;
+        *end = (uint32_t)mktime(&timeinfo);
+        break;
+    }
+    }
+}
+
+void EnergyAggregator::reset() {
+    for (uint8_t level = 0; level < AGG_LEVELS; level++) {
+        open[level] = AggregateBucket();
+    }
+    unclocked = AggregateBucket();
+}
+
+void EnergyAggregator::add(uint32_t epoch, const MeterReading &reading, uint8_t flags) {
+    if (epoch == 0) {
+        unclocked.add(reading, flags);
+        return;
+    }
+    uint32_t half = (uint32_t)(reading.durationSec / 2);
+    uint32_t t = epoch > half ? epoch - half : epoch;
+
+    for (uint8_t level = 0; level < AGG_LEVELS; level++) {
+        AggregateBucket &bucket = open[level];
+        if (bucket.start != 0 && (t < bucket.start || t >= bucket.end)) {
+            closeThrough((AggregateLevel)level, t);
+        }
+        if (bucket.start == 0) {
+            bounds((AggregateLevel)level, t, &bucket.start, &bucket.end);
+            bucket.merge(unclocked);
+        }
+        bucket.add(reading, flags);
+    }
+    unclocked = AggregateBucket();
+}
+
+// Close the open bucket, then every empty one between it and t's
+void EnergyAggregator::closeThrough(AggregateLevel level, uint32_t t) {
+    AggregateBucket closed = open[level];
+    open[level] = AggregateBucket();
+    emit(level, closed);
+
+    // A clock that went back, or jumped too far to be worth filling
+    if (t < closed.end || t - closed.end > MAX_GAP_S) {
+        return;
+    }
+    uint32_t next = closed.end;
+    for (;;) {
+        AggregateBucket gap;
+        bounds(level, next, &gap.start, &gap.end);
+        if (t < gap.end) {
+            break;
+        }
+        emit(level, gap);
+        next = gap.end;
+    }
+}
+
+void EnergyAggregator::emit(AggregateLevel level, const AggregateBucket &bucket) {
+    if (listener != nullptr) {
+        listener->bucketClosed(level, bucket);
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef ENERGY_AGGREGATOR_H
+#define ENERGY_AGGREGATOR_H
+
+#include <stdint.h>
+#include "MeterEngine.h"
+
+// The granularities EnergyAggregator keeps, finest first
+enum AggregateLevel {
+    AGG_MINUTE = 0,
+    AGG_QUARTER,     // 15 minutes, the demand interval
+    AGG_HOUR,
+    AGG_DAY,
+    AGG_LEVELS
+};
+
+// One bucket's readings. Averages are weighted by each reading's duration,
+// since readings come closer together around load steps (ReadingCadence).
+struct AggregateBucket {
+    uint32_t start = 0;          // epoch of the bucket's first second; 0 while none is open
+    uint32_t end = 0;            // first second after it
+    uint32_t samples = 0;        // readings
+    uint64_t energyMws = 0;
+    float powerSec = 0;          // real power x seconds, W s
+    float apparentSec = 0;       // VA s
+    float currentSec = 0;        // A s
+    float voltageSec = 0;        // V s
+    float seconds = 0;
+    float peakPower = 0;         // highest reading, W
+    uint8_t flags = 0;           // MINUTE_RELAY_ON etc., ORed over the readings
+
+    bool empty() const { return samples == 0; }
+    float avgPower() const { return seconds > 0 ? powerSec / seconds : 0; }
+    float avgApparentPower() const { return seconds > 0 ? apparentSec / seconds : 0; }
+    float avgCurrent() const { return seconds > 0 ? currentSec / seconds : 0; }
+    float avgVoltage() const { return seconds > 0 ? voltageSec / seconds : 0; }
+
+    void add(const MeterReading &reading, uint8_t readingFlags);
+    void merge(const AggregateBucket &other);
+};
+
+// Told about every bucket as it closes, finest level first
+class AggregateListener {
+public:
+    virtual ~AggregateListener() {}
+    virtual void bucketClosed(AggregateLevel level, const AggregateBucket &bucket) = 0;
+};
+
+// Minute, quarter-hour, hour and day buckets kept in one pass per reading,
+// keyed on the epoch second the reading's midpoint falls in - so the
+// reading that closes at 01:00:00 is hour 0's, and whenever a bucket is
+// closed its date and hour are its own, never the clock's at the time.
+// Boundaries are local time (TZ), like the history paths.
+//
+// A reading past the open bucket closes it, and every bucket in between
+// is closed too, empty, so a gap in the readings leaves empty buckets
+// rather than folding into the next one. Gaps longer than MAX_GAP_S (a
+// clock that jumped) aren't filled. Readings taken before the clock was
+// set are held and go into the first bucket after it is.
+class EnergyAggregator {
+public:
+    static const uint32_t MAX_GAP_S = 2 * 86400;
+
+    explicit EnergyAggregator(AggregateListener *listener = nullptr) : listener(listener) {}
+
+    void setListener(AggregateListener *l) { listener = l; }
+
+    // epoch is when the reading closed, 0 if the clock isn't set
+    void add(uint32_t epoch, const MeterReading &reading, uint8_t flags);
+
+    // The open bucket at each level (start == 0 if none)
+    const AggregateBucket &current(AggregateLevel level) const { return open[level]; }
+
+    // Start again with nothing open, e.g. after the clock was corrected
+    void reset();
+
+    // [start, end) of the level's bucket holding second t, in local time
+    static void bounds(AggregateLevel level, uint32_t t, uint32_t *start, uint32_t *end);
+
+private:
+    void closeThrough(AggregateLevel level, uint32_t t);
+    void emit(AggregateLevel level, const AggregateBucket &bucket);
+
+    AggregateListener *listener;
+    AggregateBucket open[AGG_LEVELS];
+    AggregateBucket unclocked;   // readings from before the clock was set
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef ENERGY_COUNTER_H
+#define ENERGY_COUNTER_H
+
+#include <stdint.h>
+#include <math.h>
+
+// Energy is counted in whole milli-watt-seconds in 64-bit integers all the
+// way from the metering kernel to the hourly totals and the credit ledger,
+// and only turned into kWh for display and publishing. A float kWh total
+// stops registering a phone charger's ~1e-5 kWh a minute long before a
+// month is up; an integer never drops any.
+const double MWS_PER_KWH = 3.6e9;
+
+inline double mwsToKwh(int64_t mws) {
+    return mws / MWS_PER_KWH;
+}
+
+inline int64_t kwhToMws(double kwh) {
+    return isfinite(kwh) ? (int64_t)llround(kwh * MWS_PER_KWH) : 0;
+}
+
+// Milli-watt-seconds -> the telemetry records' fixed-point units, rounded
+inline uint32_t mwsToUwh(uint64_t mws) {
+    uint64_t uwh = (mws * 10 + 18) / 36;
+    return uwh > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)uwh;
+}
+
+inline uint32_t mwsToMwh(uint64_t mws) {
+    uint64_t mwh = (mws + 1800) / 3600;
+    return mwh > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)mwh;
+}
+
+// Hands out each interval's energy in whole mWs and carries the fraction
+// into the next interval, so rounding never adds up over a long run
+class EnergyQuantizer {
+public:
+    EnergyQuantizer() : carry(0) {}
+
+    uint64_t take(double mws) {
+        if (!(mws > 0)) {
+            return 0;   // noise below zero (or NaN) is no energy
+        }
+        double total = mws + carry;
+        uint64_t whole = (uint64_t)total;
+        carry = total - (double)whole;
+        return whole;
+    }
+
+    void reset() { carry = 0; }
+
+private:
+    double carry;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef ENERGY_ROLLUP_H
+#define ENERGY_ROLLUP_H
+
+#include <stdint.h>
+#include "EnergyCounter.h"
+
+// Totals for one calendar period
+struct RollupTotals {
+    uint32_t period = 0;       // YYYYMMDD for a day, YYYYMM for a month; 0 while empty
+    uint32_t samples = 0;      // readings, at whatever cadence they came
+    uint64_t energyMws = 0;
+    uint32_t seconds = 0;      // covered by the readings
+    uint32_t peakPowerDw = 0;
+    uint32_t peakDemandDw = 0; // the busiest quarter hour's average power
+
+    double energyKwh() const { return mwsToKwh(energyMws); }
+    // Energy over time covered, so a busy hour's closer readings don't
+    // weigh more than a quiet hour's
+    float avgPowerW() const { return seconds ? (float)(energyMws / 1000.0 / seconds) : 0.0f; }
+    float peakPowerW() const { return peakPowerDw / 10.0f; }
+    float peakDemandW() const { return peakDemandDw / 10.0f; }
+};
+
+// Running total for a day or a month, fed one finished hour at a time, so
+// the day and month can be published as single precomputed nodes instead of
+// being summed from every hourly one.
+class EnergyRollup {
+public:
+    void restore(const RollupTotals &saved) { totals = saved; }
+    const RollupTotals &current() const { return totals; }
+
+    // Add a finished hour that belongs to period, with its peak reading and
+    // busiest quarter hour. An hour from any other period than the running
+    // one starts the total afresh; returns true then.
+    bool add(uint32_t period, uint64_t energyMws, uint32_t seconds,
+             uint32_t peakPowerDw, uint32_t peakDemandDw, uint32_t samples) {
+        bool started = period != totals.period;
+        if (started) {
+            totals = RollupTotals();
+            totals.period = period;
+        }
+        totals.energyMws += energyMws;
+        totals.seconds += seconds;
+        totals.samples += samples;
+        if (peakPowerDw > totals.peakPowerDw) {
+            totals.peakPowerDw = peakPowerDw;
+        }
+        if (peakDemandDw > totals.peakDemandDw) {
+            totals.peakDemandDw = peakDemandDw;
+        }
+        return started;
+    }
+
+private:
+    RollupTotals totals;
+};
+
+#endif
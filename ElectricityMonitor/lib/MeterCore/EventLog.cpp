@@ -0,0 +1,155 @@
+#include "EventLog.h"
+#include <stdio.h>
+#include <string.h>
+
+void EventLog::clear() {
+    head = 0;
+    n = 0;
+    recorded = 0;
+}
+
+void EventLog::record(uint8_t level, uint32_t ms, const char *text, const LogArg *args, uint8_t argc) {
+    size_t slot = (head + n) % CAPACITY;
+    if (n == CAPACITY) {
+        head = (head + 1) % CAPACITY;
+    } else {
+        n++;
+    }
+
+    LogEntry &entry = entries[slot];
+    entry.ms = ms;
+    entry.format = text;
+    entry.level = level;
+    entry.argc = argc > LogEntry::MAX_ARGS ? LogEntry::MAX_ARGS : argc;
+    for (uint8_t k = 0; k < entry.argc; k++) {
+        entry.args[k] = args[k];
+    }
+    recorded++;
+
+    if (echo != nullptr) {
+        char line[160];
+        format(entry, line, sizeof(line));
+        echo(line);
+    }
+}
+
+// Append to out without running past size, always terminated
+static void appendText(char *out, size_t size, size_t &length, const char *text, size_t count) {
+    if (length + 1 >= size) {
+        return;
+    }
+    size_t room = size - 1 - length;
+    if (count > room) {
+        count = room;
+    }
+    memcpy(out + length, text, count);
+    length += count;
+    out[length] = '\0';
+}
+
+// One conversion with the argument cast to what the conversion expects.
+// The format's own length modifiers are dropped: arguments were widened
+// to 32 bits (or float) when they were packed, whatever was written.
+static int formatArg(char *out, size_t size, const char *flags, char conversion, const LogArg &arg) {
+    char spec[24];
+    switch (conversion) {
+    case 'd':
+    case 'i':
+    case 'c': {
+        long v = arg.type == LogArg::INT ? arg.i
+               : arg.type == LogArg::UINT ? (long)arg.u
+               : arg.type == LogArg::FLOAT ? (long)arg.f : 0;
+        if (conversion == 'c') {
+            snprintf(spec, sizeof(spec), "%%%sc", flags);
+            return snprintf(out, size, spec, (int)v);
+        }
+        snprintf(spec, sizeof(spec), "%%%sld", flags);
+        return snprintf(out, size, spec, v);
+    }
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o': {
+        unsigned long v = arg.type == LogArg::UINT ? arg.u
+                        : arg.type == LogArg::INT ? (unsigned long)(uint32_t)arg.i
+                        : arg.type == LogArg::FLOAT ? (unsigned long)arg.f : 0;
+        snprintf(spec, sizeof(spec), "%%%sl%c", flags, conversion);
+        return snprintf(out, size, spec, v);
+    }
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G': {
+        double v = arg.type == LogArg::FLOAT ? arg.f
+                 : arg.type == LogArg::INT ? (double)arg.i
+                 : arg.type == LogArg::UINT ? (double)arg.u : 0.0;
+        snprintf(spec, sizeof(spec), "%%%s%c", flags, conversion);
+        return snprintf(out, size, spec, v);
+    }
+    case 's': {
+        const char *v = arg.type == LogArg::TEXT && arg.s != nullptr ? arg.s : "?";
+        snprintf(spec, sizeof(spec), "%%%ss", flags);
+        return snprintf(out, size, spec, v);
+    }
+    default:
+        return snprintf(out, size, "%%%c", conversion);
+    }
+}
+
+size_t EventLog::format(const LogEntry &entry, char *out, size_t size) {
+    static const char LEVELS[] = "-EWID";
+    if (size == 0) {
+        return 0;
+    }
+    out[0] = '\0';
+
+    size_t length = 0;
+    char piece[96];
+    int n = snprintf(piece, sizeof(piece), "[%5lu.%03lu] %c ", (unsigned long)(entry.ms / 1000),
+                     (unsigned long)(entry.ms % 1000), entry.level <= EVENT_LOG_DEBUG ? LEVELS[entry.level] : '?');
+    appendText(out, size, length, piece, n > 0 ? (size_t)n : 0);
+
+    const char *p = entry.format != nullptr ? entry.format : "";
+    uint8_t next = 0;
+    while (*p != '\0') {
+        const char *literal = strchr(p, '%');
+        if (literal == nullptr) {
+            appendText(out, size, length, p, strlen(p));
+            break;
+        }
+        appendText(out, size, length, p, (size_t)(literal - p));
+        p = literal + 1;
+        if (*p == '%') {
+            appendText(out, size, length, "%", 1);
+            p++;
+            continue;
+        }
+
+        // Flags, width and precision carry over; length modifiers don't
+        char flags[12];
+        size_t flagLength = 0;
+        while (*p != '\0' && strchr("-+ #0123456789.", *p) != nullptr) {
+            if (flagLength + 1 < sizeof(flags)) flags[flagLength++] = *p;
+            p++;
+        }
+        flags[flagLength] = '\0';
+        while (*p != '\0' && strchr("hlLqjzt", *p) != nullptr) {
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+
+        LogArg missing;
+        const LogArg &arg = next < entry.argc ? entry.args[next] : missing;
+        next++;
+        n = formatArg(piece, sizeof(piece), flags, *p, arg);
+        if (n > 0) {
+            appendText(out, size, length, piece, (size_t)n < sizeof(piece) ? (size_t)n : sizeof(piece) - 1);
+        }
+        p++;
+    }
+    return length;
+}
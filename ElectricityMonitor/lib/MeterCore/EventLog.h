@@ -0,0 +1,126 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Levels, most severe first
+#define EVENT_LOG_NONE 0
+#define EVENT_LOG_ERROR 1
+#define EVENT_LOG_WARN 2
+#define EVENT_LOG_INFO 3
+#define EVENT_LOG_DEBUG 4
+
+// Anything less severe than this compiles to nothing, arguments included.
+// Production builds keep the default; bench builds pass
+// -DEVENT_LOG_LEVEL=EVENT_LOG_DEBUG.
+#ifndef EVENT_LOG_LEVEL
+#define EVENT_LOG_LEVEL EVENT_LOG_INFO
+#endif
+
+// One argument as given, formatted later
+struct LogArg {
+    enum Type : uint8_t { NONE, INT, UINT, FLOAT, TEXT };
+
+    Type type;
+    union {
+        int32_t i;
+        uint32_t u;
+        float f;
+        const char *s;   // must outlive the entry: literals only
+    };
+
+    LogArg() : type(NONE), u(0) {}
+    LogArg(int v) : type(INT), i(v) {}
+    LogArg(long v) : type(INT), i((int32_t)v) {}
+    LogArg(unsigned v) : type(UINT), u(v) {}
+    LogArg(unsigned long v) : type(UINT), u((uint32_t)v) {}
+    LogArg(unsigned long long v) : type(UINT), u((uint32_t)v) {}
+    LogArg(long long v) : type(INT), i((int32_t)v) {}
+    LogArg(float v) : type(FLOAT), f(v) {}
+    LogArg(double v) : type(FLOAT), f((float)v) {}
+    LogArg(const char *v) : type(TEXT), s(v) {}
+};
+
+struct LogEntry {
+    static const uint8_t MAX_ARGS = 4;
+
+    uint32_t ms;               // when it was logged
+    const char *format;        // printf-style, literal
+    uint8_t level;
+    uint8_t argc;
+    LogArg args[MAX_ARGS];
+};
+
+// Fixed ring of binary entries. Logging stores the format pointer and the
+// raw arguments - a few dozen bytes copied, no formatting and no UART - and
+// format() turns an entry into text only when it is dumped or uploaded.
+// When full the oldest entries are overwritten.
+//
+// One writer at a time: only setup() and the network task log.
+class EventLog {
+public:
+    static const size_t CAPACITY = 64;
+
+    EventLog() : echo(nullptr) { clear(); }
+
+    void clear();
+    void record(uint8_t level, uint32_t ms, const char *text, const LogArg *args, uint8_t argc);
+
+    size_t count() const { return n; }
+    uint32_t total() const { return recorded; }    // ever recorded; sequence of the next entry
+
+    // k-th oldest entry, k < count(). Its sequence number is total() - count() + k.
+    const LogEntry &at(size_t k) const { return entries[(head + k) % CAPACITY]; }
+
+    // "[   12.345] W message" into out; returns the length
+    static size_t format(const LogEntry &entry, char *out, size_t size);
+
+    // Called with each entry's text as it is recorded, e.g. to echo it to
+    // Serial on the bench. Off by default.
+    void setEcho(void (*callback)(const char *line)) { echo = callback; }
+
+private:
+    LogEntry entries[CAPACITY];
+    size_t head;
+    size_t n;
+    uint32_t recorded;
+    void (*echo)(const char *line);
+};
+
+// The log the macros write to, and its clock; the sketch supplies both
+extern EventLog eventLog;
+uint32_t eventLogClockMs();
+
+template <typename... Args>
+inline void logEvent(uint8_t level, const char *format, Args... args) {
+    static_assert(sizeof...(Args) <= LogEntry::MAX_ARGS, "too many log arguments");
+    LogArg packed[sizeof...(Args) + 1] = { LogArg(args)... };
+    eventLog.record(level, eventLogClockMs(), format, packed, (uint8_t)sizeof...(Args));
+}
+
+#if EVENT_LOG_LEVEL >= EVENT_LOG_ERROR
+#define LOG_ERROR(...) logEvent(EVENT_LOG_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do {} while (0)
+#endif
+
+#if EVENT_LOG_LEVEL >= EVENT_LOG_WARN
+#define LOG_WARN(...) logEvent(EVENT_LOG_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do {} while (0)
+#endif
+
+#if EVENT_LOG_LEVEL >= EVENT_LOG_INFO
+#define LOG_INFO(...) logEvent(EVENT_LOG_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do {} while (0)
+#endif
+
+#if EVENT_LOG_LEVEL >= EVENT_LOG_DEBUG
+#define LOG_DEBUG(...) logEvent(EVENT_LOG_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do {} while (0)
+#endif
+
+#endif
@@ -0,0 +1,100 @@
+#include "FakeSampleSource.h"
+#include <math.h>
+
+static const double TWO_PI = 6.283185307179586;
+
+static uint16_t clampAdc(float value) {
+    long rounded = lround(value);
+    if (rounded < 0) return 0;
+    if (rounded > 4095) return 4095;
+    return (uint16_t)rounded;
+}
+
+FakeSampleSource::FakeSampleSource(uint32_t rateHz)
+    : rateHz(rateHz), ring(nullptr), sampleIndex(0), phaseCycles(0) {}
+
+bool FakeSampleSource::begin(RawSampleRing &target) {
+    ring = &target;
+    return true;
+}
+
+void FakeSampleSource::end() {
+    ring = nullptr;
+}
+
+size_t FakeSampleSource::generate(size_t count) {
+    if (ring == nullptr) {
+        return 0;
+    }
+
+    // The phase is carried in whole-cycle units and wrapped, which keeps the
+    // argument small over days of simulated time without an fmod per sample
+    const double cyclesPerSample = (double)wave.frequencyHz / rateHz;
+    size_t pushed = 0;
+    for (size_t k = 0; k < count; k++) {
+        double angle = TWO_PI * phaseCycles;
+        phaseCycles += cyclesPerSample;
+        if (phaseCycles >= 1.0) phaseCycles -= 1.0;
+        sampleIndex++;
+
+        RawSample sample;
+        sample.voltage = clampAdc(wave.voltageOffset + wave.voltageAmplitude * sin(angle));
+        sample.current = clampAdc(wave.currentOffset +
+                                  wave.currentAmplitude * sin(angle - wave.currentPhaseRad));
+        if (ring->push(sample)) {
+            pushed++;
+        }
+    }
+    return pushed;
+}
+
+FakeChannelFrameSource::FakeChannelFrameSource(uint8_t channels, uint32_t rateHz)
+    : channelCount(channels > MAX_METER_CHANNELS ? MAX_METER_CHANNELS : channels),
+      rateHz(rateHz),
+      ring(nullptr),
+      frameIndex(0),
+      phaseCycles(0) {}
+
+bool FakeChannelFrameSource::begin(ChannelFrameRing &target) {
+    ring = &target;
+    return true;
+}
+
+void FakeChannelFrameSource::end() {
+    ring = nullptr;
+}
+
+void FakeChannelFrameSource::setWaveform(uint8_t channel, const FakeWaveform &waveform) {
+    if (channel < MAX_METER_CHANNELS) {
+        waves[channel] = waveform;
+    }
+}
+
+size_t FakeChannelFrameSource::generate(size_t count) {
+    if (ring == nullptr) {
+        return 0;
+    }
+
+    const FakeWaveform &supply = waves[0];
+    const double cyclesPerSample = (double)supply.frequencyHz / rateHz;
+    size_t pushed = 0;
+    for (size_t k = 0; k < count; k++) {
+        double angle = TWO_PI * phaseCycles;
+        phaseCycles += cyclesPerSample;
+        if (phaseCycles >= 1.0) phaseCycles -= 1.0;
+        frameIndex++;
+
+        ChannelFrame frame;
+        frame.voltage = clampAdc(supply.voltageOffset + supply.voltageAmplitude * sin(angle));
+        for (uint8_t c = 0; c < MAX_METER_CHANNELS; c++) {
+            const FakeWaveform &wave = waves[c];
+            frame.current[c] = c < channelCount
+                ? clampAdc(wave.currentOffset + wave.currentAmplitude * sin(angle - wave.currentPhaseRad))
+                : 0;
+        }
+        if (ring->push(frame)) {
+            pushed++;
+        }
+    }
+    return pushed;
+}
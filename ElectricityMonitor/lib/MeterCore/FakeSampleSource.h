@@ -0,0 +1,68 @@
+#ifndef FAKE_SAMPLE_SOURCE_H
+#define FAKE_SAMPLE_SOURCE_H
+
+#include "SampleSource.h"
+
+// Synthetic mains waveform, in ADC counts
+struct FakeWaveform {
+    float frequencyHz = 50.0;
+    float voltageAmplitude = 0;    // peak counts around voltageOffset
+    float voltageOffset = 2048;
+    float currentAmplitude = 0;    // peak counts around currentOffset
+    float currentOffset = 2048;
+    float currentPhaseRad = 0;     // positive = current lags voltage
+};
+
+// Host-side stand-in for the DMA sampler. Nothing happens in the background:
+// the test calls generate() to simulate the DMA delivering samples.
+class FakeSampleSource : public SampleSource {
+public:
+    explicit FakeSampleSource(uint32_t rateHz = 1000);
+
+    bool begin(RawSampleRing &ring) override;
+    void end() override;
+    uint32_t sampleRateHz() const override { return rateHz; }
+
+    void setWaveform(const FakeWaveform &waveform) { wave = waveform; }
+
+    // Push count samples into the ring; returns how many fit
+    size_t generate(size_t count);
+
+    uint64_t generatedCount() const { return sampleIndex; }
+
+private:
+    uint32_t rateHz;
+    FakeWaveform wave;
+    RawSampleRing *ring;
+    uint64_t sampleIndex;
+    double phaseCycles;      // [0, 1)
+};
+
+// The same for a multi-channel board. Each channel has its own current
+// waveform; the shared voltage is channel 0's.
+class FakeChannelFrameSource : public ChannelFrameSource {
+public:
+    explicit FakeChannelFrameSource(uint8_t channels, uint32_t rateHz = 1000);
+
+    bool begin(ChannelFrameRing &ring) override;
+    void end() override;
+    uint32_t sampleRateHz() const override { return rateHz; }
+    uint8_t channels() const override { return channelCount; }
+
+    void setWaveform(uint8_t channel, const FakeWaveform &waveform);
+
+    // Push count frames into the ring; returns how many fit
+    size_t generate(size_t count);
+
+    uint64_t generatedCount() const { return frameIndex; }
+
+private:
+    uint8_t channelCount;
+    uint32_t rateHz;
+    FakeWaveform waves[MAX_METER_CHANNELS];
+    ChannelFrameRing *ring;
+    uint64_t frameIndex;
+    double phaseCycles;
+};
+
+#endif
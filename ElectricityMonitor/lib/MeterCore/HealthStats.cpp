@@ -0,0 +1,91 @@
+#include "HealthStats.h"
+#include <string.h>
+
+static const char *const ROUND_TRIP_NAMES[RTT_KINDS] = {
+    "credit", "cycleUpdate", "replayUpdate", "forceHourly"
+};
+
+void LatencyHistogram::reset() {
+    memset(buckets, 0, sizeof(buckets));
+    n = 0;
+    maxValue = 0;
+}
+
+void LatencyHistogram::add(uint32_t value) {
+    uint8_t k = 0;
+    while (k < BUCKETS - 1 && (value >> (k + 1)) != 0) {
+        k++;
+    }
+    buckets[k]++;
+    n++;
+    if (value > maxValue) {
+        maxValue = value;
+    }
+}
+
+uint32_t LatencyHistogram::percentile(uint8_t pct) const {
+    if (n == 0) {
+        return 0;
+    }
+    // Rank of the percentile, rounded up, so p99 of 50 values is the largest
+    uint32_t rank = (uint32_t)(((uint64_t)n * pct + 99) / 100);
+    if (rank == 0) rank = 1;
+
+    uint32_t seen = 0;
+    for (uint8_t k = 0; k < BUCKETS; k++) {
+        seen += buckets[k];
+        if (seen >= rank) {
+            uint32_t upper = k + 1 < 32 ? (1u << (k + 1)) - 1 : 0xFFFFFFFFu;
+            return upper < maxValue ? upper : maxValue;
+        }
+    }
+    return maxValue;
+}
+
+LatencySummary LatencyHistogram::summary() const {
+    LatencySummary summary;
+    summary.count = n;
+    summary.p50 = percentile(50);
+    summary.p90 = percentile(90);
+    summary.p99 = percentile(99);
+    summary.max = maxValue;
+    return summary;
+}
+
+const char *roundTripName(uint8_t kind) {
+    return kind < RTT_KINDS ? ROUND_TRIP_NAMES[kind] : "";
+}
+
+// A step is realtime power like a reading's update, and is timed with them,
+// so the health record's layout stays as it is
+static const char *const STEP_UPDATE = "stepUpdate";
+
+uint8_t roundTripKind(const char *uid) {
+    if (strcmp(uid, STEP_UPDATE) == 0) {
+        return RTT_CYCLE_UPDATE;
+    }
+    for (uint8_t kind = RTT_CYCLE_UPDATE; kind < RTT_KINDS; kind++) {
+        if (strcmp(uid, ROUND_TRIP_NAMES[kind]) == 0) {
+            return kind;
+        }
+    }
+    return RTT_KINDS;
+}
+
+void HealthStats::reset() {
+    loopUs.reset();
+    passUs.reset();
+    meteringUs.reset();
+    for (uint8_t kind = 0; kind < RTT_KINDS; kind++) {
+        roundTripMs[kind].reset();
+    }
+    firebaseErrors = 0;
+    maxConsecutiveErrors = 0;
+    ackTimeouts = 0;
+    creditTimeouts = 0;
+    reconnects = 0;
+    linkDrops = 0;
+    sampleDrops = 0;
+    logBacklogMax = 0;
+    queueHighWater = 0;
+}
@@ -0,0 +1,78 @@
+#ifndef HEALTH_STATS_H
+#define HEALTH_STATS_H
+
+#include <stdint.h>
+
+// Count, percentiles and maximum of a histogram, as kept in a health record
+struct LatencySummary {
+    uint32_t count = 0;
+    uint32_t p50 = 0;
+    uint32_t p90 = 0;
+    uint32_t p99 = 0;
+    uint32_t max = 0;
+};
+
+// Durations in power-of-two buckets: bucket k counts [2^k, 2^(k+1)), and
+// bucket 0 takes 0 as well. 24 buckets reach 16.7 s in microseconds, more
+// than the watchdog allows. A percentile is the upper edge of its bucket,
+// never more than the largest value seen, so it is within a factor of
+// two - enough to see a unit falling behind, in 104 bytes.
+class LatencyHistogram {
+public:
+    static const uint8_t BUCKETS = 24;
+
+    LatencyHistogram() { reset(); }
+
+    void reset();
+    void add(uint32_t value);
+
+    uint32_t count() const { return n; }
+    uint32_t max() const { return maxValue; }
+    uint32_t bucket(uint8_t k) const { return buckets[k]; }
+    uint32_t percentile(uint8_t pct) const;
+    LatencySummary summary() const;
+
+private:
+    uint32_t buckets[BUCKETS];
+    uint32_t n;
+    uint32_t maxValue;
+};
+
+// Firebase round trips, timed by what was asked. The update kinds are the
+// task uids MonitorApp sends them with.
+enum RoundTripKind {
+    RTT_CREDIT = 0,         // the remaining_units get
+    RTT_CYCLE_UPDATE,       // "cycleUpdate", and "stepUpdate" between readings
+    RTT_REPLAY_UPDATE,      // "replayUpdate"
+    RTT_FORCE_HOURLY,       // "forceHourly"
+    RTT_KINDS
+};
+
+const char *roundTripName(uint8_t kind);
+
+// The update kind sent with uid, or RTT_KINDS for one that isn't known
+uint8_t roundTripKind(const char *uid);
+
+// What the network task saw over one hour. Kept by MonitorApp, closed into
+// a HealthRecord with the hour and started afresh.
+struct HealthStats {
+    LatencyHistogram loopUs;       // network task pass to pass, FirebaseClient and the yield included
+    LatencyHistogram passUs;       // MonitorApp's own share of a pass
+    LatencyHistogram meteringUs;   // slowest metering period of each reading's minute
+    LatencyHistogram roundTripMs[RTT_KINDS];
+
+    uint16_t firebaseErrors;
+    uint16_t maxConsecutiveErrors;
+    uint16_t ackTimeouts;          // updates given up on unanswered
+    uint16_t creditTimeouts;
+    uint16_t reconnects;           // reconnect attempts
+    uint16_t linkDrops;
+    uint32_t sampleDrops;          // sample ring overruns
+    uint32_t logBacklogMax;        // most telemetry log bytes waiting for replay
+    uint8_t queueHighWater;        // most readings waiting for the network task
+
+    HealthStats() { reset(); }
+    void reset();
+};
+
+#endif
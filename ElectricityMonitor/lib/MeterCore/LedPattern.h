@@ -0,0 +1,41 @@
+#ifndef LED_PATTERN_H
+#define LED_PATTERN_H
+
+#include <stdint.h>
+
+// Non-blocking status LED blinks. blink() starts a pattern of count
+// off/on pulses, each half lasting halfPeriodMs; levelAt() says what the
+// LED should show at a given time, so loop() drives the pin instead of a
+// callback sitting in delay(). A new pattern replaces the one running.
+class LedPattern {
+public:
+    explicit LedPattern(bool idleOn = true)
+        : idleOn(idleOn), startMs(0), halfPeriodMs(0), pulses(0) {}
+
+    void blink(uint8_t count, uint16_t halfPeriod, uint32_t nowMs) {
+        startMs = nowMs;
+        halfPeriodMs = halfPeriod;
+        pulses = count;
+    }
+
+    bool busy(uint32_t nowMs) const {
+        return halfPeriodMs > 0 && (nowMs - startMs) / halfPeriodMs < 2u * pulses;
+    }
+
+    // true = LED lit. Each pulse starts with the off half.
+    bool levelAt(uint32_t nowMs) const {
+        if (!busy(nowMs)) {
+            return idleOn;
+        }
+        uint32_t phase = (nowMs - startMs) / halfPeriodMs;
+        return (phase & 1) ? idleOn : !idleOn;
+    }
+
+private:
+    bool idleOn;
+    uint32_t startMs;
+    uint16_t halfPeriodMs;
+    uint8_t pulses;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#include "MeterEngine.h"
+
+MeterEngine::MeterEngine() {
+    configure(MeterConfig());
+}
+
+void MeterEngine::configure(const MeterConfig &config) {
+    cfg = config;
+    currentBias = OffsetTracker(cfg.offsetTrackingShift, cfg.adcCenter);
+    voltageBias = OffsetTracker(cfg.offsetTrackingShift, cfg.adcCenter);
+    sync.configure(cfg);
+    channel.configure(cfg);
+}
+
+void MeterEngine::seedOffsets(float currentCounts, float voltageCounts) {
+    currentBias.seed(currentCounts);
+    voltageBias.seed(voltageCounts);
+}
+
+void MeterEngine::process(const RawSample *samples, size_t count) {
+    for (size_t k = 0; k < count; k++) {
+        int16_t i = (int16_t)currentBias.deviation(samples[k].current, DEVIATION_FRAC_BITS);
+        int16_t v = (int16_t)voltageBias.deviation(samples[k].voltage, DEVIATION_FRAC_BITS);
+        currentBias.update(samples[k].current);
+        voltageBias.update(samples[k].voltage);
+
+        if (sync.startSample(v)) {
+            channel.closeWindow(calibration.voltage, calibration.current);
+        }
+        channel.add(v, i);
+        if (sync.endSample()) {
+            channel.closeWindow(calibration.voltage, calibration.current);
+        }
+    }
+}
+
+size_t MeterEngine::drain(RawSampleRing &ring) {
+    RawSample batch[64];
+    size_t total = 0;
+    size_t n;
+    while ((n = ring.popBatch(batch, 64)) > 0) {
+        process(batch, n);
+        total += n;
+    }
+    return total;
+}
+
+MeterReading MeterEngine::takeReading() {
+    MeterReading reading;
+    channel.takeReading(reading);
+    sync.takeInterval(reading);
+    reading.currentOffset = currentBias.value();
+    reading.voltageOffset = voltageBias.value();
+    return reading;
+}
@@ -0,0 +1,85 @@
+#ifndef METER_ENGINE_H
+#define METER_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "CalibrationProfile.h"
+#include "SampleSource.h"
+#include "OffsetTracker.h"
+#include "MeterWindow.h"
+
+// Consumes the continuous sample stream in a single pass. Each V/I pair
+// updates sum(v^2), sum(i^2) and sum(v*i), so real power and energy come
+// from instantaneous products rather than Vrms * Irms, and nothing between
+// readings goes unmeasured.
+//
+// Sums are gathered into windows that start and end on rising zero
+// crossings of the voltage, so every window is an exact number of mains
+// cycles. A reading only includes closed windows; the open one carries
+// over. Without a voltage signal windows fall back to a fixed length.
+//
+// Each channel's DC bias is tracked continuously from the same samples
+// rather than assumed to be the ADC midpoint. Deviations are kept in
+// quarter counts so the fractional offset isn't rounded away.
+//
+// The calibration profile is applied per closed window, from that window's
+// own RMS, so a minute that mixes a standby load with a kettle gets each
+// range's gain rather than one for the average.
+//
+// The windowing and sums are WindowSync's and PowerChannel's, which
+// MultiChannelMeter runs per channel as well.
+class MeterEngine {
+public:
+    MeterEngine();
+
+    void configure(const MeterConfig &config);
+    const MeterConfig &config() const { return cfg; }
+
+    void process(const RawSample *samples, size_t count);
+
+    // Pop everything currently in the ring and process it
+    size_t drain(RawSampleRing &ring);
+
+    // Snapshot the current interval and start a new one
+    MeterReading takeReading();
+
+    uint64_t totalSamples() const { return sync.totalSamples(); }
+
+    // Real power over the last whole second of closed windows, W: what the
+    // load is doing now, between readings (see PublishPolicy)
+    float recentPower() const { return channel.recentPower(); }
+    bool hasRecentPower() const { return channel.hasRecentPower(); }
+
+    // Takes effect from the next window closed
+    void setCalibration(const CalibrationProfile &profile) { calibration = profile; }
+    const CalibrationProfile &calibrationProfile() const { return calibration; }
+
+    // Offsets persisted across reboots or measured by the calibration wizard
+    void seedOffsets(float currentCounts, float voltageCounts);
+    float currentOffset() const { return currentBias.value(); }
+    float voltageOffset() const { return voltageBias.value(); }
+
+private:
+    MeterConfig cfg;
+    CalibrationProfile calibration;
+    OffsetTracker currentBias;
+    OffsetTracker voltageBias;
+    WindowSync sync;
+    PowerChannel channel;      // voltage = channel a, current = channel b
+};
+
+// Metering task side of a CalibrationMailbox: apply the newest profile
+// waiting, if any
+inline bool takeCalibration(MeterEngine &engine, CalibrationMailbox &mailbox) {
+    CalibrationProfile profile;
+    bool taken = false;
+    while (mailbox.pop(profile)) {
+        taken = true;
+    }
+    if (taken) {
+        engine.setCalibration(profile);
+    }
+    return taken;
+}
+
+#endif
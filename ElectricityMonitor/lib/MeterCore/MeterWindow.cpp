@@ -0,0 +1,155 @@
+#include "MeterWindow.h"
+#include <math.h>
+
+const float DEVIATION_SCALE = 1.0f / (1 << DEVIATION_FRAC_BITS);
+
+void WindowSync::configure(const MeterConfig &config) {
+    sampleRateHz = config.sampleRateHz;
+    cyclesPerWindow = config.cyclesPerWindow;
+    zeroCross = ZeroCrossDetector(config.zeroCrossHysteresis << DEVIATION_FRAC_BITS);
+
+    // Give up on sync after twice the nominal window so a missing voltage
+    // signal doesn't stall readings
+    maxWindowSamples = (uint32_t)(2.0f * config.cyclesPerWindow * config.sampleRateHz / config.mainsFrequencyHz);
+    if (maxWindowSamples == 0) maxWindowSamples = 1;
+    if (maxWindowSamples > MAX_WINDOW_SAMPLES) maxWindowSamples = MAX_WINDOW_SAMPLES;
+
+    windowSamples = 0;
+    windowCycles = 0;
+    locked = false;
+    windowStartPos = 0;
+
+    intervalWindows = 0;
+    intervalSyncedWindows = 0;
+    intervalCycles = 0;
+    intervalSyncedSamples = 0;
+
+    closedSamples = 0;
+}
+
+bool WindowSync::crossed() {
+    // The crossing lies between the previous sample and this one, so this
+    // sample is the first of the next window
+    double position = (double)totalSamples() - 1.0 + zeroCross.crossingFraction();
+    if (!locked) {
+        bool closing = windowSamples > 0;
+        if (closing) close(false);
+        locked = true;
+        windowStartPos = position;
+        return closing;
+    }
+    if (++windowCycles < cyclesPerWindow) {
+        return false;
+    }
+    intervalCycles += windowCycles;
+    intervalSyncedSamples += position - windowStartPos;
+    close(true);
+    windowStartPos = position;
+    return true;
+}
+
+bool WindowSync::overran() {
+    // Lost the voltage signal (outage, unplugged sensor)
+    close(false);
+    locked = false;
+    return true;
+}
+
+void WindowSync::close(bool synced) {
+    intervalWindows++;
+    if (synced) intervalSyncedWindows++;
+    closedSamples += windowSamples;
+    windowSamples = 0;
+    windowCycles = 0;
+}
+
+void WindowSync::takeInterval(MeterReading &reading) {
+    if (intervalSyncedSamples > 0) {
+        reading.lineFrequencyHz = intervalCycles * sampleRateHz / intervalSyncedSamples;
+    }
+    reading.windows = intervalWindows;
+    reading.syncedWindows = intervalSyncedWindows;
+
+    intervalWindows = 0;
+    intervalSyncedWindows = 0;
+    intervalCycles = 0;
+    intervalSyncedSamples = 0;
+}
+
+void PowerChannel::configure(const MeterConfig &config) {
+    sampleRateHz = config.sampleRateHz;
+    voltsPerUnit = config.voltsPerCount * DEVIATION_SCALE;
+    ampsPerUnit = config.ampsPerCount * DEVIATION_SCALE;
+
+    window.reset();
+    interval.reset();
+    calibratedVV = 0;
+    calibratedII = 0;
+    calibratedVI = 0;
+    energyOut.reset();
+
+    recentVI = 0;
+    recentSamples = 0;
+    recentPowerW = 0;
+    recentMeasured = false;
+}
+
+void PowerChannel::closeWindow(const CalibrationTable &voltage, const CalibrationTable &current) {
+    // Ten windows a second: the table lookups are nothing next to the samples
+    float kv = 1;
+    float ki = 1;
+    if (voltage.count > 0 || current.count > 0) {
+        kv = voltage.scale(window.rmsA() * voltsPerUnit);
+        ki = current.scale(window.rmsB() * ampsPerUnit);
+    }
+    double vi = (double)window.sumProduct() * kv * ki;
+    calibratedVV += (double)window.sumSquareA() * kv * kv;
+    calibratedII += (double)window.sumSquareB() * ki * ki;
+    calibratedVI += vi;
+    interval.merge(window);
+
+    recentVI += vi;
+    recentSamples += window.count();
+    if (recentSamples >= sampleRateHz) {
+        float power = (float)(recentVI / recentSamples) * voltsPerUnit * ampsPerUnit;
+        recentPowerW = power > 0 ? power : 0;
+        recentMeasured = true;
+        recentVI = 0;
+        recentSamples = 0;
+    }
+
+    window.reset();
+}
+
+void PowerChannel::takeReading(MeterReading &reading) {
+    if (interval.count() > 0) {
+        double n = interval.count();
+        reading.voltageRms = (float)sqrt(calibratedVV / n) * voltsPerUnit;
+        reading.currentRms = (float)sqrt(calibratedII / n) * ampsPerUnit;
+        reading.realPower = (float)(calibratedVI / n) * voltsPerUnit * ampsPerUnit;
+        reading.apparentPower = reading.voltageRms * reading.currentRms;
+
+        // ADC noise on an idle channel can push mean(v*i) slightly negative
+        if (reading.realPower < 0) reading.realPower = 0;
+
+        if (reading.apparentPower > 0) {
+            reading.powerFactor = reading.realPower / reading.apparentPower;
+            if (reading.powerFactor > 1) reading.powerFactor = 1;
+            reading.phaseAngleDeg = acosf(reading.powerFactor) * 57.29578f;
+        }
+
+        reading.durationSec = (float)interval.count() / sampleRateHz;
+        // From sum(v*i), each window's scaled by the calibration gains at its
+        // own level: W * s = sum * V/unit * A/unit / rate
+        double intervalMws = calibratedVI * voltsPerUnit * ampsPerUnit *
+                             1000.0 / sampleRateHz;
+        reading.energyMws = energyOut.take(intervalMws);
+        reading.energyKwh = mwsToKwh(reading.energyMws);
+    }
+    reading.samples = interval.count();
+
+    interval.reset();
+    calibratedVV = 0;
+    calibratedII = 0;
+    calibratedVI = 0;
+}
@@ -0,0 +1,144 @@
+#ifndef METER_WINDOW_H
+#define METER_WINDOW_H
+
+#include <stdint.h>
+#include "CalibrationProfile.h"
+#include "ZeroCrossDetector.h"
+#include "RmsKernel.h"
+#include "EnergyCounter.h"
+
+// Upper bounds the kernels are sized (and overflow-checked) for
+const uint32_t MAX_WINDOW_SAMPLES = 8192;
+const uint32_t MAX_INTERVAL_SAMPLES = 0x80000000u;  // ~24 days at 1 kHz
+
+// Deviations from the channel offset are kept in 1/4 counts, which fit
+// comfortably in 16 bits
+const uint8_t DEVIATION_FRAC_BITS = 2;
+typedef PowerKernel<int16_t, MAX_WINDOW_SAMPLES> WindowKernel;
+typedef PowerKernel<int16_t, MAX_INTERVAL_SAMPLES> IntervalKernel;
+
+struct MeterConfig {
+    uint32_t sampleRateHz = 1000;
+    int adcCenter = 2048;      // starting offset until the trackers have a better one
+    uint8_t offsetTrackingShift = 14;
+    float voltsPerCount = 0;   // mains volts per ADC count, before the calibration profile
+    float ampsPerCount = 0;    // load amps per ADC count, likewise
+    float mainsFrequencyHz = 50;
+    uint8_t cyclesPerWindow = 5;    // 100 ms at 50 Hz
+    int32_t zeroCrossHysteresis = 40;
+};
+
+// Everything measured since the previous takeReading()
+struct MeterReading {
+    float voltageRms = 0;
+    float currentRms = 0;
+    float realPower = 0;       // W, mean(v * i)
+    float apparentPower = 0;   // VA, Vrms * Irms
+    float powerFactor = 0;     // realPower / apparentPower
+    float phaseAngleDeg = 0;   // acos(powerFactor); lead/lag is not resolved
+    float lineFrequencyHz = 0; // measured from zero crossings, 0 if no mains
+    uint64_t energyMws = 0;    // milli-watt-seconds, integrated over every sample in the interval
+    double energyKwh = 0;      // the same, for display
+    uint32_t samples = 0;
+    uint32_t windows = 0;      // RMS windows closed in the interval
+    uint32_t syncedWindows = 0; // of which spanned whole mains cycles
+    float durationSec = 0;
+    float currentOffset = 0;   // tracked DC bias, ADC counts
+    float voltageOffset = 0;
+};
+
+// Where windows start and end. Fed each sample's voltage deviation, it
+// closes a window every cyclesPerWindow rising zero crossings, or after
+// twice the nominal length if the crossings stop. Counts the interval's
+// windows and cycles for the line frequency. Holds no sums: the channels
+// sharing the voltage each keep their own (see PowerChannel).
+class WindowSync {
+public:
+    WindowSync() { configure(MeterConfig()); }
+
+    void configure(const MeterConfig &config);
+
+    // Before a sample joins the window: true if a crossing closes the
+    // open window first. Inline, like the kernels: it runs every sample.
+    bool startSample(int16_t voltage) {
+        return zeroCross.update(voltage) && crossed();
+    }
+
+    // After it has joined: true if the window has run too long without a
+    // crossing and closes too
+    bool endSample() {
+        return ++windowSamples >= maxWindowSamples && overran();
+    }
+
+    uint64_t totalSamples() const { return closedSamples + windowSamples; }
+
+    // The interval's windows, synced windows and line frequency into
+    // reading, and start a new interval
+    void takeInterval(MeterReading &reading);
+
+private:
+    bool crossed();
+    bool overran();
+    void close(bool synced);
+
+    uint32_t sampleRateHz;
+    uint8_t cyclesPerWindow;
+    uint32_t maxWindowSamples;
+    ZeroCrossDetector zeroCross;
+
+    uint32_t windowSamples;
+    uint8_t windowCycles;
+    bool locked;               // windows currently start on a crossing
+    double windowStartPos;     // crossing position in samples since configure()
+
+    uint32_t intervalWindows;
+    uint32_t intervalSyncedWindows;
+    uint32_t intervalCycles;
+    double intervalSyncedSamples;
+
+    uint64_t closedSamples;    // since configure(), in windows already closed
+};
+
+// One voltage/current pair's sums: the open window in a WindowKernel, and
+// the reading interval it's merged into when WindowSync closes it. Each
+// window's sums are scaled by the calibration gains at that window's own
+// RMS, so an interval that mixes a standby load with a kettle gets each
+// range's gain rather than one for the average.
+class PowerChannel {
+public:
+    PowerChannel() { configure(MeterConfig()); }
+
+    void configure(const MeterConfig &config);
+
+    void add(int16_t voltage, int16_t current) { window.add(voltage, current); }
+
+    void closeWindow(const CalibrationTable &voltage, const CalibrationTable &current);
+
+    // RMS, power, energy and samples of the closed windows into reading,
+    // and start a new interval
+    void takeReading(MeterReading &reading);
+
+    // Real power over the last whole second of closed windows, W
+    float recentPower() const { return recentPowerW; }
+    bool hasRecentPower() const { return recentMeasured; }
+
+private:
+    uint32_t sampleRateHz;
+    float voltsPerUnit;        // per deviation unit, before calibration
+    float ampsPerUnit;
+
+    WindowKernel window;
+
+    IntervalKernel interval;
+    double calibratedVV;
+    double calibratedII;
+    double calibratedVI;
+    EnergyQuantizer energyOut;   // sub-mWs remainder carried between readings
+
+    double recentVI;
+    uint32_t recentSamples;
+    float recentPowerW;
+    bool recentMeasured;         // a whole second has been seen since configure()
+};
+
+#endif
@@ -0,0 +1,62 @@
+#include "MinuteProfile.h"
+#include "Varint.h"
+
+uint8_t encodeProfile(const MinuteProfile &profile, uint8_t first,
+                      uint8_t *out, size_t maxBytes, size_t *length) {
+    // One byte of minute and flags plus three varints of at most 3 bytes
+    uint8_t sample[10];
+    MinuteSample previous = MinuteSample();
+    size_t used = 0;
+    uint8_t encoded = 0;
+
+    for (uint8_t k = first; k < profile.count(); k++) {
+        const MinuteSample &s = profile.at(k);
+        size_t n = 0;
+        sample[n++] = (uint8_t)((s.minute & 0x3F) | (s.flags & 0x03) << 6);
+        n += putVarint(sample + n, (int32_t)s.powerQw - previous.powerQw);
+        n += putVarint(sample + n, (int32_t)s.currentMa - previous.currentMa);
+        n += putVarint(sample + n, (int32_t)s.voltageDv - previous.voltageDv);
+        if (used + n > maxBytes) {
+            break;
+        }
+        for (size_t b = 0; b < n; b++) {
+            out[used + b] = sample[b];
+        }
+        used += n;
+        encoded++;
+        previous = s;
+    }
+    *length = used;
+    return encoded;
+}
+
+size_t decodeProfile(const uint8_t *in, size_t length, MinuteSample *out, size_t maxSamples) {
+    MinuteSample previous = MinuteSample();
+    size_t pos = 0;
+    size_t count = 0;
+
+    while (pos < length) {
+        if (count >= maxSamples) {
+            return 0;
+        }
+        MinuteSample s;
+        s.minute = in[pos] & 0x3F;
+        s.flags = in[pos] >> 6;
+        pos++;
+
+        int32_t delta[3];
+        for (int c = 0; c < 3; c++) {
+            size_t n = getVarint(in + pos, length - pos, delta[c]);
+            if (n == 0) {
+                return 0;
+            }
+            pos += n;
+        }
+        s.powerQw = (uint16_t)(previous.powerQw + delta[0]);
+        s.currentMa = (uint16_t)(previous.currentMa + delta[1]);
+        s.voltageDv = (uint16_t)(previous.voltageDv + delta[2]);
+        out[count++] = s;
+        previous = s;
+    }
+    return count;
+}
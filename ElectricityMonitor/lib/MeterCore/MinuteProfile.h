@@ -0,0 +1,71 @@
+#ifndef MINUTE_PROFILE_H
+#define MINUTE_PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// One reading inside the hour, quantized to 8 bytes
+struct MinuteSample {
+    uint8_t minute;       // minute of the hour, 0-59
+    uint8_t flags;        // MINUTE_RELAY_ON etc. (low two bits survive encoding)
+    uint16_t powerQw;     // real power, 0.25 W (up to 16 kW)
+    uint16_t currentMa;
+    uint16_t voltageDv;   // 0.1 V
+};
+
+// The hour's minutes, oldest first, in a fixed array: 64 slots cover an
+// hour, in 512 bytes. Each sample is a closed minute bucket (see
+// EnergyAggregator), however many readings it took. If more arrive the
+// oldest are overwritten and counted.
+class MinuteProfile {
+public:
+    static const uint8_t CAPACITY = 64;
+
+    MinuteProfile() { clear(); }
+
+    void clear() {
+        head = 0;
+        n = 0;
+        lost = 0;
+    }
+
+    void add(const MinuteSample &sample) {
+        samples[(head + n) % CAPACITY] = sample;
+        if (n < CAPACITY) {
+            n++;
+        } else {
+            head = (head + 1) % CAPACITY;
+            lost++;
+        }
+    }
+
+    uint8_t count() const { return n; }
+    uint16_t overwritten() const { return lost; }
+
+    // k-th oldest sample, k < count()
+    const MinuteSample &at(uint8_t k) const { return samples[(head + k) % CAPACITY]; }
+
+private:
+    MinuteSample samples[CAPACITY];
+    uint8_t head;
+    uint8_t n;
+    uint16_t lost;
+};
+
+// Delta encoding for publishing. Each sample is
+//   minute | (flags & 3) << 6                      one byte
+//   power, current, voltage                        zigzag varints of the
+//                                                  change from the previous sample
+// with the first sample of a segment taken against zero, so every segment
+// decodes on its own. A steady load costs 4 bytes a minute.
+//
+// Encodes samples from first onwards into out for as long as whole samples
+// fit in maxBytes. Returns how many were encoded; *length gets the bytes used.
+uint8_t encodeProfile(const MinuteProfile &profile, uint8_t first,
+                      uint8_t *out, size_t maxBytes, size_t *length);
+
+// The reverse, for clients and tests. Returns the samples decoded, or 0 if
+// the data is malformed.
+size_t decodeProfile(const uint8_t *in, size_t length, MinuteSample *out, size_t maxSamples);
+
+#endif
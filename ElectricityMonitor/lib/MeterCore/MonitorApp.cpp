@@ -0,0 +1,1293 @@
+#include "MonitorApp.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "Base64.h"
+#include "EventLog.h"
+
+static const double DEGREES_PER_RADIAN = 57.29577951308232;
+
+// Room a record needs in publishBatch, so a record is never split across updates
+static const size_t MINUTE_REPLAY_BYTES = 256;
+static const size_t HOURLY_REPLAY_BYTES = 800;
+static const size_t ROLLUP_REPLAY_BYTES = 460;
+static const size_t PROFILE_REPLAY_BYTES = 400;
+static const size_t HEALTH_REPLAY_BYTES = 1400;
+static const size_t PACKET_REPLAY_BYTES = TelemetryPacketWriter::ENCODED_CAPACITY + 64;
+static size_t replayBytes(uint8_t type) {
+    return type == RECORD_HOURLY ? HOURLY_REPLAY_BYTES
+         : type == RECORD_ROLLUP ? ROLLUP_REPLAY_BYTES
+         : type == RECORD_PROFILE ? PROFILE_REPLAY_BYTES
+         : type == RECORD_HEALTH ? HEALTH_REPLAY_BYTES
+         : MINUTE_REPLAY_BYTES;
+}
+// Fields in the longest record, for the batch root each key carries under a building
+static const size_t MAX_RECORD_FIELDS = 20;
+
+// Warnings and errors go up with the next update under diagnostics/log/<sequence>
+static const size_t LOG_UPLOAD_BYTES = 192;
+static const uint8_t LOG_UPLOAD_MAX_LEVEL = EVENT_LOG_WARN;
+
+// remaining_units goes up with 6 decimals, so billing is in whole micro-kWh;
+// the rest waits in unbilledMws() for the next update
+static const uint64_t MWS_PER_MICRO_KWH = 3600;
+
+static uint64_t billableMws(uint64_t unbilledMws) {
+    return unbilledMws - unbilledMws % MWS_PER_MICRO_KWH;
+}
+
+// remaining_credit, in kobo, that billing billedMws in all has deducted.
+// Each update sends the difference this makes, so the 0.01 NGN rounding
+// never adds up.
+static int64_t billedKobo(uint64_t billedMws, float costPerKwh) {
+    return (int64_t)floor(mwsToKwh(billedMws) * costPerKwh * 100 + 1e-6);
+}
+
+// Local date as YYYYMMDD and the hour of epoch
+static uint32_t localDate(uint32_t epoch, uint8_t *hour) {
+    time_t seconds = epoch;
+    struct tm timeinfo;
+    localtime_r(&seconds, &timeinfo);
+    if (hour != nullptr) {
+        *hour = (uint8_t)timeinfo.tm_hour;
+    }
+    return (timeinfo.tm_year + 1900) * 10000 + (timeinfo.tm_mon + 1) * 100 + timeinfo.tm_mday;
+}
+
+MonitorApp::MonitorApp(MonitorPlatform &platform, ReadingQueue &readings, TelemetryLog &telemetryLog)
+    : platform(platform),
+      readingQueue(readings),
+      telemetryLog(telemetryLog),
+      sampleDropCounter(nullptr),
+      livePower(nullptr),
+      batchCarriesLog(false),
+      batchLogOffset(0),
+      batchBilledMws(0),
+      batchLogSeq(0),
+      batchCarriesPower(false),
+      batchPower(0),
+      uploadedLogSeq(0),
+      lastReplay(0),
+      batchHeldRecords(0),
+      heldCount(0),
+      packetEpoch(0),
+      packetLogOffset(0),
+      hourDemandW(0),
+      offlineMinuteOpen(false),
+      offlineEpoch(0),
+      offlineEnergyMws(0),
+      offlinePowerSec(0),
+      offlineCurrentSec(0),
+      offlineVoltageSec(0),
+      offlineSeconds(0),
+      offlineFlags(0),
+      lastCreditEvent(0),
+      cycleEpoch(0),
+      relayState(false),
+      heldRemainingUnits(false),
+      heldUnits(0),
+      consecutiveFirebaseErrors(0),
+      calibrationMailbox(nullptr),
+      lastCalibrationCheck(0),
+      calibrationChecked(false),
+      lastPassUs(0),
+      passTimed(false),
+      creditSentAt(0),
+      sampleDropsSeen(0) {
+    unitBasePath[0] = '\0';
+    creditPath[0] = '\0';
+    calibrationPath[0] = '\0';
+    cycleTimestamp[0] = '\0';
+}
+
+void MonitorApp::restore(const MonitorConfig &config) {
+    cfg = config;
+    if (cfg.publishUnderBuilding) {
+        char root[UpdateBatch::ROOT_CAPACITY];
+        unitKeyRoot(cfg.unitId, root, sizeof(root));
+        publishBatch.setRoot(root);
+        buildingPath(cfg.buildingId, unitBasePath, sizeof(unitBasePath));
+    } else {
+        publishBatch.setRoot("");
+        unitPath(cfg.buildingId, cfg.unitId, "", unitBasePath, sizeof(unitBasePath));
+    }
+    unitPath(cfg.buildingId, cfg.unitId, "remaining_units", creditPath, sizeof(creditPath));
+    unitPath(cfg.buildingId, cfg.unitId, "calibration", calibrationPath, sizeof(calibrationPath));
+
+    // The relay follows the saved balance from the start, not from the first credit check
+    loadLedger();
+    enforceCredit();
+    loadRollups();
+    loadCalibration();
+}
+
+void MonitorApp::begin() {
+    // Hours are the readings' own, so the first one opens the first hour;
+    // any taken before NTP syncs go into it
+    aggregator.reset();
+    aggregator.setListener(this);
+    hourProfile.clear();
+    hourDemandW = 0;
+
+    scheduler.configure(cfg.scheduler);
+    scheduler.begin(platform.nowMs());
+    publishPolicy.configure(cfg.publish);
+
+    // Credit is checked as soon as Firebase reports ready
+    scheduler.requestCreditCheck();
+}
+
+void MonitorApp::pass() {
+    // Pass to pass is the whole network task loop (FirebaseClient, the yield)
+    // and the gap between watchdog resets
+    uint32_t startUs = platform.nowUs();
+    if (passTimed) {
+        healthStats.loopUs.add(startUs - lastPassUs);
+    }
+    lastPassUs = startUs;
+    passTimed = true;
+
+    SchedulerInputs inputs;
+    inputs.wifiConnected = platform.wifiConnected();
+    inputs.firebaseReady = platform.firebaseReady();
+    // Not while an update that changes credit is in flight
+    inputs.creditCheckAllowed = !pendingUpdate.active;
+    inputs.readingQueued = !readingQueue.empty();
+    inputs.creditStreamLive = creditStreamLive();
+
+    switch (scheduler.poll(platform.nowMs(), inputs)) {
+    case ACTION_CONNECT:
+        LOG_WARN("WiFi still down - reconnecting");
+        healthStats.reconnects++;
+        platform.reconnect();
+        break;
+    case ACTION_LINK_UP: {
+        uint32_t ip = platform.localIp();
+        LOG_INFO("WiFi connected - IP %u.%u.%u.%u", ip & 0xFF, (ip >> 8) & 0xFF, (ip >> 16) & 0xFF, ip >> 24);
+        // The outage's readings went to the log; the next one goes up live
+        publishPolicy.reset();
+        break;
+    }
+    case ACTION_LINK_DOWN:
+        LOG_WARN("WiFi disconnected - metering continues offline");
+        healthStats.linkDrops++;
+        break;
+    case ACTION_CREDIT_REQUEST:
+        // creditAnswered() applies the answer; the scheduler gives up on it
+        // after creditTimeoutMs
+        creditSentAt = platform.nowMs();
+        platform.requestCredit(creditPath);
+        break;
+    case ACTION_CREDIT_TIMEOUT:
+        LOG_WARN("Credit check timed out");
+        healthStats.creditTimeouts++;
+        break;
+    case ACTION_STREAM_OPEN:
+        platform.openCreditStream(creditPath);
+        LOG_INFO("Credit stream opening...");
+        break;
+    case ACTION_SAMPLE:
+        sampleReading();
+        break;
+    case ACTION_ROLLOVER:
+        rollOverHour();
+        break;
+    case ACTION_PUBLISH:
+        publishReading();
+        break;
+    case ACTION_NONE:
+        break;
+    }
+
+    // A step in the load goes up now rather than with the next reading; then
+    // work through anything logged while we couldn't publish
+    if (scheduler.state() == STATE_IDLE) {
+        publishStep();
+        replayTelemetry();
+        checkCalibration();
+    }
+
+    updateStatusLed(inputs.wifiConnected);
+
+    uint32_t backlog = telemetryLog.pendingBytes();
+    if (backlog > healthStats.logBacklogMax) {
+        healthStats.logBacklogMax = backlog;
+    }
+    healthStats.passUs.add(platform.nowUs() - startUs);
+}
+
+// Firebase is reachable, though it may still be failing
+bool MonitorApp::canReachFirebase() {
+    return platform.wifiConnected() && platform.firebaseReady();
+}
+
+// A reading can go straight up only when the last update worked and none is
+// pending; otherwise it goes to the telemetry log and replayTelemetry() sends it
+bool MonitorApp::canPublish() {
+    return canReachFirebase() && consecutiveFirebaseErrors == 0 && !pendingUpdate.active;
+}
+
+bool MonitorApp::creditStreamLive() {
+    return lastCreditEvent != 0 && platform.nowMs() - lastCreditEvent < cfg.creditStreamLiveWindowMs;
+}
+
+// Steady on when connected, slow blink while offline, plus any event pattern
+void MonitorApp::updateStatusLed(bool connected) {
+    uint32_t now = platform.nowMs();
+    if (!connected && !statusLed.busy(now)) {
+        statusLed.blink(1, 500, now);
+    }
+    platform.setStatusLed(statusLed.levelAt(now));
+}
+
+void MonitorApp::loadLedger() {
+    LedgerState saved;
+    saved.creditedMws = platform.loadU64("ldgCreditMws", 0);
+    saved.consumedMws = platform.loadU64("ldgConsumeMws", 0);
+    saved.billedMws = platform.loadU64("ldgBilledMws", 0);
+
+    creditLedger.restore(saved);
+    LOG_INFO("Credit ledger restored - balance: %.3f kWh, unbilled: %.6f kWh",
+             CreditLedger::toKwh(creditLedger.balanceMws()),
+             CreditLedger::toKwh(creditLedger.unbilledMws()));
+}
+
+// Every change is saved straight away: credit is billing-critical and
+// NVS spreads the writes over its pages
+void MonitorApp::saveLedger() {
+    const LedgerState &state = creditLedger.state();
+    platform.saveU64("ldgCreditMws", state.creditedMws);
+    platform.saveU64("ldgConsumeMws", state.consumedMws);
+    platform.saveU64("ldgBilledMws", state.billedMws);
+}
+
+void MonitorApp::loadRollups() {
+    RollupTotals day;
+    RollupTotals month;
+    platform.loadBytes("rollDay", &day, sizeof(day));
+    platform.loadBytes("rollMonth", &month, sizeof(month));
+
+    dailyRollup.restore(day);
+    monthlyRollup.restore(month);
+    LOG_INFO("Rollups restored - day %lu: %.3f kWh, month %lu: %.3f kWh",
+             (unsigned long)day.period, day.energyKwh(),
+             (unsigned long)month.period, month.energyKwh());
+}
+
+// Saved once an hour, when an hour is added
+void MonitorApp::saveRollups() {
+    platform.saveBytes("rollDay", &dailyRollup.current(), sizeof(RollupTotals));
+    platform.saveBytes("rollMonth", &monthlyRollup.current(), sizeof(RollupTotals));
+}
+
+// The profile saved by the wizard or pushed from the RTDB, else the
+// configured one
+void MonitorApp::loadCalibration() {
+    CalibrationProfile saved;
+    if (platform.loadBytes("calProfile", &saved, sizeof(saved)) && saved.version == CalibrationProfile::VERSION) {
+        calibrationProfile = saved;
+        LOG_INFO("Calibration restored - %u voltage, %u current point(s)",
+                 (unsigned)saved.voltage.count, (unsigned)saved.current.count);
+    } else {
+        calibrationProfile = cfg.calibration;
+    }
+}
+
+bool MonitorApp::applyCalibration(const CalibrationProfile &profile, const char *source) {
+    if (profile == calibrationProfile) {
+        return true;
+    }
+    if (calibrationMailbox != nullptr && !calibrationMailbox->push(profile)) {
+        LOG_WARN("Calibration from %s not applied - the metering task hasn't taken the last one", source);
+        return false;
+    }
+    calibrationProfile = profile;
+    platform.saveBytes("calProfile", &calibrationProfile, sizeof(calibrationProfile));
+    // A warning so it goes up with the next update: every reading after it changes
+    LOG_WARN("Calibration from %s applied - %u voltage, %u current point(s)", source,
+             (unsigned)profile.voltage.count, (unsigned)profile.current.count);
+    return true;
+}
+
+// Tracked ADC offsets are saved once an hour (not every sample) to spare the
+// flash. Offsets as of the given reading; the engine itself belongs to the
+// metering task.
+void MonitorApp::saveOffsets(const MeterReading &reading) {
+    platform.saveFloat("iOffset", reading.currentOffset);
+    platform.saveFloat("vOffset", reading.voltageOffset);
+}
+
+// Local time of the reading, or millis() while the clock isn't set
+void MonitorApp::formatCycleTimestamp() {
+    if (formatTimestamp(cycleEpoch, cycleTimestamp, sizeof(cycleTimestamp)) == 0) {
+        LOG_DEBUG("Clock not set - timestamp from millis()");
+        snprintf(cycleTimestamp, sizeof(cycleTimestamp), "%lu", (unsigned long)platform.nowMs());
+    }
+}
+
+void MonitorApp::creditAnswered() {
+    healthStats.roundTripMs[RTT_CREDIT].add(platform.nowMs() - creditSentAt);
+    scheduler.creditAnswered();
+}
+
+// A profile the server doesn't have leaves the device's alone; a malformed
+// one is reported and ignored
+void MonitorApp::calibrationAnswered(const char *text) {
+    if (text[0] == '\0') {
+        return;
+    }
+    CalibrationProfile profile;
+    if (!parseCalibrationProfile(text, profile)) {
+        LOG_WARN("Calibration on the server is malformed - keeping the current one");
+        return;
+    }
+    if (!applyCalibration(profile, "Firebase")) {
+        calibrationChecked = false;   // ask again on the next pass
+    }
+}
+
+void MonitorApp::creditStreamEvent() {
+    lastCreditEvent = platform.nowMs();
+}
+
+void MonitorApp::creditStreamClosed() {
+    lastCreditEvent = 0;
+}
+
+// remaining_units from a poll or a stream event. Top-ups are taken from it
+// by delta against the ledger; while an update is in flight it is held
+// until that update is answered.
+void MonitorApp::applyRemainingUnits(double units, const char *source) {
+    LOG_INFO("Remaining units from %s: %.2f kWh", source, units);
+    if (pendingUpdate.active) {
+        heldRemainingUnits = true;
+        heldUnits = units;
+        return;
+    }
+    reconcileCredit(units);
+}
+
+void MonitorApp::reconcileCredit(double units) {
+    heldRemainingUnits = false;
+    int64_t delta = creditLedger.reconcile(CreditLedger::toMws(units));
+    if (delta != 0) {
+        saveLedger();
+        LOG_INFO("Credit %s by %.3f kWh", delta > 0 ? "topped up" : "corrected",
+                 CreditLedger::toKwh(delta > 0 ? delta : -delta));
+    }
+    enforceCredit();
+}
+
+// Relay on while the ledger has a balance, off the moment it runs out
+void MonitorApp::enforceCredit() {
+    bool shouldBeOn = creditLedger.hasCredit();
+
+    // Ensure hardware matches desired state
+    platform.setRelay(shouldBeOn);
+    if (shouldBeOn) {
+        if (!relayState) {
+            relayState = true;
+            LOG_INFO("Relay ON - power flowing to unit");
+            statusLed.blink(2, 100, platform.nowMs());
+        }
+    } else {
+        if (relayState) {
+            relayState = false;
+            LOG_WARN("Relay OFF - no credit, power disconnected");
+            statusLed.blink(3, 500, platform.nowMs());
+        } else {
+            // For debugging - confirm we actively set the pin low
+            LOG_DEBUG("Relay forced OFF (no credit)");
+        }
+    }
+
+    LOG_DEBUG("Relay state: %s | remaining: %.2f kWh",
+              relayState ? "ON" : "OFF",
+              CreditLedger::toKwh(creditLedger.balanceMws()));
+}
+
+// Sample step: pick up the metering task's reading - everything measured
+// since the last one, not a one-off snapshot. The scheduler only calls this
+// with a reading queued, and this task is the queue's only consumer.
+void MonitorApp::sampleReading() {
+    size_t waiting = readingQueue.size();
+    QueuedReading queued;
+    if (!readingQueue.pop(queued)) {
+        return;
+    }
+    if (waiting > healthStats.queueHighWater) {
+        healthStats.queueHighWater = (uint8_t)waiting;
+    }
+    if (queued.metering.periods > 0) {
+        healthStats.meteringUs.add(queued.metering.maxUs);
+    }
+    cycleReading = queued.reading;
+    cycleEpoch = queued.epoch;
+    formatCycleTimestamp();
+
+    LOG_DEBUG("Reading: %.3f A, %.2f V, %.2f W",
+              cycleReading.currentRms, cycleReading.voltageRms, cycleReading.realPower);
+    LOG_DEBUG("Apparent %.2f VA, PF %.2f, %.1f deg",
+              cycleReading.apparentPower, cycleReading.powerFactor, cycleReading.phaseAngleDeg);
+    LOG_DEBUG("Energy %.6f kWh over %.1f s (%u samples)",
+              cycleReading.energyKwh, cycleReading.durationSec, cycleReading.samples);
+    LOG_DEBUG("Line %.2f Hz (%u/%u windows cycle-synced)",
+              cycleReading.lineFrequencyHz, cycleReading.syncedWindows, cycleReading.windows);
+    LOG_DEBUG("ADC offsets - current: %.2f, voltage: %.2f",
+              cycleReading.currentOffset, cycleReading.voltageOffset);
+    uint32_t drops = sampleDropCounter != nullptr ? sampleDropCounter->load(std::memory_order_relaxed) : 0;
+    if (drops > 0) {
+        LOG_WARN("Sample ring overruns so far: %u", drops);
+        healthStats.sampleDrops += drops - sampleDropsSeen;
+        sampleDropsSeen = drops;
+    }
+}
+
+// Rollover step: the reading into its minute, quarter, hour and day, which
+// closes whichever of them it is past (see bucketClosed())
+void MonitorApp::rollOverHour() {
+    beginBatch();
+    aggregator.add(cycleEpoch, cycleReading, relayState ? MINUTE_RELAY_ON : 0);
+
+    LOG_DEBUG("Hourly buffer - samples: %u, energy: %.6f kWh",
+              (unsigned)aggregator.current(AGG_HOUR).samples,
+              mwsToKwh(aggregator.current(AGG_HOUR).energyMws));
+}
+
+// Empty buckets - a gap in the readings, up to two days of them after the
+// clock stalled - are skipped: nothing to log or save, so catching up on a
+// gap costs the aggregator's bookkeeping and no flash writes.
+void MonitorApp::bucketClosed(AggregateLevel level, const AggregateBucket &bucket) {
+    if (bucket.empty()) {
+        return;
+    }
+    switch (level) {
+    case AGG_MINUTE:
+        addProfileMinute(bucket);
+        break;
+    case AGG_QUARTER:
+        // A quarter closes before its hour does, so the hour's last counts
+        if (bucket.avgPower() > hourDemandW) {
+            hourDemandW = bucket.avgPower();
+        }
+        break;
+    case AGG_HOUR:
+        closeHour(bucket);
+        break;
+    default:
+        // Days are the daily rollup's, fed by the hours
+        break;
+    }
+}
+
+// A minute with readings is one profile sample, however many it took
+void MonitorApp::addProfileMinute(const AggregateBucket &minute) {
+    time_t start = minute.start;
+    struct tm timeinfo;
+    localtime_r(&start, &timeinfo);
+    MinuteSample sample;
+    sample.minute = (uint8_t)timeinfo.tm_min;
+    sample.flags = minute.flags;
+    sample.powerQw = toFixedU16(minute.avgPower(), 4);
+    sample.currentMa = toFixedU16(minute.avgCurrent(), 1000);
+    sample.voltageDv = toFixedU16(minute.avgVoltage(), 10);
+    hourProfile.add(sample);
+}
+
+// Publish step: send the reading, or log it if we can't right now
+void MonitorApp::publishReading() {
+    const MeterReading &reading = cycleReading;
+
+    // Deduct energy only if relay ON. The ledger takes it now, online or
+    // not, and the relay is cut locally if that was the last of the credit.
+    bool drawnOnCredit = relayState;
+    if (drawnOnCredit) {
+        creditLedger.consume(reading.energyMws);
+        saveLedger();
+        if (!creditLedger.hasCredit()) {
+            enforceCredit();
+        }
+    } else {
+        LOG_DEBUG("Relay OFF - not deducting energy (still tracking consumption)");
+    }
+
+    if (!canPublish()) {
+        logMinuteReading(reading, cycleEpoch, drawnOnCredit);
+        return;
+    }
+    // Back online: the minute being logged is as complete as it gets
+    closeOfflineMinute();
+
+    // Realtime data if the policy wants it, plus whatever is waiting in the
+    // log (e.g. the hourly record written at rollover) so it all lands in
+    // one update. Billing goes with any update, but doesn't make one: a
+    // steady load's consumption waits for the next change or heartbeat.
+    if (publishPolicy.readingDue(reading.realPower, platform.nowMs())) {
+        publishBatch.setPrefix("");
+        publishBatch.add("power", reading.realPower, 2);
+        publishBatch.add("timestamp", cycleTimestamp);
+        batchCarriesPower = true;
+        batchPower = reading.realPower;
+    }
+
+    queueLoggedRecords();
+    queueEventLog();
+    if (!publishBatch.empty()) {
+        queueBilling();
+    }
+
+    sendBatch("cycleUpdate");
+}
+
+// Idle step: the metering task's live power has moved by a step since the
+// last value published, e.g. a kettle or a heater switching
+void MonitorApp::publishStep() {
+    if (livePower == nullptr || !canPublish()) {
+        return;
+    }
+    float power = livePower->load(std::memory_order_relaxed);
+    if (!publishPolicy.stepDue(power, platform.nowMs())) {
+        return;
+    }
+
+    char timestamp[TIMESTAMP_CHARS];
+    if (formatTimestamp(platform.epoch(), timestamp, sizeof(timestamp)) == 0) {
+        snprintf(timestamp, sizeof(timestamp), "%lu", (unsigned long)platform.nowMs());
+    }
+    LOG_DEBUG("Load stepped from %.1f W to %.1f W", publishPolicy.lastPower(), power);
+
+    beginBatch();
+    publishBatch.setPrefix("");
+    publishBatch.add("power", power, 2);
+    publishBatch.add("timestamp", timestamp);
+    batchCarriesPower = true;
+    batchPower = power;
+    queueBilling();
+    sendBatch("stepUpdate");
+}
+
+// Start a new update: empty batch, nothing to commit or bill yet
+void MonitorApp::beginBatch() {
+    publishBatch.clear();
+    batchCarriesLog = false;
+    batchLogOffset = 0;
+    batchBilledMws = 0;
+    batchLogSeq = uploadedLogSeq;
+    batchCarriesPower = false;
+    batchPower = 0;
+    batchHeldRecords = 0;
+}
+
+// Push everything queued in publishBatch as one multi-location update
+void MonitorApp::sendBatch(const char *uid) {
+    if (publishBatch.empty()) {
+        beginBatch();
+        return;
+    }
+    if (publishBatch.overflowed()) {
+        LOG_WARN("Update batch full - some fields were dropped");
+    }
+
+    // The answer can come back from inside sendUpdate() (the simulation
+    // answers some requests at once), so the update is pending first
+    pendingUpdate.active = true;
+    pendingUpdate.uid = uid;
+    pendingUpdate.carriesLog = batchCarriesLog;
+    pendingUpdate.logOffset = batchLogOffset;
+    pendingUpdate.billedMws = batchBilledMws;
+    pendingUpdate.logSeq = batchLogSeq;
+    pendingUpdate.carriesPower = batchCarriesPower;
+    pendingUpdate.power = batchPower;
+    pendingUpdate.heldRecords = batchHeldRecords;
+    pendingUpdate.sentAt = platform.nowMs();
+
+    LOG_DEBUG("%u fields sent in one update (%u bytes)",
+              publishBatch.fieldCount(), publishBatch.length());
+    platform.sendUpdate(unitBasePath, publishBatch.json(), uid);
+    beginBatch();
+}
+
+// Called from updateAnswered(), or on timeout with acknowledged = false.
+// Unacknowledged log records stay uncommitted and unbilled energy stays
+// unbilled; both go out again with the next update.
+void MonitorApp::finishPendingUpdate(bool acknowledged) {
+    if (acknowledged) {
+        if (pendingUpdate.carriesLog && !telemetryLog.commit(pendingUpdate.logOffset)) {
+            LOG_ERROR("Failed to commit the telemetry log cursor");
+        }
+        uploadedLogSeq = pendingUpdate.logSeq;
+        if (pendingUpdate.billedMws > 0) {
+            creditLedger.billed(pendingUpdate.billedMws);
+            saveLedger();
+        }
+        if (pendingUpdate.carriesPower) {
+            publishPolicy.published(pendingUpdate.power, platform.nowMs());
+        }
+        dropHeldRecords(pendingUpdate.heldRecords);
+    }
+    pendingUpdate.active = false;
+
+    if (heldRemainingUnits) {
+        reconcileCredit(heldUnits);
+    }
+}
+
+void MonitorApp::updateAnswered(const char *uid, bool ok, int errorCode) {
+    bool pending = pendingUpdate.active && strcmp(uid, pendingUpdate.uid) == 0;
+    if (pending) {
+        uint8_t kind = roundTripKind(uid);
+        if (kind < RTT_KINDS) {
+            healthStats.roundTripMs[kind].add(platform.nowMs() - pendingUpdate.sentAt);
+        }
+    }
+
+    if (ok) {
+        consecutiveFirebaseErrors = 0;
+        if (pending) finishPendingUpdate(true);
+        // Quick LED blink on successful write
+        statusLed.blink(1, 50, platform.nowMs());
+        return;
+    }
+
+    consecutiveFirebaseErrors++;
+    healthStats.firebaseErrors++;
+    if (consecutiveFirebaseErrors > healthStats.maxConsecutiveErrors) {
+        healthStats.maxConsecutiveErrors = (uint16_t)consecutiveFirebaseErrors;
+    }
+    if (pending) finishPendingUpdate(false);
+    LOG_ERROR("Firebase error #%d (code %d)", consecutiveFirebaseErrors, errorCode);
+
+    if (consecutiveFirebaseErrors >= cfg.maxFirebaseErrors) {
+        LOG_ERROR("Too many Firebase errors - reinitializing");
+        platform.restartFirebase();
+        scheduler.requestCreditCheck();
+        consecutiveFirebaseErrors = 0;
+    }
+
+    // LED error pattern
+    statusLed.blink(3, 200, platform.nowMs());
+}
+
+// Everything drawn on credit since the last acknowledged update, deducted
+// with server-side increments so a dashboard top-up landing in between is
+// never overwritten
+void MonitorApp::queueBilling() {
+    uint64_t billable = billableMws(creditLedger.unbilledMws());
+    if (billable == 0) {
+        return;
+    }
+    double drawnKwh = CreditLedger::toKwh(billable);
+    uint64_t billedBefore = creditLedger.state().billedMws;
+    int64_t kobo = billedKobo(billedBefore + billable, cfg.costPerKwh) -
+                   billedKobo(billedBefore, cfg.costPerKwh);
+
+    publishBatch.setPrefix("");
+    publishBatch.addIncrement("remaining_units", -drawnKwh, 6);
+    if (kobo > 0) {
+        publishBatch.addIncrement("remaining_credit", -kobo / 100.0, 2);
+    }
+    batchBilledMws = billable;
+
+    float remainingUnits = CreditLedger::toKwh(creditLedger.balanceMws());
+    LOG_INFO("Billing %.6f kWh - remaining: %.3f kWh (NGN %.2f)",
+             drawnKwh, remainingUnits, remainingUnits * cfg.costPerKwh);
+}
+
+// Warnings and errors logged since the last acknowledged upload, as text
+// under diagnostics/log/<sequence>, for as long as they fit. Entries the
+// ring overwrote before they could go up are skipped.
+void MonitorApp::queueEventLog() {
+    if (!cfg.uploadEventLog) {
+        return;
+    }
+    uint32_t oldest = eventLog.total() - eventLog.count();
+    uint32_t seq = batchLogSeq > oldest ? batchLogSeq : oldest;
+    char key[PATH_CHARS];
+    char line[160];
+
+    while (seq < eventLog.total() && publishBatch.length() + LOG_UPLOAD_BYTES <= UpdateBatch::CAPACITY) {
+        const LogEntry &entry = eventLog.at(seq - oldest);
+        if (entry.level <= LOG_UPLOAD_MAX_LEVEL) {
+            snprintf(key, sizeof(key), "diagnostics/log/%lu", (unsigned long)seq);
+            EventLog::format(entry, line, sizeof(line));
+            publishBatch.add(key, line);
+        }
+        seq++;
+    }
+    batchLogSeq = seq;
+}
+
+// A warning or error hasn't gone up yet
+bool MonitorApp::eventLogWaiting() {
+    if (!cfg.uploadEventLog) {
+        return false;
+    }
+    uint32_t oldest = eventLog.total() - eventLog.count();
+    for (uint32_t seq = uploadedLogSeq > oldest ? uploadedLogSeq : oldest; seq < eventLog.total(); seq++) {
+        if (eventLog.at(seq - oldest).level <= LOG_UPLOAD_MAX_LEVEL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A reading we couldn't publish: keep it in the log until replayTelemetry()
+// can. Around a load step the metering task closes readings every few
+// seconds; those in the same minute are merged, time-weighted, so the
+// minute goes up as one history/minutes/ record with all of its energy.
+// The minute is logged once a reading from a later one arrives, or the
+// link is back. A reboot loses only the open minute's history; its
+// energy is already in the ledger.
+void MonitorApp::logMinuteReading(const MeterReading &reading, uint32_t epoch, bool drawnOnCredit) {
+    if (offlineMinuteOpen && (epoch == 0 || epoch / 60 != offlineEpoch / 60)) {
+        closeOfflineMinute();
+    }
+    offlineMinuteOpen = true;
+    offlineEpoch = epoch;
+    offlineEnergyMws += reading.energyMws;
+    offlinePowerSec += reading.realPower * reading.durationSec;
+    offlineCurrentSec += reading.currentRms * reading.durationSec;
+    offlineVoltageSec += reading.voltageRms * reading.durationSec;
+    offlineSeconds += reading.durationSec;
+    if (drawnOnCredit) {
+        offlineFlags |= MINUTE_RELAY_ON;
+    }
+    // Without the time there's no minute to share
+    if (epoch == 0) {
+        closeOfflineMinute();
+    }
+}
+
+void MonitorApp::closeOfflineMinute() {
+    if (!offlineMinuteOpen) {
+        return;
+    }
+    float seconds = offlineSeconds > 0 ? offlineSeconds : 1;
+    MinuteRecord record;
+    record.epoch = offlineEpoch;
+    record.energyUwh = mwsToUwh(offlineEnergyMws);
+    record.powerDw = toFixedU32(offlinePowerSec / seconds, 10);
+    record.currentMa = toFixedU16(offlineCurrentSec / seconds, 1000);
+    record.voltageDv = toFixedU16(offlineVoltageSec / seconds, 10);
+    record.flags = offlineFlags;
+
+    offlineMinuteOpen = false;
+    offlineEnergyMws = 0;
+    offlinePowerSec = 0;
+    offlineCurrentSec = 0;
+    offlineVoltageSec = 0;
+    offlineSeconds = 0;
+    offlineFlags = 0;
+
+    uint8_t payload[MinuteRecord::ENCODED_SIZE];
+    uint8_t length = record.encode(payload);
+    if (telemetryLog.append(RECORD_MINUTE, payload, length)) {
+        LOG_DEBUG("Offline - reading logged (%u bytes waiting)", telemetryLog.pendingBytes());
+    } else {
+        LOG_ERROR("Offline and the telemetry log is full or unavailable - reading dropped");
+    }
+}
+
+// Add logged records to publishBatch, oldest first, for as long as they fit
+void MonitorApp::queueLoggedRecords() {
+    uint32_t offset = telemetryLog.cursor();
+    TelemetryFrame frame;
+    historyPacket.clear();
+    // Batch room held for the packet once it has a record
+    size_t packetRoom = 0;
+
+    while (true) {
+        uint32_t next = offset;
+        if (telemetryLog.read(next, &frame, 1) != 1) {
+            break;
+        }
+        bool packed = cfg.packedHistory && (frame.type == RECORD_MINUTE || frame.type == RECORD_HOURLY ||
+                                             frame.type == RECORD_ROLLUP);
+        size_t needed = replayBytes(frame.type);
+        needed += publishBatch.rootLength() * MAX_RECORD_FIELDS;
+        if (packed) {
+            if (!historyPacket.fits(frame.type, frame.length)) {
+                break;
+            }
+            needed = packetRoom > 0 ? 0 : PACKET_REPLAY_BYTES + publishBatch.rootLength();
+        }
+        if (publishBatch.length() + packetRoom + needed > UpdateBatch::CAPACITY) {
+            break;
+        }
+
+        // A record we can't decode is skipped rather than blocking the queue
+        if (packed) {
+            if (packRecord(frame, offset)) {
+                packetRoom = PACKET_REPLAY_BYTES + publishBatch.rootLength();
+            }
+        } else {
+            queueRecord(frame);
+        }
+        offset = next;
+        batchCarriesLog = true;
+    }
+
+    // Then the held records, oldest first, behind everything logged before them
+    while (batchHeldRecords < heldCount) {
+        const TelemetryFrame &held = heldRecords[batchHeldRecords];
+        size_t needed = replayBytes(held.type) + publishBatch.rootLength() * MAX_RECORD_FIELDS;
+        if (publishBatch.length() + packetRoom + needed > UpdateBatch::CAPACITY) {
+            break;
+        }
+        queueRecord(held);
+        batchHeldRecords++;
+    }
+
+    queuePacket();
+    batchLogOffset = offset;
+    publishBatch.setPrefix("");
+}
+
+// One record's fields into publishBatch, if it decodes
+void MonitorApp::queueRecord(const TelemetryFrame &frame) {
+    if (frame.type == RECORD_MINUTE) {
+        MinuteRecord record;
+        if (record.decode(frame.payload, frame.length)) {
+            queueMinuteRecord(record);
+        }
+    } else if (frame.type == RECORD_HOURLY) {
+        HourlyRecord record;
+        if (record.decode(frame.payload, frame.length)) {
+            queueHourlyRecord(record);
+        }
+    } else if (frame.type == RECORD_ROLLUP) {
+        RollupRecord record;
+        if (record.decode(frame.payload, frame.length)) {
+            queueRollupRecord(record);
+        }
+    } else if (frame.type == RECORD_PROFILE) {
+        ProfileRecord record;
+        if (record.decode(frame.payload, frame.length)) {
+            queueProfileRecord(record);
+        }
+    } else if (frame.type == RECORD_HEALTH) {
+        HealthRecord record;
+        if (record.decode(frame.payload, frame.length)) {
+            queueHealthRecord(record);
+        }
+    }
+}
+
+// A record the telemetry log wouldn't take, held until an update carrying it
+// is acknowledged. When they don't all fit the oldest goes.
+void MonitorApp::holdRecord(uint8_t type, const uint8_t *payload, uint8_t length) {
+    if (heldCount == HELD_RECORDS) {
+        LOG_ERROR("Telemetry log unavailable and %u records held - the oldest dropped", (unsigned)HELD_RECORDS);
+        dropHeldRecords(1);
+        // It was the first of any the update in flight carries
+        if (pendingUpdate.heldRecords > 0) {
+            pendingUpdate.heldRecords--;
+        }
+    }
+    TelemetryFrame &frame = heldRecords[heldCount++];
+    frame.type = type;
+    frame.length = length;
+    memcpy(frame.payload, payload, length);
+}
+
+void MonitorApp::dropHeldRecords(uint8_t count) {
+    if (count > heldCount) {
+        count = heldCount;
+    }
+    memmove(heldRecords, heldRecords + count, (heldCount - count) * sizeof(TelemetryFrame));
+    heldCount -= count;
+}
+
+// Add a logged record to historyPacket as it is, once it decodes. A minute
+// without a timestamp is dropped as it is from the JSON fields.
+bool MonitorApp::packRecord(const TelemetryFrame &frame, uint32_t logOffset) {
+    uint32_t epoch = 0;
+    if (frame.type == RECORD_MINUTE) {
+        MinuteRecord record;
+        if (!record.decode(frame.payload, frame.length) || record.epoch == 0) return false;
+        epoch = record.epoch;
+    } else if (frame.type == RECORD_HOURLY) {
+        HourlyRecord record;
+        if (!record.decode(frame.payload, frame.length)) return false;
+        epoch = record.savedAt;
+    } else {
+        RollupRecord record;
+        if (!record.decode(frame.payload, frame.length)) return false;
+        epoch = record.savedAt;
+    }
+    if (historyPacket.empty()) {
+        packetEpoch = epoch;
+        packetLogOffset = logOffset;
+    }
+    return historyPacket.add(frame.type, frame.payload, frame.length);
+}
+
+// historyPacket, base64 under history/packed/<date>/<epoch>-<log offset>
+void MonitorApp::queuePacket() {
+    if (historyPacket.empty()) {
+        return;
+    }
+    char path[PATH_CHARS];
+    char key[24];
+    packedPath(packetEpoch, path, sizeof(path));
+    snprintf(key, sizeof(key), "%lu-%lu", (unsigned long)packetEpoch, (unsigned long)packetLogOffset);
+
+    char encoded[TelemetryPacketWriter::ENCODED_CAPACITY];
+    historyPacket.encode(encoded, sizeof(encoded));
+    publishBatch.setPrefix(path);
+    publishBatch.add(key, encoded);
+    publishBatch.setPrefix("");
+    LOG_DEBUG("%u records packed in %u bytes", (unsigned)historyPacket.records(),
+              (unsigned)historyPacket.length());
+    historyPacket.clear();
+}
+
+// Background drainer: one batch of logged records every replayIntervalMs
+// while Firebase is reachable. It also probes a failing connection, since
+// readings aren't published directly until an update succeeds again.
+void MonitorApp::replayTelemetry() {
+    if (pendingUpdate.active) {
+        if (platform.nowMs() - pendingUpdate.sentAt >= cfg.updateAckTimeoutMs) {
+            LOG_WARN("No answer to the last update - its records will be replayed");
+            healthStats.ackTimeouts++;
+            finishPendingUpdate(false);
+        }
+        return;
+    }
+    // Unbilled energy alone waits for the next published reading, unless
+    // every reading is published anyway
+    bool billingWaiting = billableMws(creditLedger.unbilledMws()) > 0 && !cfg.publish.enabled;
+    if ((telemetryLog.empty() && heldCount == 0 && !billingWaiting && !eventLogWaiting()) ||
+        !canReachFirebase()) {
+        return;
+    }
+    if (platform.nowMs() - lastReplay < cfg.replayIntervalMs) {
+        return;
+    }
+    lastReplay = platform.nowMs();
+
+    beginBatch();
+    queueLoggedRecords();
+    queueBilling();
+    queueEventLog();
+    LOG_DEBUG("Replaying logged telemetry (%u bytes waiting)", telemetryLog.pendingBytes());
+    sendBatch("replayUpdate");
+}
+
+// Ask for <unit>/calibration once Firebase is reachable after boot, then
+// every calibrationCheckIntervalMs
+void MonitorApp::checkCalibration() {
+    if (!canReachFirebase()) {
+        return;
+    }
+    uint32_t now = platform.nowMs();
+    if (calibrationChecked && now - lastCalibrationCheck < cfg.calibrationCheckIntervalMs) {
+        return;
+    }
+    calibrationChecked = true;
+    lastCalibrationCheck = now;
+    platform.requestCalibration(calibrationPath);
+}
+
+// Fields of a logged minute under history/minutes/<date>/<hour>/<minute>/.
+// Its energy was already taken by the ledger when it was read.
+void MonitorApp::queueMinuteRecord(const MinuteRecord &record) {
+    // Without a timestamp there is nowhere to file it
+    char path[PATH_CHARS];
+    if (record.epoch != 0 && minutePath(record.epoch, path, sizeof(path)) > 0) {
+        publishBatch.setPrefix(path);
+        publishBatch.add("energy", record.energyKwh(), 6);
+        publishBatch.add("power", record.powerDw / 10.0f, 1);
+        publishBatch.add("current", record.currentMa / 1000.0f, 3);
+        publishBatch.add("voltage", record.voltageDv / 10.0f, 1);
+        publishBatch.setPrefix("");
+    }
+}
+
+// Fields of a finished hour under history/hourly/<date>/<hour>/
+void MonitorApp::queueHourlyRecord(const HourlyRecord &record) {
+    char savedAt[TIMESTAMP_CHARS];
+    formatTimestamp(record.savedAt, savedAt, sizeof(savedAt));
+
+    float avgPower = record.avgPowerDw / 10.0f;
+    float peakPower = record.peakPowerDw / 10.0f;
+    float powerFactor = record.powerFactorPermille / 1000.0f;
+    float phaseAngle = record.avgApparentDva > 0 ? acos(powerFactor) * DEGREES_PER_RADIAN : 0;
+
+    char path[PATH_CHARS];
+    hourlyPath(record.date, record.hour, path, sizeof(path));
+
+    publishBatch.setPrefix(path);
+    publishBatch.add("energy", record.energyKwh(), 6);
+    publishBatch.add("avgPower", avgPower, 2);
+    publishBatch.add("peakPower", peakPower, 2);
+    publishBatch.add("avgCurrent", record.avgCurrentMa / 1000.0f, 3);
+    publishBatch.add("samples", (int32_t)record.samples);
+    publishBatch.add("avgApparentPower", record.avgApparentDva / 10.0f, 2);
+    publishBatch.add("powerFactor", powerFactor, 3);
+    publishBatch.add("phaseAngle", phaseAngle, 1);
+    publishBatch.add("savedAt", savedAt);
+    publishBatch.setPrefix("");
+}
+
+// One part of an hour's minute profile, base64 under
+// history/hourly/<date>/<hour>/profile/<part>
+void MonitorApp::queueProfileRecord(const ProfileRecord &record) {
+    char path[PATH_CHARS];
+    profilePath(record.date, record.hour, path, sizeof(path));
+    char part[4];
+    snprintf(part, sizeof(part), "%u", record.part);
+
+    char encoded[(ProfileRecord::MAX_DATA + 2) / 3 * 4 + 1];
+    base64Encode(record.data, record.length, encoded, sizeof(encoded));
+    publishBatch.setPrefix(path);
+    publishBatch.add(part, encoded);
+    publishBatch.setPrefix("");
+}
+
+// Day or month totals under history/daily/<date>/ or history/monthly/<month>/
+void MonitorApp::queueRollupRecord(const RollupRecord &record) {
+    const RollupTotals &totals = record.totals;
+    char path[PATH_CHARS];
+    rollupPath(record.kind, totals.period, path, sizeof(path));
+
+    char updatedAt[TIMESTAMP_CHARS];
+    formatTimestamp(record.savedAt, updatedAt, sizeof(updatedAt));
+
+    float energy = totals.energyKwh();
+    publishBatch.setPrefix(path);
+    publishBatch.add("energy", energy, 6);
+    publishBatch.add("cost", energy * cfg.costPerKwh, 2);
+    publishBatch.add("avgPower", totals.avgPowerW(), 2);
+    publishBatch.add("peakPower", totals.peakPowerW(), 2);
+    publishBatch.add("peakDemand", totals.peakDemandW(), 2);
+    publishBatch.add("samples", (int32_t)totals.samples);
+    publishBatch.add("updatedAt", updatedAt);
+    publishBatch.setPrefix("");
+}
+
+// A latency summary as one field, "count,p50,p90,p99,max"
+static void addSummary(UpdateBatch &batch, const char *key, const LatencySummary &summary) {
+    char value[64];
+    snprintf(value, sizeof(value), "%lu,%lu,%lu,%lu,%lu",
+             (unsigned long)summary.count, (unsigned long)summary.p50, (unsigned long)summary.p90,
+             (unsigned long)summary.p99, (unsigned long)summary.max);
+    batch.add(key, value);
+}
+
+// An hour's health under diagnostics/health/<date>/<hour>/. Round trips
+// nothing was sent for are left out.
+void MonitorApp::queueHealthRecord(const HealthRecord &record) {
+    char path[PATH_CHARS];
+    healthPath(record.date, record.hour, path, sizeof(path));
+    char savedAt[TIMESTAMP_CHARS];
+    formatTimestamp(record.savedAt, savedAt, sizeof(savedAt));
+
+    uint32_t slowestMs = record.loopUs.max / 1000;
+    int32_t headroomMs = slowestMs < cfg.watchdogTimeoutMs ? (int32_t)(cfg.watchdogTimeoutMs - slowestMs) : 0;
+
+    publishBatch.setPrefix(path);
+    addSummary(publishBatch, "loopUs", record.loopUs);
+    addSummary(publishBatch, "passUs", record.passUs);
+    addSummary(publishBatch, "meteringUs", record.meteringUs);
+    for (uint8_t kind = 0; kind < RTT_KINDS; kind++) {
+        if (record.roundTripMs[kind].count > 0) {
+            char key[24];
+            snprintf(key, sizeof(key), "rttMs/%s", roundTripName(kind));
+            addSummary(publishBatch, key, record.roundTripMs[kind]);
+        }
+    }
+    publishBatch.add("wdtHeadroomMs", headroomMs);
+    publishBatch.add("heapFree", (int32_t)record.heapFree);
+    publishBatch.add("heapLowWater", (int32_t)record.heapLowWater);
+    publishBatch.add("logBacklog", (int32_t)record.logBacklogMax);
+    publishBatch.add("sampleDrops", (int32_t)record.sampleDrops);
+    publishBatch.add("queueHighWater", (int32_t)record.queueHighWater);
+    publishBatch.add("firebaseErrors", (int32_t)record.firebaseErrors);
+    publishBatch.add("maxConsecutiveErrors", (int32_t)record.maxConsecutiveErrors);
+    publishBatch.add("ackTimeouts", (int32_t)record.ackTimeouts);
+    publishBatch.add("creditTimeouts", (int32_t)record.creditTimeouts);
+    publishBatch.add("reconnects", (int32_t)record.reconnects);
+    publishBatch.add("linkDrops", (int32_t)record.linkDrops);
+    publishBatch.add("savedAt", savedAt);
+    publishBatch.setPrefix("");
+}
+
+// A finished hour with readings: its record, profile and health, and into
+// the day and month. An hour without any has no record - the gap in
+// history/hourly/ is the outage.
+void MonitorApp::closeHour(const AggregateBucket &hour) {
+    HourlyRecord record;
+    logHour(hour, &record);
+    logProfile(record.date, record.hour);
+    hourProfile.clear();
+    rollUpHour(record, hour.energyMws, (uint32_t)(hour.seconds + 0.5f), hourDemandW);
+    hourDemandW = 0;
+    logHealth(record.date, record.hour);
+    saveOffsets(cycleReading);
+}
+
+// The hourly record for hour, into the telemetry log
+void MonitorApp::logHour(const AggregateBucket &hour, HourlyRecord *record) {
+    uint8_t hourOfDay = 0;
+    uint32_t date = localDate(hour.start, &hourOfDay);
+
+    // Hourly power factor from the totals so heavy-load minutes weigh more
+    float powerFactor = 0;
+    if (hour.apparentSec > 0) {
+        powerFactor = hour.powerSec / hour.apparentSec;
+        if (powerFactor > 1) powerFactor = 1;
+    }
+
+    LOG_INFO("Saving hour %lu %02u:00 - %.6f kWh, %u samples",
+             (unsigned long)date, (unsigned)hourOfDay, mwsToKwh(hour.energyMws), (unsigned)hour.samples);
+    LOG_DEBUG("Avg %.2f W, peak %.2f W, avg %.3f A", hour.avgPower(), hour.peakPower, hour.avgCurrent());
+    LOG_DEBUG("Avg apparent %.2f VA, PF %.2f (%.1f deg)", hour.avgApparentPower(), powerFactor,
+              acos(powerFactor) * DEGREES_PER_RADIAN);
+
+    record->date = date;
+    record->hour = hourOfDay;
+    record->samples = (uint16_t)hour.samples;
+    record->energyMwh = mwsToMwh(hour.energyMws);
+    record->avgPowerDw = toFixedU32(hour.avgPower(), 10);
+    record->peakPowerDw = toFixedU32(hour.peakPower, 10);
+    record->avgApparentDva = toFixedU32(hour.avgApparentPower(), 10);
+    record->avgCurrentMa = toFixedU16(hour.avgCurrent(), 1000);
+    record->powerFactorPermille = toFixedU16(powerFactor, 1000);
+    record->savedAt = platform.epoch();
+
+    uint8_t payload[HourlyRecord::ENCODED_SIZE];
+    uint8_t length = record->encode(payload);
+    if (telemetryLog.append(RECORD_HOURLY, payload, length)) {
+        LOG_DEBUG("Hourly data written to the telemetry log");
+    } else {
+        LOG_WARN("Telemetry log unavailable - hourly data held for the next update");
+        holdRecord(RECORD_HOURLY, payload, length);
+    }
+}
+
+void MonitorApp::logProfile(uint32_t date, uint8_t hour) {
+    const MinuteProfile &profile = hourProfile;
+    if (profile.overwritten() > 0) {
+        LOG_WARN("Minute profile overflowed - %u oldest readings dropped", profile.overwritten());
+    }
+
+    ProfileRecord record;
+    record.date = date;
+    record.hour = hour;
+    uint8_t first = 0;
+    while (first < profile.count()) {
+        size_t length = 0;
+        uint8_t encoded = encodeProfile(profile, first, record.data, ProfileRecord::MAX_DATA, &length);
+        if (encoded == 0) {
+            break;
+        }
+        record.length = (uint8_t)length;
+
+        uint8_t payload[ProfileRecord::HEADER_SIZE + ProfileRecord::MAX_DATA];
+        uint8_t size = record.encode(payload);
+        if (!telemetryLog.append(RECORD_PROFILE, payload, size)) {
+            holdRecord(RECORD_PROFILE, payload, size);
+        }
+        first += encoded;
+        record.part++;
+    }
+    LOG_DEBUG("Minute profile: %u readings in %u part(s)", profile.count(), record.part);
+}
+
+// Add the finished hour to the day and month, then log both totals so they
+// reach Firebase the same way the hour does. demandW is the hour's busiest
+// quarter hour; the day's and month's peak demand is the largest of them.
+void MonitorApp::rollUpHour(const HourlyRecord &hour, uint64_t energyMws, uint32_t seconds, float demandW) {
+    uint32_t demandDw = toFixedU32(demandW, 10);
+    if (dailyRollup.add(hour.date, energyMws, seconds, hour.peakPowerDw, demandDw, hour.samples)) {
+        LOG_INFO("Started daily totals for %lu", (unsigned long)hour.date);
+    }
+    if (monthlyRollup.add(hour.date / 100, energyMws, seconds, hour.peakPowerDw, demandDw, hour.samples)) {
+        LOG_INFO("Started monthly totals for %lu", (unsigned long)(hour.date / 100));
+    }
+    saveRollups();
+
+    RollupRecord day;
+    day.kind = ROLLUP_DAY;
+    day.totals = dailyRollup.current();
+    day.savedAt = hour.savedAt;
+    RollupRecord month = day;
+    month.kind = ROLLUP_MONTH;
+    month.totals = monthlyRollup.current();
+
+    logRollupRecord(day);
+    logRollupRecord(month);
+    LOG_INFO("Day: %.6f kWh (NGN %.2f) | Month: %.6f kWh (NGN %.2f)",
+             day.totals.energyKwh(), day.totals.energyKwh() * cfg.costPerKwh,
+             month.totals.energyKwh(), month.totals.energyKwh() * cfg.costPerKwh);
+}
+
+void MonitorApp::logRollupRecord(const RollupRecord &record) {
+    uint8_t payload[RollupRecord::ENCODED_SIZE];
+    uint8_t length = record.encode(payload);
+    if (!telemetryLog.append(RECORD_ROLLUP, payload, length)) {
+        holdRecord(RECORD_ROLLUP, payload, length);
+    }
+}
+
+// Close the hour's health stats into a record for the telemetry log, and
+// start the next hour's afresh
+void MonitorApp::logHealth(uint32_t date, uint8_t hour) {
+    const HealthStats &stats = healthStats;
+    HealthRecord record;
+    record.date = date;
+    record.hour = hour;
+    record.loopUs = stats.loopUs.summary();
+    record.passUs = stats.passUs.summary();
+    record.meteringUs = stats.meteringUs.summary();
+    for (uint8_t kind = 0; kind < RTT_KINDS; kind++) {
+        record.roundTripMs[kind] = stats.roundTripMs[kind].summary();
+    }
+    record.heapFree = platform.heapFree();
+    record.heapLowWater = platform.heapLowWater();
+    record.logBacklogMax = stats.logBacklogMax;
+    record.sampleDrops = stats.sampleDrops;
+    record.firebaseErrors = stats.firebaseErrors;
+    record.maxConsecutiveErrors = stats.maxConsecutiveErrors;
+    record.ackTimeouts = stats.ackTimeouts;
+    record.creditTimeouts = stats.creditTimeouts;
+    record.reconnects = stats.reconnects;
+    record.linkDrops = stats.linkDrops;
+    record.queueHighWater = stats.queueHighWater;
+    record.savedAt = platform.epoch();
+    healthStats.reset();
+
+    LOG_INFO("Health %02u:00 - pass p99 %lu us, max %lu us, %u Firebase errors",
+             (unsigned)hour, (unsigned long)record.passUs.p99, (unsigned long)record.passUs.max,
+             (unsigned)record.firebaseErrors);
+    if (date == 0) {
+        return;
+    }
+
+    uint8_t payload[HealthRecord::ENCODED_SIZE];
+    uint8_t length = record.encode(payload);
+    if (!telemetryLog.append(RECORD_HEALTH, payload, length)) {
+        holdRecord(RECORD_HEALTH, payload, length);
+    }
+}
+
+void MonitorApp::forceSaveHour() {
+    const AggregateBucket &hour = aggregator.current(AGG_HOUR);
+    if (hour.empty()) {
+        LOG_WARN("No data to force save");
+        return;
+    }
+
+    LOG_INFO("Force saving current hourly data");
+    beginBatch();
+    HourlyRecord record;
+    logHour(hour, &record);
+    if (canPublish()) {
+        queueLoggedRecords();
+        queueBilling();
+        queueEventLog();
+        sendBatch("forceHourly");
+    }
+}
@@ -0,0 +1,285 @@
+#ifndef MONITOR_APP_H
+#define MONITOR_APP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "CalibrationProfile.h"
+#include "CreditLedger.h"
+#include "EnergyAggregator.h"
+#include "EnergyRollup.h"
+#include "LedPattern.h"
+#include "MeterEngine.h"
+#include "MinuteProfile.h"
+#include "MonitorPlatform.h"
+#include "MonitorScheduler.h"
+#include "PublishPolicy.h"
+#include "ReadingQueue.h"
+#include "TelemetryLog.h"
+#include "TelemetryPacket.h"
+#include "TelemetryPaths.h"
+#include "TelemetryRecord.h"
+#include "UpdateBatch.h"
+
+struct MonitorConfig {
+    const char *buildingId = "building_002";
+    const char *unitId = "unit_002";
+    float costPerKwh = 209.5;
+    uint32_t replayIntervalMs = 2000;
+    uint32_t updateAckTimeoutMs = 30000;
+    // RTDB sends a keep-alive every 30 s, so a quiet stream for longer is dead
+    uint32_t creditStreamLiveWindowMs = 75000;
+    int maxFirebaseErrors = 5;
+    // The task watchdog's timeout; the health record reports how close the
+    // slowest network task pass came to it
+    uint32_t watchdogTimeoutMs = 10000;
+    // Used until a profile is saved in NVS, from the wizard or the RTDB;
+    // <unit>/calibration is checked this often for a new one
+    CalibrationProfile calibration;
+    uint32_t calibrationCheckIntervalMs = 3600000;
+    // On a board metering several units (see BuildingHub), updates go to
+    // /buildings/<building>/ with every key under units/<unit>/, so the hub
+    // can merge the units' updates into one. The event log is the board's,
+    // so only one unit uploads it.
+    bool publishUnderBuilding = false;
+    bool uploadEventLog = true;
+    // Replayed minute, hourly and rollup records go up as TelemetryPackets
+    // under history/packed/<date>/ instead of a JSON field per value. Off
+    // while the apps read history/hourly/ and history/daily/ leaves.
+    bool packedHistory = false;
+    // When power and timestamp go up: on a change, a heartbeat or a step
+    // between readings (see PublishPolicy). Billing rides along with them.
+    PublishPolicyConfig publish;
+    SchedulerConfig scheduler;
+};
+
+// The update waiting for Firebase to answer. Only one is sent at a time, so
+// log records and billed energy are committed in order, once acknowledged.
+struct PendingUpdate {
+    bool active = false;
+    const char *uid = "";        // always a literal
+    bool carriesLog = false;     // commit the log up to logOffset on success
+    uint32_t logOffset = 0;
+    uint64_t billedMws = 0;      // consumption this update deducts on the server
+    uint32_t logSeq = 0;         // event log uploaded up to here on success
+    bool carriesPower = false;   // tell the publish policy on success
+    float power = 0;
+    uint8_t heldRecords = 0;     // held records it carries, dropped on success
+    uint32_t sentAt = 0;
+};
+
+// The network task: credit, the hourly buffer, rollups, the telemetry log
+// and publishing, driven one step per pass by MonitorScheduler. Everything
+// outside the process goes through MonitorPlatform, so the firmware and the
+// native simulation run this same code.
+//
+// Single-threaded: pass() and the callbacks must all come from one task.
+// The metering task only touches the ReadingQueue.
+class MonitorApp : public MonitorListener, public AggregateListener {
+public:
+    MonitorApp(MonitorPlatform &platform, ReadingQueue &readings, TelemetryLog &telemetryLog);
+
+    // Saved ledger and rollups back from NVS, and the relay set to match.
+    // Called early in setup() so the relay never waits on the network.
+    void restore(const MonitorConfig &config);
+
+    // Start the scheduler; the first credit check goes out once Firebase is ready
+    void begin();
+
+    // One network task pass: at most one scheduler step, then replay
+    void pass();
+
+    // Sample ring whose overruns are reported with each reading (optional)
+    template <typename Ring>
+    void watchSampleRing(const Ring *ring) { sampleDropCounter = ring != nullptr ? &ring->dropCounter() : nullptr; }
+
+    // The metering task's live power, watched for steps between readings (optional)
+    void watchLivePower(const LivePower *live) { livePower = live; }
+
+    // Where new calibration profiles go for the metering task (optional)
+    void watchCalibration(CalibrationMailbox *mailbox) { calibrationMailbox = mailbox; }
+
+    // Save a profile to NVS and hand it to the metering task. False if the
+    // metering task still hasn't taken the last one; nothing is saved then.
+    bool applyCalibration(const CalibrationProfile &profile, const char *source);
+
+    // Firebase answers, from the platform's callbacks
+    void creditAnswered() override;
+    void applyRemainingUnits(double units, const char *source) override;
+    void creditStreamEvent() override;
+    void creditStreamClosed() override;
+    void updateAnswered(const char *uid, bool ok, int errorCode = 0) override;
+    void calibrationAnswered(const char *text) override;
+
+    // Minute, quarter, hour and day buckets closing, from the rollover step
+    void bucketClosed(AggregateLevel level, const AggregateBucket &bucket) override;
+
+    // Publish the open hour as it stands rather than waiting for it to
+    // close; the finished hour replaces it
+    void forceSaveHour();
+
+    const CreditLedger &ledger() const { return creditLedger; }
+    bool relayOn() const { return relayState; }
+    const RollupTotals &dailyTotals() const { return dailyRollup.current(); }
+    const RollupTotals &monthlyTotals() const { return monthlyRollup.current(); }
+    const AggregateBucket &hourly() const { return aggregator.current(AGG_HOUR); }
+    const CalibrationProfile &calibration() const { return calibrationProfile; }
+    bool updatePending() const { return pendingUpdate.active; }
+    MonitorState state() const { return scheduler.state(); }
+    const HealthStats &health() const { return healthStats; }
+
+private:
+    bool canReachFirebase();
+    bool canPublish();
+    bool creditStreamLive();
+    void updateStatusLed(bool connected);
+
+    void loadLedger();
+    void saveLedger();
+    void loadRollups();
+    void loadCalibration();
+    void saveRollups();
+    void saveOffsets(const MeterReading &reading);
+
+    void formatCycleTimestamp();
+
+    void reconcileCredit(double units);
+    void enforceCredit();
+
+    void sampleReading();
+    void rollOverHour();
+    void publishReading();
+    void publishStep();
+
+    void beginBatch();
+    void sendBatch(const char *uid);
+    void finishPendingUpdate(bool acknowledged);
+    void queueBilling();
+    void queueEventLog();
+    bool eventLogWaiting();
+    void replayTelemetry();
+    void checkCalibration();
+
+    void logMinuteReading(const MeterReading &reading, uint32_t epoch, bool drawnOnCredit);
+    void closeOfflineMinute();
+    void queueLoggedRecords();
+    void queueRecord(const TelemetryFrame &frame);
+    void holdRecord(uint8_t type, const uint8_t *payload, uint8_t length);
+    void dropHeldRecords(uint8_t count);
+    bool packRecord(const TelemetryFrame &frame, uint32_t logOffset);
+    void queuePacket();
+    void queueMinuteRecord(const MinuteRecord &record);
+    void queueHourlyRecord(const HourlyRecord &record);
+    void queueProfileRecord(const ProfileRecord &record);
+    void queueRollupRecord(const RollupRecord &record);
+    void queueHealthRecord(const HealthRecord &record);
+
+    void closeHour(const AggregateBucket &hour);
+    void logHour(const AggregateBucket &hour, HourlyRecord *record);
+    void addProfileMinute(const AggregateBucket &minute);
+    void logProfile(uint32_t date, uint8_t hour);
+    void rollUpHour(const HourlyRecord &hour, uint64_t energyMws, uint32_t seconds, float demandW);
+    void logRollupRecord(const RollupRecord &record);
+    void logHealth(uint32_t date, uint8_t hour);
+
+    MonitorPlatform &platform;
+    ReadingQueue &readingQueue;
+    TelemetryLog &telemetryLog;
+    const std::atomic<uint32_t> *sampleDropCounter;
+    const LivePower *livePower;
+    MonitorConfig cfg;
+
+    char unitBasePath[64];
+    char creditPath[96];
+    char calibrationPath[96];
+
+    // Every field written in a cycle goes up in one multi-location update
+    UpdateBatch publishBatch;
+    PendingUpdate pendingUpdate;
+    PublishPolicy publishPolicy;
+
+    // What the batch being built will do once acknowledged (see beginBatch())
+    bool batchCarriesLog;
+    uint32_t batchLogOffset;
+    uint64_t batchBilledMws;
+    uint32_t batchLogSeq;          // where the batch leaves the event log upload
+    bool batchCarriesPower;
+    float batchPower;
+    uint32_t uploadedLogSeq;       // first event log entry not yet acknowledged
+    uint32_t lastReplay;
+    uint8_t batchHeldRecords;      // how many of heldRecords the batch carries
+
+    // Records the telemetry log wouldn't take (full, or not mounted), kept
+    // here and sent with every update until one carrying them is answered
+    static const uint8_t HELD_RECORDS = 8;
+    TelemetryFrame heldRecords[HELD_RECORDS];
+    uint8_t heldCount;
+
+    // Records for the batch's packet (packedHistory), keyed by the first
+    // one's time and log offset so a resend lands on the same key
+    TelemetryPacketWriter historyPacket;
+    uint32_t packetEpoch;
+    uint32_t packetLogOffset;
+
+    // Every reading into minute, quarter, hour and day buckets by its own
+    // time; closed minutes make the hour's profile, closed hours its record
+    EnergyAggregator aggregator;
+    MinuteProfile hourProfile;
+    float hourDemandW;             // the hour's busiest quarter hour, average W
+
+    // Offline readings in the minute being logged, merged into one minute
+    // record (see logMinuteReading())
+    bool offlineMinuteOpen;
+    uint32_t offlineEpoch;
+    uint64_t offlineEnergyMws;
+    float offlinePowerSec;
+    float offlineCurrentSec;
+    float offlineVoltageSec;
+    float offlineSeconds;
+    uint8_t offlineFlags;
+
+    // Running day and month totals, fed each finished hour and kept in NVS, so
+    // history/daily/<date>/ and history/monthly/<month>/ are single precomputed
+    // nodes instead of sums over every hourly one
+    EnergyRollup dailyRollup;
+    EnergyRollup monthlyRollup;
+
+    // The network task never waits on the network: the scheduler picks one short
+    // step per pass (connect, credit check, sample, rollover, publish) and
+    // callbacks finish whatever the network started
+    MonitorScheduler scheduler;
+    LedPattern statusLed;
+    uint32_t lastCreditEvent;
+
+    // The reading being carried through the sample -> rollover -> publish steps
+    MeterReading cycleReading;
+    uint32_t cycleEpoch;
+    char cycleTimestamp[TIMESTAMP_CHARS];
+
+    bool relayState;
+
+    // Prepaid credit, kept here and in NVS so the relay follows it offline too
+    CreditLedger creditLedger;
+
+    // remaining_units that arrived while an update was in flight. Whether it
+    // includes that update's deduction is unknown, so it waits for the answer.
+    bool heldRemainingUnits;
+    double heldUnits;
+
+    int consecutiveFirebaseErrors;
+
+    CalibrationProfile calibrationProfile;
+    CalibrationMailbox *calibrationMailbox;
+    uint32_t lastCalibrationCheck;
+    bool calibrationChecked;       // asked at least once since boot
+
+    // Timings and counts for this hour's health record, cheap enough to keep
+    // always on: a few compares and an increment per event
+    HealthStats healthStats;
+    uint32_t lastPassUs;
+    bool passTimed;                // lastPassUs is set
+    uint32_t creditSentAt;
+    uint32_t sampleDropsSeen;      // ring overruns already counted
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef MONITOR_PLATFORM_H
+#define MONITOR_PLATFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Where a platform delivers Firebase answers: MonitorApp, or a BuildingHub
+// sharing one connection between several MonitorApps. Called from the
+// network task, like the FirebaseClient callbacks they stand in for.
+class MonitorListener {
+public:
+    virtual ~MonitorListener() {}
+
+    virtual void creditAnswered() = 0;
+    virtual void applyRemainingUnits(double units, const char *source) = 0;
+    virtual void creditStreamEvent() = 0;       // any event, keep-alives included
+    virtual void creditStreamClosed() = 0;
+    virtual void updateAnswered(const char *uid, bool ok, int errorCode = 0) = 0;
+    virtual void calibrationAnswered(const char *text) = 0;    // "" if there is none
+};
+
+// Everything MonitorApp needs from the outside world: the clock, the link,
+// Firebase, the relay and NVS. The firmware implements it on WiFi,
+// FirebaseClient and Preferences (src/Esp32Platform); the native
+// simulation implements it with a fake clock and a fake RTDB
+// (lib/MeterSim), so both run the same MonitorApp.
+//
+// Firebase calls only start the request. The answer comes back through
+// the attached MonitorListener (creditAnswered(), applyRemainingUnits(),
+// updateAnswered(), ...) from the network task, like the FirebaseClient
+// callbacks do.
+class MonitorPlatform {
+public:
+    virtual ~MonitorPlatform() {}
+
+    // Monotonic milliseconds, and seconds since 1970 or 0 while the clock isn't set
+    virtual uint32_t nowMs() = 0;
+    virtual uint32_t epoch() = 0;
+    // Microseconds for timing passes; wraps, so only differences count
+    virtual uint32_t nowUs() { return nowMs() * 1000; }
+
+    // Free heap now and the least there has been since boot, bytes; 0 if unknown
+    virtual uint32_t heapFree() { return 0; }
+    virtual uint32_t heapLowWater() { return 0; }
+
+    virtual bool wifiConnected() = 0;
+    virtual bool firebaseReady() = 0;
+    virtual uint32_t localIp() { return 0; }   // IPv4, first octet in the low byte
+    virtual void reconnect() = 0;
+    virtual void restartFirebase() = 0;
+
+    virtual void requestCredit(const char *path) = 0;
+    virtual void openCreditStream(const char *path) = 0;
+    // The calibration profile text at path, answered with calibrationAnswered()
+    virtual void requestCalibration(const char *) {}
+    // Multi-location update of json under path; answered with uid
+    virtual void sendUpdate(const char *path, const char *json, const char *uid) = 0;
+
+    virtual void setRelay(bool on) = 0;
+    // A board metering several units has a relay per channel; channel 0 is setRelay()'s
+    virtual void setChannelRelay(uint8_t channel, bool on) {
+        if (channel == 0) setRelay(on);
+    }
+    virtual void setStatusLed(bool on) = 0;
+
+    // NVS, namespace "emonitor"
+    virtual float loadFloat(const char *key, float fallback) = 0;
+    virtual void saveFloat(const char *key, float value) = 0;
+    virtual uint64_t loadU64(const char *key, uint64_t fallback) = 0;
+    virtual void saveU64(const char *key, uint64_t value) = 0;
+    // False (and out untouched) unless exactly size bytes are stored
+    virtual bool loadBytes(const char *key, void *out, size_t size) = 0;
+    virtual void saveBytes(const char *key, const void *data, size_t size) = 0;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include "MonitorScheduler.h"
+
+MonitorScheduler::MonitorScheduler() {
+    configure(SchedulerConfig());
+    begin(0);
+}
+
+void MonitorScheduler::configure(const SchedulerConfig &config) {
+    cfg = config;
+}
+
+void MonitorScheduler::begin(uint32_t nowMs) {
+    current = STATE_CONNECT;
+    linkUp = false;
+    lastCreditMs = nowMs;
+    creditStartedMs = nowMs;
+    // setup() has just started the first attempt
+    lastConnectMs = nowMs;
+    creditPending = false;
+    creditForced = true;   // check credit as soon as we're online
+    lastStreamOpenMs = nowMs;
+    streamForced = true;   // and open the stream right after
+}
+
+MonitorAction MonitorScheduler::poll(uint32_t nowMs, const SchedulerInputs &inputs) {
+    switch (current) {
+    case STATE_SAMPLE:
+        current = STATE_ROLLOVER;
+        return ACTION_ROLLOVER;
+
+    case STATE_ROLLOVER:
+        current = STATE_PUBLISH;
+        return ACTION_PUBLISH;
+
+    case STATE_CREDIT_CHECK:
+        if (creditPending) {
+            if (nowMs - creditStartedMs < cfg.creditTimeoutMs) {
+                return ACTION_NONE;
+            }
+            creditPending = false;
+            current = STATE_IDLE;
+            return ACTION_CREDIT_TIMEOUT;
+        }
+        break;
+
+    default:
+        break;
+    }
+    return pollIdle(nowMs, inputs);
+}
+
+MonitorAction MonitorScheduler::pollIdle(uint32_t nowMs, const SchedulerInputs &inputs) {
+    current = inputs.wifiConnected ? STATE_IDLE : STATE_CONNECT;
+
+    // Report link changes first so the task can log them
+    if (inputs.wifiConnected != linkUp) {
+        linkUp = inputs.wifiConnected;
+        if (linkUp) {
+            streamForced = true;    // the old stream died with the link
+        } else {
+            lastConnectMs = nowMs;  // give the driver's own reconnect a chance first
+        }
+        return linkUp ? ACTION_LINK_UP : ACTION_LINK_DOWN;
+    }
+
+    if (inputs.readingQueued) {
+        current = STATE_SAMPLE;
+        return ACTION_SAMPLE;
+    }
+
+    if (!inputs.wifiConnected) {
+        if (nowMs - lastConnectMs >= cfg.connectRetryMs) {
+            lastConnectMs = nowMs;
+            return ACTION_CONNECT;
+        }
+        return ACTION_NONE;
+    }
+
+    if (!inputs.firebaseReady) {
+        return ACTION_NONE;
+    }
+
+    uint32_t creditInterval = inputs.creditStreamLive ? cfg.creditFallbackIntervalMs
+                                                      : cfg.creditCheckIntervalMs;
+    if (inputs.creditCheckAllowed && (creditForced || nowMs - lastCreditMs >= creditInterval)) {
+        creditForced = false;
+        lastCreditMs = nowMs;
+        creditStartedMs = nowMs;
+        creditPending = true;
+        current = STATE_CREDIT_CHECK;
+        return ACTION_CREDIT_REQUEST;
+    }
+
+    if (!inputs.creditStreamLive && (streamForced || nowMs - lastStreamOpenMs >= cfg.streamRetryMs)) {
+        streamForced = false;
+        lastStreamOpenMs = nowMs;
+        return ACTION_STREAM_OPEN;
+    }
+    return ACTION_NONE;
+}
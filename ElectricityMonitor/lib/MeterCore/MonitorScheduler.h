@@ -0,0 +1,95 @@
+#ifndef MONITOR_SCHEDULER_H
+#define MONITOR_SCHEDULER_H
+
+#include <stdint.h>
+
+// Where the network task is in its cycle
+enum MonitorState {
+    STATE_CONNECT,        // WiFi down: retrying now and then, metering carries on
+    STATE_IDLE,           // online, nothing due
+    STATE_CREDIT_CHECK,   // credit request in flight
+    STATE_SAMPLE,         // reading picked up, rollover next
+    STATE_ROLLOVER,       // hour closed if it changed, publish next
+    STATE_PUBLISH         // reading published or logged
+};
+
+// What the network task should do on this pass. Each one is a few milliseconds of
+// work at most; anything slower (the network) is started here and
+// finished by a callback.
+enum MonitorAction {
+    ACTION_NONE,
+    ACTION_CONNECT,          // (re)start a WiFi connection attempt
+    ACTION_LINK_UP,          // WiFi just came back
+    ACTION_LINK_DOWN,        // WiFi just dropped
+    ACTION_CREDIT_REQUEST,   // send the credit get; call creditAnswered() from its callback
+    ACTION_CREDIT_TIMEOUT,   // no answer in time, give up on this one
+    ACTION_STREAM_OPEN,      // (re)open the credit event stream
+    ACTION_SAMPLE,           // pick up the reading the metering task queued
+    ACTION_ROLLOVER,         // close the hour if it changed
+    ACTION_PUBLISH           // send the reading, or log it if we can't
+};
+
+struct SchedulerConfig {
+    uint32_t creditCheckIntervalMs = 60000;
+    uint32_t creditFallbackIntervalMs = 600000;  // poll interval while the stream is live
+    uint32_t creditTimeoutMs = 2000;
+    uint32_t connectRetryMs = 10000;
+    uint32_t streamRetryMs = 30000;
+};
+
+// What the network task sees on this pass
+struct SchedulerInputs {
+    bool wifiConnected = false;
+    bool firebaseReady = false;
+    bool creditCheckAllowed = true;   // e.g. not while an update changing credit is in flight
+    bool readingQueued = false;       // the metering task has a reading waiting
+    bool creditStreamLive = false;    // the credit stream has delivered an event recently
+};
+
+// Cooperative, millis-based scheduler for the network task. It only
+// decides; the task calls poll() every pass and carries out the returned
+// action. Pure logic with the clock passed in, so the native tests can
+// drive it.
+//
+// The metering task decides when a reading is taken. Each one queued is
+// carried through the reading cycle (sample, rollover, publish) one step
+// per pass, whether or not the network is up. Connection retries, the
+// credit stream and credit checks fill the gaps in between. Credit changes
+// normally arrive over the stream; while it is live the poll drops back to
+// a slow fallback.
+class MonitorScheduler {
+public:
+    MonitorScheduler();
+
+    void configure(const SchedulerConfig &config);
+    void begin(uint32_t nowMs);
+
+    MonitorAction poll(uint32_t nowMs, const SchedulerInputs &inputs);
+
+    // The credit callback fired (with data or an error)
+    void creditAnswered() { creditPending = false; }
+
+    // Check credit at the next chance rather than waiting out the interval
+    void requestCreditCheck() { creditForced = true; }
+
+    MonitorState state() const { return current; }
+    bool inReadingCycle() const {
+        return current == STATE_SAMPLE || current == STATE_ROLLOVER || current == STATE_PUBLISH;
+    }
+
+private:
+    MonitorAction pollIdle(uint32_t nowMs, const SchedulerInputs &inputs);
+
+    SchedulerConfig cfg;
+    MonitorState current;
+    bool linkUp;
+    uint32_t lastCreditMs;
+    uint32_t creditStartedMs;
+    uint32_t lastConnectMs;
+    uint32_t lastStreamOpenMs;
+    bool creditPending;
+    bool creditForced;
+    bool streamForced;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include "MultiChannelMeter.h"
+#include <math.h>
+
+MultiChannelMeter::MultiChannelMeter() {
+    configure(MeterConfig(), 1);
+}
+
+void MultiChannelMeter::configure(const MeterConfig &config, uint8_t channels) {
+    cfg = config;
+    channelCount = channels > MAX_METER_CHANNELS ? MAX_METER_CHANNELS : channels;
+    sync.configure(cfg);
+    voltageBias = OffsetTracker(cfg.offsetTrackingShift, cfg.adcCenter);
+    voltageTable = CalibrationTable();
+
+    for (uint8_t c = 0; c < MAX_METER_CHANNELS; c++) {
+        currentBias[c] = OffsetTracker(cfg.offsetTrackingShift, cfg.adcCenter);
+        currentTable[c] = CalibrationTable();
+        power[c].configure(cfg);
+    }
+}
+
+void MultiChannelMeter::setCalibration(uint8_t channel, const CalibrationProfile &profile) {
+    if (channel >= channelCount) {
+        return;
+    }
+    if (channel == 0) {
+        voltageTable = profile.voltage;
+    }
+    currentTable[channel] = profile.current;
+}
+
+CalibrationProfile MultiChannelMeter::calibrationProfile(uint8_t channel) const {
+    CalibrationProfile profile;
+    profile.voltage = voltageTable;
+    if (channel < channelCount) {
+        profile.current = currentTable[channel];
+    }
+    return profile;
+}
+
+void MultiChannelMeter::seedOffsets(uint8_t channel, float currentCounts, float voltageCounts) {
+    if (channel >= channelCount) {
+        return;
+    }
+    currentBias[channel].seed(currentCounts);
+    if (channel == 0) {
+        voltageBias.seed(voltageCounts);
+    }
+}
+
+void MultiChannelMeter::process(const ChannelFrame *frames, size_t count) {
+    const uint8_t n = channelCount;
+    for (size_t k = 0; k < count; k++) {
+        const ChannelFrame &frame = frames[k];
+        int16_t v = (int16_t)voltageBias.deviation(frame.voltage, DEVIATION_FRAC_BITS);
+        voltageBias.update(frame.voltage);
+
+        if (sync.startSample(v)) {
+            closeWindows();
+        }
+        for (uint8_t c = 0; c < n; c++) {
+            int16_t i = (int16_t)currentBias[c].deviation(frame.current[c], DEVIATION_FRAC_BITS);
+            currentBias[c].update(frame.current[c]);
+            power[c].add(v, i);
+        }
+        if (sync.endSample()) {
+            closeWindows();
+        }
+    }
+}
+
+size_t MultiChannelMeter::drain(ChannelFrameRing &ring) {
+    ChannelFrame batch[32];
+    size_t total = 0;
+    size_t n;
+    while ((n = ring.popBatch(batch, 32)) > 0) {
+        process(batch, n);
+        total += n;
+    }
+    return total;
+}
+
+void MultiChannelMeter::closeWindows() {
+    for (uint8_t c = 0; c < channelCount; c++) {
+        power[c].closeWindow(voltageTable, currentTable[c]);
+    }
+}
+
+void MultiChannelMeter::takeReadings(MeterReading *out) {
+    MeterReading shared;
+    sync.takeInterval(shared);
+    for (uint8_t c = 0; c < channelCount; c++) {
+        MeterReading reading;
+        power[c].takeReading(reading);
+        reading.lineFrequencyHz = shared.lineFrequencyHz;
+        reading.windows = shared.windows;
+        reading.syncedWindows = shared.syncedWindows;
+        reading.currentOffset = currentBias[c].value();
+        reading.voltageOffset = voltageBias.value();
+        out[c] = reading;
+    }
+}
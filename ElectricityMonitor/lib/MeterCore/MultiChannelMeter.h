@@ -0,0 +1,127 @@
+#ifndef MULTI_CHANNEL_METER_H
+#define MULTI_CHANNEL_METER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "CalibrationProfile.h"
+#include "MeterEngine.h"
+#include "ReadingQueue.h"
+#include "SampleSource.h"
+
+// MeterEngine for a board metering several units off one voltage sensor.
+// The voltage's deviation and zero crossings are worked out once per frame
+// and a single WindowSync closes every channel's window on them, so
+// windows, sync and line frequency are the voltage's and every channel's
+// reading covers exactly the same samples. Each channel's sums are a
+// PowerChannel of its own, the same kernels and per-window calibration as
+// MeterEngine's; a channel that isn't configured costs nothing.
+//
+// Calibration: the voltage table is channel 0's (the sensor is shared);
+// each channel's current table is its own.
+class MultiChannelMeter {
+public:
+    MultiChannelMeter();
+
+    void configure(const MeterConfig &config, uint8_t channels);
+    const MeterConfig &config() const { return cfg; }
+    uint8_t channels() const { return channelCount; }
+
+    void process(const ChannelFrame *frames, size_t count);
+
+    // Pop everything currently in the ring and process it
+    size_t drain(ChannelFrameRing &ring);
+
+    // Snapshot every channel's interval into out[0..channels()) and start a new one
+    void takeReadings(MeterReading *out);
+
+    uint64_t totalSamples() const { return sync.totalSamples(); }
+
+    // MeterEngine::recentPower() for a channel
+    float recentPower(uint8_t channel) const { return power[channel].recentPower(); }
+    bool hasRecentPower() const { return power[0].hasRecentPower(); }
+
+    // Takes effect from the next window closed
+    void setCalibration(uint8_t channel, const CalibrationProfile &profile);
+    CalibrationProfile calibrationProfile(uint8_t channel) const;
+
+    void seedOffsets(uint8_t channel, float currentCounts, float voltageCounts);
+    float currentOffset(uint8_t channel) const { return currentBias[channel].value(); }
+    float voltageOffset() const { return voltageBias.value(); }
+
+private:
+    void closeWindows();
+
+    MeterConfig cfg;
+    uint8_t channelCount;
+    WindowSync sync;
+    OffsetTracker voltageBias;
+    CalibrationTable voltageTable;
+
+    // Per channel, indexed by channel
+    OffsetTracker currentBias[MAX_METER_CHANNELS];
+    CalibrationTable currentTable[MAX_METER_CHANNELS];
+    PowerChannel power[MAX_METER_CHANNELS];
+};
+
+// Metering task side of one CalibrationMailbox per channel
+inline bool takeCalibrations(MultiChannelMeter &meter, CalibrationMailbox *mailboxes) {
+    bool taken = false;
+    for (uint8_t c = 0; c < meter.channels(); c++) {
+        CalibrationProfile profile;
+        bool found = false;
+        while (mailboxes[c].pop(profile)) {
+            found = true;
+        }
+        if (found) {
+            meter.setCalibration(c, profile);
+            taken = true;
+        }
+    }
+    return taken;
+}
+
+// runMeteringPeriod() for every channel at once: one reading per channel
+// into its own queue, all covering the same interval. The interval is only
+// closed when every queue has room, so a stalled tenant delays the others'
+// readings rather than losing its own energy. The timer watches the
+// channels' total power: a step on any one moves it by the same watts.
+// live, if given, is a LivePower per channel.
+template <typename EpochFn>
+inline bool runMultiMeteringPeriod(MultiChannelMeter &meter, ChannelFrameRing &ring,
+                                   ReadingQueue *queues, ReadingTimer &timer,
+                                   uint32_t nowMs, EpochFn epoch,
+                                   LivePower *live = nullptr) {
+    meter.drain(ring);
+    float total = 0;
+    for (uint8_t c = 0; c < meter.channels(); c++) {
+        total += meter.recentPower(c);
+        if (live != nullptr) {
+            live[c].store(meter.recentPower(c), std::memory_order_relaxed);
+        }
+    }
+    if (meter.hasRecentPower()) {
+        timer.observe(total);
+    }
+    if (!timer.due(nowMs)) {
+        return false;
+    }
+    for (uint8_t c = 0; c < meter.channels(); c++) {
+        if (queues[c].size() >= queues[c].capacity()) {
+            return false;
+        }
+    }
+
+    MeterReading readings[MAX_METER_CHANNELS];
+    meter.takeReadings(readings);
+    QueuedReading item;
+    item.epoch = epoch();
+    item.metering = timer.periods();
+    for (uint8_t c = 0; c < meter.channels(); c++) {
+        item.reading = readings[c];
+        queues[c].push(item);
+    }
+    timer.taken(nowMs);
+    return true;
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef OFFSET_TRACKER_H
+#define OFFSET_TRACKER_H
+
+#include <stdint.h>
+
+// Running estimate of a channel's DC bias (the ADC count that means "zero
+// amps" or "zero volts"). It is a first-order low-pass on the raw samples:
+//   offset += (sample - offset) / 2^shift
+// kept in Q16 fixed point, so each sample costs a subtract and a shift.
+// With shift 14 at 1 kHz the time constant is ~16 s: slow enough that the
+// mains waveform averages out, fast enough to follow thermal drift.
+class OffsetTracker {
+public:
+    explicit OffsetTracker(uint8_t shift = 14, float initialCounts = 2048)
+        : shift(shift) {
+        seed(initialCounts);
+    }
+
+    // Start from a known offset, e.g. the calibration zero point or the
+    // value saved before the last reboot
+    void seed(float counts) {
+        offsetQ16 = (int32_t)(counts * 65536.0f + 0.5f);
+    }
+
+    void update(uint16_t sample) {
+        offsetQ16 += (((int32_t)sample << 16) - offsetQ16) >> shift;
+    }
+
+    // Sample minus offset in 1/2^fracBits counts, rounded
+    int32_t deviation(uint16_t sample, uint8_t fracBits) const {
+        uint8_t drop = 16 - fracBits;
+        return ((((int32_t)sample << 16) - offsetQ16) + (1 << (drop - 1))) >> drop;
+    }
+
+    float value() const { return offsetQ16 / 65536.0f; }
+    int32_t valueQ16() const { return offsetQ16; }
+
+private:
+    uint8_t shift;
+    int32_t offsetQ16;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#include "PublishPolicy.h"
+#include <math.h>
+
+PublishPolicy::PublishPolicy() {
+    configure(PublishPolicyConfig());
+}
+
+void PublishPolicy::configure(const PublishPolicyConfig &config) {
+    cfg = config;
+    reset();
+}
+
+void PublishPolicy::reset() {
+    publishedAny = false;
+    lastPowerW = 0;
+    lastPublishMs = 0;
+    stepSeen = false;
+    stepPowerW = 0;
+    stepSinceMs = 0;
+}
+
+bool PublishPolicy::beyondDeadband(float power, float reference) const {
+    float band = cfg.deadbandFraction * fabsf(reference);
+    if (band < cfg.deadbandW) band = cfg.deadbandW;
+    return fabsf(power - reference) > band;
+}
+
+bool PublishPolicy::readingDue(float power, uint32_t nowMs) const {
+    if (!cfg.enabled || !publishedAny) {
+        return true;
+    }
+    return nowMs - lastPublishMs >= cfg.heartbeatMs || beyondDeadband(power, lastPowerW);
+}
+
+// The live power moves once a second and a load switching mid-second shows
+// half its step first, so the step counts once the value has settled
+// (stayed within the deadband of itself) for stepSettleMs
+bool PublishPolicy::stepDue(float power, uint32_t nowMs) {
+    if (!cfg.enabled || !publishedAny || fabsf(power - lastPowerW) < cfg.stepW) {
+        stepSeen = false;
+        return false;
+    }
+    if (!stepSeen || beyondDeadband(power, stepPowerW)) {
+        stepSeen = true;
+        stepPowerW = power;
+        stepSinceMs = nowMs;
+        return false;
+    }
+    return nowMs - stepSinceMs >= cfg.stepSettleMs;
+}
+
+void PublishPolicy::published(float power, uint32_t nowMs) {
+    publishedAny = true;
+    lastPowerW = power;
+    lastPublishMs = nowMs;
+    stepSeen = false;
+}
@@ -0,0 +1,61 @@
+#ifndef PUBLISH_POLICY_H
+#define PUBLISH_POLICY_H
+
+#include <stdint.h>
+
+struct PublishPolicyConfig {
+    bool enabled = true;              // false: every reading goes up, as before
+    // A reading goes up once it is this far from the last one published:
+    // the larger of the absolute and the relative band
+    float deadbandW = 10;
+    float deadbandFraction = 0.05f;
+    // ...or once nothing has gone up for this long, so the dashboard can
+    // tell a quiet unit from a dead one
+    uint32_t heartbeatMs = 600000;
+    // Between readings, a change this large in the metering task's live
+    // power goes up on its own once it has held for stepSettleMs
+    float stepW = 300;
+    uint32_t stepSettleMs = 1500;
+};
+
+// Report by exception for the realtime power field. Pure logic with the
+// clock passed in: MonitorApp asks readingDue() with each minute's reading
+// and stepDue() with the live power between them, and calls published()
+// once an update carrying power is acknowledged - an update that fails
+// leaves the last published value where it was, so the next reading is
+// compared against what the server actually has.
+class PublishPolicy {
+public:
+    PublishPolicy();
+
+    void configure(const PublishPolicyConfig &config);
+    const PublishPolicyConfig &config() const { return cfg; }
+
+    // Forget what was published: the next reading goes up whatever it is
+    void reset();
+
+    bool readingDue(float power, uint32_t nowMs) const;
+
+    // Not const: a step has to hold before it counts
+    bool stepDue(float power, uint32_t nowMs);
+
+    void published(float power, uint32_t nowMs);
+
+    bool hasPublished() const { return publishedAny; }
+    float lastPower() const { return lastPowerW; }
+
+private:
+    bool beyondDeadband(float power, float reference) const;
+
+    PublishPolicyConfig cfg;
+    bool publishedAny;
+    float lastPowerW;
+    uint32_t lastPublishMs;
+
+    // A live value far enough from the last published one, and since when
+    bool stepSeen;
+    float stepPowerW;
+    uint32_t stepSinceMs;
+};
+
+#endif
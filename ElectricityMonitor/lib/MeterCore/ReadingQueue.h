@@ -0,0 +1,170 @@
+#ifndef READING_QUEUE_H
+#define READING_QUEUE_H
+
+#include <math.h>
+#include <stdint.h>
+#include <atomic>
+#include "MeterEngine.h"
+#include "SampleRing.h"
+
+// How long the metering task's periods took over one reading's interval.
+// It travels with the reading, so the metering task never touches the
+// network task's health stats.
+struct MeteringTiming {
+    uint32_t periods = 0;
+    uint32_t maxUs = 0;
+    uint32_t totalUs = 0;
+
+    void add(uint32_t us) {
+        periods++;
+        totalUs += us;
+        if (us > maxUs) maxUs = us;
+    }
+};
+
+// A finished reading, handed from the metering task to the network task
+struct QueuedReading {
+    MeterReading reading;
+    uint32_t epoch;    // when it was taken, 0 if the clock wasn't set
+    MeteringTiming metering;
+};
+
+// 16 readings is a quarter of an hour at one a minute
+const size_t READING_QUEUE_SIZE = 16;
+typedef SampleRing<QueuedReading, READING_QUEUE_SIZE> ReadingQueue;
+
+// Producer side. Close the engine's interval into the queue only if there is
+// room for it; otherwise leave it open so a stalled network task delays the
+// reading instead of losing its energy.
+inline bool queueReading(MeterEngine &engine, ReadingQueue &queue, uint32_t epoch,
+                         const MeteringTiming &timing = MeteringTiming()) {
+    if (queue.size() >= queue.capacity()) {
+        return false;
+    }
+    QueuedReading item;
+    item.reading = engine.takeReading();
+    item.epoch = epoch;
+    item.metering = timing;
+    return queue.push(item);
+}
+
+// The metering task's latest recentPower(), W, for the network task to
+// watch between readings. A float is one word: the newest value is all
+// either side cares about, so no queue.
+typedef std::atomic<float> LivePower;
+
+// How often the metering task closes an interval. A reading every
+// steadyMs while the load holds; when the live power moves by more than
+// the larger of transitionW and transitionFraction of where the interval
+// started, the interval closes as soon as it is fastestMs old, so each
+// side of the step gets a reading of its own. The cadence then relaxes
+// back, doubling each quiet reading, until it is steadyMs again.
+struct ReadingCadence {
+    uint32_t steadyMs = 60000;
+    uint32_t fastestMs = 10000;
+    float transitionW = 150;
+    float transitionFraction = 0.2f;
+};
+
+// When the metering task closes an interval: measured from the last
+// reading actually queued, on the cadence above. Energy is integrated per
+// sample whatever the cadence, and each reading carries its own duration.
+class ReadingTimer {
+public:
+    // A fixed interval, with no transitions
+    explicit ReadingTimer(uint32_t intervalMs = 60000) : lastMs(0) {
+        cadence.steadyMs = intervalMs;
+        cadence.fastestMs = intervalMs;
+        reset();
+    }
+    explicit ReadingTimer(const ReadingCadence &cadence) : cadence(cadence), lastMs(0) { reset(); }
+
+    void start(uint32_t nowMs) {
+        lastMs = nowMs;
+        reset();
+    }
+
+    // The live power (MeterEngine::recentPower()), every period
+    void observe(float power) {
+        if (!referenced) {
+            referencePower = power;
+            referenced = true;
+        } else if (fabsf(power - referencePower) > band(referencePower)) {
+            transition = true;
+        }
+        latestPower = power;
+    }
+
+    bool due(uint32_t nowMs) const {
+        uint32_t elapsed = nowMs - lastMs;
+        return elapsed >= intervalMs || (transition && elapsed >= cadence.fastestMs);
+    }
+
+    void taken(uint32_t nowMs) {
+        lastMs = nowMs;
+        timing = MeteringTiming();
+        if (transition) {
+            intervalMs = cadence.fastestMs;
+        } else if (intervalMs < cadence.steadyMs) {
+            intervalMs = intervalMs * 2 < cadence.steadyMs ? intervalMs * 2 : cadence.steadyMs;
+        }
+        transition = false;
+        referencePower = latestPower;
+    }
+
+    uint32_t interval() const { return intervalMs; }
+
+    // How long a period's work took, sent along with the next reading
+    void periodTook(uint32_t us) { timing.add(us); }
+    const MeteringTiming &periods() const { return timing; }
+
+private:
+    void reset() {
+        intervalMs = cadence.steadyMs;
+        transition = false;
+        referenced = false;
+        referencePower = 0;
+        latestPower = 0;
+        timing = MeteringTiming();
+    }
+
+    float band(float reference) const {
+        float fraction = cadence.transitionFraction * fabsf(reference);
+        return fraction > cadence.transitionW ? fraction : cadence.transitionW;
+    }
+
+    ReadingCadence cadence;
+    uint32_t lastMs;
+    uint32_t intervalMs;         // the current cadence, fastestMs..steadyMs
+    bool transition;             // the load moved since the last reading
+    bool referenced;             // referencePower is set
+    float referencePower;
+    float latestPower;
+    MeteringTiming timing;
+};
+
+// One metering period: drain the sampler's ring, show the timer the live
+// power, and queue a reading if one is due. If the network task has fallen
+// a whole queue behind, the interval stays open and is retried next period.
+// epoch() is only asked when a reading is actually taken. The caller times
+// the period and hands it to timer.periodTook() afterwards. If live is
+// given it gets the engine's recentPower() every period.
+template <typename EpochFn>
+inline bool runMeteringPeriod(MeterEngine &engine, RawSampleRing &ring, ReadingQueue &queue,
+                              ReadingTimer &timer, uint32_t nowMs, EpochFn epoch,
+                              LivePower *live = nullptr) {
+    engine.drain(ring);
+    if (engine.hasRecentPower()) {
+        timer.observe(engine.recentPower());
+    }
+    if (live != nullptr) {
+        live->store(engine.recentPower(), std::memory_order_relaxed);
+    }
+    if (timer.due(nowMs) && queueReading(engine, queue, epoch(), timer.periods())) {
+        timer.taken(nowMs);
+        return true;
+    }
+    return false;
+}
+
+#endif
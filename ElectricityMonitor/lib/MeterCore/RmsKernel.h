@@ -0,0 +1,119 @@
+#ifndef RMS_KERNEL_H
+#define RMS_KERNEL_H
+
+#include <stdint.h>
+#include <math.h>
+
+// Integer accumulation kernels for RMS and power. Samples are integer
+// deviations from the channel offset; squares are summed into 64-bit
+// accumulators and converted to float exactly once, when the result is
+// read. The window length is a template parameter so a static_assert can
+// prove at compile time that a full window can't overflow the sums.
+
+template <typename SampleT> struct KernelProduct;
+
+// 16-bit deviations (e.g. quarter counts of a 12-bit ADC): the product fits
+// in 32 bits, so the hot loop never needs a 64-bit multiply
+template <> struct KernelProduct<int16_t> {
+    typedef int32_t type;
+    static const int64_t maxMagnitude = 1073741824LL;  // 32768^2
+};
+
+// 32-bit deviations are assumed to come from at most a 24-bit converter
+template <> struct KernelProduct<int32_t> {
+    typedef int64_t type;
+    static const int64_t maxMagnitude = 70368744177664LL;  // (2^23)^2
+};
+
+// Single channel: sum(x^2) over up to Window samples
+template <typename SampleT, uint32_t Window>
+class RmsKernel {
+    typedef typename KernelProduct<SampleT>::type Product;
+    static_assert(Window > 0, "RmsKernel window must not be empty");
+    static_assert((int64_t)Window <= INT64_MAX / KernelProduct<SampleT>::maxMagnitude,
+                  "RmsKernel window too long for a 64-bit accumulator");
+
+public:
+    RmsKernel() { reset(); }
+
+    void reset() {
+        sumSquares = 0;
+        n = 0;
+    }
+
+    // Returns true once the window is full
+    bool add(SampleT x) {
+        sumSquares += (Product)x * x;
+        return ++n >= Window;
+    }
+
+    bool full() const { return n >= Window; }
+    uint32_t count() const { return n; }
+    int64_t sum() const { return sumSquares; }
+
+    float meanSquare() const { return n ? (float)sumSquares / n : 0.0f; }
+    float rms() const { return sqrtf(meanSquare()); }
+
+private:
+    int64_t sumSquares;
+    uint32_t n;
+};
+
+// Two channels sampled together (voltage a, current b):
+// sum(a^2), sum(b^2) and sum(a*b) in one pass
+template <typename SampleT, uint32_t Window>
+class PowerKernel {
+    typedef typename KernelProduct<SampleT>::type Product;
+    static_assert(Window > 0, "PowerKernel window must not be empty");
+    static_assert((int64_t)Window <= INT64_MAX / KernelProduct<SampleT>::maxMagnitude,
+                  "PowerKernel window too long for a 64-bit accumulator");
+
+    template <typename, uint32_t> friend class PowerKernel;
+
+public:
+    PowerKernel() { reset(); }
+
+    void reset() {
+        sumAA = 0;
+        sumBB = 0;
+        sumAB = 0;
+        n = 0;
+    }
+
+    bool add(SampleT a, SampleT b) {
+        sumAA += (Product)a * a;
+        sumBB += (Product)b * b;
+        sumAB += (Product)a * b;
+        return ++n >= Window;
+    }
+
+    // Fold a closed shorter window into a longer one
+    template <uint32_t OtherWindow>
+    void merge(const PowerKernel<SampleT, OtherWindow> &other) {
+        static_assert(OtherWindow <= Window, "can only merge a shorter window into a longer one");
+        sumAA += other.sumAA;
+        sumBB += other.sumBB;
+        sumAB += other.sumAB;
+        n += other.n;
+    }
+
+    bool full() const { return n >= Window; }
+    uint32_t count() const { return n; }
+
+    float meanSquareA() const { return n ? (float)sumAA / n : 0.0f; }
+    float meanSquareB() const { return n ? (float)sumBB / n : 0.0f; }
+    float meanProduct() const { return n ? (float)sumAB / n : 0.0f; }
+    int64_t sumSquareA() const { return sumAA; }
+    int64_t sumSquareB() const { return sumBB; }
+    int64_t sumProduct() const { return sumAB; }
+    float rmsA() const { return sqrtf(meanSquareA()); }
+    float rmsB() const { return sqrtf(meanSquareB()); }
+
+private:
+    int64_t sumAA;
+    int64_t sumBB;
+    int64_t sumAB;
+    uint32_t n;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Fixed-capacity single-producer/single-consumer ring buffer.
+// The producer (ADC DMA task or a host-side fake) calls push(), the
+// consumer (main loop) calls pop()/popBatch(). No locks, no heap.
+template <typename T, size_t Capacity>
+class SampleRing {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SampleRing capacity must be a power of two");
+
+public:
+    SampleRing() : head(0), tail(0), dropped(0) {}
+
+    // Returns false (and counts the drop) when the consumer has fallen behind
+    bool push(const T &item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+        if (h - t >= Capacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items[h & (Capacity - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        if (t == h) {
+            return false;
+        }
+        item = items[t & (Capacity - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Copies up to maxItems into out, oldest first
+    size_t popBatch(T *out, size_t maxItems) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        size_t available = h - t;
+        size_t n = available < maxItems ? available : maxItems;
+        for (size_t k = 0; k < n; k++) {
+            out[k] = items[(t + k) & (Capacity - 1)];
+        }
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return Capacity; }
+    uint32_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+    // The same count, for a reader that doesn't know the ring's type
+    const std::atomic<uint32_t> &dropCounter() const { return dropped; }
+
+private:
+    T items[Capacity];
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+    std::atomic<uint32_t> dropped;
+};
+
+#endif
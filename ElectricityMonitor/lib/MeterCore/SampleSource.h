@@ -0,0 +1,60 @@
+#ifndef SAMPLE_SOURCE_H
+#define SAMPLE_SOURCE_H
+
+#include <stdint.h>
+#include "SampleRing.h"
+
+// One current/voltage ADC pair, taken as close together as the ADC allows
+struct RawSample {
+    uint16_t current;
+    uint16_t voltage;
+};
+
+// ~4 s of headroom at 1 kHz, so the sampler never overruns the metering task
+// when it is held off for a while between drains
+const size_t SAMPLE_RING_SIZE = 4096;
+typedef SampleRing<RawSample, SAMPLE_RING_SIZE> RawSampleRing;
+
+// A board metering several units: one current sensor per unit, all against
+// the one voltage sensor on the shared supply
+const uint8_t MAX_METER_CHANNELS = 4;
+
+// One scan of the voltage pin and every current pin
+struct ChannelFrame {
+    uint16_t voltage;
+    uint16_t current[MAX_METER_CHANNELS];
+};
+
+// ~2 s at 1 kHz; frames are 2.5x the size of a RawSample
+const size_t CHANNEL_RING_SIZE = 2048;
+typedef SampleRing<ChannelFrame, CHANNEL_RING_SIZE> ChannelFrameRing;
+
+// A background sampler that keeps a ring buffer topped up with RawSamples.
+// The ESP32 build uses the continuous (DMA) ADC driver; the native build
+// uses FakeSampleSource so tests can decide exactly what the "sensors" see.
+class SampleSource {
+public:
+    virtual ~SampleSource() {}
+
+    // Start filling ring in the background; returns false if the hardware refused
+    virtual bool begin(RawSampleRing &ring) = 0;
+    virtual void end() = 0;
+
+    // Rate of RawSample pairs per second (not raw ADC conversions)
+    virtual uint32_t sampleRateHz() const = 0;
+};
+
+// The same for a voltage pin and several current pins, one ChannelFrame per scan
+class ChannelFrameSource {
+public:
+    virtual ~ChannelFrameSource() {}
+
+    virtual bool begin(ChannelFrameRing &ring) = 0;
+    virtual void end() = 0;
+
+    // Frames per second, and how many current channels each one carries
+    virtual uint32_t sampleRateHz() const = 0;
+    virtual uint8_t channels() const = 0;
+};
+
+#endif
@@ -0,0 +1,212 @@
+#include "TelemetryLog.h"
+#include "Crc16.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static const size_t PATH_CAPACITY = 64;
+
+static uint16_t frameCrc(uint8_t type, uint8_t length, const uint8_t *payload) {
+    uint8_t header[2] = { type, length };
+    return crc16Ccitt(payload, length, crc16Ccitt(header, 2));
+}
+
+static long fileSize(FILE *file) {
+    if (fseek(file, 0, SEEK_END) != 0) {
+        return -1;
+    }
+    return ftell(file);
+}
+
+// Read one frame from the current position. False on a short, unframed
+// or corrupt record, which is how a torn tail shows up.
+static bool readFrame(FILE *file, TelemetryFrame &frame) {
+    uint8_t header[3];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header)) return false;
+    if (header[0] != TelemetryLog::FRAME_MAGIC) return false;
+    if (header[2] > TelemetryFrame::MAX_PAYLOAD) return false;
+
+    uint8_t crc[2];
+    if (fread(frame.payload, 1, header[2], file) != header[2]) return false;
+    if (fread(crc, 1, sizeof(crc), file) != sizeof(crc)) return false;
+
+    frame.type = header[1];
+    frame.length = header[2];
+    return frameCrc(frame.type, frame.length, frame.payload) == (uint16_t)(crc[0] | (crc[1] << 8));
+}
+
+TelemetryLog::TelemetryLog(const char *logPath, const char *cursorPath, uint32_t maxBytes)
+    : logPath(logPath), cursorPath(cursorPath), maxBytes(maxBytes),
+      readCursor(0), endOffset(0), discardedBytes(0), opened(false) {}
+
+bool TelemetryLog::open() {
+    opened = false;
+    discardedBytes = 0;
+
+    FILE *file = fopen(logPath, "rb");
+    if (file == nullptr) {
+        file = fopen(logPath, "wb");
+        if (file == nullptr) {
+            return false;
+        }
+    }
+    long length = fileSize(file);
+    if (length < 0) {
+        fclose(file);
+        return false;
+    }
+
+    // A cursor past the end means the log was compacted but the cursor
+    // reset never landed
+    loadCursor();
+    if (readCursor > (uint32_t)length) {
+        readCursor = 0;
+    }
+
+    // Everything before the cursor was valid when it was written; walk the
+    // rest and stop at the first frame that doesn't check out
+    uint32_t offset = readCursor;
+    TelemetryFrame frame;
+    fseek(file, offset, SEEK_SET);
+    while (offset < (uint32_t)length && readFrame(file, frame)) {
+        offset += FRAME_OVERHEAD + frame.length;
+    }
+    fclose(file);
+
+    endOffset = offset;
+    if (endOffset < (uint32_t)length) {
+        discardedBytes = (uint32_t)length - endOffset;
+        if (!truncateTo(endOffset)) {
+            return false;
+        }
+    }
+
+    opened = true;
+    if (readCursor >= endOffset) {
+        return commit(endOffset);
+    }
+    return true;
+}
+
+bool TelemetryLog::append(uint8_t type, const uint8_t *payload, uint8_t length) {
+    if (!opened || length > TelemetryFrame::MAX_PAYLOAD) {
+        return false;
+    }
+    if (endOffset + FRAME_OVERHEAD + length > maxBytes) {
+        return false;
+    }
+
+    uint8_t frame[FRAME_OVERHEAD + TelemetryFrame::MAX_PAYLOAD];
+    uint16_t crc = frameCrc(type, length, payload);
+    frame[0] = FRAME_MAGIC;
+    frame[1] = type;
+    frame[2] = length;
+    memcpy(frame + 3, payload, length);
+    frame[3 + length] = (uint8_t)crc;
+    frame[4 + length] = (uint8_t)(crc >> 8);
+
+    // Write at our own end offset rather than in append mode, so leftovers
+    // of a failed write are overwritten instead of sitting in the middle
+    FILE *file = fopen(logPath, "r+b");
+    if (file == nullptr) {
+        return false;
+    }
+    size_t total = FRAME_OVERHEAD + length;
+    bool ok = fseek(file, endOffset, SEEK_SET) == 0 && fwrite(frame, 1, total, file) == total;
+    ok = (fclose(file) == 0) && ok;
+    if (ok) {
+        endOffset += total;
+    }
+    return ok;
+}
+
+size_t TelemetryLog::read(uint32_t &offset, TelemetryFrame *frames, size_t maxFrames) const {
+    if (!opened || offset >= endOffset || maxFrames == 0) {
+        return 0;
+    }
+    FILE *file = fopen(logPath, "rb");
+    if (file == nullptr) {
+        return 0;
+    }
+
+    size_t count = 0;
+    if (fseek(file, offset, SEEK_SET) == 0) {
+        while (count < maxFrames && offset < endOffset && readFrame(file, frames[count])) {
+            offset += FRAME_OVERHEAD + frames[count].length;
+            count++;
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+bool TelemetryLog::commit(uint32_t offset) {
+    if (!opened || offset > endOffset) {
+        return false;
+    }
+    if (offset < endOffset) {
+        return storeCursor(offset);
+    }
+
+    // Fully drained: compact. Truncate first - if power fails before the
+    // cursor is rewritten, open() sees a cursor past the end and resets it.
+    if (endOffset > 0) {
+        if (!truncateTo(0)) {
+            return false;
+        }
+        endOffset = 0;
+    }
+    return storeCursor(0);
+}
+
+bool TelemetryLog::loadCursor() {
+    readCursor = 0;
+    FILE *file = fopen(cursorPath, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    uint8_t raw[8];
+    bool ok = fread(raw, 1, sizeof(raw), file) == sizeof(raw);
+    fclose(file);
+    if (!ok) {
+        return false;
+    }
+
+    uint32_t value = raw[0] | (raw[1] << 8) | ((uint32_t)raw[2] << 16) | ((uint32_t)raw[3] << 24);
+    uint32_t check = raw[4] | (raw[5] << 8) | ((uint32_t)raw[6] << 16) | ((uint32_t)raw[7] << 24);
+    if ((value ^ check) != 0xFFFFFFFFu) {
+        return false;  // garbage: replay from the start rather than skip records
+    }
+    readCursor = value;
+    return true;
+}
+
+bool TelemetryLog::storeCursor(uint32_t offset) {
+    char tempPath[PATH_CAPACITY];
+    if (snprintf(tempPath, sizeof(tempPath), "%s.tmp", cursorPath) >= (int)sizeof(tempPath)) {
+        return false;
+    }
+
+    uint8_t raw[8];
+    uint32_t check = ~offset;
+    for (int k = 0; k < 4; k++) {
+        raw[k] = (uint8_t)(offset >> (8 * k));
+        raw[4 + k] = (uint8_t)(check >> (8 * k));
+    }
+
+    FILE *file = fopen(tempPath, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool ok = fwrite(raw, 1, sizeof(raw), file) == sizeof(raw);
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(tempPath, cursorPath) != 0) {
+        return false;
+    }
+    readCursor = offset;
+    return true;
+}
+
+bool TelemetryLog::truncateTo(uint32_t length) {
+    return truncate(logPath, length) == 0;
+}
@@ -0,0 +1,75 @@
+#ifndef TELEMETRY_LOG_H
+#define TELEMETRY_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// One record read back from the log
+struct TelemetryFrame {
+    static const uint8_t MAX_PAYLOAD = 224;
+
+    uint8_t type;
+    uint8_t length;
+    uint8_t payload[MAX_PAYLOAD];
+};
+
+// Crash-safe append-only queue of telemetry records on a filesystem.
+//
+// Each record is framed as
+//   0xA5 | type | length | payload | crc16 (LE, over type..payload)
+// and appended with the file closed after every write, so a power cut can
+// at worst leave one torn frame at the tail; open() finds it and truncates
+// it away. A separate cursor file holds the offset of the first record not
+// yet acknowledged. It is replaced via write-then-rename, so it is always
+// either the old or the new value.
+//
+// Delivery is at least once: records between the cursor and the end are
+// replayed after a reboot until commit() moves past them. Once everything
+// is committed the log is truncated back to empty.
+//
+// Plain stdio, so the same code runs on LittleFS (mounted under /littlefs
+// on the ESP32) and on ordinary files in the native tests.
+class TelemetryLog {
+public:
+    static const uint8_t FRAME_MAGIC = 0xA5;
+    static const size_t FRAME_OVERHEAD = 5;
+
+    TelemetryLog(const char *logPath, const char *cursorPath, uint32_t maxBytes = 65536);
+
+    // Recover from a torn tail and load the cursor. Creates the files if needed.
+    bool open();
+    bool isOpen() const { return opened; }
+
+    // False if the log is full, the payload too long or the write failed
+    bool append(uint8_t type, const uint8_t *payload, uint8_t length);
+
+    // Read up to maxFrames records starting at offset (begin at cursor())
+    // and advance offset past them. Returns how many were read; 0 at the end.
+    size_t read(uint32_t &offset, TelemetryFrame *frames, size_t maxFrames) const;
+
+    // Acknowledge every record before offset
+    bool commit(uint32_t offset);
+
+    uint32_t cursor() const { return readCursor; }
+    uint32_t size() const { return endOffset; }
+    uint32_t pendingBytes() const { return endOffset - readCursor; }
+    bool empty() const { return readCursor >= endOffset; }
+
+    // Bytes of torn or corrupt tail dropped by the last open()
+    uint32_t recoveredBytes() const { return discardedBytes; }
+
+private:
+    bool loadCursor();
+    bool storeCursor(uint32_t offset);
+    bool truncateTo(uint32_t length);
+
+    const char *logPath;
+    const char *cursorPath;
+    uint32_t maxBytes;
+    uint32_t readCursor;
+    uint32_t endOffset;
+    uint32_t discardedBytes;
+    bool opened;
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include "TelemetryPacket.h"
+#include <string.h>
+#include "Base64.h"
+#include "Varint.h"
+
+void TelemetryPacketWriter::clear() {
+    buf[0] = TELEMETRY_PACKET_VERSION;
+    len = 1;
+    count = 0;
+    runStart = 0;
+    previous = MinuteRecord();
+}
+
+bool TelemetryPacketWriter::fits(uint8_t type, uint8_t length) const {
+    size_t record = type == RECORD_MINUTE ? MINUTE_MAX_BYTES : 1 + (size_t)length;
+    return len + 2 + record <= CAPACITY;
+}
+
+bool TelemetryPacketWriter::add(uint8_t type, const uint8_t *payload, uint8_t length) {
+    if (count == 0xFF) {
+        return false;
+    }
+    uint8_t record[TelemetryFrame::MAX_PAYLOAD + 1];
+    size_t n = 0;
+    bool newRun = runStart == 0 || buf[runStart] != type || buf[runStart + 1] == 0xFF;
+    if (type == RECORD_MINUTE) {
+        MinuteRecord minute;
+        if (!minute.decode(payload, length)) {
+            return false;
+        }
+        MinuteRecord from = newRun ? MinuteRecord() : previous;
+        n += putVarint(record + n, (int32_t)(minute.epoch - from.epoch));
+        n += putVarint(record + n, (int32_t)(minute.energyUwh - from.energyUwh));
+        n += putVarint(record + n, (int32_t)(minute.powerDw - from.powerDw));
+        n += putVarint(record + n, (int32_t)minute.currentMa - from.currentMa);
+        n += putVarint(record + n, (int32_t)minute.voltageDv - from.voltageDv);
+        record[n++] = minute.flags;
+        previous = minute;
+    } else {
+        record[n++] = length;
+        memcpy(record + n, payload, length);
+        n += length;
+    }
+    if (len + (newRun ? 2 : 0) + n > CAPACITY) {
+        return false;
+    }
+
+    if (newRun) {
+        runStart = len;
+        buf[len++] = type;
+        buf[len++] = 0;
+    }
+    memcpy(buf + len, record, n);
+    len += n;
+    buf[runStart + 1]++;
+    count++;
+    return true;
+}
+
+size_t TelemetryPacketWriter::encode(char *out, size_t size) const {
+    return base64Encode(buf, len, out, size);
+}
+
+TelemetryPacketReader::TelemetryPacketReader(const uint8_t *data, size_t length)
+    : data(data),
+      length(length),
+      offset(1),
+      runType(0),
+      runLeft(0),
+      known(length > 0 && data[0] == TELEMETRY_PACKET_VERSION),
+      broken(false) {}
+
+bool TelemetryPacketReader::fail() {
+    broken = true;
+    return false;
+}
+
+bool TelemetryPacketReader::next(TelemetryFrame &frame) {
+    if (!known || broken) {
+        return false;
+    }
+    if (runLeft == 0) {
+        if (offset >= length) {
+            return false;
+        }
+        if (offset + 2 > length || data[offset + 1] == 0) {
+            return fail();
+        }
+        runType = data[offset];
+        runLeft = data[offset + 1];
+        offset += 2;
+        previous = MinuteRecord();
+    }
+
+    frame.type = runType;
+    if (runType == RECORD_MINUTE) {
+        int32_t delta[5];
+        for (int k = 0; k < 5; k++) {
+            size_t n = getVarint(data + offset, length - offset, delta[k]);
+            if (n == 0) {
+                return fail();
+            }
+            offset += n;
+        }
+        if (offset >= length) {
+            return fail();
+        }
+        MinuteRecord minute;
+        minute.epoch = previous.epoch + (uint32_t)delta[0];
+        minute.energyUwh = previous.energyUwh + (uint32_t)delta[1];
+        minute.powerDw = previous.powerDw + (uint32_t)delta[2];
+        minute.currentMa = (uint16_t)(previous.currentMa + delta[3]);
+        minute.voltageDv = (uint16_t)(previous.voltageDv + delta[4]);
+        minute.flags = data[offset++];
+        frame.length = minute.encode(frame.payload);
+        previous = minute;
+    } else {
+        if (offset >= length) {
+            return fail();
+        }
+        uint8_t n = data[offset];
+        if (n > TelemetryFrame::MAX_PAYLOAD || offset + 1 + n > length) {
+            return fail();
+        }
+        frame.length = n;
+        memcpy(frame.payload, data + offset + 1, n);
+        offset += 1 + n;
+    }
+    runLeft--;
+    return true;
+}
+
+size_t decodeTelemetryPacket(const char *text, TelemetryFrame *frames, size_t maxFrames) {
+    uint8_t packet[TelemetryPacketWriter::CAPACITY];
+    size_t length = base64Decode(text, packet, sizeof(packet));
+    TelemetryPacketReader reader(packet, length);
+    size_t count = 0;
+    while (count < maxFrames && reader.next(frames[count])) {
+        count++;
+    }
+    return reader.valid() && !reader.malformed() ? count : 0;
+}
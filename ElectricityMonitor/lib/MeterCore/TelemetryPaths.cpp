@@ -0,0 +1,96 @@
+#include "TelemetryPaths.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+#include "TelemetryRecord.h"
+
+// snprintf that reports truncation as failure
+static size_t formatInto(char *out, size_t size, const char *format, ...) {
+    if (size == 0) {
+        return 0;
+    }
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(out, size, format, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= size) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)n;
+}
+
+static size_t formatLocal(uint32_t epoch, const char *format, char *out, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    time_t seconds = epoch;
+    struct tm timeinfo;
+    localtime_r(&seconds, &timeinfo);
+    size_t n = strftime(out, size, format, &timeinfo);
+    if (n == 0) {
+        out[0] = '\0';
+    }
+    return n;
+}
+
+size_t formatTimestamp(uint32_t epoch, char *out, size_t size) {
+    if (epoch == 0) {
+        if (size > 0) out[0] = '\0';
+        return 0;
+    }
+    return formatLocal(epoch, "%Y-%m-%d %H:%M:%S", out, size);
+}
+
+size_t formatDate(uint32_t date, char *out, size_t size) {
+    return formatInto(out, size, "%04lu-%02lu-%02lu", (unsigned long)(date / 10000),
+                      (unsigned long)(date / 100 % 100), (unsigned long)(date % 100));
+}
+
+size_t minutePath(uint32_t epoch, char *out, size_t size) {
+    return formatLocal(epoch, "history/minutes/%Y-%m-%d/%H/%M/", out, size);
+}
+
+size_t hourlyPath(uint32_t date, uint8_t hour, char *out, size_t size) {
+    char day[12];
+    formatDate(date, day, sizeof(day));
+    return formatInto(out, size, "history/hourly/%s/%u/", day, hour);
+}
+
+size_t packedPath(uint32_t epoch, char *out, size_t size) {
+    return formatLocal(epoch, "history/packed/%Y-%m-%d/", out, size);
+}
+
+size_t profilePath(uint32_t date, uint8_t hour, char *out, size_t size) {
+    char day[12];
+    formatDate(date, day, sizeof(day));
+    return formatInto(out, size, "history/hourly/%s/%u/profile/", day, hour);
+}
+
+size_t healthPath(uint32_t date, uint8_t hour, char *out, size_t size) {
+    char day[12];
+    formatDate(date, day, sizeof(day));
+    return formatInto(out, size, "diagnostics/health/%s/%u/", day, hour);
+}
+
+size_t rollupPath(uint8_t kind, uint32_t period, char *out, size_t size) {
+    if (kind == ROLLUP_DAY) {
+        char day[12];
+        formatDate(period, day, sizeof(day));
+        return formatInto(out, size, "history/daily/%s/", day);
+    }
+    return formatInto(out, size, "history/monthly/%04lu-%02lu/",
+                      (unsigned long)(period / 100), (unsigned long)(period % 100));
+}
+
+size_t unitPath(const char *building, const char *unit, const char *leaf, char *out, size_t size) {
+    return formatInto(out, size, "/buildings/%s/units/%s/%s", building, unit, leaf);
+}
+
+size_t buildingPath(const char *building, char *out, size_t size) {
+    return formatInto(out, size, "/buildings/%s/", building);
+}
+
+size_t unitKeyRoot(const char *unit, char *out, size_t size) {
+    return formatInto(out, size, "units/%s/", unit);
+}
@@ -0,0 +1,49 @@
+#ifndef TELEMETRY_PATHS_H
+#define TELEMETRY_PATHS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Keys and timestamps for the RTDB tree, formatted into caller buffers so
+// nothing on the publish path touches the heap. Every function returns the
+// length written, or 0 (and an empty string) if it didn't fit.
+//
+// Times are local, as set by configTime() on the device (TZ in the tests).
+
+const size_t TIMESTAMP_CHARS = 20;   // "2025-11-04 14:30:45" and the terminator
+const size_t PATH_CHARS = 48;        // room for any history/... prefix below
+
+// "YYYY-MM-DD HH:MM:SS", or "" for epoch 0 (clock not set)
+size_t formatTimestamp(uint32_t epoch, char *out, size_t size);
+
+// YYYYMMDD -> "YYYY-MM-DD"
+size_t formatDate(uint32_t date, char *out, size_t size);
+
+// history/minutes/YYYY-MM-DD/HH/MM/
+size_t minutePath(uint32_t epoch, char *out, size_t size);
+
+// history/hourly/YYYY-MM-DD/H/
+size_t hourlyPath(uint32_t date, uint8_t hour, char *out, size_t size);
+
+// history/hourly/YYYY-MM-DD/H/profile/
+size_t profilePath(uint32_t date, uint8_t hour, char *out, size_t size);
+
+// history/packed/YYYY-MM-DD/, for the day of epoch (see TelemetryPacket.h)
+size_t packedPath(uint32_t epoch, char *out, size_t size);
+
+// diagnostics/health/YYYY-MM-DD/H/
+size_t healthPath(uint32_t date, uint8_t hour, char *out, size_t size);
+
+// history/daily/YYYY-MM-DD/ for a ROLLUP_DAY, history/monthly/YYYY-MM/ otherwise
+size_t rollupPath(uint8_t kind, uint32_t period, char *out, size_t size);
+
+// /buildings/<building>/units/<unit>/<leaf>, built once at startup
+size_t unitPath(const char *building, const char *unit, const char *leaf, char *out, size_t size);
+
+// /buildings/<building>/, where a board metering several units sends its updates
+size_t buildingPath(const char *building, char *out, size_t size);
+
+// units/<unit>/, a unit's keys relative to buildingPath()
+size_t unitKeyRoot(const char *unit, char *out, size_t size);
+
+#endif
@@ -0,0 +1,253 @@
+#include "TelemetryRecord.h"
+
+static uint8_t *putU8(uint8_t *out, uint8_t value) {
+    *out++ = value;
+    return out;
+}
+
+static uint8_t *putU16(uint8_t *out, uint16_t value) {
+    *out++ = (uint8_t)value;
+    *out++ = (uint8_t)(value >> 8);
+    return out;
+}
+
+static uint8_t *putU32(uint8_t *out, uint32_t value) {
+    out = putU16(out, (uint16_t)value);
+    return putU16(out, (uint16_t)(value >> 16));
+}
+
+static uint8_t *putU64(uint8_t *out, uint64_t value) {
+    out = putU32(out, (uint32_t)value);
+    return putU32(out, (uint32_t)(value >> 32));
+}
+
+static const uint8_t *getU8(const uint8_t *in, uint8_t &value) {
+    value = *in++;
+    return in;
+}
+
+static const uint8_t *getU16(const uint8_t *in, uint16_t &value) {
+    value = (uint16_t)(in[0] | (in[1] << 8));
+    return in + 2;
+}
+
+static const uint8_t *getU32(const uint8_t *in, uint32_t &value) {
+    uint16_t low, high;
+    in = getU16(in, low);
+    in = getU16(in, high);
+    value = low | ((uint32_t)high << 16);
+    return in;
+}
+
+static const uint8_t *getU64(const uint8_t *in, uint64_t &value) {
+    uint32_t low, high;
+    in = getU32(in, low);
+    in = getU32(in, high);
+    value = low | ((uint64_t)high << 32);
+    return in;
+}
+
+static uint8_t *putSummary(uint8_t *out, const LatencySummary &summary) {
+    out = putU32(out, summary.count);
+    out = putU32(out, summary.p50);
+    out = putU32(out, summary.p90);
+    out = putU32(out, summary.p99);
+    return putU32(out, summary.max);
+}
+
+static const uint8_t *getSummary(const uint8_t *in, LatencySummary &summary) {
+    in = getU32(in, summary.count);
+    in = getU32(in, summary.p50);
+    in = getU32(in, summary.p90);
+    in = getU32(in, summary.p99);
+    return getU32(in, summary.max);
+}
+
+uint32_t toFixedU32(float value, float scale) {
+    double scaled = (double)value * scale + 0.5;
+    if (!(scaled > 0)) return 0;  // also catches NaN
+    if (scaled >= 4294967295.0) return 0xFFFFFFFFu;
+    return (uint32_t)scaled;
+}
+
+uint16_t toFixedU16(float value, float scale) {
+    uint32_t fixed = toFixedU32(value, scale);
+    return fixed > 0xFFFF ? 0xFFFF : (uint16_t)fixed;
+}
+
+MinuteRecord::MinuteRecord()
+    : epoch(0), energyUwh(0), powerDw(0), currentMa(0), voltageDv(0), flags(0) {}
+
+uint8_t MinuteRecord::encode(uint8_t *out) const {
+    uint8_t *p = out;
+    p = putU32(p, epoch);
+    p = putU32(p, energyUwh);
+    p = putU32(p, powerDw);
+    p = putU16(p, currentMa);
+    p = putU16(p, voltageDv);
+    p = putU8(p, flags);
+    return (uint8_t)(p - out);
+}
+
+bool MinuteRecord::decode(const uint8_t *in, uint8_t length) {
+    if (length != ENCODED_SIZE) {
+        return false;
+    }
+    in = getU32(in, epoch);
+    in = getU32(in, energyUwh);
+    in = getU32(in, powerDw);
+    in = getU16(in, currentMa);
+    in = getU16(in, voltageDv);
+    getU8(in, flags);
+    return true;
+}
+
+HourlyRecord::HourlyRecord()
+    : date(0), hour(0), samples(0), energyMwh(0), avgPowerDw(0), peakPowerDw(0),
+      avgApparentDva(0), avgCurrentMa(0), powerFactorPermille(0), savedAt(0) {}
+
+uint8_t HourlyRecord::encode(uint8_t *out) const {
+    uint8_t *p = out;
+    p = putU32(p, date);
+    p = putU8(p, hour);
+    p = putU16(p, samples);
+    p = putU32(p, energyMwh);
+    p = putU32(p, avgPowerDw);
+    p = putU32(p, peakPowerDw);
+    p = putU32(p, avgApparentDva);
+    p = putU16(p, avgCurrentMa);
+    p = putU16(p, powerFactorPermille);
+    p = putU32(p, savedAt);
+    return (uint8_t)(p - out);
+}
+
+bool HourlyRecord::decode(const uint8_t *in, uint8_t length) {
+    if (length != ENCODED_SIZE) {
+        return false;
+    }
+    in = getU32(in, date);
+    in = getU8(in, hour);
+    in = getU16(in, samples);
+    in = getU32(in, energyMwh);
+    in = getU32(in, avgPowerDw);
+    in = getU32(in, peakPowerDw);
+    in = getU32(in, avgApparentDva);
+    in = getU16(in, avgCurrentMa);
+    in = getU16(in, powerFactorPermille);
+    getU32(in, savedAt);
+    return true;
+}
+
+RollupRecord::RollupRecord() : kind(0), savedAt(0) {}
+
+uint8_t RollupRecord::encode(uint8_t *out) const {
+    uint8_t *p = out;
+    p = putU8(p, kind);
+    p = putU32(p, totals.period);
+    p = putU32(p, totals.samples);
+    p = putU64(p, totals.energyMws);
+    p = putU32(p, totals.seconds);
+    p = putU32(p, totals.peakPowerDw);
+    p = putU32(p, totals.peakDemandDw);
+    p = putU32(p, savedAt);
+    return (uint8_t)(p - out);
+}
+
+bool RollupRecord::decode(const uint8_t *in, uint8_t length) {
+    if (length != ENCODED_SIZE) {
+        return false;
+    }
+    in = getU8(in, kind);
+    in = getU32(in, totals.period);
+    in = getU32(in, totals.samples);
+    in = getU64(in, totals.energyMws);
+    in = getU32(in, totals.seconds);
+    in = getU32(in, totals.peakPowerDw);
+    in = getU32(in, totals.peakDemandDw);
+    getU32(in, savedAt);
+    return kind == ROLLUP_DAY || kind == ROLLUP_MONTH;
+}
+
+ProfileRecord::ProfileRecord() : date(0), hour(0), part(0), length(0) {}
+
+uint8_t ProfileRecord::encode(uint8_t *out) const {
+    uint8_t *p = out;
+    p = putU32(p, date);
+    p = putU8(p, hour);
+    p = putU8(p, part);
+    for (uint8_t k = 0; k < length; k++) {
+        p = putU8(p, data[k]);
+    }
+    return (uint8_t)(p - out);
+}
+
+bool ProfileRecord::decode(const uint8_t *in, uint8_t frameLength) {
+    if (frameLength < HEADER_SIZE || frameLength - HEADER_SIZE > MAX_DATA) {
+        return false;
+    }
+    in = getU32(in, date);
+    in = getU8(in, hour);
+    in = getU8(in, part);
+    length = frameLength - HEADER_SIZE;
+    for (uint8_t k = 0; k < length; k++) {
+        in = getU8(in, data[k]);
+    }
+    return true;
+}
+
+HealthRecord::HealthRecord()
+    : date(0), hour(0), heapFree(0), heapLowWater(0), logBacklogMax(0), sampleDrops(0),
+      firebaseErrors(0), maxConsecutiveErrors(0), ackTimeouts(0), creditTimeouts(0),
+      reconnects(0), linkDrops(0), queueHighWater(0), savedAt(0) {}
+
+uint8_t HealthRecord::encode(uint8_t *out) const {
+    uint8_t *p = out;
+    p = putU32(p, date);
+    p = putU8(p, hour);
+    p = putSummary(p, loopUs);
+    p = putSummary(p, passUs);
+    p = putSummary(p, meteringUs);
+    for (uint8_t kind = 0; kind < RTT_KINDS; kind++) {
+        p = putSummary(p, roundTripMs[kind]);
+    }
+    p = putU32(p, heapFree);
+    p = putU32(p, heapLowWater);
+    p = putU32(p, logBacklogMax);
+    p = putU32(p, sampleDrops);
+    p = putU16(p, firebaseErrors);
+    p = putU16(p, maxConsecutiveErrors);
+    p = putU16(p, ackTimeouts);
+    p = putU16(p, creditTimeouts);
+    p = putU16(p, reconnects);
+    p = putU16(p, linkDrops);
+    p = putU8(p, queueHighWater);
+    p = putU32(p, savedAt);
+    return (uint8_t)(p - out);
+}
+
+bool HealthRecord::decode(const uint8_t *in, uint8_t length) {
+    if (length != ENCODED_SIZE) {
+        return false;
+    }
+    in = getU32(in, date);
+    in = getU8(in, hour);
+    in = getSummary(in, loopUs);
+    in = getSummary(in, passUs);
+    in = getSummary(in, meteringUs);
+    for (uint8_t kind = 0; kind < RTT_KINDS; kind++) {
+        in = getSummary(in, roundTripMs[kind]);
+    }
+    in = getU32(in, heapFree);
+    in = getU32(in, heapLowWater);
+    in = getU32(in, logBacklogMax);
+    in = getU32(in, sampleDrops);
+    in = getU16(in, firebaseErrors);
+    in = getU16(in, maxConsecutiveErrors);
+    in = getU16(in, ackTimeouts);
+    in = getU16(in, creditTimeouts);
+    in = getU16(in, reconnects);
+    in = getU16(in, linkDrops);
+    in = getU8(in, queueHighWater);
+    getU32(in, savedAt);
+    return true;
+}
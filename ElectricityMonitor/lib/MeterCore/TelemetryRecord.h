@@ -0,0 +1,135 @@
+#ifndef TELEMETRY_RECORD_H
+#define TELEMETRY_RECORD_H
+
+#include <stdint.h>
+#include "EnergyRollup.h"
+#include "HealthStats.h"
+
+// Compact binary records kept in the telemetry log while they wait for
+// Firebase. Fields are fixed point and written little-endian byte by byte,
+// so the encoding doesn't depend on struct padding or the host's byte order.
+
+enum TelemetryRecordType {
+    RECORD_MINUTE = 1,
+    RECORD_HOURLY = 2,
+    RECORD_ROLLUP = 3,
+    RECORD_PROFILE = 4,
+    RECORD_HEALTH = 5
+};
+
+// Which period a rollup record covers
+enum RollupKind {
+    ROLLUP_DAY = 1,
+    ROLLUP_MONTH = 2
+};
+
+// Flags on a minute record
+const uint8_t MINUTE_RELAY_ON = 0x01;  // energy was drawn on credit (the ledger has already taken it)
+
+// One reading taken while the device could not publish
+struct MinuteRecord {
+    uint32_t epoch;        // seconds since 1970, 0 if the clock wasn't set
+    uint32_t energyUwh;    // micro-watt-hours in this interval
+    uint32_t powerDw;      // real power, 0.1 W
+    uint16_t currentMa;
+    uint16_t voltageDv;    // 0.1 V
+    uint8_t flags;
+
+    static const uint8_t ENCODED_SIZE = 17;
+
+    MinuteRecord();
+    uint8_t encode(uint8_t *out) const;
+    bool decode(const uint8_t *in, uint8_t length);
+
+    float energyKwh() const { return energyUwh / 1e9f; }
+};
+
+// A finished hour, written ahead to the log before it is published
+struct HourlyRecord {
+    uint32_t date;             // local date as YYYYMMDD
+    uint8_t hour;              // local hour, 0-23
+    uint16_t samples;
+    uint32_t energyMwh;        // milli-watt-hours (1e-6 kWh)
+    uint32_t avgPowerDw;       // 0.1 W
+    uint32_t peakPowerDw;      // 0.1 W
+    uint32_t avgApparentDva;   // 0.1 VA
+    uint16_t avgCurrentMa;
+    uint16_t powerFactorPermille;
+    uint32_t savedAt;          // epoch seconds
+
+    static const uint8_t ENCODED_SIZE = 31;
+
+    HourlyRecord();
+    uint8_t encode(uint8_t *out) const;
+    bool decode(const uint8_t *in, uint8_t length);
+
+    float energyKwh() const { return energyMwh / 1e6f; }
+};
+
+// Day or month totals as they stood after an hour was added. Each one
+// replaces the last on the server, so replaying a run of them leaves the
+// final value of every period.
+struct RollupRecord {
+    uint8_t kind;              // RollupKind
+    RollupTotals totals;
+    uint32_t savedAt;          // epoch seconds
+
+    static const uint8_t ENCODED_SIZE = 33;
+
+    RollupRecord();
+    uint8_t encode(uint8_t *out) const;
+    bool decode(const uint8_t *in, uint8_t length);
+};
+
+// Part of an hour's delta-encoded minute profile (see MinuteProfile.h).
+// Each part decodes on its own; a long hour just takes more than one.
+struct ProfileRecord {
+    static const uint8_t HEADER_SIZE = 6;
+    static const uint8_t MAX_DATA = 218;   // a full frame less the header
+
+    uint32_t date;             // local date as YYYYMMDD
+    uint8_t hour;
+    uint8_t part;              // 0, 1, ... in sample order
+    uint8_t length;            // bytes used in data
+    uint8_t data[MAX_DATA];
+
+    ProfileRecord();
+    uint8_t encode(uint8_t *out) const;
+    bool decode(const uint8_t *in, uint8_t length);
+};
+
+// How the network task fared over an hour (see HealthStats.h): latencies
+// as percentile summaries, plus the counters and the heap
+struct HealthRecord {
+    uint32_t date;             // local date as YYYYMMDD
+    uint8_t hour;
+    LatencySummary loopUs;
+    LatencySummary passUs;
+    LatencySummary meteringUs;
+    LatencySummary roundTripMs[RTT_KINDS];
+    uint32_t heapFree;         // bytes, at the close of the hour
+    uint32_t heapLowWater;     // bytes, lowest since boot
+    uint32_t logBacklogMax;
+    uint32_t sampleDrops;
+    uint16_t firebaseErrors;
+    uint16_t maxConsecutiveErrors;
+    uint16_t ackTimeouts;
+    uint16_t creditTimeouts;
+    uint16_t reconnects;
+    uint16_t linkDrops;
+    uint8_t queueHighWater;
+    uint32_t savedAt;          // epoch seconds
+
+    static const uint8_t ENCODED_SIZE = 178;
+
+    HealthRecord();
+    uint8_t encode(uint8_t *out) const;
+    bool decode(const uint8_t *in, uint8_t length);
+};
+
+// Float -> fixed point for the encoders: rounded, clamped at 0 and at the
+// field's maximum so a wild reading can't wrap around
+uint32_t toFixedU32(float value, float scale);
+uint16_t toFixedU16(float value, float scale);
+
+#endif
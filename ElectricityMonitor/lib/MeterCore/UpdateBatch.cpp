@@ -0,0 +1,116 @@
+#include "UpdateBatch.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+UpdateBatch::UpdateBatch() : rootLen(0) {
+    root[0] = '\0';
+    clear();
+}
+
+void UpdateBatch::clear() {
+    buf[0] = '{';
+    buf[1] = '}';
+    buf[2] = '\0';
+    len = 2;
+    prefix[0] = '\0';
+    fields = 0;
+    overflow = false;
+}
+
+void UpdateBatch::setPrefix(const char *newPrefix) {
+    size_t n = strlen(newPrefix);
+    if (n >= PREFIX_CAPACITY) {
+        n = PREFIX_CAPACITY - 1;
+        overflow = true;
+    }
+    memcpy(prefix, newPrefix, n);
+    prefix[n] = '\0';
+}
+
+void UpdateBatch::setRoot(const char *newRoot) {
+    size_t n = strlen(newRoot);
+    if (n >= ROOT_CAPACITY) {
+        n = ROOT_CAPACITY - 1;
+        overflow = true;
+    }
+    memcpy(root, newRoot, n);
+    root[n] = '\0';
+    rootLen = n;
+}
+
+void UpdateBatch::add(const char *key, float value, uint8_t decimals) {
+    size_t rollback = len;
+    char number[24];
+    // NaN/Inf are not valid JSON; a broken sensor reading goes up as 0
+    if (!isfinite(value)) value = 0;
+    snprintf(number, sizeof(number), "%.*f", decimals, value);
+    commitField(rollback, beginField(key) && append(number));
+}
+
+void UpdateBatch::add(const char *key, int32_t value) {
+    size_t rollback = len;
+    char number[16];
+    snprintf(number, sizeof(number), "%ld", (long)value);
+    commitField(rollback, beginField(key) && append(number));
+}
+
+void UpdateBatch::add(const char *key, const char *value) {
+    size_t rollback = len;
+    commitField(rollback, beginField(key) && append("\"") && appendEscaped(value) && append("\""));
+}
+
+void UpdateBatch::addIncrement(const char *key, double delta, uint8_t decimals) {
+    size_t rollback = len;
+    char number[24];
+    if (!isfinite(delta)) delta = 0;
+    snprintf(number, sizeof(number), "%.*f", decimals, delta);
+    commitField(rollback, beginField(key) && append("{\".sv\":{\"increment\":") &&
+                          append(number) && append("}}"));
+}
+
+bool UpdateBatch::beginField(const char *key) {
+    len--;  // drop the closing brace while the field is written
+    return append(fields > 0 ? ",\"" : "\"") && appendEscaped(root) && appendEscaped(prefix) &&
+           appendEscaped(key) && append("\":");
+}
+
+bool UpdateBatch::append(const char *text) {
+    size_t n = strlen(text);
+    // Always keep room for the closing brace and terminator
+    if (len + n + 2 > CAPACITY) {
+        return false;
+    }
+    memcpy(buf + len, text, n);
+    len += n;
+    return true;
+}
+
+bool UpdateBatch::appendEscaped(const char *text) {
+    char escaped[3] = { '\\', 0, 0 };
+    char plain[2] = { 0, 0 };
+    for (const char *c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            escaped[1] = *c;
+            if (!append(escaped)) return false;
+        } else if ((unsigned char)*c < 0x20) {
+            // Control characters never belong in our keys or values
+            continue;
+        } else {
+            plain[0] = *c;
+            if (!append(plain)) return false;
+        }
+    }
+    return true;
+}
+
+void UpdateBatch::commitField(size_t rollback, bool ok) {
+    if (ok) {
+        fields++;
+    } else {
+        len = rollback - 1;
+        overflow = true;
+    }
+    buf[len++] = '}';
+    buf[len] = '\0';
+}
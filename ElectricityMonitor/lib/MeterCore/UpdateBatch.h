@@ -0,0 +1,65 @@
+#ifndef UPDATE_BATCH_H
+#define UPDATE_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Collects every field written in one cycle into a single flat JSON object
+// for an RTDB multi-location update, e.g.
+//   {"power":412.5,"history/hourly/2025-11-04/10/energy":0.41}
+// Keys are written literally, slashes included. (FirebaseJson would turn
+// "history/hourly/..." into nested objects, and an update with a nested
+// "history" object replaces that whole subtree.)
+//
+// Fixed buffer, no heap. The JSON is always well formed: a field that
+// doesn't fit is dropped and overflowed() is set.
+class UpdateBatch {
+public:
+    static const size_t CAPACITY = 2048;
+    static const size_t PREFIX_CAPACITY = 96;
+    static const size_t ROOT_CAPACITY = 48;
+
+    UpdateBatch();
+
+    void clear();
+
+    // Prepended to every key added after this call, e.g. "history/hourly/2025-11-04/10/"
+    void setPrefix(const char *prefix);
+
+    // Prepended ahead of the prefix, and kept across clear(): "units/<unit>/"
+    // when the update is sent to the building rather than the unit
+    void setRoot(const char *root);
+    size_t rootLength() const { return rootLen; }
+
+    void add(const char *key, float value, uint8_t decimals = 4);
+    void add(const char *key, int32_t value);
+    void add(const char *key, const char *value);
+
+    // Server-side increment, {".sv":{"increment":<delta>}}: RTDB adds delta
+    // to whatever the value is when the update lands
+    void addIncrement(const char *key, double delta, uint8_t decimals = 4);
+
+    bool empty() const { return fields == 0; }
+    size_t fieldCount() const { return fields; }
+    bool overflowed() const { return overflow; }
+
+    const char *json() const { return buf; }
+    size_t length() const { return len; }
+
+private:
+    // Appends ,"<root><prefix><key>":<raw value> before the closing brace
+    bool beginField(const char *key);
+    bool append(const char *text);
+    bool appendEscaped(const char *text);
+    void commitField(size_t rollback, bool ok);
+
+    char buf[CAPACITY];
+    char prefix[PREFIX_CAPACITY];
+    char root[ROOT_CAPACITY];
+    size_t rootLen;
+    size_t len;
+    size_t fields;
+    bool overflow;
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Zigzag varints for delta encodings: a change of -64..63 is one byte, and
+// any int32_t at most five. Writes into out and returns the bytes used.
+inline size_t putVarint(uint8_t *out, int32_t delta) {
+    uint32_t value = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);   // zigzag
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+// Returns the bytes consumed, 0 if the varint runs past the end or is too long
+inline size_t getVarint(const uint8_t *in, size_t length, int32_t &delta) {
+    uint32_t value = 0;
+    for (size_t n = 0; n < length && n < 5; n++) {
+        value |= (uint32_t)(in[n] & 0x7F) << (7 * n);
+        if ((in[n] & 0x80) == 0) {
+            delta = (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef ZERO_CROSS_DETECTOR_H
+#define ZERO_CROSS_DETECTOR_H
+
+#include <stdint.h>
+
+// Rising zero-crossing detector for the mains voltage channel. Input is the
+// sample minus the ADC centre. A crossing only counts after the signal has
+// been below -hysteresis, so noise around zero can't double-trigger.
+class ZeroCrossDetector {
+public:
+    explicit ZeroCrossDetector(int32_t hysteresis = 40)
+        : hysteresis(hysteresis), previous(0), armed(false), fraction(0) {}
+
+    void reset() {
+        previous = 0;
+        armed = false;
+        fraction = 0;
+    }
+
+    // Returns true when the signal crossed zero going up between the
+    // previous sample and this one
+    bool update(int32_t value) {
+        bool crossed = false;
+        if (value < -hysteresis) {
+            armed = true;
+        } else if (armed && value >= 0) {
+            // Linear interpolation between the two samples straddling zero
+            fraction = (float)(-previous) / (float)(value - previous);
+            armed = false;
+            crossed = true;
+        }
+        previous = value;
+        return crossed;
+    }
+
+    // Where the last crossing fell between the two samples, 0..1 of a sample
+    float crossingFraction() const { return fraction; }
+
+private:
+    int32_t hysteresis;
+    int32_t previous;
+    bool armed;
+    float fraction;
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "BuildingSim.h"
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include <TelemetryPaths.h>
+
+BuildingSim::BuildingSim(const BuildingSimConfig &config)
+    : cfg(config),
+      sim(config.startEpoch),
+      readingTimer(config.readingCadence),
+      dayEpoch(0),
+      daySecond(0),
+      readingCount(0) {
+    if (cfg.channels > MAX_METER_CHANNELS) cfg.channels = MAX_METER_CHANNELS;
+    LoadStep idle = { 0, 0.0f, 1.0f };
+    for (uint8_t c = 0; c < MAX_METER_CHANNELS; c++) {
+        char path[96];
+        ::unitPath(cfg.monitor.buildingId, cfg.unitIds[c], "", path, sizeof(path));
+        unitBases[c] = path;
+        snprintf(path, sizeof(path), "/tmp/emonitor_building_%u.log", (unsigned)c);
+        logPaths[c] = path;
+        snprintf(path, sizeof(path), "/tmp/emonitor_building_%u.pos", (unsigned)c);
+        cursorPaths[c] = path;
+        loads[c].assign(1, idle);
+        trueMws[c] = 0;
+    }
+}
+
+void BuildingSim::setLoad(uint8_t channel, const std::vector<LoadStep> &daily) {
+    if (channel < MAX_METER_CHANNELS && !daily.empty()) {
+        loads[channel] = daily;
+    }
+}
+
+void BuildingSim::start() {
+    for (uint8_t c = 0; c < MAX_METER_CHANNELS; c++) {
+        remove(logPaths[c].c_str());
+        remove(cursorPaths[c].c_str());
+    }
+    boot();
+}
+
+void BuildingSim::reboot() {
+    boot();
+}
+
+// The building's setup(): a MonitorApp per channel on the hub's ports
+void BuildingSim::boot() {
+    for (uint8_t c = 0; c < MAX_METER_CHANNELS; c++) {
+        monitors[c].reset();
+    }
+    ring.reset(new ChannelFrameRing());
+    source.reset(new FakeChannelFrameSource(cfg.channels, cfg.sampleRateHz));
+    meter.reset(new MultiChannelMeter());
+    queues.reset(new ReadingQueue[MAX_METER_CHANNELS]);
+    calibrations.reset(new CalibrationMailbox[MAX_METER_CHANNELS]);
+    livePower.reset(new LivePower[MAX_METER_CHANNELS]());
+    building.reset(new BuildingHub(sim));
+
+    sim.restartFirebase();
+    sim.attach(building.get());
+    BuildingHubConfig hubConfig = cfg.hub;
+    hubConfig.buildingId = cfg.monitor.buildingId;
+    building->configure(hubConfig, cfg.channels);
+
+    MeterConfig meterConfig;
+    meterConfig.sampleRateHz = cfg.sampleRateHz;
+    meterConfig.voltsPerCount = cfg.voltsPerCount;
+    meterConfig.ampsPerCount = cfg.ampsPerCount;
+    meter->configure(meterConfig, cfg.channels);
+
+    for (uint8_t c = 0; c < cfg.channels; c++) {
+        MonitorPlatform &port = building->port(c);
+        telemetryLogs[c].reset(new TelemetryLog(logPaths[c].c_str(), cursorPaths[c].c_str(), cfg.logMaxBytes));
+        monitors[c].reset(new MonitorApp(port, queues[c], *telemetryLogs[c]));
+        building->attach(c, monitors[c].get());
+
+        MonitorConfig unit = cfg.monitor;
+        unit.unitId = cfg.unitIds[c];
+        unit.publishUnderBuilding = true;
+        unit.uploadEventLog = c == 0;
+        monitors[c]->restore(unit);
+
+        meter->setCalibration(c, monitors[c]->calibration());
+        meter->seedOffsets(c, port.loadFloat("iOffset", 2048), port.loadFloat("vOffset", 2048));
+        telemetryLogs[c]->open();
+        monitors[c]->watchSampleRing(ring.get());
+        monitors[c]->watchCalibration(&calibrations[c]);
+        monitors[c]->watchLivePower(&livePower[c]);
+        monitors[c]->begin();
+    }
+    source->begin(*ring);
+    readingTimer.start(sim.nowMs());
+}
+
+uint32_t BuildingSim::secondOfDay(uint32_t epoch) {
+    if (epoch != dayEpoch) {
+        time_t seconds = epoch;
+        struct tm timeinfo;
+        localtime_r(&seconds, &timeinfo);
+        dayEpoch = epoch;
+        daySecond = timeinfo.tm_hour * 3600 + timeinfo.tm_min * 60 + timeinfo.tm_sec;
+    }
+    return daySecond;
+}
+
+const LoadStep &BuildingSim::loadAt(uint8_t channel, uint32_t second) const {
+    const std::vector<LoadStep> &load = loads[channel];
+    const LoadStep *current = &load.front();
+    for (size_t k = 0; k < load.size(); k++) {
+        if (load[k].fromSecond <= second) {
+            current = &load[k];
+        }
+    }
+    return *current;
+}
+
+void BuildingSim::meteringPeriod() {
+    uint32_t second = secondOfDay(cfg.startEpoch + sim.nowMs() / 1000);
+    const float root2 = 1.41421356f;
+    for (uint8_t c = 0; c < cfg.channels; c++) {
+        const LoadStep &step = loadAt(c, second);
+        float amps = sim.relay(c) ? step.amps : 0.0f;
+
+        FakeWaveform wave;
+        wave.frequencyHz = mains.frequencyHz;
+        wave.voltageAmplitude = mains.voltsRms * root2 / cfg.voltsPerCount;
+        wave.currentAmplitude = amps * root2 / cfg.ampsPerCount;
+        wave.currentPhaseRad = acosf(step.powerFactor);
+        source->setWaveform(c, wave);
+        trueMws[c] += (double)mains.voltsRms * amps * step.powerFactor * cfg.meteringPeriodMs;
+    }
+    source->generate(cfg.sampleRateHz * cfg.meteringPeriodMs / 1000);
+
+    takeCalibrations(*meter, calibrations.get());
+    SimPlatform &clock = sim;
+    if (runMultiMeteringPeriod(*meter, *ring, queues.get(), readingTimer, sim.nowMs(),
+                               [&clock]() { return clock.epoch(); }, livePower.get())) {
+        readingCount++;
+    }
+}
+
+void BuildingSim::run(uint32_t seconds) {
+    for (uint32_t s = 0; s < seconds; s++) {
+        runMs(1000);
+    }
+}
+
+void BuildingSim::runMs(uint32_t ms) {
+    uint32_t passMs = cfg.meteringPeriodMs / cfg.networkPassesPerPeriod;
+    for (uint32_t elapsed = 0; elapsed < ms; elapsed += cfg.meteringPeriodMs) {
+        meteringPeriod();
+        for (uint32_t p = 0; p < cfg.networkPassesPerPeriod; p++) {
+            sim.deliver();
+            for (uint8_t c = 0; c < cfg.channels; c++) {
+                monitors[c]->pass();
+            }
+            building->pass();
+            sim.advance(passMs);
+        }
+    }
+}
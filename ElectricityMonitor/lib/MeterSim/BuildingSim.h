@@ -0,0 +1,90 @@
+#ifndef BUILDING_SIM_H
+#define BUILDING_SIM_H
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <BuildingHub.h>
+#include <FakeSampleSource.h>
+#include <MonitorApp.h>
+#include <MultiChannelMeter.h>
+#include <ReadingQueue.h>
+#include <TelemetryLog.h>
+#include "MonitorSim.h"
+#include "SimPlatform.h"
+
+struct BuildingSimConfig {
+    uint32_t startEpoch = 1762214400;     // 2025-11-04 00:00:00 UTC
+    uint32_t sampleRateHz = 1000;
+    ReadingCadence readingCadence;        // the firmware's
+    uint32_t meteringPeriodMs = 20;
+    uint32_t networkPassesPerPeriod = 4;
+    float voltsPerCount = 0.21665;        // as SimConfig
+    float ampsPerCount = 0.0082622;
+    uint8_t channels = 3;
+    const char *unitIds[MAX_METER_CHANNELS] = { "unit_002", "unit_003", "unit_004", "unit_005" };
+    uint32_t logMaxBytes = 131072;
+    MonitorConfig monitor;                // every unit's, but for its id
+    BuildingHubConfig hub;
+};
+
+// MonitorSim for a board metering several units: one voltage sensor and a
+// current sensor and relay per channel into the real MultiChannelMeter, a
+// MonitorApp per unit on the real BuildingHub, all on one SimPlatform.
+class BuildingSim {
+public:
+    explicit BuildingSim(const BuildingSimConfig &config = BuildingSimConfig());
+
+    // Each channel's load, repeated daily; a channel's relay gates its own
+    void setLoad(uint8_t channel, const std::vector<LoadStep> &daily);
+
+    void start();
+    void reboot();
+
+    void run(uint32_t seconds);
+    void runMs(uint32_t ms);
+
+    double trueEnergyKwh(uint8_t channel) const { return trueMws[channel] / 3.6e9; }
+
+    SimPlatform &platform() { return sim; }
+    FakeRtdb &rtdb() { return sim.rtdb(); }
+    BuildingHub &hub() { return *building; }
+    MonitorApp &app(uint8_t channel) { return *monitors[channel]; }
+    const BuildingSimConfig &config() const { return cfg; }
+    // "/buildings/<building>/units/<unit>/" of a channel
+    const std::string &unitPath(uint8_t channel) const { return unitBases[channel]; }
+    uint32_t readingsQueued() const { return readingCount; }
+
+private:
+    void boot();
+    uint32_t secondOfDay(uint32_t epoch);
+    const LoadStep &loadAt(uint8_t channel, uint32_t second) const;
+    void meteringPeriod();
+
+    BuildingSimConfig cfg;
+    SimPlatform sim;
+    std::vector<LoadStep> loads[MAX_METER_CHANNELS];
+    MainsSupply mains;
+    std::string unitBases[MAX_METER_CHANNELS];
+    std::string logPaths[MAX_METER_CHANNELS];
+    std::string cursorPaths[MAX_METER_CHANNELS];
+
+    std::unique_ptr<ChannelFrameRing> ring;
+    std::unique_ptr<FakeChannelFrameSource> source;
+    std::unique_ptr<MultiChannelMeter> meter;
+    std::unique_ptr<ReadingQueue[]> queues;
+    std::unique_ptr<CalibrationMailbox[]> calibrations;
+    std::unique_ptr<LivePower[]> livePower;
+    std::unique_ptr<BuildingHub> building;
+    std::unique_ptr<TelemetryLog> telemetryLogs[MAX_METER_CHANNELS];
+    std::unique_ptr<MonitorApp> monitors[MAX_METER_CHANNELS];
+    ReadingTimer readingTimer;
+
+    uint32_t dayEpoch;           // secondOfDay()'s last answer
+    uint32_t daySecond;
+    double trueMws[MAX_METER_CHANNELS];
+    uint32_t readingCount;
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include "FakeRtdb.h"
+#include <stdlib.h>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Just enough JSON for UpdateBatch output
+class Parser {
+public:
+    explicit Parser(const char *text) : p(text) {}
+
+    bool expect(char c) {
+        skipSpace();
+        if (*p != c) return false;
+        p++;
+        return true;
+    }
+
+    bool peek(char c) {
+        skipSpace();
+        return *p == c;
+    }
+
+    bool string(std::string &out) {
+        if (!expect('"')) return false;
+        out.clear();
+        while (*p != '"') {
+            if (*p == '\0') return false;
+            if (*p == '\\') {
+                p++;
+                if (*p != '"' && *p != '\\') return false;
+            }
+            out += *p++;
+        }
+        p++;
+        return true;
+    }
+
+    bool number(double &out) {
+        skipSpace();
+        char *end = nullptr;
+        out = strtod(p, &end);
+        if (end == p) return false;
+        p = end;
+        return true;
+    }
+
+    bool atEnd() {
+        skipSpace();
+        return *p == '\0';
+    }
+
+private:
+    void skipSpace() {
+        while (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r') p++;
+    }
+
+    const char *p;
+};
+
+struct Field {
+    std::string key;
+    bool isText = false;
+    bool increment = false;
+    double number = 0;
+    std::string text;
+};
+
+// {".sv":{"increment":<n>}}
+bool parseServerValue(Parser &in, Field &field) {
+    std::string name;
+    if (!in.expect('{') || !in.string(name) || name != ".sv" || !in.expect(':')) return false;
+    if (!in.expect('{') || !in.string(name) || name != "increment" || !in.expect(':')) return false;
+    if (!in.number(field.number) || !in.expect('}') || !in.expect('}')) return false;
+    field.increment = true;
+    return true;
+}
+
+}  // namespace
+
+bool FakeRtdb::update(const std::string &basePath, const char *json) {
+    Parser in(json);
+    std::vector<Field> fields;
+
+    if (!in.expect('{')) return false;
+    if (!in.peek('}')) {
+        do {
+            Field field;
+            if (!in.string(field.key) || !in.expect(':')) return false;
+            if (in.peek('"')) {
+                if (!in.string(field.text)) return false;
+                field.isText = true;
+            } else if (in.peek('{')) {
+                if (!parseServerValue(in, field)) return false;
+            } else if (!in.number(field.number)) {
+                return false;
+            }
+            fields.push_back(field);
+        } while (in.expect(','));
+    }
+    if (!in.expect('}') || !in.atEnd()) return false;
+
+    for (size_t k = 0; k < fields.size(); k++) {
+        const Field &field = fields[k];
+        std::string path = basePath + field.key;
+        if (field.isText) {
+            set(path, field.text);
+        } else if (field.increment) {
+            set(path, number(path) + field.number);
+        } else {
+            set(path, field.number);
+        }
+    }
+    applied++;
+    received += strlen(json);
+    return true;
+}
+
+void FakeRtdb::set(const std::string &path, double value) {
+    Value &v = values[path];
+    v.isText = false;
+    v.number = value;
+    v.text.clear();
+}
+
+void FakeRtdb::set(const std::string &path, const std::string &text) {
+    Value &v = values[path];
+    v.isText = true;
+    v.number = 0;
+    v.text = text;
+}
+
+double FakeRtdb::number(const std::string &path, double fallback) const {
+    std::map<std::string, Value>::const_iterator it = values.find(path);
+    return it == values.end() || it->second.isText ? fallback : it->second.number;
+}
+
+std::string FakeRtdb::text(const std::string &path) const {
+    std::map<std::string, Value>::const_iterator it = values.find(path);
+    return it == values.end() ? std::string() : it->second.text;
+}
+
+size_t FakeRtdb::countUnder(const std::string &prefix) const {
+    size_t n = 0;
+    for (std::map<std::string, Value>::const_iterator it = values.lower_bound(prefix);
+         it != values.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+        n++;
+    }
+    return n;
+}
+
+std::vector<std::string> FakeRtdb::pathsUnder(const std::string &prefix) const {
+    std::vector<std::string> paths;
+    for (std::map<std::string, Value>::const_iterator it = values.lower_bound(prefix);
+         it != values.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+        paths.push_back(it->first);
+    }
+    return paths;
+}
+
+double FakeRtdb::sumUnder(const std::string &prefix, const std::string &leaf) const {
+    std::string suffix = "/" + leaf;
+    double sum = 0;
+    for (std::map<std::string, Value>::const_iterator it = values.lower_bound(prefix);
+         it != values.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+        const std::string &path = it->first;
+        if (!it->second.isText && path.size() > suffix.size() &&
+            path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            sum += it->second.number;
+        }
+    }
+    return sum;
+}
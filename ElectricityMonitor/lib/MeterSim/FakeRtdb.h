@@ -0,0 +1,51 @@
+#ifndef FAKE_RTDB_H
+#define FAKE_RTDB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// In-memory stand-in for the Realtime Database, flat: every leaf is stored
+// under its full path ("/buildings/b/units/u/history/hourly/.../energy").
+// It understands exactly what the firmware sends - UpdateBatch's flat
+// multi-location JSON with numbers, strings and {".sv":{"increment":x}} -
+// and rejects anything else, so a malformed batch fails the simulation
+// instead of going unnoticed.
+class FakeRtdb {
+public:
+    // Apply one multi-location update under basePath. False (and nothing
+    // applied) if the JSON isn't a flat object of the kinds above.
+    bool update(const std::string &basePath, const char *json);
+
+    void set(const std::string &path, double value);
+    void set(const std::string &path, const std::string &text);
+
+    bool has(const std::string &path) const { return values.count(path) != 0; }
+    double number(const std::string &path, double fallback = 0) const;
+    std::string text(const std::string &path) const;
+
+    // Leaves whose path starts with prefix
+    size_t countUnder(const std::string &prefix) const;
+    std::vector<std::string> pathsUnder(const std::string &prefix) const;
+    // Sum of every numeric leaf named leaf somewhere below prefix
+    double sumUnder(const std::string &prefix, const std::string &leaf) const;
+
+    size_t size() const { return values.size(); }
+    uint32_t updates() const { return applied; }
+    uint64_t bytesReceived() const { return received; }
+
+private:
+    struct Value {
+        bool isText = false;
+        double number = 0;
+        std::string text;
+    };
+
+    std::map<std::string, Value> values;
+    uint32_t applied = 0;
+    uint64_t received = 0;
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include "MonitorSim.h"
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include <TelemetryPaths.h>
+
+MonitorSim::MonitorSim(const SimConfig &config)
+    : cfg(config),
+      sim(config.startEpoch),
+      loadEpoch(0),
+      loadStep(nullptr),
+      readingTimer(config.readingCadence),
+      trueMws(0),
+      readingCount(0) {
+    char path[96];
+    ::unitPath(cfg.monitor.buildingId, cfg.monitor.unitId, "", path, sizeof(path));
+    unitBase = path;
+
+    LoadStep idle = { 0, 0.0f, 1.0f };
+    load.push_back(idle);
+}
+
+void MonitorSim::start() {
+    // A board fresh out of the box: nothing logged yet
+    remove(cfg.logPath);
+    remove(cfg.cursorPath);
+    boot();
+}
+
+void MonitorSim::reboot() {
+    boot();
+}
+
+// Mirrors setup(), minus the calibration wizard
+void MonitorSim::boot() {
+    monitor.reset();
+    ring.reset(new RawSampleRing());
+    source.reset(new FakeSampleSource(cfg.sampleRateHz));
+    engine.reset(new MeterEngine());
+    queue.reset(new ReadingQueue());
+    calibrations.reset(new CalibrationMailbox());
+    livePower.reset(new LivePower(0));
+    telemetryLog.reset(new TelemetryLog(cfg.logPath, cfg.cursorPath, cfg.logMaxBytes));
+    monitor.reset(new MonitorApp(sim, *queue, *telemetryLog));
+
+    // Whatever was in flight went down with the old app
+    sim.restartFirebase();
+    sim.attach(monitor.get());
+    monitor->restore(cfg.monitor);
+
+    MeterConfig meterConfig;
+    meterConfig.sampleRateHz = cfg.sampleRateHz;
+    meterConfig.adcCenter = 2048;
+    meterConfig.voltsPerCount = cfg.voltsPerCount;
+    meterConfig.ampsPerCount = cfg.ampsPerCount;
+    engine->configure(meterConfig);
+    engine->setCalibration(monitor->calibration());
+    engine->seedOffsets(sim.loadFloat("iOffset", 2048), sim.loadFloat("vOffset", 2048));
+    source->begin(*ring);
+    telemetryLog->open();
+
+    monitor->watchSampleRing(ring.get());
+    monitor->watchCalibration(calibrations.get());
+    monitor->watchLivePower(livePower.get());
+    monitor->begin();
+    readingTimer.start(sim.nowMs());
+}
+
+// Looked up once per simulated second rather than every metering period:
+// localtime_r is a good part of the run time otherwise
+const LoadStep *MonitorSim::loadAt(uint32_t epoch) {
+    if (epoch == loadEpoch && loadStep != nullptr) {
+        return loadStep;
+    }
+    time_t seconds = epoch;
+    struct tm timeinfo;
+    localtime_r(&seconds, &timeinfo);
+    uint32_t secondOfDay = timeinfo.tm_hour * 3600 + timeinfo.tm_min * 60 + timeinfo.tm_sec;
+
+    const LoadStep *current = &load.front();
+    for (size_t k = 0; k < load.size(); k++) {
+        if (load[k].fromSecond <= secondOfDay) {
+            current = &load[k];
+        }
+    }
+    loadEpoch = epoch;
+    loadStep = current;
+    return current;
+}
+
+// One metering task period: the DMA delivers period's worth of samples of
+// whatever the load draws through the relay, and the metering task drains them
+void MonitorSim::meteringPeriod() {
+    const LoadStep &step = *loadAt(cfg.startEpoch + sim.nowMs() / 1000);
+    float amps = sim.relay() ? step.amps : 0.0f;
+    const float root2 = 1.41421356f;
+
+    FakeWaveform wave;
+    wave.frequencyHz = mains.frequencyHz;
+    wave.voltageAmplitude = mains.voltsRms * root2 / cfg.voltsPerCount;
+    wave.currentAmplitude = amps * root2 / cfg.ampsPerCount;
+    wave.currentPhaseRad = acosf(step.powerFactor);
+    source->setWaveform(wave);
+    source->generate(cfg.sampleRateHz * cfg.meteringPeriodMs / 1000);
+    trueMws += (double)mains.voltsRms * amps * step.powerFactor * cfg.meteringPeriodMs;
+
+    takeCalibration(*engine, *calibrations);
+    SimPlatform &clock = sim;
+    if (runMeteringPeriod(*engine, *ring, *queue, readingTimer, sim.nowMs(),
+                          [&clock]() { return clock.epoch(); }, livePower.get())) {
+        readingCount++;
+    }
+}
+
+void MonitorSim::run(uint32_t seconds) {
+    for (uint32_t s = 0; s < seconds; s++) {
+        runMs(1000);
+    }
+}
+
+void MonitorSim::runMs(uint32_t ms) {
+    uint32_t passMs = cfg.meteringPeriodMs / cfg.networkPassesPerPeriod;
+    for (uint32_t elapsed = 0; elapsed < ms; elapsed += cfg.meteringPeriodMs) {
+        meteringPeriod();
+        for (uint32_t p = 0; p < cfg.networkPassesPerPeriod; p++) {
+            sim.deliver();
+            monitor->pass();
+            sim.advance(passMs);
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef MONITOR_SIM_H
+#define MONITOR_SIM_H
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <FakeSampleSource.h>
+#include <MeterEngine.h>
+#include <MonitorApp.h>
+#include <ReadingQueue.h>
+#include <TelemetryLog.h>
+#include "SimPlatform.h"
+
+// The load from a time of day until the next step, repeated every day
+struct LoadStep {
+    uint32_t fromSecond;     // seconds after local midnight
+    float amps;              // RMS
+    float powerFactor;       // current lags by acos(powerFactor)
+};
+
+struct MainsSupply {
+    float voltsRms = 230;
+    float frequencyHz = 50;
+};
+
+struct SimConfig {
+    uint32_t startEpoch = 1762214400;     // 2025-11-04 00:00:00 UTC
+    uint32_t sampleRateHz = 1000;         // what Esp32AdcSampleSource delivers
+    ReadingCadence readingCadence;        // the firmware's
+    uint32_t meteringPeriodMs = 20;
+    uint32_t networkPassesPerPeriod = 4;  // the network task yields every 5 ms
+    // The firmware's scale with its default calibration folded in, so the
+    // profile starts empty: (3.3 / 4095) * 268.8471 and (3.3 / 4095) / 0.066 * 0.6767
+    float voltsPerCount = 0.21665;
+    float ampsPerCount = 0.0082622;
+    const char *logPath = "/tmp/emonitor_sim.log";
+    const char *cursorPath = "/tmp/emonitor_sim.pos";
+    uint32_t logMaxBytes = 131072;
+    MonitorConfig monitor;
+};
+
+// The firmware on a simulated board: synthetic mains into the real
+// MeterEngine on the metering task's period, the real MonitorApp on the
+// network task's passes, a SimPlatform for the clock, relay, NVS and RTDB.
+// Everything runs in one thread in simulated time, so a day takes seconds.
+//
+// Deterministic: the same config and calls give the same results.
+class MonitorSim {
+public:
+    explicit MonitorSim(const SimConfig &config = SimConfig());
+
+    void setLoad(const std::vector<LoadStep> &daily) { load = daily; loadStep = nullptr; }
+    void setMains(const MainsSupply &supply) { mains = supply; }
+
+    // What setup() does: restore from NVS, start sampling and the scheduler
+    void start();
+
+    // Power cycle: fresh engine, queue and app; NVS, the telemetry log
+    // files and the RTDB survive
+    void reboot();
+
+    void run(uint32_t seconds);
+    void runMs(uint32_t ms);
+
+    // Energy delivered to the load, integrated from the load profile on the
+    // relay state - what a perfect meter would have read
+    double trueEnergyKwh() const { return trueMws / 3.6e9; }
+
+    SimPlatform &platform() { return sim; }
+    FakeRtdb &rtdb() { return sim.rtdb(); }
+    MonitorApp &app() { return *monitor; }
+    const SimConfig &config() const { return cfg; }
+    // "/buildings/<building>/units/<unit>/"
+    const std::string &unitPath() const { return unitBase; }
+    uint64_t samplesMetered() const { return engine ? engine->totalSamples() : 0; }
+    uint32_t readingsQueued() const { return readingCount; }
+
+private:
+    void boot();
+    const LoadStep *loadAt(uint32_t epoch);
+    void meteringPeriod();
+
+    SimConfig cfg;
+    SimPlatform sim;
+    std::vector<LoadStep> load;
+    MainsSupply mains;
+    std::string unitBase;
+    uint32_t loadEpoch;          // loadAt()'s last answer
+    const LoadStep *loadStep;
+
+    std::unique_ptr<RawSampleRing> ring;
+    std::unique_ptr<FakeSampleSource> source;
+    std::unique_ptr<MeterEngine> engine;
+    std::unique_ptr<ReadingQueue> queue;
+    std::unique_ptr<CalibrationMailbox> calibrations;
+    std::unique_ptr<LivePower> livePower;
+    std::unique_ptr<TelemetryLog> telemetryLog;
+    std::unique_ptr<MonitorApp> monitor;
+    ReadingTimer readingTimer;
+
+    double trueMws;
+    uint32_t readingCount;
+};
+
+#endif
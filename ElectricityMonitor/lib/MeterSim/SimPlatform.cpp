@@ -0,0 +1,217 @@
+#include "SimPlatform.h"
+#include <string.h>
+#include <EventLog.h>
+#include <MonitorApp.h>
+
+// The simulation is the program here, so it supplies the event log the
+// sketch otherwise would, on the clock of the newest SimPlatform
+EventLog eventLog;
+static SimPlatform *logClock = nullptr;
+
+uint32_t eventLogClockMs() {
+    return logClock != nullptr ? logClock->nowMs() : 0;
+}
+
+static const uint32_t KEEP_ALIVE_MS = 30000;   // what RTDB sends on an idle stream
+
+SimPlatform::SimPlatform(uint32_t startEpoch)
+    : app(nullptr),
+      clockMs(0),
+      startEpoch(startEpoch),
+      clockSynced(true),
+      link(true),
+      latencyMs(150),
+      updatesToFail(0),
+      acksToLose(0),
+      streamOpen(false),
+      nextKeepAliveMs(0),
+      led(false),
+      switches(0),
+      nvsWriteCount(0),
+      sent(0),
+      failed(0),
+      creditGets(0),
+      restarts(0) {
+    for (uint8_t c = 0; c < MAX_METER_CHANNELS; c++) {
+        relayOn[c] = false;
+    }
+    logClock = this;
+}
+
+SimPlatform::~SimPlatform() {
+    if (logClock == this) {
+        logClock = nullptr;
+    }
+}
+
+uint32_t SimPlatform::epoch() {
+    return clockSynced ? startEpoch + clockMs / 1000 : 0;
+}
+
+void SimPlatform::setLinkUp(bool up) {
+    link = up;
+    if (!up) {
+        answers.clear();
+        streamOpen = false;
+    }
+}
+
+void SimPlatform::schedule(Kind kind, const std::string &path, const std::string &json,
+                           const char *uid, bool fail, bool lose) {
+    Answer answer;
+    answer.dueMs = clockMs + latencyMs;
+    answer.kind = kind;
+    answer.path = path;
+    answer.json = json;
+    answer.uid = uid;
+    answer.fail = fail;
+    answer.lose = lose;
+    answers.push_back(answer);
+}
+
+void SimPlatform::deliver() {
+    if (app == nullptr) {
+        return;
+    }
+    if (streamOpen && (int32_t)(clockMs - nextKeepAliveMs) >= 0) {
+        nextKeepAliveMs = clockMs + KEEP_ALIVE_MS;
+        app->creditStreamEvent();
+    }
+
+    // Answers are scheduled in time order; ones added while delivering wait
+    // for the next call
+    size_t due = answers.size();
+    while (due-- > 0 && !answers.empty() && (int32_t)(clockMs - answers.front().dueMs) >= 0) {
+        Answer answer = answers.front();
+        answers.pop_front();
+
+        switch (answer.kind) {
+        case ANSWER_UPDATE: {
+            if (answer.fail) {
+                failed++;
+                app->updateAnswered(answer.uid, false, -1);
+                break;
+            }
+            double before = database.number(streamPath);
+            bool applied = database.update(answer.path, answer.json.c_str());
+            if (applied && streamOpen && database.number(streamPath) != before) {
+                schedule(STREAM_PUT, streamPath);
+            }
+            if (!answer.lose) {
+                app->updateAnswered(answer.uid, applied, applied ? 0 : 400);
+            }
+            break;
+        }
+        case ANSWER_CREDIT:
+            app->creditAnswered();
+            app->applyRemainingUnits(database.number(answer.path), "Firebase");
+            break;
+        case ANSWER_CALIBRATION:
+            app->calibrationAnswered(database.text(answer.path).c_str());
+            break;
+        case STREAM_PUT:
+            if (streamOpen) {
+                app->creditStreamEvent();
+                app->applyRemainingUnits(database.number(streamPath), "stream");
+            }
+            break;
+        }
+    }
+}
+
+void SimPlatform::topUp(const std::string &unitPath, double kwh, double costPerKwh) {
+    std::string units = unitPath + "remaining_units";
+    database.set(units, database.number(units) + kwh);
+    database.set(unitPath + "remaining_credit",
+                 database.number(unitPath + "remaining_credit") + kwh * costPerKwh);
+    if (streamOpen && units == streamPath) {
+        schedule(STREAM_PUT, streamPath);
+    }
+}
+
+void SimPlatform::restartFirebase() {
+    restarts++;
+    answers.clear();
+    streamOpen = false;
+}
+
+void SimPlatform::requestCredit(const char *path) {
+    creditGets++;
+    if (link) {
+        schedule(ANSWER_CREDIT, path);
+    }
+}
+
+void SimPlatform::requestCalibration(const char *path) {
+    if (link) {
+        schedule(ANSWER_CALIBRATION, path);
+    }
+}
+
+// The stream opens with a put of the current value, like RTDB's
+void SimPlatform::openCreditStream(const char *path) {
+    if (!link) {
+        return;
+    }
+    streamPath = path;
+    streamOpen = true;
+    nextKeepAliveMs = clockMs + latencyMs + KEEP_ALIVE_MS;
+    schedule(STREAM_PUT, streamPath);
+}
+
+void SimPlatform::sendUpdate(const char *path, const char *json, const char *uid) {
+    sent++;
+    if (!link) {
+        return;
+    }
+    bool fail = updatesToFail > 0;
+    if (fail) updatesToFail--;
+    bool lose = !fail && acksToLose > 0;
+    if (lose) acksToLose--;
+    schedule(ANSWER_UPDATE, path, json, uid, fail, lose);
+}
+
+void SimPlatform::setChannelRelay(uint8_t channel, bool on) {
+    if (channel >= MAX_METER_CHANNELS) {
+        return;
+    }
+    if (on != relayOn[channel]) {
+        switches++;
+    }
+    relayOn[channel] = on;
+}
+
+float SimPlatform::loadFloat(const char *key, float fallback) {
+    float value = fallback;
+    loadBytes(key, &value, sizeof(value));
+    return value;
+}
+
+void SimPlatform::saveFloat(const char *key, float value) {
+    saveBytes(key, &value, sizeof(value));
+}
+
+uint64_t SimPlatform::loadU64(const char *key, uint64_t fallback) {
+    uint64_t value = fallback;
+    loadBytes(key, &value, sizeof(value));
+    return value;
+}
+
+void SimPlatform::saveU64(const char *key, uint64_t value) {
+    saveBytes(key, &value, sizeof(value));
+}
+
+bool SimPlatform::loadBytes(const char *key, void *out, size_t size) {
+    std::map<std::string, std::vector<uint8_t> >::const_iterator it = nvs.find(key);
+    if (it == nvs.end() || it->second.size() != size) {
+        return false;
+    }
+    memcpy(out, it->second.data(), size);
+    return true;
+}
+
+void SimPlatform::saveBytes(const char *key, const void *data, size_t size) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    nvs[key].assign(bytes, bytes + size);
+    nvsWriteCount++;
+}
@@ -0,0 +1,127 @@
+#ifndef SIM_PLATFORM_H
+#define SIM_PLATFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include <MonitorPlatform.h>
+#include <SampleSource.h>
+#include "FakeRtdb.h"
+
+// MonitorPlatform on a fake clock and a FakeRtdb. Requests are answered
+// after a configurable latency, from deliver() - the simulation's
+// app.loop() - never from inside the request, just like FirebaseClient.
+// The link can be dropped, updates failed or their acks lost, to drive
+// the firmware's offline and retry paths.
+//
+// NVS lives here too, so a reboot (a new MonitorApp on the same platform)
+// sees what the last one saved.
+class SimPlatform : public MonitorPlatform {
+public:
+    explicit SimPlatform(uint32_t startEpoch);
+    ~SimPlatform();
+
+    // Where answers go; set before the first request
+    void attach(MonitorListener *target) { app = target; }
+
+    // Clock
+    void advance(uint32_t ms) { clockMs += ms; }
+    void setClockSynced(bool synced) { clockSynced = synced; }
+    // The wall clock moves on without the board, as when NTP corrects one
+    // that had stalled
+    void jumpClock(uint32_t seconds) { startEpoch += seconds; }
+    uint32_t nowMs() override { return clockMs; }
+    uint32_t epoch() override;
+
+    // Link. Dropping it loses every request in flight and closes the stream.
+    void setLinkUp(bool up);
+    bool linkUp() const { return link; }
+    void setLatencyMs(uint32_t ms) { latencyMs = ms; }
+    void failUpdates(unsigned count) { updatesToFail += count; }      // answered with an error
+    void loseAcks(unsigned count) { acksToLose += count; }            // applied, never answered
+
+    // Answer everything that is due
+    void deliver();
+
+    // The dashboard adds credit: remaining_units and remaining_credit go up
+    // on the server, and the stream (if open) pushes the new value
+    void topUp(const std::string &unitPath, double kwh, double costPerKwh);
+
+    FakeRtdb &rtdb() { return database; }
+
+    bool wifiConnected() override { return link; }
+    bool firebaseReady() override { return link; }
+    void reconnect() override {}
+    void restartFirebase() override;
+
+    void requestCredit(const char *path) override;
+    void openCreditStream(const char *path) override;
+    void requestCalibration(const char *path) override;
+    void sendUpdate(const char *path, const char *json, const char *uid) override;
+
+    void setRelay(bool on) override { setChannelRelay(0, on); }
+    void setChannelRelay(uint8_t channel, bool on) override;
+    void setStatusLed(bool on) override { led = on; }
+    bool relay(uint8_t channel = 0) const { return channel < MAX_METER_CHANNELS && relayOn[channel]; }
+    uint32_t relaySwitches() const { return switches; }
+
+    float loadFloat(const char *key, float fallback) override;
+    void saveFloat(const char *key, float value) override;
+    uint64_t loadU64(const char *key, uint64_t fallback) override;
+    void saveU64(const char *key, uint64_t value) override;
+    bool loadBytes(const char *key, void *out, size_t size) override;
+    void saveBytes(const char *key, const void *data, size_t size) override;
+    uint32_t nvsWrites() const { return nvsWriteCount; }
+
+    uint32_t updatesSent() const { return sent; }
+    uint32_t updatesFailed() const { return failed; }
+    uint32_t creditRequests() const { return creditGets; }
+    uint32_t firebaseRestarts() const { return restarts; }
+
+private:
+    enum Kind { ANSWER_UPDATE, ANSWER_CREDIT, ANSWER_CALIBRATION, STREAM_PUT };
+
+    struct Answer {
+        uint32_t dueMs;
+        Kind kind;
+        std::string path;
+        std::string json;
+        const char *uid;     // a literal, as MonitorApp passes them
+        bool fail;
+        bool lose;
+    };
+
+    void schedule(Kind kind, const std::string &path, const std::string &json = "",
+                  const char *uid = "", bool fail = false, bool lose = false);
+
+    MonitorListener *app;
+    FakeRtdb database;
+    std::deque<Answer> answers;
+    std::map<std::string, std::vector<uint8_t> > nvs;
+
+    uint32_t clockMs;
+    uint32_t startEpoch;
+    bool clockSynced;
+    bool link;
+    uint32_t latencyMs;
+    unsigned updatesToFail;
+    unsigned acksToLose;
+
+    bool streamOpen;
+    std::string streamPath;
+    uint32_t nextKeepAliveMs;
+
+    bool relayOn[MAX_METER_CHANNELS];
+    bool led;
+    uint32_t switches;
+    uint32_t nvsWriteCount;
+    uint32_t sent;
+    uint32_t failed;
+    uint32_t creditGets;
+    uint32_t restarts;
+};
+
+#endif
@@ -1,15 +1,30 @@
-#define ENABLE_DATABASE
-#define ENABLE_USER_AUTH
 #include <Arduino.h>
-#include <WiFi.h>
-
-#include <WiFiClientSecure.h>
-#include <FirebaseClient.h>
 #include <time.h>
 #include <math.h>
-#include <vector>
 #include <esp_task_wdt.h>
-#include <FirebaseJson.h>
+#include <LittleFS.h>
+#include <MeterEngine.h>
+#include <ZeroCrossDetector.h>
+#include <RmsKernel.h>
+#include <TelemetryLog.h>
+#include <ReadingQueue.h>
+#include <MonitorApp.h>
+#include <EventLog.h>
+#include "Esp32AdcSampleSource.h"
+#include "Esp32Platform.h"
+
+// 1 meters one unit. More meters that many units of a building off one
+// voltage sensor, each with its own current sensor and relay
+// (env:esp32dev-building).
+#ifndef METER_CHANNELS
+#define METER_CHANNELS 1
+#endif
+
+#if METER_CHANNELS > 1
+#include <BuildingHub.h>
+#include <MultiChannelMeter.h>
+#include "Esp32MultiAdcSampleSource.h"
+#endif
 
 
 // WiFi credentials
@@ -27,543 +42,433 @@ const char* password = "<PASSWORD>";
 #define RELAY_PIN 21
 
 // Unit identification
-const String UNIT_ID = "unit_002";
-
-String unitBasePath;
-String historyHourlyBasePath;
-String historyDailyBasePath;
+const char* UNIT_ID = "unit_002";
+
+#if METER_CHANNELS > 1
+// Channel c's current sensor, relay and unit; channel 0 is the pins above.
+// One entry per channel wired on the board; the first METER_CHANNELS are metered.
+const uint8_t WIRED_CHANNELS = 3;
+static_assert(METER_CHANNELS <= WIRED_CHANNELS && WIRED_CHANNELS <= MAX_METER_CHANNELS,
+              "METER_CHANNELS needs a current pin, relay pin and unit id for each channel");
+const uint8_t CURRENT_PINS[MAX_METER_CHANNELS] = { CURRENT_PIN, 32, 33 };
+const uint8_t RELAY_PINS[MAX_METER_CHANNELS] = { RELAY_PIN, 22, 23 };
+const char* UNIT_IDS[MAX_METER_CHANNELS] = { UNIT_ID, "unit_003", "unit_004" };
+#endif
 
 const float COST_PER_KWH = 209.5;
 const int ADC_CENTER = 2048;
 const int ADC_MAX = 4095;
 const float ADC_VOLTAGE = 3.3;
-const String BUILDING_ID = "building_002";
+const char* BUILDING_ID = "building_002";
 
-// Calibration factors - UPDATE THESE AFTER CALIBRATION
-float currentCalibrationFactor = 0.6767; // went with the lowest from my calibration on loads as most household appliances operate in the low-current range (0.1-2A)
-float voltageCalibrationFactor = 268.8471;
+// Calibration used until a profile is saved: the wizard or
+// <unit>/calibration in the RTDB replaces it without a reflash
+const float DEFAULT_CURRENT_GAIN = 0.6767; // went with the lowest from my calibration on loads as most household appliances operate in the low-current range (0.1-2A)
+const float DEFAULT_VOLTAGE_GAIN = 268.8471;
 
 // ACS712 30A sensitivity: 66mV per Ampere
 const float ACS712_SENSITIVITY = 0.066;
 
-// Set to true to run calibration
+// Set to true to run the calibration wizard at every boot; 'c' on the
+// serial console runs it once, at the next boot
 bool CALIBRATION_MODE = false;
-
-// Firebase objects
-WiFiClientSecure ssl_client;
-using AsyncClient = AsyncClientClass;
-AsyncClient aClient(ssl_client);
-RealtimeDatabase Database;
-FirebaseApp app;
-NoAuth noAuth;
-
-volatile bool isFirebaseBusy = false;
-
-struct HourlyData {
-    float totalEnergy = 0;
-    float totalPower = 0;
-    float totalCurrent = 0;
-    float peakPower = 0;
-    int samples = 0;
-    int currentHour = -1;  // Track which hour this data belongs to
-};
-
-HourlyData hourlyBuffer;
-
-// Timing
-unsigned long lastReading = 0;
-unsigned long lastCreditCheck = 0;
-const unsigned long READING_INTERVAL = 60000; // 1 minute
+const uint32_t WIZARD_REQUESTED = 0xCA1B0001;
+RTC_NOINIT_ATTR uint32_t wizardRequest;   // survives ESP.restart()
+
+// WiFi, Firebase, the relay and NVS
+Esp32Platform platform(RELAY_PIN, STATUS_LED);
+
+// Continuous sampling: the DMA sampler fills sampleRing in the background,
+// the metering task drains it into meterEngine which integrates energy from
+// every sample, and hands each minute's reading to the network task
+#if METER_CHANNELS > 1
+// A frame per sample: the voltage and every channel's current. Each unit
+// has its own reading queue and calibration mailbox.
+ChannelFrameRing sampleRing;
+Esp32MultiAdcSampleSource sampleSource(VOLTAGE_PIN, CURRENT_PINS, METER_CHANNELS);
+MultiChannelMeter meterEngine;
+ReadingQueue readingQueues[METER_CHANNELS];
+CalibrationMailbox calibrationMailboxes[METER_CHANNELS];
+LivePower livePower[METER_CHANNELS];
+ReadingQueue &readingQueue = readingQueues[0];
+CalibrationMailbox &calibrationMailbox = calibrationMailboxes[0];
+#else
+RawSampleRing sampleRing;
+Esp32AdcSampleSource sampleSource(CURRENT_PIN, VOLTAGE_PIN);
+MeterEngine meterEngine;
+ReadingQueue readingQueue;
+// New calibration profiles, from the network task to the metering task
+CalibrationMailbox calibrationMailbox;
+// The last second's power, for the network task to catch steps between readings
+LivePower livePower(0);
+#endif
+
+// Metering shares core 1 with the ADC sampler; WiFi, TLS and Firebase get
+// core 0, where the WiFi stack already runs. Neither waits on the other:
+// the only link between them is readingQueue.
+const BaseType_t METERING_CORE = 1;
+const BaseType_t NETWORK_CORE = 0;
+const uint32_t METERING_STACK = 4096;
+const uint32_t NETWORK_STACK = 12288;   // TLS handshakes need the room
+const unsigned long METERING_PERIOD_MS = 20;
+TaskHandle_t meteringTaskHandle = nullptr;
+TaskHandle_t networkTaskHandle = nullptr;
+
+// Readings taken while we can't publish, and every finished hour, go into
+// an append-only log on LittleFS first and are replayed from there.
+// 128 KB holds about four days of minute records.
+const uint32_t TELEMETRY_LOG_MAX_BYTES = 131072;
+TelemetryLog telemetryLog("/littlefs/telemetry.log", "/littlefs/telemetry.pos", TELEMETRY_LOG_MAX_BYTES);
+
+// Credit, the hourly buffer, rollups and publishing: everything the network
+// task does, in lib/MeterCore so the native simulation runs it too
+#if METER_CHANNELS > 1
+// One MonitorApp per unit on the hub, which merges their updates into one
+// per building. `monitor` is channel 0's: the serial console and the
+// wizard work on it; the other units' logs and apps are made in setup().
+BuildingHub hub(platform);
+MonitorApp monitor(hub.port(0), readingQueue, telemetryLog);
+MonitorApp *units[METER_CHANNELS] = { &monitor };
+TelemetryLog *unitLogs[METER_CHANNELS] = { &telemetryLog };
+char unitLogPaths[METER_CHANNELS][2][32];   // TelemetryLog keeps the pointers
+#else
+MonitorApp monitor(platform, readingQueue, telemetryLog);
+#endif
+
+// Replay history as compact binary packets (history/packed/, see
+// lib/MeterCore/TelemetryPacket.h) once the apps decode them; until then
+// the JSON fields under history/hourly/ they read today
+const bool PACKED_HISTORY = false;
+
+// Timing. A reading a minute while the load holds, down to one every 10 s
+// around a step of 150 W or 20% (see ReadingCadence)
+ReadingCadence readingCadence;
 const unsigned long CREDIT_CHECK_INTERVAL = 60000;
+const unsigned long CREDIT_FALLBACK_INTERVAL = 600000;  // while the stream is live
+const unsigned long CREDIT_STREAM_RETRY = 30000;
+const unsigned long CREDIT_CHECK_TIMEOUT = 2000;
+const unsigned long WIFI_RETRY_INTERVAL = 10000;
+const unsigned long NETWORK_YIELD_MS = 5;
+const uint32_t WATCHDOG_TIMEOUT_MS = 10000;
 
 // Time configuration
 const char* ntpServer = "pool.ntp.org";
 const long gmtOffset_sec = 7200;
 const int daylightOffset_sec = 0;
 
-bool relayState = false;
-float currentRemainingUnits = 0;
+// What the network task logs goes into this ring, unformatted; 'l' on the
+// serial console prints it, and warnings and errors ride along with the
+// next update under diagnostics/log/<sequence>
+EventLog eventLog;
 
-int consecutiveFirebaseErrors = 0;
-const int MAX_FIREBASE_ERRORS = 5;
+uint32_t eventLogClockMs() {
+    return millis();
+}
 
-int getCurrentHour() {
-    struct tm timeinfo;
-    if (!getLocalTime(&timeinfo)) {
-        return -1;
-    }
-    return timeinfo.tm_hour;
+// Tracked ADC offsets are saved once an hour (not every sample) to spare the flash
+void loadSavedOffsets() {
+#if METER_CHANNELS > 1
+    for (uint8_t c = 0; c < METER_CHANNELS; c++) {
+        MonitorPlatform &port = hub.port(c);
+        float currentOffset = port.loadFloat("iOffset", ADC_CENTER);
+        float voltageOffset = port.loadFloat("vOffset", ADC_CENTER);
+        meterEngine.seedOffsets(c, currentOffset, voltageOffset);
+        Serial.printf("✓ %s ADC offsets restored - current: %.2f, voltage: %.2f\n",
+                      UNIT_IDS[c], currentOffset, voltageOffset);
+    }
+#else
+    float currentOffset = platform.loadFloat("iOffset", ADC_CENTER);
+    float voltageOffset = platform.loadFloat("vOffset", ADC_CENTER);
+
+    meterEngine.seedOffsets(currentOffset, voltageOffset);
+    Serial.printf("✓ ADC offsets restored - current: %.2f, voltage: %.2f\n", currentOffset, voltageOffset);
+#endif
 }
 
-String getCurrentDate() {
-    struct tm timeinfo;
-    if (!getLocalTime(&timeinfo)) {
-        return "";
-    }
-    char dateBuff[20];
-    strftime(dateBuff, sizeof(dateBuff), "%Y-%m-%d", &timeinfo);
-    return String(dateBuff);
+void printRestoredState() {
+    const CreditLedger &ledger = monitor.ledger();
+    Serial.printf("✓ Credit ledger restored - balance: %.3f kWh, unbilled: %.6f kWh\n",
+                  CreditLedger::toKwh(ledger.balanceMws()),
+                  CreditLedger::toKwh(ledger.unbilledMws()));
+    const RollupTotals &day = monitor.dailyTotals();
+    const RollupTotals &month = monitor.monthlyTotals();
+    Serial.printf("✓ Rollups restored - day %lu: %.3f kWh, month %lu: %.3f kWh\n",
+                  (unsigned long)day.period, day.energyKwh(),
+                  (unsigned long)month.period, month.energyKwh());
 }
 
-String getCurrentMonth() {
-    struct tm timeinfo;
-    if (!getLocalTime(&timeinfo)) {
-        return "";
-    }
-    char monthBuff[10];
-    strftime(monthBuff, sizeof(monthBuff), "%Y-%m", &timeinfo);
-    return String(monthBuff);
+// Seconds since 1970, or 0 while NTP hasn't set the clock yet
+uint32_t getEpoch() {
+    return platform.epoch();
 }
 
-String getFormattedTimestamp() {
-    struct tm timeinfo;
-    if (!getLocalTime(&timeinfo)) {
-        Serial.println("Failed to obtain time");
-        return String(millis());
+// 'p' alone prints the calibration profile; 'p' and a profile on the same
+// line ("p v 0.855 268.85; i 0.12 0.6767") applies and saves it
+void calibrationCommand() {
+    String line = Serial.readStringUntil('\n');
+    line.trim();
+    char text[CALIBRATION_TEXT_CHARS];
+    if (line.length() == 0) {
+        formatCalibrationProfile(monitor.calibration(), text, sizeof(text));
+        Serial.printf("Calibration: %s\n", text);
+        return;
+    }
+
+    CalibrationProfile profile;
+    if (!parseCalibrationProfile(line.c_str(), profile)) {
+        Serial.println("❌ Not a calibration profile - expected e.g. \"v 0.855 268.85; i 0.12 0.6767\"");
+    } else if (monitor.applyCalibration(profile, "serial")) {
+        formatCalibrationProfile(profile, text, sizeof(text));
+        Serial.printf("✓ Calibration applied and saved: %s\n", text);
+    } else {
+        Serial.println("❌ Calibration not applied - try again");
     }
-    
-    char timeStringBuff[50];
-    strftime(timeStringBuff, sizeof(timeStringBuff), "%Y-%m-%d %H:%M:%S", &timeinfo);
-    return String(timeStringBuff);
 }
 
 void setup() {
     Serial.begin(115200);
+#ifdef EVENT_LOG_ECHO
+    eventLog.setEcho(echoLogLine);
+#endif
 
     esp_task_wdt_config_t wdt_config = {
-        .timeout_ms = 10000,
+        .timeout_ms = WATCHDOG_TIMEOUT_MS,
         .idle_core_mask = 0,
         .trigger_panic = true
     };
     esp_task_wdt_init(&wdt_config);
-    esp_task_wdt_add(NULL);
 
     pinMode(STATUS_LED, OUTPUT);
     pinMode(RELAY_PIN, OUTPUT);
     digitalWrite(STATUS_LED, LOW);
     digitalWrite(RELAY_PIN, LOW);
+#if METER_CHANNELS > 1
+    for (uint8_t c = 1; c < METER_CHANNELS; c++) {
+        pinMode(RELAY_PINS[c], OUTPUT);
+        digitalWrite(RELAY_PINS[c], LOW);
+    }
+    platform.setRelayPins(RELAY_PINS, METER_CHANNELS);
+#endif
+
+    Serial.printf("Initial RELAY_PIN output (wrote LOW, relay on - active-low). digitalRead: %d\n", digitalRead(RELAY_PIN));
+
+    // The relay follows the saved balance from the start, not from the first credit check
+    MonitorConfig monitorConfig;
+    monitorConfig.buildingId = BUILDING_ID;
+    monitorConfig.unitId = UNIT_ID;
+    monitorConfig.costPerKwh = COST_PER_KWH;
+    monitorConfig.scheduler.creditCheckIntervalMs = CREDIT_CHECK_INTERVAL;
+    monitorConfig.scheduler.creditFallbackIntervalMs = CREDIT_FALLBACK_INTERVAL;
+    monitorConfig.scheduler.streamRetryMs = CREDIT_STREAM_RETRY;
+    monitorConfig.scheduler.creditTimeoutMs = CREDIT_CHECK_TIMEOUT;
+    monitorConfig.scheduler.connectRetryMs = WIFI_RETRY_INTERVAL;
+    monitorConfig.watchdogTimeoutMs = WATCHDOG_TIMEOUT_MS;
+    monitorConfig.calibration = CalibrationProfile::flat(DEFAULT_VOLTAGE_GAIN, DEFAULT_CURRENT_GAIN);
+    monitorConfig.packedHistory = PACKED_HISTORY;
+#if METER_CHANNELS > 1
+    BuildingHubConfig hubConfig;
+    hubConfig.buildingId = BUILDING_ID;
+    hub.configure(hubConfig, METER_CHANNELS);
+    for (uint8_t c = 1; c < METER_CHANNELS; c++) {
+        char *logPath = unitLogPaths[c][0];
+        char *cursorPath = unitLogPaths[c][1];
+        snprintf(logPath, sizeof(unitLogPaths[c][0]), "/littlefs/telemetry%u.log", (unsigned)c);
+        snprintf(cursorPath, sizeof(unitLogPaths[c][1]), "/littlefs/telemetry%u.pos", (unsigned)c);
+        unitLogs[c] = new TelemetryLog(logPath, cursorPath, TELEMETRY_LOG_MAX_BYTES);
+        units[c] = new MonitorApp(hub.port(c), readingQueues[c], *unitLogs[c]);
+    }
+    // The board's event log goes up once, with channel 0's updates
+    monitorConfig.publishUnderBuilding = true;
+    for (uint8_t c = 0; c < METER_CHANNELS; c++) {
+        monitorConfig.unitId = UNIT_IDS[c];
+        monitorConfig.uploadEventLog = c == 0;
+        units[c]->restore(monitorConfig);
+        hub.attach(c, units[c]);
+    }
+#else
+    monitor.restore(monitorConfig);
+#endif
+    printRestoredState();
 
-    Serial.printf("Initial RELAY_PIN output (wrote HIGH). digitalRead: %d\n", digitalRead(RELAY_PIN));
-    
     analogSetWidth(12);
     analogSetAttenuation(ADC_11db);
 
-    unitBasePath = "/buildings/building_002/units/" + UNIT_ID + "/";
-    historyHourlyBasePath = unitBasePath + "history/hourly/";
-    historyDailyBasePath = unitBasePath + "history/daily/";
-    
     Serial.println("\n\n========================================");
     Serial.println("ESP32 Energy Monitor with Relay Control");
     Serial.println("========================================");
-    Serial.println("Unit: " + UNIT_ID);
+    Serial.printf("Unit: %s\n", UNIT_ID);
     Serial.println("========================================\n");
     
-    if (CALIBRATION_MODE) {
+    if (CALIBRATION_MODE || wizardRequest == WIZARD_REQUESTED) {
+        wizardRequest = 0;
         Serial.println("CALIBRATION MODE STARTED");
         Serial.println("Running calibration routine...\n");
         delay(2000);
         runFullCalibration();
-        Serial.println("\n✓ Calibration complete!");
-        Serial.println("Update the calibration factors in code and set CALIBRATION_MODE to false");
-        while(1) { delay(1000); }
+        Serial.println("\n✓ Calibration complete - starting up with it");
+    }
+
+    // Sampling starts after calibration since the wizard still uses analogRead()
+    MeterConfig meterConfig;
+    meterConfig.sampleRateHz = sampleSource.sampleRateHz();
+    meterConfig.adcCenter = ADC_CENTER;
+    meterConfig.voltsPerCount = ADC_VOLTAGE / ADC_MAX;
+    meterConfig.ampsPerCount = (ADC_VOLTAGE / ADC_MAX) / ACS712_SENSITIVITY;
+#if METER_CHANNELS > 1
+    meterEngine.configure(meterConfig, METER_CHANNELS);
+    for (uint8_t c = 0; c < METER_CHANNELS; c++) {
+        meterEngine.setCalibration(c, units[c]->calibration());
+    }
+#else
+    meterEngine.configure(meterConfig);
+    meterEngine.setCalibration(monitor.calibration());
+#endif
+    loadSavedOffsets();
+
+    if (sampleSource.begin(sampleRing)) {
+        Serial.printf("✓ Continuous ADC sampling at %u Hz\n", meterConfig.sampleRateHz);
+    } else {
+        Serial.println("❌ Failed to start continuous ADC sampling");
     }
-    
-    setupWiFi();
-    setupFirebase();
-    
-    // Initialize hourly buffer with current hour
-    hourlyBuffer.currentHour = getCurrentHour();
-    Serial.printf("Initialized hourly tracking for hour: %d\n", hourlyBuffer.currentHour);
-    
-    digitalWrite(STATUS_LED, HIGH);
-    Serial.println("System ready!");
-}
 
-void loop() {
-    app.loop();
-    esp_task_wdt_reset();
+    // Metering starts right away so the slower setup below can't overrun the ring
+    xTaskCreatePinnedToCore(meteringTask, "metering", METERING_STACK, nullptr,
+                            configMAX_PRIORITIES - 3, &meteringTaskHandle, METERING_CORE);
 
-    if (WiFi.status() != WL_CONNECTED) {
-        Serial.println("⚠️  WiFi disconnected! Reconnecting...");
-        setupWiFi();
-    }
-    
-    // Check credit every minute
-    if (app.ready() && (millis() - lastCreditCheck >= CREDIT_CHECK_INTERVAL)) {
-        checkCreditAndControlRelay();
-        lastCreditCheck = millis();
-    }
-    
-    // Read sensors every minute
-    if (millis() - lastReading >= READING_INTERVAL) {
-        if (app.ready()) {
-            int currentHour = getCurrentHour();
-            
-            // FIXED: Check if hour has changed and we have data to save
-            if (currentHour != -1 && hourlyBuffer.currentHour != -1) {
-                if (currentHour != hourlyBuffer.currentHour && hourlyBuffer.samples > 0) {
-                    // Hour has changed - save the previous hour's data
-                    Serial.printf("\n🕐 Hour changed from %d to %d - saving previous hour data\n", 
-                                  hourlyBuffer.currentHour, currentHour);
-                    saveHourlyData();
-                    
-                    // Reset buffer for new hour
-                    hourlyBuffer.totalEnergy = 0;
-                    hourlyBuffer.totalPower = 0;
-                    hourlyBuffer.totalCurrent = 0;
-                    hourlyBuffer.peakPower = 0;
-                    hourlyBuffer.samples = 0;
-                    hourlyBuffer.currentHour = currentHour;
-                    
-                    Serial.printf("✓ Buffer reset for new hour: %d\n", currentHour);
-                }
-            } else if (currentHour != -1 && hourlyBuffer.currentHour == -1) {
-                // First time getting valid hour after startup
-                hourlyBuffer.currentHour = currentHour;
-                Serial.printf("✓ Set initial hour tracking: %d\n", currentHour);
-            }
-            
-            readAndSendData();
-            lastReading = millis();
-        } else {
-            Serial.println("Firebase not ready yet...");
+    if (LittleFS.begin(true) && telemetryLog.open()) {
+        Serial.printf("✓ Telemetry log open - %u bytes waiting for replay\n", telemetryLog.pendingBytes());
+        if (telemetryLog.recoveredBytes() > 0) {
+            Serial.printf("⚠️  Dropped %u bytes of a torn record at the log tail\n", telemetryLog.recoveredBytes());
         }
+    } else {
+        Serial.println("❌ Telemetry log unavailable - offline readings won't be kept");
     }
-    
-    delay(100);
-}
-
-void setupWiFi() {
-    WiFi.begin(ssid, password);
-    Serial.print("Connecting to WiFi");
-    
-    while (WiFi.status() != WL_CONNECTED) {
-        delay(500);
-        Serial.print(".");
-        digitalWrite(STATUS_LED, !digitalRead(STATUS_LED));
+#if METER_CHANNELS > 1
+    for (uint8_t c = 1; c < METER_CHANNELS; c++) {
+        if (!unitLogs[c]->open()) {
+            Serial.printf("❌ %s telemetry log unavailable\n", UNIT_IDS[c]);
+        }
     }
+    platform.attach(&hub);
+#else
+    platform.attach(&monitor);
+#endif
+    platform.beginWiFi(ssid, password, ntpServer, gmtOffset_sec, daylightOffset_sec);
+    platform.beginFirebase(DATABASE_URL);
+
+    // Hourly tracking starts here (-1 until NTP has synced; the first
+    // rollover step picks it up then), and the first credit check goes out
+    // as soon as Firebase is ready
+#if METER_CHANNELS > 1
+    for (uint8_t c = 0; c < METER_CHANNELS; c++) {
+        units[c]->watchSampleRing(&sampleRing);
+        units[c]->watchCalibration(&calibrationMailboxes[c]);
+        units[c]->watchLivePower(&livePower[c]);
+        units[c]->begin();
+    }
+#else
+    monitor.watchSampleRing(&sampleRing);
+    monitor.watchCalibration(&calibrationMailbox);
+    monitor.watchLivePower(&livePower);
+    monitor.begin();
+#endif
+
+    xTaskCreatePinnedToCore(networkTask, "network", NETWORK_STACK, nullptr,
+                            1, &networkTaskHandle, NETWORK_CORE);
     
-    Serial.println();
-    Serial.println("WiFi connected!");
-    Serial.print("IP address: ");
-    Serial.println(WiFi.localIP());
-
-    configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
-    Serial.println("Time synchronization started");
-
-    digitalWrite(STATUS_LED, HIGH);
+    Serial.println("System ready!");
 }
 
-void setupFirebase() {
-    Firebase.printf("Firebase Client v%s\n", FIREBASE_CLIENT_VERSION);
-    
-    ssl_client.setInsecure();
-    
-    Serial.println("Initializing Firebase...");
-    
-    initializeApp(aClient, app, getAuth(noAuth), asyncCB, "authTask");
-    
-    app.getApp<RealtimeDatabase>(Database);
-    Database.url(DATABASE_URL);
-    
-    Serial.println("Firebase initialization started");
-
-    delay(500);
-    checkCreditAndControlRelay();
+// Everything runs in the pinned tasks started by setup()
+void loop() {
+    vTaskDelete(NULL);
 }
 
-void asyncCB(AsyncResult &aResult) {
-    if (aResult.isEvent()) {
-        Firebase.printf("Event task: %s, msg: %s, code: %d\n", 
-                       aResult.uid().c_str(), 
-                       aResult.appEvent().message().c_str(), 
-                       aResult.appEvent().code());
-    }
-    
-    if (aResult.isError()) {
-        Firebase.printf("Error task: %s, msg: %s, code: %d\n", 
-                       aResult.uid().c_str(), 
-                       aResult.error().message().c_str(), 
-                       aResult.error().code());
+// Drains the sample ring every METERING_PERIOD_MS and queues a reading on
+// readingCadence. Nothing here touches the network, so TLS handshakes and
+// stalls on core 0 can't shift measurement timing. How long each period
+// took goes along with the next reading into the hourly health record.
+void meteringTask(void *arg) {
+    esp_task_wdt_add(NULL);
+    TickType_t lastWake = xTaskGetTickCount();
+    ReadingTimer readingTimer(readingCadence);
+    readingTimer.start(millis());
+
+    for (;;) {
+        uint32_t startUs = micros();
+#if METER_CHANNELS > 1
+        takeCalibrations(meterEngine, calibrationMailboxes);
+        runMultiMeteringPeriod(meterEngine, sampleRing, readingQueues, readingTimer, millis(), getEpoch, livePower);
+#else
+        takeCalibration(meterEngine, calibrationMailbox);
+        runMeteringPeriod(meterEngine, sampleRing, readingQueue, readingTimer, millis(), getEpoch, &livePower);
+#endif
+        readingTimer.periodTook(micros() - startUs);
+
+        esp_task_wdt_reset();
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(METERING_PERIOD_MS));
     }
 }
 
-void creditCallback(AsyncResult &aResult) {
-    isFirebaseBusy = false;
-    
-    if (aResult.available()) {
-        RealtimeDatabaseResult &RTDB = aResult.to<RealtimeDatabaseResult>();
-        if (RTDB.type() == realtime_database_data_type_float || 
-            RTDB.type() == realtime_database_data_type_integer || 
-            RTDB.type() == realtime_database_data_type_double) {
-            currentRemainingUnits = RTDB.to<float>();
-            Serial.printf("✓ Remaining units from Firebase: %.2f kWh\n", currentRemainingUnits);
-            
-            // Control relay based on credit
-            bool shouldBeOn = (currentRemainingUnits > 0);
-
-            if (shouldBeOn) {
-                // Ensure hardware matches desired state
-                digitalWrite(RELAY_PIN, LOW);
-                if (!relayState) {
-                    relayState = true;
-                    Serial.println("✓ RELAY ON - Power flowing to unit");
-                    for (int i = 0; i < 2; i++) {
-                        digitalWrite(STATUS_LED, LOW);
-                        delay(100);
-                        digitalWrite(STATUS_LED, HIGH);
-                        delay(100);
-                    }
-                }
-            } else {
-                digitalWrite(RELAY_PIN, HIGH);
-                if (relayState) {
-                    relayState = false;
-                    Serial.println("✗ RELAY OFF - No credit! Power disconnected");
-                    for (int i = 0; i < 3; i++) {
-                        digitalWrite(STATUS_LED, LOW);
-                        delay(500);
-                        digitalWrite(STATUS_LED, HIGH);
-                        delay(500);
-                    }
-                } else {
-                    // For debugging - confirm we actively set the pin low
-                    Serial.println("Relay forced OFF (no credit)");
-                }
-            }
-
-            Serial.printf("Relay State: %s | Remaining: %.2f kWh\n",
-                        relayState ? "ON" : "OFF",
-                        currentRemainingUnits);
-            
-            // Serial.printf("Relay State: %s | Remaining: %.2f kWh\n", 
-            //               relayState ? "ON" : "OFF", 
-            //               currentRemainingUnits);
-        } else {
-            Serial.println("⚠️  Firebase returned unexpected data type");
+void networkTask(void *arg) {
+    esp_task_wdt_add(NULL);
+    for (;;) {
+        platform.loop();
+#if METER_CHANNELS > 1
+        for (uint8_t c = 0; c < METER_CHANNELS; c++) {
+            units[c]->pass();
         }
-    }
-    
-    if (aResult.isError()) {
-        Serial.printf("❌ Error reading credit: %s\n", aResult.error().message().c_str());
-        Serial.println("   Retrying in next cycle...");
+        hub.pass();
+#else
+        monitor.pass();
+#endif
+        pollSerialCommands();
+        esp_task_wdt_reset();
+        vTaskDelay(pdMS_TO_TICKS(NETWORK_YIELD_MS));
     }
 }
 
-void checkCreditAndControlRelay() {
-
-     if (isFirebaseBusy) {
-        Serial.println("⏳ Firebase busy, skipping credit check");
-        return;
-    }
-    
-    isFirebaseBusy = true;
-
-    String path = unitBasePath + "remaining_units";
-    Database.get(aClient, path.c_str(), creditCallback, "getCreditTask");
-    
-    delay(500);
-
-    unsigned long startWait = millis();
-    while (isFirebaseBusy && (millis() - startWait < 2000)) {
-        app.loop();  // Process Firebase events
-        delay(50);
-    }
-    
-    if (isFirebaseBusy) {
-        Serial.println("⚠️  Credit check timeout");
-        isFirebaseBusy = false;
-    }
-}
-
-float readVoltage() {
-    float rawVoltage = readVoltageRaw();
-    float actual_voltage = rawVoltage * voltageCalibrationFactor;
-    
-    Serial.printf("[DEBUG] Raw: %.4fV, Calibrated: %.2fV\n", rawVoltage, actual_voltage);
-    return actual_voltage;
-} 
-
-float readCurrent() {
-    float voltage = readCurrentRaw();
-    float current = (voltage / ACS712_SENSITIVITY) * currentCalibrationFactor;
-    
-    Serial.printf("[DEBUG] Current sensor: %.4fV → %.3fA\n", voltage, current);
-    return current;
-}
-
-void readAndSendData() {
-    Serial.println("\n========== Reading Sensors ==========");
-    
-    float current = readCurrent();
-    float voltage = readVoltage();
-    float power = voltage * current;
-    
-    // Calculate energy consumed (kWh) for this reading interval
-    float energyConsumed = (power * (READING_INTERVAL / 1000.0 / 3600.0)) / 1000.0; //investigate this 1000.0 division factor(ejay's notes)
-    
-    String timestamp = getFormattedTimestamp();
-    
-    Serial.printf("Current: %.3f A\n", current);
-    Serial.printf("Voltage: %.2f V\n", voltage);
-    Serial.printf("Power: %.2f W\n", power);
-    Serial.printf("Energy (this interval): %.6f kWh\n", energyConsumed);
-
-    // FIXED: Accumulate in hourly buffer regardless of relay state
-    hourlyBuffer.totalEnergy += energyConsumed;
-    hourlyBuffer.totalPower += power;
-    hourlyBuffer.totalCurrent += current;
-    if (power > hourlyBuffer.peakPower) {
-        hourlyBuffer.peakPower = power;
-    }
-    hourlyBuffer.samples++;
-    
-    Serial.printf("📊 Hourly buffer - Hour: %d, Samples: %d, Total Energy: %.6f kWh\n", 
-                  hourlyBuffer.currentHour, hourlyBuffer.samples, hourlyBuffer.totalEnergy);
-    
-    // Send realtime data to Firebase
-    Database.set<float>(aClient, unitBasePath + "power", power, dataCallback, "setPower");
-    delay(100);
-    Database.set<String>(aClient, unitBasePath + "timestamp", timestamp, dataCallback, "setTimestamp");
-    
-    // Deduct energy only if relay ON
-    if (relayState && currentRemainingUnits > 0) {
-        float newRemainingUnits = currentRemainingUnits - energyConsumed;
-        if (newRemainingUnits < 0) newRemainingUnits = 0;
-        
-        delay(150);
-        Database.set<float>(aClient, unitBasePath + "remaining_units", newRemainingUnits, dataCallback, "setUnits");
-        
-        float newRemainingCredit = newRemainingUnits * COST_PER_KWH;
-        delay(150);
-        Database.set<float>(aClient, unitBasePath + "remaining_credit", newRemainingCredit, dataCallback, "setCredit");
-        
-        Serial.printf("Remaining: %.3f kWh (₦%.2f)\n", newRemainingUnits, newRemainingCredit);
-    } else {
-        Serial.println("⚠️  Relay OFF - Not deducting energy (but still tracking consumption)");
+// Single-key commands on the serial console
+void pollSerialCommands() {
+    while (Serial.available()) {
+        char command = Serial.read();
+        if (command == 'l') {
+            dumpEventLog();
+        } else if (command == 'p') {
+            calibrationCommand();
+        } else if (command == 'c') {
+            Serial.println("Restarting into the calibration wizard...");
+            wizardRequest = WIZARD_REQUESTED;
+            delay(100);
+            ESP.restart();
+        }
     }
-    Serial.println("=====================================\n");
 }
 
-void saveHourlyData() {
-    if (hourlyBuffer.samples == 0) {
-        Serial.println("⚠️  No samples to save for hourly data");
-        return;
-    }
-    
-    String date = getCurrentDate();
-    int hour = hourlyBuffer.currentHour;  // FIXED: Use the hour from buffer, not lastSavedHour
-    
-    if (date.isEmpty() || hour < 0) {
-        Serial.println("⚠️  Invalid date or hour for saving");
-        return;
-    }
-    
-    // Calculate averages
-    float avgPower = hourlyBuffer.totalPower / hourlyBuffer.samples;
-    float avgCurrent = hourlyBuffer.totalCurrent / hourlyBuffer.samples;
-    
-    Serial.println("\n========== Saving Hourly Data ==========");
-    Serial.printf("Date: %s, Hour: %02d:00\n", date.c_str(), hour);
-    Serial.printf("Total Energy: %.6f kWh\n", hourlyBuffer.totalEnergy);
-    Serial.printf("Avg Power: %.2f W\n", avgPower);
-    Serial.printf("Peak Power: %.2f W\n", hourlyBuffer.peakPower);
-    Serial.printf("Avg Current: %.3f A\n", avgCurrent);
-    Serial.printf("Samples: %d\n", hourlyBuffer.samples);
-    
-    String hourlyPath = historyHourlyBasePath + date + "/";
-    String hourStr = String(hour);
-    
-    // Save to Firebase with delay between writes to avoid overwhelming the connection
-    Database.set<float>(aClient, hourlyPath + hourStr + "/energy", hourlyBuffer.totalEnergy, dataCallback, "hourlyEnergy");
-    delay(150);
-    Database.set<float>(aClient, hourlyPath + hourStr + "/avgPower", avgPower, dataCallback, "hourlyAvgPower");
-    delay(150);
-    Database.set<float>(aClient, hourlyPath + hourStr + "/peakPower", hourlyBuffer.peakPower, dataCallback, "hourlyPeakPower");
-    delay(150);
-    Database.set<float>(aClient, hourlyPath + hourStr + "/avgCurrent", avgCurrent, dataCallback, "hourlyAvgCurrent");
-    delay(150);
-    Database.set<int>(aClient, hourlyPath + hourStr + "/samples", hourlyBuffer.samples, dataCallback, "hourlySamples");
-    delay(150);
-    
-    // Save timestamp of when this data was saved
-    String timestamp = getFormattedTimestamp();
-    Database.set<String>(aClient, hourlyPath + hourStr + "/savedAt", timestamp, dataCallback, "hourlySavedAt");
-    
-    // Also update daily aggregation
-    updateDailyData(date, hourlyBuffer.totalEnergy, avgPower, hourlyBuffer.peakPower);
-    
-    Serial.println("✓ Hourly data saved to Firebase");
-    Serial.println("=========================================\n");
+// Everything still in the log ring, oldest first. Formatting happens here,
+// not when the entries were logged.
+void dumpEventLog() {
+    uint32_t first = eventLog.total() - eventLog.count();
+    Serial.printf("---- event log: %u entries, %lu logged since boot ----\n",
+                  (unsigned)eventLog.count(), (unsigned long)eventLog.total());
+    char line[160];
+    for (size_t k = 0; k < eventLog.count(); k++) {
+        EventLog::format(eventLog.at(k), line, sizeof(line));
+        Serial.printf("%6lu %s\n", (unsigned long)(first + k), line);
+    }
+    Serial.println("---- end of event log ----");
 }
 
-void updateDailyData(String date, float hourlyEnergy, float hourlyAvgPower, float hourlyPeakPower) {
-    String dailyPath = historyDailyBasePath + date + "/";
-    
-    // Instead of overwriting, we should be accumulating daily totals
-    // For now, keeping your structure but with better naming
-    Database.set<float>(aClient, dailyPath + "lastHourEnergy", hourlyEnergy, dataCallback, "dailyUpdate");
-    delay(150);
-    Database.set<float>(aClient, dailyPath + "lastHourAvgPower", hourlyAvgPower, dataCallback, "dailyUpdate");
-    delay(150);
-    Database.set<float>(aClient, dailyPath + "lastPeakPower", hourlyPeakPower, dataCallback, "dailyUpdate");
-    delay(150);
-    
-    // Calculate cost
-    float cost = hourlyEnergy * COST_PER_KWH;
-    Database.set<float>(aClient, dailyPath + "lastHourCost", cost, dataCallback, "dailyUpdate");
-    
-    Serial.printf("✓ Updated daily aggregation for %s\n", date.c_str());
+#ifdef EVENT_LOG_ECHO
+// Bench builds: every entry also goes to Serial as it is logged
+void echoLogLine(const char *line) {
+    Serial.println(line);
 }
+#endif
 
-void forceSaveHourlyData() {
-    if (hourlyBuffer.samples > 0) {
-        Serial.println("\n⚡ Force saving current hourly data...");
-        saveHourlyData();
-        
-        // Reset buffer
-        int currentHour = getCurrentHour();
-        hourlyBuffer.totalEnergy = 0;
-        hourlyBuffer.totalPower = 0;
-        hourlyBuffer.totalCurrent = 0;
-        hourlyBuffer.peakPower = 0;
-        hourlyBuffer.samples = 0;
-        hourlyBuffer.currentHour = currentHour;
-    } else {
-        Serial.println("⚠️  No data to force save");
-    }
-}
-
-void dataCallback(AsyncResult &aResult) {
-    if (aResult.available()) {
-        consecutiveFirebaseErrors = 0;
-        // Quick LED blink on successful write
-        digitalWrite(STATUS_LED, LOW);
-        delay(50);
-        digitalWrite(STATUS_LED, HIGH);
-    }
-    
-    if (aResult.isError()) {
-        consecutiveFirebaseErrors++;
-        Serial.printf("Firebase error #%d: %s\n", consecutiveFirebaseErrors, aResult.error().message().c_str());
-
-        if (consecutiveFirebaseErrors >= MAX_FIREBASE_ERRORS) {
-            Serial.println("⚠️  Too many Firebase errors! Reinitializing...");
-            setupFirebase();
-            consecutiveFirebaseErrors = 0;
-        }
-
-        // LED error pattern
-        for (int i = 0; i < 3; i++) {
-            digitalWrite(STATUS_LED, LOW);
-            delay(200);
-            digitalWrite(STATUS_LED, HIGH);
-            delay(200);
-        }
-    }
-}
-
-void calibrateCurrentWithClampMeter() {
+// Each load tested becomes a point of the current table, so the profile
+// follows the sensor from a phone charger up to the high load
+void calibrateCurrentWithClampMeter(CalibrationTable &table) {
     Serial.println("\n═══════════════════════════════════════");
     Serial.println("  CURRENT SENSOR CALIBRATION");
     Serial.println("═══════════════════════════════════════");
@@ -588,6 +493,10 @@ void calibrateCurrentWithClampMeter() {
     }
     float zeroPoint = zeroSum / 2000.0;
     Serial.printf("✓ Zero point: %.2f ADC counts\n\n", zeroPoint);
+
+    // Seed the runtime offset tracker with the measured zero point
+    platform.saveFloat("iOffset", zeroPoint);
+    Serial.println("✓ Zero point saved as the current channel offset");
     
     // Test with low load
     Serial.println("STEP 2: Low Load Test (Phone charger)");
@@ -597,7 +506,7 @@ void calibrateCurrentWithClampMeter() {
     Serial.println("\nPress ENTER when ready...");
     waitForSerialInput();
     
-    testCurrentReading("Low Load", zeroPoint);
+    testCurrentReading("Low Load", zeroPoint, table);
     
     // Test with medium load
     Serial.println("\nSTEP 3: Medium Load Test");
@@ -607,7 +516,7 @@ void calibrateCurrentWithClampMeter() {
     Serial.println("\nPress ENTER when ready...");
     waitForSerialInput();
     
-    testCurrentReading("Medium Load", zeroPoint);
+    testCurrentReading("Medium Load", zeroPoint, table);
     
     // Test with higher load
     Serial.println("\nSTEP 4: High Load Test");
@@ -617,33 +526,35 @@ void calibrateCurrentWithClampMeter() {
     Serial.println("\nPress ENTER when ready...");
     waitForSerialInput();
     
-    testCurrentReading("High Load", zeroPoint);
+    testCurrentReading("High Load", zeroPoint, table);
     
     Serial.println("\n═══════════════════════════════════════");
     Serial.println("  Current Calibration Complete!");
     Serial.println("═══════════════════════════════════════\n");
 }
 
-void testCurrentReading(String loadDesc, float zeroPoint) {
+const uint32_t CALIBRATION_CURRENT_SAMPLES = 1000;
+
+void testCurrentReading(String loadDesc, float zeroPoint, CalibrationTable &table) {
     Serial.printf("\nTesting: %s\n", loadDesc.c_str());
     Serial.println("Taking 10 readings...\n");
     
     float sensorSum = 0;
     int readings = 10;
+
+    // Fixed reference at the measured zero point (seeded, never updated)
+    OffsetTracker zero(14, zeroPoint);
     
     for(int i = 0; i < readings; i++) {
-        long sum = 0;
-        int samples = 1000;
+        RmsKernel<int16_t, CALIBRATION_CURRENT_SAMPLES> kernel;
         
-        for (int j = 0; j < samples; j++) {
-            int reading = analogRead(CURRENT_PIN);
-            float adjusted = reading - zeroPoint;
-            sum += adjusted * adjusted;
+        while (!kernel.full()) {
+            kernel.add((int16_t)zero.deviation(analogRead(CURRENT_PIN), DEVIATION_FRAC_BITS));
             delayMicroseconds(100);
         }
         
-        float rms = sqrt(sum / samples);
-        float voltage = (rms * 3.3) / 4095.0;
+        float rms = kernel.rms() / (1 << DEVIATION_FRAC_BITS);
+        float voltage = (rms * ADC_VOLTAGE) / ADC_MAX;
         float current = voltage / ACS712_SENSITIVITY;
         
         sensorSum += current;
@@ -664,8 +575,11 @@ void testCurrentReading(String loadDesc, float zeroPoint) {
     
     if(clampReading > 0 && avgSensorReading > 0.001) {
         float calibrationFactor = clampReading / avgSensorReading;
-        Serial.printf("\n✅ USE THIS VALUE: %.4f\n", calibrationFactor);
-        Serial.println("\n📝 Update currentCalibrationFactor in code!");
+        if (table.add(avgSensorReading, calibrationFactor)) {
+            Serial.printf("\n✅ Gain %.4f at %.4fA (uncalibrated)\n", calibrationFactor, avgSensorReading);
+        } else {
+            Serial.println("\n❌ Same reading as an earlier load - point skipped");
+        }
     } else {
         Serial.println("\n❌ Invalid reading - try again");
     }
@@ -673,7 +587,7 @@ void testCurrentReading(String loadDesc, float zeroPoint) {
     Serial.println("-----------------------------------------");
 }
 
-void calibrateVoltageSimple() {
+void calibrateVoltageSimple(CalibrationTable &table) {
     Serial.println("\n═══════════════════════════════════════");
     Serial.println("  VOLTAGE SENSOR CALIBRATION");
     Serial.println("═══════════════════════════════════════");
@@ -718,8 +632,8 @@ void calibrateVoltageSimple() {
     
     if(actualVoltage > 0 && avgVoltage > 0) {
         float voltageFactor = actualVoltage / avgVoltage;
-        Serial.printf("\n✅ USE THIS VALUE: %.4f\n", voltageFactor);
-        Serial.println("\n📝 Update voltageCalibrationFactor in code!");
+        table.add(avgVoltage, voltageFactor);
+        Serial.printf("\n✅ Gain %.4f at %.4fV (raw)\n", voltageFactor, avgVoltage);
     }
     
     Serial.println("-----------------------------------------");
@@ -733,19 +647,29 @@ void runFullCalibration() {
     Serial.println("\nPress ENTER to begin...");
     waitForSerialInput();
     
-    calibrateCurrentWithClampMeter();
+    CalibrationTable current;
+    calibrateCurrentWithClampMeter(current);
     
     delay(2000);
     
-    calibrateVoltageSimple();
+    CalibrationTable voltage;
+    calibrateVoltageSimple(voltage);
+
+    // A channel the wizard got no good reading for keeps what it had
+    CalibrationProfile profile = monitor.calibration();
+    if (current.count > 0) profile.current = current;
+    if (voltage.count > 0) profile.voltage = voltage;
+    monitor.applyCalibration(profile, "wizard");
+
+    char text[CALIBRATION_TEXT_CHARS];
+    formatCalibrationProfile(profile, text, sizeof(text));
     
     Serial.println("\n\n╔════════════════════════════════════════╗");
     Serial.println("║     CALIBRATION COMPLETE! 🎉          ║");
     Serial.println("╚════════════════════════════════════════╝");
-    Serial.println("\n📝 Update these in your code:");
-    Serial.println("\n   float currentCalibrationFactor = ;");
-    Serial.println("   float voltageCalibrationFactor = ;");
-    Serial.println("\nThen set CALIBRATION_MODE = false");
+    Serial.println("\n✓ Saved - no reflash needed. The profile, for other units");
+    Serial.println("  ('p <profile>' on their console or <unit>/calibration in the RTDB):");
+    Serial.printf("\n   %s\n", text);
 }
 
 void waitForSerialInput() {
@@ -771,33 +695,36 @@ String readSerialLine() {
     return input;
 }
 
-float readCurrentRaw() {
-    long sum = 0;
-    int samples = 500;
-    
-    for (int i = 0; i < samples; i++) {
-        int reading = analogRead(CURRENT_PIN);
-        sum += (reading - ADC_CENTER) * (reading - ADC_CENTER);
-        delayMicroseconds(50);
-    }
-    
-    float rms = sqrt(sum / samples);
-    float voltage = (rms * ADC_VOLTAGE) / ADC_MAX;
-    
-    return voltage;
-}
+// Blocking burst read, only used by the calibration wizard before sampling starts.
+// The burst runs from one rising zero crossing to another CALIBRATION_CYCLES
+// later, so it always averages whole mains cycles.
+const int CALIBRATION_CYCLES = 10;
+const unsigned long CALIBRATION_BURST_TIMEOUT_MS = 500;
+const uint32_t CALIBRATION_MAX_SAMPLES = 10000;  // > 500 ms of analogRead at ~60 us each
 
 float readVoltageRaw() {
-    long sum = 0;
-    int samples = 500;
-
-    for (int i = 0; i < samples; i++) {
-        int reading = analogRead(VOLTAGE_PIN);
-        sum += (reading - ADC_CENTER) * (reading - ADC_CENTER);
+    ZeroCrossDetector zeroCross;
+    RmsKernel<int16_t, CALIBRATION_MAX_SAMPLES> kernel;
+    int cycles = -1;  // -1 until the first crossing starts the window
+    unsigned long start = millis();
+    // From the offset saved last hour, tracked through the burst
+    OffsetTracker zero(14, platform.loadFloat("vOffset", ADC_CENTER));
+
+    while (cycles < CALIBRATION_CYCLES && millis() - start < CALIBRATION_BURST_TIMEOUT_MS) {
+        uint16_t raw = analogRead(VOLTAGE_PIN);
+        zero.update(raw);
+        int16_t adjusted = (int16_t)zero.deviation(raw, DEVIATION_FRAC_BITS);
+        if (zeroCross.update(adjusted)) {
+            cycles++;
+            if (cycles == CALIBRATION_CYCLES) break;
+        }
+        if (cycles >= 0 && kernel.add(adjusted)) {
+            break;
+        }
         delayMicroseconds(50);
     }
 
-    float rms = sqrt(sum / samples);
+    float rms = kernel.rms() / (1 << DEVIATION_FRAC_BITS);
     float voltage_reading = (rms * ADC_VOLTAGE) / ADC_MAX;
     
     return voltage_reading;
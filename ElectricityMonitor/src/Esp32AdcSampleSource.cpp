@@ -0,0 +1,79 @@
+#include "Esp32AdcSampleSource.h"
+
+// 20 kHz is the slowest rate the ESP32 DMA ADC accepts. Two pins with
+// 10 conversions each per frame gives one averaged V/I pair every 1 ms,
+// i.e. 20 pairs per 50 Hz cycle.
+const uint32_t ADC_CONVERSION_RATE_HZ = 20000;
+const uint32_t ADC_CONVERSIONS_PER_PIN = 10;
+const uint8_t ADC_PIN_COUNT = 2;
+
+static TaskHandle_t samplerTaskHandle = nullptr;
+
+Esp32AdcSampleSource::Esp32AdcSampleSource(uint8_t currentPin, uint8_t voltagePin)
+    : currentPin(currentPin), voltagePin(voltagePin), ring(nullptr), task(nullptr) {}
+
+uint32_t Esp32AdcSampleSource::sampleRateHz() const {
+    return ADC_CONVERSION_RATE_HZ / (ADC_CONVERSIONS_PER_PIN * ADC_PIN_COUNT);
+}
+
+bool Esp32AdcSampleSource::begin(RawSampleRing &target) {
+    ring = &target;
+
+    if (xTaskCreatePinnedToCore(samplerTask, "adcSampler", 3072, this,
+                                configMAX_PRIORITIES - 2, &task, 1) != pdPASS) {
+        return false;
+    }
+    samplerTaskHandle = task;
+
+    uint8_t pins[ADC_PIN_COUNT] = { currentPin, voltagePin };
+    analogContinuousSetWidth(12);
+    analogContinuousSetAtten(ADC_11db);
+    if (!analogContinuous(pins, ADC_PIN_COUNT, ADC_CONVERSIONS_PER_PIN,
+                          ADC_CONVERSION_RATE_HZ, &onFrameReady)) {
+        end();
+        return false;
+    }
+    return analogContinuousStart();
+}
+
+void Esp32AdcSampleSource::end() {
+    analogContinuousStop();
+    analogContinuousDeinit();
+    if (task != nullptr) {
+        vTaskDelete(task);
+        task = nullptr;
+    }
+    samplerTaskHandle = nullptr;
+}
+
+// Runs in ISR context: just wake the sampler task
+void IRAM_ATTR Esp32AdcSampleSource::onFrameReady() {
+    if (samplerTaskHandle == nullptr) return;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(samplerTaskHandle, &woken);
+    if (woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void Esp32AdcSampleSource::samplerTask(void *arg) {
+    Esp32AdcSampleSource *self = static_cast<Esp32AdcSampleSource *>(arg);
+    adc_continuous_data_t *result = nullptr;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Drain every frame the driver has queued since the last wake-up
+        while (analogContinuousRead(&result, 0)) {
+            RawSample sample = { 0, 0 };
+            for (uint8_t k = 0; k < ADC_PIN_COUNT; k++) {
+                if (result[k].pin == self->currentPin) {
+                    sample.current = (uint16_t)result[k].avg_read_raw;
+                } else if (result[k].pin == self->voltagePin) {
+                    sample.voltage = (uint16_t)result[k].avg_read_raw;
+                }
+            }
+            self->ring->push(sample);
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef ESP32_ADC_SAMPLE_SOURCE_H
+#define ESP32_ADC_SAMPLE_SOURCE_H
+
+#include <Arduino.h>
+#include <SampleSource.h>
+
+// Continuous ADC sampling on ADC1 using the DMA-backed driver
+// (analogContinuous). The driver interrupts once per conversion frame;
+// a small FreeRTOS task then moves the frame's V/I pair into the ring.
+class Esp32AdcSampleSource : public SampleSource {
+public:
+    Esp32AdcSampleSource(uint8_t currentPin, uint8_t voltagePin);
+
+    bool begin(RawSampleRing &ring) override;
+    void end() override;
+    uint32_t sampleRateHz() const override;
+
+private:
+    static void IRAM_ATTR onFrameReady();
+    static void samplerTask(void *arg);
+
+    uint8_t currentPin;
+    uint8_t voltagePin;
+    RawSampleRing *ring;
+    TaskHandle_t task;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include "Esp32MultiAdcSampleSource.h"
+
+// As Esp32AdcSampleSource: 20 kHz shared by every pin in the pattern. The
+// conversions per pin shrink as pins are added so a frame still closes
+// about every 1 ms; sampleRateHz() reports what that works out to.
+const uint32_t ADC_CONVERSION_RATE_HZ = 20000;
+const uint32_t ADC_CONVERSIONS_PER_FRAME = 20;
+
+static TaskHandle_t samplerTaskHandle = nullptr;
+
+Esp32MultiAdcSampleSource::Esp32MultiAdcSampleSource(uint8_t voltagePin, const uint8_t *pins, uint8_t channels)
+    : voltagePin(voltagePin),
+      channelCount(channels > MAX_METER_CHANNELS ? MAX_METER_CHANNELS : channels),
+      ring(nullptr),
+      task(nullptr) {
+    for (uint8_t c = 0; c < MAX_METER_CHANNELS; c++) {
+        currentPins[c] = c < channelCount ? pins[c] : 0xFF;
+    }
+}
+
+uint32_t Esp32MultiAdcSampleSource::conversionsPerPin() const {
+    uint32_t conversions = ADC_CONVERSIONS_PER_FRAME / pinCount();
+    return conversions > 0 ? conversions : 1;
+}
+
+uint32_t Esp32MultiAdcSampleSource::sampleRateHz() const {
+    return ADC_CONVERSION_RATE_HZ / (conversionsPerPin() * pinCount());
+}
+
+bool Esp32MultiAdcSampleSource::begin(ChannelFrameRing &target) {
+    ring = &target;
+
+    if (xTaskCreatePinnedToCore(samplerTask, "adcSampler", 3072, this,
+                                configMAX_PRIORITIES - 2, &task, 1) != pdPASS) {
+        return false;
+    }
+    samplerTaskHandle = task;
+
+    uint8_t pins[MAX_METER_CHANNELS + 1];
+    pins[0] = voltagePin;
+    for (uint8_t c = 0; c < channelCount; c++) {
+        pins[c + 1] = currentPins[c];
+    }
+    analogContinuousSetWidth(12);
+    analogContinuousSetAtten(ADC_11db);
+    if (!analogContinuous(pins, pinCount(), conversionsPerPin(),
+                          ADC_CONVERSION_RATE_HZ, &onFrameReady)) {
+        end();
+        return false;
+    }
+    return analogContinuousStart();
+}
+
+void Esp32MultiAdcSampleSource::end() {
+    analogContinuousStop();
+    analogContinuousDeinit();
+    if (task != nullptr) {
+        vTaskDelete(task);
+        task = nullptr;
+    }
+    samplerTaskHandle = nullptr;
+}
+
+// Runs in ISR context: just wake the sampler task
+void IRAM_ATTR Esp32MultiAdcSampleSource::onFrameReady() {
+    if (samplerTaskHandle == nullptr) return;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(samplerTaskHandle, &woken);
+    if (woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void Esp32MultiAdcSampleSource::samplerTask(void *arg) {
+    Esp32MultiAdcSampleSource *self = static_cast<Esp32MultiAdcSampleSource *>(arg);
+    adc_continuous_data_t *result = nullptr;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Drain every frame the driver has queued since the last wake-up
+        while (analogContinuousRead(&result, 0)) {
+            ChannelFrame frame = {};
+            for (uint8_t k = 0; k < self->pinCount(); k++) {
+                uint16_t raw = (uint16_t)result[k].avg_read_raw;
+                if (result[k].pin == self->voltagePin) {
+                    frame.voltage = raw;
+                    continue;
+                }
+                for (uint8_t c = 0; c < self->channelCount; c++) {
+                    if (result[k].pin == self->currentPins[c]) {
+                        frame.current[c] = raw;
+                        break;
+                    }
+                }
+            }
+            self->ring->push(frame);
+        }
+    }
+}
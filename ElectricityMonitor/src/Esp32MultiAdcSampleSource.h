@@ -0,0 +1,33 @@
+#ifndef ESP32_MULTI_ADC_SAMPLE_SOURCE_H
+#define ESP32_MULTI_ADC_SAMPLE_SOURCE_H
+
+#include <Arduino.h>
+#include <SampleSource.h>
+
+// Esp32AdcSampleSource for a board metering several units: the voltage pin
+// and one current pin per channel in the same DMA conversion pattern, so
+// every frame's samples are taken within a few tens of microseconds.
+class Esp32MultiAdcSampleSource : public ChannelFrameSource {
+public:
+    Esp32MultiAdcSampleSource(uint8_t voltagePin, const uint8_t *currentPins, uint8_t channels);
+
+    bool begin(ChannelFrameRing &ring) override;
+    void end() override;
+    uint32_t sampleRateHz() const override;
+    uint8_t channels() const override { return channelCount; }
+
+private:
+    static void IRAM_ATTR onFrameReady();
+    static void samplerTask(void *arg);
+
+    uint8_t pinCount() const { return channelCount + 1; }
+    uint32_t conversionsPerPin() const;
+
+    uint8_t voltagePin;
+    uint8_t currentPins[MAX_METER_CHANNELS];
+    uint8_t channelCount;
+    ChannelFrameRing *ring;
+    TaskHandle_t task;
+};
+
+#endif
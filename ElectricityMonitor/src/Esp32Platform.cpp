@@ -0,0 +1,270 @@
+#include "Esp32Platform.h"
+#include <time.h>
+#include <EventLog.h>
+#include <MonitorApp.h>
+
+static const char *PREFS_NAMESPACE = "emonitor";
+
+Esp32Platform *Esp32Platform::instance = nullptr;
+
+Esp32Platform::Esp32Platform(uint8_t relayPin, uint8_t statusLedPin)
+    : relayCount(1),
+      statusLedPin(statusLedPin),
+      app(nullptr),
+      databaseUrl(""),
+      aClient(ssl_client),
+      streamClient(stream_ssl_client) {
+    relayPins[0] = relayPin;
+    instance = this;
+}
+
+void Esp32Platform::setRelayPins(const uint8_t *pins, uint8_t count) {
+    relayCount = count > MAX_METER_CHANNELS ? MAX_METER_CHANNELS : count;
+    for (uint8_t c = 0; c < relayCount; c++) {
+        relayPins[c] = pins[c];
+    }
+}
+
+void Esp32Platform::beginWiFi(const char *ssid, const char *password, const char *ntpServer,
+                              long gmtOffsetSec, int daylightOffsetSec) {
+    WiFi.begin(ssid, password);
+    LOG_INFO("Connecting to WiFi...");
+
+    // SNTP keeps trying on its own once the network comes up
+    configTime(gmtOffsetSec, daylightOffsetSec, ntpServer);
+    LOG_INFO("Time synchronization started");
+}
+
+void Esp32Platform::beginFirebase(const char *url) {
+    databaseUrl = url;
+    Firebase.printf("Firebase Client v%s\n", FIREBASE_CLIENT_VERSION);
+
+    ssl_client.setInsecure();
+    stream_ssl_client.setInsecure();
+    streamClient.setSSEFilters("get,put,patch,keep-alive,cancel,auth_revoked");
+
+    restartFirebase();
+}
+
+void Esp32Platform::restartFirebase() {
+    LOG_INFO("Initializing Firebase...");
+
+    initializeApp(aClient, firebaseApp, getAuth(noAuth), asyncCB, "authTask");
+
+    firebaseApp.getApp<RealtimeDatabase>(Database);
+    Database.url(databaseUrl);
+
+    LOG_INFO("Firebase initialization started");
+}
+
+void Esp32Platform::loop() {
+    firebaseApp.loop();
+}
+
+// Seconds since 1970, or 0 while NTP hasn't set the clock yet
+uint32_t Esp32Platform::epoch() {
+    time_t now = time(nullptr);
+    return now > 1600000000 ? (uint32_t)now : 0;
+}
+
+bool Esp32Platform::wifiConnected() {
+    return WiFi.status() == WL_CONNECTED;
+}
+
+bool Esp32Platform::firebaseReady() {
+    return firebaseApp.ready();
+}
+
+uint32_t Esp32Platform::localIp() {
+    return (uint32_t)WiFi.localIP();
+}
+
+void Esp32Platform::reconnect() {
+    WiFi.reconnect();
+}
+
+// Sends the get and returns; creditCallback() passes the answer on and the
+// scheduler gives up on it after its credit timeout
+void Esp32Platform::requestCredit(const char *path) {
+    Database.get(aClient, path, creditCallback, "getCreditTask");
+}
+
+// Server-sent events on remaining_units: a dashboard top-up reaches the
+// relay as soon as RTDB pushes it, instead of at the next poll
+void Esp32Platform::openCreditStream(const char *path) {
+    streamClient.stopAsync();  // drop a stale stream before opening a fresh one
+    Database.get(streamClient, path, creditStreamCallback, true, "creditStream");
+}
+
+void Esp32Platform::requestCalibration(const char *path) {
+    Database.get(aClient, path, calibrationCallback, "getCalibration");
+}
+
+void Esp32Platform::sendUpdate(const char *path, const char *json, const char *uid) {
+    Database.update<object_t>(aClient, path, object_t(json), dataCallback, uid);
+}
+
+void Esp32Platform::setRelay(bool on) {
+    setChannelRelay(0, on);
+}
+
+// The relay modules are active-low
+void Esp32Platform::setChannelRelay(uint8_t channel, bool on) {
+    if (channel < relayCount) {
+        digitalWrite(relayPins[channel], on ? LOW : HIGH);
+    }
+}
+
+void Esp32Platform::setStatusLed(bool on) {
+    digitalWrite(statusLedPin, on ? HIGH : LOW);
+}
+
+float Esp32Platform::loadFloat(const char *key, float fallback) {
+    prefs.begin(PREFS_NAMESPACE, true);
+    float value = prefs.getFloat(key, fallback);
+    prefs.end();
+    return value;
+}
+
+void Esp32Platform::saveFloat(const char *key, float value) {
+    prefs.begin(PREFS_NAMESPACE, false);
+    prefs.putFloat(key, value);
+    prefs.end();
+}
+
+uint64_t Esp32Platform::loadU64(const char *key, uint64_t fallback) {
+    prefs.begin(PREFS_NAMESPACE, true);
+    uint64_t value = prefs.getULong64(key, fallback);
+    prefs.end();
+    return value;
+}
+
+void Esp32Platform::saveU64(const char *key, uint64_t value) {
+    prefs.begin(PREFS_NAMESPACE, false);
+    prefs.putULong64(key, value);
+    prefs.end();
+}
+
+bool Esp32Platform::loadBytes(const char *key, void *out, size_t size) {
+    prefs.begin(PREFS_NAMESPACE, true);
+    bool found = prefs.getBytesLength(key) == size && prefs.getBytes(key, out, size) == size;
+    prefs.end();
+    return found;
+}
+
+void Esp32Platform::saveBytes(const char *key, const void *data, size_t size) {
+    prefs.begin(PREFS_NAMESPACE, false);
+    prefs.putBytes(key, data, size);
+    prefs.end();
+}
+
+void Esp32Platform::asyncCB(AsyncResult &aResult) {
+    if (aResult.isEvent()) {
+        Firebase.printf("Event task: %s, msg: %s, code: %d\n",
+                       aResult.uid().c_str(),
+                       aResult.appEvent().message().c_str(),
+                       aResult.appEvent().code());
+    }
+
+    if (aResult.isError()) {
+        Firebase.printf("Error task: %s, msg: %s, code: %d\n",
+                       aResult.uid().c_str(),
+                       aResult.error().message().c_str(),
+                       aResult.error().code());
+    }
+}
+
+bool Esp32Platform::isNumber(RealtimeDatabaseResult &RTDB) {
+    return RTDB.type() == realtime_database_data_type_float ||
+           RTDB.type() == realtime_database_data_type_integer ||
+           RTDB.type() == realtime_database_data_type_double;
+}
+
+void Esp32Platform::creditCallback(AsyncResult &aResult) {
+    MonitorListener *app = instance->app;
+    if (app == nullptr) {
+        return;
+    }
+    if (aResult.available() || aResult.isError()) {
+        app->creditAnswered();
+    }
+
+    if (aResult.available()) {
+        RealtimeDatabaseResult &RTDB = aResult.to<RealtimeDatabaseResult>();
+        if (isNumber(RTDB)) {
+            app->applyRemainingUnits(RTDB.to<double>(), "Firebase");
+        } else {
+            LOG_WARN("Credit read returned an unexpected data type");
+        }
+    }
+
+    if (aResult.isError()) {
+        LOG_ERROR("Credit read failed (code %d) - retrying next cycle", aResult.error().code());
+    }
+}
+
+void Esp32Platform::creditStreamCallback(AsyncResult &aResult) {
+    MonitorListener *app = instance->app;
+    if (app == nullptr) {
+        return;
+    }
+    if (aResult.available()) {
+        RealtimeDatabaseResult &stream = aResult.to<RealtimeDatabaseResult>();
+        if (!stream.isStream()) {
+            return;
+        }
+
+        // Any event, keep-alives included, shows the stream is up
+        app->creditStreamEvent();
+
+        if (stream.event() == "cancel" || stream.event() == "auth_revoked") {
+            LOG_WARN("Credit stream closed by server (%s)", stream.event() == "cancel" ? "cancel" : "auth_revoked");
+            app->creditStreamClosed();
+        } else if ((stream.event() == "put" || stream.event() == "patch") && stream.dataPath() == "/") {
+            if (isNumber(stream)) {
+                app->applyRemainingUnits(stream.to<double>(), "stream");
+            } else {
+                LOG_WARN("Credit stream sent an unexpected data type");
+            }
+        }
+    }
+
+    if (aResult.isError()) {
+        LOG_ERROR("Credit stream error (code %d)", aResult.error().code());
+        app->creditStreamClosed();
+    }
+}
+
+// A string node; null when the unit has no profile on the server
+void Esp32Platform::calibrationCallback(AsyncResult &aResult) {
+    MonitorListener *app = instance->app;
+    if (app == nullptr) {
+        return;
+    }
+    if (aResult.available()) {
+        RealtimeDatabaseResult &RTDB = aResult.to<RealtimeDatabaseResult>();
+        if (RTDB.type() == realtime_database_data_type_string) {
+            app->calibrationAnswered(RTDB.to<String>().c_str());
+        } else if (RTDB.type() == realtime_database_data_type_null) {
+            app->calibrationAnswered("");
+        } else {
+            LOG_WARN("Calibration read returned an unexpected data type");
+        }
+    }
+    if (aResult.isError()) {
+        LOG_WARN("Calibration read failed (code %d)", aResult.error().code());
+    }
+}
+
+void Esp32Platform::dataCallback(AsyncResult &aResult) {
+    MonitorListener *app = instance->app;
+    if (app == nullptr) {
+        return;
+    }
+    if (aResult.available()) {
+        app->updateAnswered(aResult.uid().c_str(), true);
+    }
+    if (aResult.isError()) {
+        app->updateAnswered(aResult.uid().c_str(), false, aResult.error().code());
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef ESP32_PLATFORM_H
+#define ESP32_PLATFORM_H
+
+#define ENABLE_DATABASE
+#define ENABLE_USER_AUTH
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <FirebaseClient.h>
+#include <Preferences.h>
+#include <MonitorPlatform.h>
+#include <SampleSource.h>
+
+// MonitorPlatform on the board: WiFi and SNTP, FirebaseClient for the RTDB,
+// the relay and status LED pins, and Preferences for NVS. FirebaseClient
+// callbacks are plain functions, so there is one instance and its callbacks
+// forward to the MonitorListener attached to it (MonitorApp, or a
+// BuildingHub on a board metering several units).
+class Esp32Platform : public MonitorPlatform {
+public:
+    Esp32Platform(uint8_t relayPin, uint8_t statusLedPin);
+
+    // Where the Firebase answers go; set before beginFirebase()
+    void attach(MonitorListener *target) { app = target; }
+
+    // A board metering several units: one relay pin per channel, channel 0's
+    // replacing the constructor's
+    void setRelayPins(const uint8_t *pins, uint8_t count);
+
+    // Start the first connection attempt and SNTP, and return; the
+    // scheduler reports when the link comes up and retries if it doesn't
+    void beginWiFi(const char *ssid, const char *password, const char *ntpServer,
+                   long gmtOffsetSec, int daylightOffsetSec);
+    void beginFirebase(const char *databaseUrl);
+
+    // FirebaseClient's loop; once per network task pass, before MonitorApp's
+    void loop();
+
+    uint32_t nowMs() override { return millis(); }
+    uint32_t epoch() override;
+    uint32_t nowUs() override { return micros(); }
+
+    uint32_t heapFree() override { return ESP.getFreeHeap(); }
+    uint32_t heapLowWater() override { return ESP.getMinFreeHeap(); }
+
+    bool wifiConnected() override;
+    bool firebaseReady() override;
+    uint32_t localIp() override;
+    void reconnect() override;
+    void restartFirebase() override;
+
+    void requestCredit(const char *path) override;
+    void openCreditStream(const char *path) override;
+    void requestCalibration(const char *path) override;
+    void sendUpdate(const char *path, const char *json, const char *uid) override;
+
+    void setRelay(bool on) override;
+    void setChannelRelay(uint8_t channel, bool on) override;
+    void setStatusLed(bool on) override;
+
+    float loadFloat(const char *key, float fallback) override;
+    void saveFloat(const char *key, float value) override;
+    uint64_t loadU64(const char *key, uint64_t fallback) override;
+    void saveU64(const char *key, uint64_t value) override;
+    bool loadBytes(const char *key, void *out, size_t size) override;
+    void saveBytes(const char *key, const void *data, size_t size) override;
+
+private:
+    static void asyncCB(AsyncResult &aResult);
+    static void creditCallback(AsyncResult &aResult);
+    static void creditStreamCallback(AsyncResult &aResult);
+    static void calibrationCallback(AsyncResult &aResult);
+    static void dataCallback(AsyncResult &aResult);
+    static bool isNumber(RealtimeDatabaseResult &RTDB);
+
+    static Esp32Platform *instance;
+
+    uint8_t relayPins[MAX_METER_CHANNELS];
+    uint8_t relayCount;
+    uint8_t statusLedPin;
+    MonitorListener *app;
+    const char *databaseUrl;
+
+    WiFiClientSecure ssl_client;
+    AsyncClientClass aClient;
+    // The credit stream holds its connection open, so it gets its own client
+    WiFiClientSecure stream_ssl_client;
+    AsyncClientClass streamClient;
+    RealtimeDatabase Database;
+    FirebaseApp firebaseApp;
+    NoAuth noAuth;
+
+    Preferences prefs;
+};
+
+#endif
@@ -0,0 +1,251 @@
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <AllocCounter.h>
+#include <BenchClock.h>
+#include <BenchPlatform.h>
+#include <BenchReport.h>
+#include <EventLog.h>
+#include <FakeSampleSource.h>
+#include <MeterEngine.h>
+#include <MonitorApp.h>
+#include <RmsKernel.h>
+#ifdef ARDUINO_ARCH_ESP32
+#include <Arduino.h>
+#include <LittleFS.h>
+#endif
+
+// Benchmarks, run with `pio test -e native-bench` or `-e esp32-bench`.
+// Each result is a BENCH line (see BenchReport.h):
+//   rms_kernel, power_kernel   ns/sample, the integer kernels on their own
+//   meter_engine               ns/sample, everything the metering task does
+//                              per sample: offsets, zero crossings, kernel
+//   publish_cycle              us and allocations for one reading carried
+//                              through the sample, rollover and publish steps
+//   hour_close                 the same for the cycle that closes an hour
+//   payload_per_hour           bytes (paths and JSON) sent to Firebase
+// The assertions only catch a benchmark that didn't run what it meant to.
+
+EventLog eventLog;
+static BenchPlatform *logClock = nullptr;
+
+uint32_t eventLogClockMs() {
+    return logClock != nullptr ? logClock->nowMs() : 0;
+}
+
+static const uint32_t SAMPLE_RATE_HZ = 1000;
+static const size_t BLOCK_SAMPLES = 4000;
+static const size_t BLOCKS_PER_MINUTE = 60 * SAMPLE_RATE_HZ / BLOCK_SAMPLES;
+static const int RUNS = 5;   // the best run counts
+
+static RawSample samples[BLOCK_SAMPLES];
+static int16_t voltage[BLOCK_SAMPLES];
+static int16_t current[BLOCK_SAMPLES];
+static volatile int64_t sink;
+
+static const uint32_t START_EPOCH = 1762214400;   // 2025-11-04 00:00:00 UTC
+#ifdef ARDUINO_ARCH_ESP32
+static const char *LOG_PATH = "/littlefs/bench.log";
+static const char *CURSOR_PATH = "/littlefs/bench.pos";
+#else
+static const char *LOG_PATH = "/tmp/emonitor_bench.log";
+static const char *CURSOR_PATH = "/tmp/emonitor_bench.pos";
+#endif
+
+// Four seconds of a 4 A, PF 0.9 load on 230 V mains, in ADC counts
+static void makeSamples() {
+    static RawSampleRing ring;   // 16 KB: too much for the loop task stack
+    FakeSampleSource source(SAMPLE_RATE_HZ);
+    FakeWaveform wave;
+    wave.voltageAmplitude = 230 * 1.41421356f / 0.21665f;
+    wave.currentAmplitude = 4 * 1.41421356f / 0.0082622f;
+    wave.currentPhaseRad = 0.4510268f;
+    source.setWaveform(wave);
+    source.begin(ring);
+    source.generate(BLOCK_SAMPLES);
+    ring.popBatch(samples, BLOCK_SAMPLES);
+
+    for (size_t k = 0; k < BLOCK_SAMPLES; k++) {
+        voltage[k] = (int16_t)((samples[k].voltage - 2048) * 4);
+        current[k] = (int16_t)((samples[k].current - 2048) * 4);
+    }
+}
+
+// Best of RUNS runs of a minute's worth of samples, in ns per sample
+template <typename Body>
+static double bestNsPerSample(Body body) {
+    uint64_t best = UINT64_MAX;
+    for (int run = 0; run < RUNS; run++) {
+        BenchStopwatch watch;
+        watch.start();
+        for (size_t block = 0; block < BLOCKS_PER_MINUTE; block++) {
+            body();
+        }
+        uint64_t ns = watch.elapsedNs();
+        if (ns < best) best = ns;
+    }
+    return (double)best / (BLOCKS_PER_MINUTE * BLOCK_SAMPLES);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void bench_rms_kernel(void) {
+    double ns = bestNsPerSample([]() {
+        RmsKernel<int16_t, BLOCK_SAMPLES> kernel;
+        for (size_t k = 0; k < BLOCK_SAMPLES; k++) {
+            kernel.add(current[k]);
+        }
+        sink = kernel.sum();
+    });
+    benchReport("rms_kernel", ns, "ns/sample");
+    TEST_ASSERT_GREATER_THAN(0, sink);
+}
+
+void bench_power_kernel(void) {
+    double ns = bestNsPerSample([]() {
+        PowerKernel<int16_t, BLOCK_SAMPLES> kernel;
+        for (size_t k = 0; k < BLOCK_SAMPLES; k++) {
+            kernel.add(voltage[k], current[k]);
+        }
+        sink = kernel.sumProduct();
+    });
+    benchReport("power_kernel", ns, "ns/sample");
+    TEST_ASSERT_GREATER_THAN(0, sink);
+}
+
+void bench_meter_engine(void) {
+    static MeterEngine engine;
+    MeterConfig config;
+    config.sampleRateHz = SAMPLE_RATE_HZ;
+    config.voltsPerCount = 0.21665f;
+    config.ampsPerCount = 0.0082622f;
+    engine.configure(config);
+
+    double ns = bestNsPerSample([]() {
+        engine.process(samples, BLOCK_SAMPLES);
+    });
+    benchReport("meter_engine", ns, "ns/sample");
+
+    MeterReading reading = engine.takeReading();
+    TEST_ASSERT_FLOAT_WITHIN(5, 828, reading.realPower);
+}
+
+// One reading through MonitorApp, online, each request answered on the
+// next pass. The passes after publish give replay its turn.
+static const int PASSES_PER_CYCLE = 6;
+
+static void runCycle(BenchPlatform &platform, MonitorApp &app, ReadingQueue &queue,
+                     const MeterReading &reading) {
+    platform.advance(60000);
+    QueuedReading item;
+    item.reading = reading;
+    item.epoch = platform.epoch();
+    queue.push(item);
+    for (int pass = 0; pass < PASSES_PER_CYCLE; pass++) {
+        platform.deliver();
+        app.pass();
+    }
+}
+
+void bench_publish_pipeline(void) {
+    remove(LOG_PATH);
+    remove(CURSOR_PATH);
+    static TelemetryLog telemetryLog(LOG_PATH, CURSOR_PATH, 131072);
+    static ReadingQueue queue;
+    static BenchPlatform platform(START_EPOCH);
+    static MonitorApp app(platform, queue, telemetryLog);
+    TEST_ASSERT_TRUE(telemetryLog.open());
+    platform.attach(&app);
+    logClock = &platform;
+
+    app.restore(MonitorConfig());
+    app.begin();
+    for (int pass = 0; pass < 20; pass++) {
+        platform.deliver();
+        app.pass();
+    }
+
+    // A minute of a 920 W load
+    MeterReading reading;
+    reading.voltageRms = 230;
+    reading.currentRms = 4;
+    reading.realPower = 828;
+    reading.apparentPower = 920;
+    reading.powerFactor = 0.9f;
+    reading.energyMws = 828ULL * 60 * 1000;
+    reading.energyKwh = mwsToKwh(reading.energyMws);
+    reading.durationSec = 60;
+    reading.samples = 60000;
+
+    // The first hour warms up (credit check, stream, first hour close)
+    for (int minute = 0; minute < 60; minute++) {
+        runCycle(platform, app, queue, reading);
+    }
+
+    const int HOURS = 3;
+    uint64_t publishNs = 0, closeNs = 0;
+    uint32_t publishCycles = 0, closes = 0;
+    uint32_t publishAllocs = 0, closeAllocs = 0;
+    uint64_t bytesBefore = platform.payloadBytes();
+    uint32_t updatesBefore = platform.updatesSent();
+    uint32_t nvsBefore = platform.nvsWrites();
+
+    for (int minute = 0; minute < HOURS * 60; minute++) {
+        uint32_t hourBefore = app.hourly().start;
+        AllocStats allocsBefore = allocStats();
+        BenchStopwatch watch;
+        watch.start();
+        runCycle(platform, app, queue, reading);
+        uint64_t ns = watch.elapsedNs();
+        uint32_t allocs = allocStats().count - allocsBefore.count;
+
+        if (app.hourly().start != hourBefore) {
+            closeNs += ns;
+            closeAllocs += allocs;
+            closes++;
+        } else {
+            publishNs += ns;
+            publishAllocs += allocs;
+            publishCycles++;
+        }
+    }
+    TEST_ASSERT_EQUAL(HOURS, closes);
+    TEST_ASSERT_TRUE(queue.empty());
+
+    benchReport("publish_cycle", publishNs / 1000.0 / publishCycles, "us/cycle");
+    benchReport("publish_cycle_allocs", (double)publishAllocs / publishCycles, "allocs/cycle");
+    benchReport("hour_close", closeNs / 1000.0 / closes, "us/cycle");
+    benchReport("hour_close_allocs", (double)closeAllocs / closes, "allocs/cycle");
+    benchReport("payload_per_hour", (double)(platform.payloadBytes() - bytesBefore) / HOURS, "bytes/hour");
+    benchReport("updates_per_hour", (double)(platform.updatesSent() - updatesBefore) / HOURS, "updates/hour");
+    benchReport("nvs_writes_per_hour", (double)(platform.nvsWrites() - nvsBefore) / HOURS, "writes/hour");
+}
+
+static int runBenchmarks() {
+    makeSamples();
+    UNITY_BEGIN();
+    RUN_TEST(bench_rms_kernel);
+    RUN_TEST(bench_power_kernel);
+    RUN_TEST(bench_meter_engine);
+    RUN_TEST(bench_publish_pipeline);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+void setup() {
+    delay(2000);   // let the test runner open the port
+    LittleFS.begin(true);
+    runBenchmarks();
+}
+
+void loop() {}
+#else
+int main(void) {
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    return runBenchmarks();
+}
+#endif
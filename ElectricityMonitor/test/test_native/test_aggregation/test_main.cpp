@@ -0,0 +1,164 @@
+#include <unity.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+#include <EnergyAggregator.h>
+#include <TelemetryRecord.h>
+
+const uint32_t DAY0 = 1762214400;   // 2025-11-04 00:00:00 UTC
+
+struct Closed {
+    AggregateLevel level;
+    AggregateBucket bucket;
+};
+
+class Recorder : public AggregateListener {
+public:
+    void bucketClosed(AggregateLevel level, const AggregateBucket &bucket) override {
+        Closed c = { level, bucket };
+        closed.push_back(c);
+    }
+
+    std::vector<AggregateBucket> at(AggregateLevel level) const {
+        std::vector<AggregateBucket> out;
+        for (size_t k = 0; k < closed.size(); k++) {
+            if (closed[k].level == level) out.push_back(closed[k].bucket);
+        }
+        return out;
+    }
+
+    std::vector<Closed> closed;
+};
+
+Recorder recorder;
+EnergyAggregator aggregator(&recorder);
+
+static MeterReading reading(float watts, float seconds) {
+    MeterReading r;
+    r.voltageRms = 230;
+    r.currentRms = watts / 230;
+    r.realPower = watts;
+    r.apparentPower = watts;
+    r.durationSec = seconds;
+    r.energyMws = (uint64_t)(watts * seconds * 1000);
+    r.samples = (uint32_t)(seconds * 1000);
+    return r;
+}
+
+// A reading a minute, closing at each of [from, to]
+static void minutes(uint32_t from, uint32_t to, float watts) {
+    for (uint32_t t = from; t <= to; t += 60) {
+        aggregator.add(t, reading(watts, 60), 0);
+    }
+}
+
+void setUp(void) {
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    recorder.closed.clear();
+    aggregator.reset();
+}
+
+void tearDown(void) {}
+
+// The reading that closes at 01:00:00 is hour 0's; the next one closes it
+void test_reading_is_filed_by_its_midpoint(void) {
+    minutes(DAY0 + 60, DAY0 + 3600, 100);
+    TEST_ASSERT_TRUE(recorder.at(AGG_HOUR).empty());
+    TEST_ASSERT_EQUAL_UINT32(DAY0, aggregator.current(AGG_HOUR).start);
+    TEST_ASSERT_EQUAL(60, aggregator.current(AGG_HOUR).samples);
+
+    minutes(DAY0 + 3660, DAY0 + 3660, 100);
+    std::vector<AggregateBucket> hours = recorder.at(AGG_HOUR);
+    TEST_ASSERT_EQUAL(1, hours.size());
+    TEST_ASSERT_EQUAL_UINT32(DAY0, hours[0].start);
+    TEST_ASSERT_EQUAL_UINT32(DAY0 + 3600, hours[0].end);
+    TEST_ASSERT_EQUAL(60, hours[0].samples);
+    TEST_ASSERT_EQUAL_UINT64(60ULL * 6000000, hours[0].energyMws);
+    TEST_ASSERT_EQUAL(1, aggregator.current(AGG_HOUR).samples);
+
+    // Buckets close finest first
+    TEST_ASSERT_EQUAL(AGG_MINUTE, recorder.closed[recorder.closed.size() - 3].level);
+    TEST_ASSERT_EQUAL(AGG_QUARTER, recorder.closed[recorder.closed.size() - 2].level);
+    TEST_ASSERT_EQUAL(AGG_HOUR, recorder.closed.back().level);
+}
+
+// Closer readings around a step: the averages weigh each by its length
+void test_quarter_weights_closer_readings(void) {
+    aggregator.add(DAY0 + 60, reading(100, 60), 0);
+    aggregator.add(DAY0 + 70, reading(2100, 10), MINUTE_RELAY_ON);
+    aggregator.add(DAY0 + 80, reading(2100, 10), 0);
+    aggregator.add(DAY0 + 900 + 60, reading(100, 60), 0);
+
+    std::vector<AggregateBucket> quarters = recorder.at(AGG_QUARTER);
+    TEST_ASSERT_EQUAL(1, quarters.size());
+    TEST_ASSERT_EQUAL(3, quarters[0].samples);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, (100 * 60 + 2100 * 20) / 80.0f, quarters[0].avgPower());
+    TEST_ASSERT_EQUAL_FLOAT(2100, quarters[0].peakPower);
+    TEST_ASSERT_EQUAL(MINUTE_RELAY_ON, quarters[0].flags);
+
+    // Minute 0, minute 1 and the 13 empty ones after it
+    TEST_ASSERT_EQUAL(15, recorder.at(AGG_MINUTE).size());
+    TEST_ASSERT_EQUAL(2, recorder.at(AGG_MINUTE)[1].samples);
+}
+
+// Readings from before the clock was set go into the first bucket after
+void test_unclocked_readings_join_the_first_bucket(void) {
+    aggregator.add(0, reading(100, 60), 0);
+    aggregator.add(0, reading(100, 60), 0);
+    TEST_ASSERT_EQUAL_UINT32(0, aggregator.current(AGG_HOUR).start);
+
+    aggregator.add(DAY0 + 7200 + 120, reading(100, 60), 0);
+    TEST_ASSERT_EQUAL_UINT32(DAY0 + 7200, aggregator.current(AGG_HOUR).start);
+    TEST_ASSERT_EQUAL(3, aggregator.current(AGG_HOUR).samples);
+    TEST_ASSERT_EQUAL(3, aggregator.current(AGG_MINUTE).samples);
+    TEST_ASSERT_TRUE(recorder.closed.empty());
+}
+
+// A clock that jumps a month closes what was open, but fills nothing
+void test_clock_jump_is_not_filled(void) {
+    minutes(DAY0 + 60, DAY0 + 60, 100);
+    minutes(DAY0 + 30 * 86400 + 60, DAY0 + 30 * 86400 + 60, 100);
+    TEST_ASSERT_EQUAL(AGG_LEVELS, recorder.closed.size());
+    TEST_ASSERT_EQUAL_UINT32(DAY0 + 30 * 86400, aggregator.current(AGG_DAY).start);
+}
+
+// Two days without a reading: every minute between closes, and nothing more
+void test_two_day_gap_is_bounded(void) {
+    minutes(DAY0 + 60, DAY0 + 60, 100);
+    minutes(DAY0 + 2 * 86400 + 60, DAY0 + 2 * 86400 + 60, 100);
+    TEST_ASSERT_EQUAL(2 * 1440, recorder.at(AGG_MINUTE).size());
+    TEST_ASSERT_EQUAL(2 * 96, recorder.at(AGG_QUARTER).size());
+    TEST_ASSERT_EQUAL(2 * 24, recorder.at(AGG_HOUR).size());
+    TEST_ASSERT_EQUAL(2, recorder.at(AGG_DAY).size());
+    TEST_ASSERT_EQUAL(2 * (1440 + 96 + 24 + 1), recorder.closed.size());
+}
+
+// Local days, 25 hours long when the clocks go back
+void test_day_bounds_follow_dst(void) {
+    setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+    tzset();
+    const uint32_t oct26 = 1761429600;   // 2025-10-26 00:00 CEST
+    uint32_t start = 0;
+    uint32_t end = 0;
+    EnergyAggregator::bounds(AGG_DAY, oct26 + 12 * 3600, &start, &end);
+    TEST_ASSERT_EQUAL_UINT32(oct26, start);
+    TEST_ASSERT_EQUAL_UINT32(oct26 + 25 * 3600, end);
+
+    EnergyAggregator::bounds(AGG_HOUR, oct26 + 3600 + 1234, &start, &end);
+    TEST_ASSERT_EQUAL_UINT32(oct26 + 3600, start);
+    TEST_ASSERT_EQUAL_UINT32(oct26 + 7200, end);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_reading_is_filed_by_its_midpoint);
+    RUN_TEST(test_quarter_weights_closer_readings);
+    RUN_TEST(test_unclocked_readings_join_the_first_bucket);
+    RUN_TEST(test_clock_jump_is_not_filled);
+    RUN_TEST(test_two_day_gap_is_bounded);
+    RUN_TEST(test_day_bounds_follow_dst);
+
+    return UNITY_END();
+}
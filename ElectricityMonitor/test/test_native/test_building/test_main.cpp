@@ -0,0 +1,153 @@
+#include <unity.h>
+#include <math.h>
+#include <stdlib.h>
+#include <time.h>
+#include <BuildingSim.h>
+
+static void giveCredit(BuildingSim &sim, uint8_t channel, double kwh) {
+    sim.rtdb().set(sim.unitPath(channel) + "remaining_units", kwh);
+    sim.rtdb().set(sim.unitPath(channel) + "remaining_credit", kwh * sim.config().monitor.costPerKwh);
+}
+
+static double serverUnits(BuildingSim &sim, uint8_t channel) {
+    return sim.rtdb().number(sim.unitPath(channel) + "remaining_units");
+}
+
+static std::vector<LoadStep> steady(float amps, float powerFactor) {
+    LoadStep step = { 0, amps, powerFactor };
+    return std::vector<LoadStep>(1, step);
+}
+
+void setUp(void) {
+    setenv("TZ", "UTC0", 1);
+    tzset();
+}
+
+void tearDown(void) {}
+
+// Three units, one board: each unit's history and billing is its own, and
+// a reading cycle goes up as one update for the building
+void test_units_share_one_update_per_cycle(void) {
+    BuildingSim sim;
+    sim.setLoad(0, steady(4.0f, 0.9f));
+    sim.setLoad(1, steady(0.35f, 0.95f));
+    sim.setLoad(2, steady(8.4f, 1.0f));
+    for (uint8_t c = 0; c < 3; c++) {
+        giveCredit(sim, c, 100);
+    }
+    sim.start();
+
+    sim.run(3600);
+    sim.platform().setLinkUp(false);    // a warning for the event log
+    sim.run(120);
+    sim.platform().setLinkUp(true);
+    // Hour 1 closes with the first reading past 02:00
+    sim.run(3600 - 30);
+    for (uint8_t c = 0; c < 3; c++) {
+        const std::string hour = sim.unitPath(c) + "history/hourly/2025-11-04/0/";
+        TEST_ASSERT_TRUE(sim.rtdb().has(hour + "energy"));
+        // 60 a minute apart, the one closing at 01:00 included, and three
+        // closer ones as the relays close at boot
+        TEST_ASSERT_EQUAL(63, (int)sim.rtdb().number(hour + "samples"));
+        TEST_ASSERT_TRUE(sim.rtdb().has(sim.unitPath(c) + "diagnostics/health/2025-11-04/1/passUs"));
+
+        double ledgerKwh = CreditLedger::toKwh(sim.app(c).ledger().balanceMws());
+        double unbilledKwh = CreditLedger::toKwh(sim.app(c).ledger().unbilledMws());
+        TEST_ASSERT_FLOAT_WITHIN(0.001, ledgerKwh + unbilledKwh, serverUnits(sim, c));
+        TEST_ASSERT_FLOAT_WITHIN(sim.trueEnergyKwh(c) * 0.01, 100 - sim.trueEnergyKwh(c), ledgerKwh);
+    }
+    // 2 kW vs 80 W: nothing leaks between channels
+    TEST_ASSERT_TRUE(sim.trueEnergyKwh(2) > 20 * sim.trueEnergyKwh(1));
+
+    // Every unit's cycle update in the same building update
+    TEST_ASSERT_TRUE(sim.hub().tenantUpdatesMerged() > 2 * sim.hub().updatesSent());
+    TEST_ASSERT_EQUAL(sim.hub().updatesSent(), sim.platform().updatesSent());
+
+    // The board's event log goes up once, under channel 0
+    TEST_ASSERT_TRUE(sim.rtdb().countUnder(sim.unitPath(0) + "diagnostics/log/") > 0);
+    TEST_ASSERT_EQUAL(0, sim.rtdb().countUnder(sim.unitPath(1) + "diagnostics/log/"));
+}
+
+// Credit is polled per unit and reaches that unit's relay only
+void test_credit_and_relays_are_per_unit(void) {
+    BuildingSim sim;
+    for (uint8_t c = 0; c < 3; c++) {
+        sim.setLoad(c, steady(8.0f, 1.0f));   // 1.84 kW
+    }
+    giveCredit(sim, 0, 100);
+    giveCredit(sim, 1, 0.5);
+    giveCredit(sim, 2, 100);
+    sim.start();
+
+    sim.run(30 * 60);
+    TEST_ASSERT_TRUE(sim.platform().relay(0));
+    TEST_ASSERT_FALSE(sim.platform().relay(1));
+    TEST_ASSERT_TRUE(sim.platform().relay(2));
+    TEST_ASSERT_FLOAT_WITHIN(0.035, 0.5, sim.trueEnergyKwh(1));
+
+    // No stream with several units: the top-up arrives with the next poll
+    sim.platform().topUp(sim.unitPath(1), 2.0, sim.config().monitor.costPerKwh);
+    sim.run(65);
+    TEST_ASSERT_TRUE(sim.platform().relay(1));
+    double unbilledKwh = CreditLedger::toKwh(sim.app(1).ledger().unbilledMws());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, serverUnits(sim, 1),
+                             CreditLedger::toKwh(sim.app(1).ledger().balanceMws()) + unbilledKwh);
+}
+
+// Each unit's ledger comes back from its own NVS keys
+void test_reboot_restores_each_unit(void) {
+    BuildingSim sim;
+    sim.setLoad(0, steady(1.0f, 1.0f));
+    sim.setLoad(1, steady(3.0f, 1.0f));
+    sim.setLoad(2, steady(6.0f, 1.0f));
+    for (uint8_t c = 0; c < 3; c++) {
+        giveCredit(sim, c, 50);
+    }
+    sim.start();
+    sim.run(3600 + 90);
+
+    double before[3];
+    for (uint8_t c = 0; c < 3; c++) {
+        before[c] = CreditLedger::toKwh(sim.app(c).ledger().balanceMws());
+    }
+    TEST_ASSERT_TRUE(before[0] > before[1] && before[1] > before[2]);
+
+    sim.reboot();
+    for (uint8_t c = 0; c < 3; c++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, before[c], CreditLedger::toKwh(sim.app(c).ledger().balanceMws()));
+        TEST_ASSERT_GREATER_THAN(0, sim.app(c).dailyTotals().energyKwh());
+    }
+}
+
+// Firebase refusing every update: each building update's failure counts
+// against every unit it carried, but the board is restarted only as often
+// as a single unit's errors call for
+void test_failed_building_updates_restart_once(void) {
+    BuildingSim sim;
+    for (uint8_t c = 0; c < 3; c++) {
+        sim.setLoad(c, steady(1.0f, 1.0f));
+        giveCredit(sim, c, 50);
+    }
+    sim.start();
+    sim.run(600);
+
+    uint32_t restarts = sim.platform().firebaseRestarts();
+    sim.platform().failUpdates(100000);
+    sim.run(1800);
+    for (uint8_t c = 1; c < 3; c++) {
+        TEST_ASSERT_GREATER_OR_EQUAL(sim.config().monitor.maxFirebaseErrors, sim.app(c).health().firebaseErrors);
+    }
+    uint32_t errors = sim.app(0).health().firebaseErrors;
+    TEST_ASSERT_EQUAL(errors / sim.config().monitor.maxFirebaseErrors, sim.platform().firebaseRestarts() - restarts);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_units_share_one_update_per_cycle);
+    RUN_TEST(test_credit_and_relays_are_per_unit);
+    RUN_TEST(test_reboot_restores_each_unit);
+    RUN_TEST(test_failed_building_updates_restart_once);
+
+    return UNITY_END();
+}
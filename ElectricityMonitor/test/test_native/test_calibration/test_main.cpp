@@ -0,0 +1,171 @@
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include <CalibrationProfile.h>
+#include <FakeSampleSource.h>
+#include <MeterEngine.h>
+
+// The firmware's nominal scale: volts at the ADC pin, amps at 66 mV/A
+const float VOLTS_PER_COUNT = 3.3f / 4095;
+const float AMPS_PER_COUNT = 3.3f / 4095 / 0.066f;
+
+RawSampleRing ring;
+FakeSampleSource source(1000);
+MeterEngine engine;
+
+static CalibrationTable twoRanges() {
+    CalibrationTable table;
+    table.add(5.0f, 0.70f);
+    table.add(0.5f, 0.60f);   // out of order on purpose
+    return table;
+}
+
+void setUp(void) {
+    while (!ring.empty()) {
+        RawSample discard;
+        ring.pop(discard);
+    }
+    source.begin(ring);
+    MeterConfig config;
+    config.sampleRateHz = source.sampleRateHz();
+    config.voltsPerCount = VOLTS_PER_COUNT;
+    config.ampsPerCount = AMPS_PER_COUNT;
+    engine.configure(config);
+}
+
+void tearDown(void) {
+    source.end();
+}
+
+void test_empty_table_leaves_the_channel_alone(void) {
+    CalibrationTable table;
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, table.scale(3.0f));
+}
+
+void test_gain_is_interpolated_and_held_past_the_ends(void) {
+    CalibrationTable table = twoRanges();
+    TEST_ASSERT_EQUAL(2, table.count);
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, table.points[0].input);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.60f, table.scale(0.1f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.60f, table.scale(0.5f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.65f, table.scale(2.75f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.70f, table.scale(5.0f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.70f, table.scale(30.0f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.60f, table.scale(0.0f));
+}
+
+void test_offset_takes_out_the_noise_floor(void) {
+    CalibrationTable table;
+    table.add(0, 1.0f, -0.05f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.95f, table.scale(1.0f));
+    // Never below zero: an idle channel reads nothing, not a negative current
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, table.scale(0.02f));
+}
+
+void test_bad_points_are_refused(void) {
+    CalibrationTable table = twoRanges();
+    TEST_ASSERT_FALSE(table.add(0.5f, 0.9f));        // same input twice
+    TEST_ASSERT_FALSE(table.add(1.0f, 0.0f));        // no gain
+    TEST_ASSERT_FALSE(table.add(-1.0f, 0.7f));
+    TEST_ASSERT_FALSE(table.add(1.0f, (float)NAN));
+    for (int k = 0; table.count < CalibrationTable::MAX_POINTS; k++) {
+        TEST_ASSERT_TRUE(table.add(10.0f + k, 0.7f));
+    }
+    TEST_ASSERT_FALSE(table.add(100.0f, 0.7f));
+}
+
+void test_profile_text_round_trips(void) {
+    CalibrationProfile profile;
+    TEST_ASSERT_TRUE(parseCalibrationProfile(" v 0.8554 268.85; i 0.12 0.6767 0 ;I 0.95 0.7012 -0.02", profile));
+    TEST_ASSERT_EQUAL(1, profile.voltage.count);
+    TEST_ASSERT_EQUAL(2, profile.current.count);
+    TEST_ASSERT_EQUAL_FLOAT(268.85f, profile.voltage.points[0].gain);
+    TEST_ASSERT_EQUAL_FLOAT(-0.02f, profile.current.points[1].offset);
+
+    char text[CALIBRATION_TEXT_CHARS];
+    TEST_ASSERT_TRUE(formatCalibrationProfile(profile, text, sizeof(text)) > 0);
+    TEST_ASSERT_EQUAL_STRING("v 0.8554 268.85 0; i 0.12 0.6767 0; i 0.95 0.7012 -0.02", text);
+
+    CalibrationProfile again;
+    TEST_ASSERT_TRUE(parseCalibrationProfile(text, again));
+    TEST_ASSERT_TRUE(again == profile);
+
+    // Full tables still fit the buffer
+    CalibrationProfile full;
+    for (int k = 0; k < CalibrationTable::MAX_POINTS; k++) {
+        full.voltage.add(1234.567f + k, 268.84711f, -0.0012345f);
+        full.current.add(1234.567f + k, 0.67671234f, -0.0012345f);
+    }
+    TEST_ASSERT_TRUE(formatCalibrationProfile(full, text, sizeof(text)) > 0);
+}
+
+void test_malformed_text_is_rejected(void) {
+    CalibrationProfile profile = CalibrationProfile::flat(268.8471f, 0.6767f);
+    CalibrationProfile before = profile;
+    TEST_ASSERT_FALSE(parseCalibrationProfile("", profile));
+    TEST_ASSERT_FALSE(parseCalibrationProfile("x 1 2", profile));
+    TEST_ASSERT_FALSE(parseCalibrationProfile("i 0.5", profile));
+    TEST_ASSERT_FALSE(parseCalibrationProfile("i 0.5 0.6 0 7", profile));
+    TEST_ASSERT_FALSE(parseCalibrationProfile("i 0.5 0.6; i 0.5 0.7", profile));
+    TEST_ASSERT_TRUE(profile == before);
+}
+
+static void runLoad(float uncalibratedAmps, float seconds) {
+    const float root2 = 1.41421356f;
+    FakeWaveform wave;
+    wave.voltageAmplitude = (230.0f / 268.8471f) * root2 / VOLTS_PER_COUNT;
+    wave.currentAmplitude = uncalibratedAmps * root2 / AMPS_PER_COUNT;
+    source.setWaveform(wave);
+    size_t total = (size_t)(seconds * source.sampleRateHz());
+    while (total > 0) {
+        size_t chunk = total < 100 ? total : 100;
+        source.generate(chunk);
+        engine.drain(ring);
+        total -= chunk;
+    }
+}
+
+// Half a minute of standby, half a minute of a heater: each half gets its
+// own range's gain, not one gain for the minute's RMS
+void test_engine_calibrates_each_window_by_its_range(void) {
+    CalibrationProfile profile;
+    profile.voltage.add(0, 268.8471f);
+    profile.current = twoRanges();
+    engine.setCalibration(profile);
+
+    runLoad(0.4f, 30);
+    runLoad(8.0f, 30);
+    MeterReading reading = engine.takeReading();
+
+    float low = 0.4f * 0.60f;
+    float high = 8.0f * 0.70f;
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 230.0f, reading.voltageRms);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, sqrtf((low * low + high * high) / 2), reading.currentRms);
+    double expectedKwh = 230.0 * (low + high) * 30 / 3.6e6;
+    TEST_ASSERT_FLOAT_WITHIN(expectedKwh * 0.005, expectedKwh, reading.energyKwh);
+}
+
+void test_mailbox_hands_over_the_newest_profile(void) {
+    CalibrationMailbox mailbox;
+    TEST_ASSERT_FALSE(takeCalibration(engine, mailbox));
+
+    mailbox.push(CalibrationProfile::flat(1.0f, 1.0f));
+    mailbox.push(CalibrationProfile::flat(268.8471f, 0.6767f));
+    TEST_ASSERT_TRUE(takeCalibration(engine, mailbox));
+    TEST_ASSERT_EQUAL_FLOAT(0.6767f, engine.calibrationProfile().current.points[0].gain);
+    TEST_ASSERT_TRUE(mailbox.empty());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_table_leaves_the_channel_alone);
+    RUN_TEST(test_gain_is_interpolated_and_held_past_the_ends);
+    RUN_TEST(test_offset_takes_out_the_noise_floor);
+    RUN_TEST(test_bad_points_are_refused);
+    RUN_TEST(test_profile_text_round_trips);
+    RUN_TEST(test_malformed_text_is_rejected);
+    RUN_TEST(test_engine_calibrates_each_window_by_its_range);
+    RUN_TEST(test_mailbox_hands_over_the_newest_profile);
+    return UNITY_END();
+}
@@ -0,0 +1,111 @@
+#include <unity.h>
+#include <CreditLedger.h>
+
+CreditLedger ledger;
+
+void setUp(void) {
+    ledger.restore(LedgerState());
+}
+
+void tearDown(void) {}
+
+void test_first_sync_takes_server_balance(void) {
+    TEST_ASSERT_FALSE(ledger.hasCredit());
+    TEST_ASSERT_EQUAL_INT64(18000000000LL, ledger.reconcile(CreditLedger::toMws(5.0)));
+    TEST_ASSERT_EQUAL_INT64(18000000000LL, ledger.balanceMws());
+    TEST_ASSERT_TRUE(ledger.hasCredit());
+}
+
+void test_consumption_runs_balance_to_zero_offline(void) {
+    ledger.reconcile(1000);
+    ledger.consume(600);
+    TEST_ASSERT_TRUE(ledger.hasCredit());
+    ledger.consume(400);
+    TEST_ASSERT_FALSE(ledger.hasCredit());
+
+    // Overshoot within the last interval is carried as debt
+    ledger.consume(50);
+    TEST_ASSERT_EQUAL_INT64(-50, ledger.balanceMws());
+    TEST_ASSERT_EQUAL_UINT64(1050, ledger.unbilledMws());
+}
+
+void test_own_deduction_is_not_a_top_up(void) {
+    ledger.reconcile(10000);
+    ledger.consume(300);
+    ledger.billed(ledger.unbilledMws());
+
+    // The server now shows 10000 - 300
+    TEST_ASSERT_EQUAL_INT64(0, ledger.reconcile(9700));
+    TEST_ASSERT_EQUAL_INT64(9700, ledger.balanceMws());
+    TEST_ASSERT_EQUAL_UINT64(0, ledger.unbilledMws());
+}
+
+void test_top_up_found_by_delta(void) {
+    ledger.reconcile(10000);
+    ledger.consume(300);
+    ledger.billed(300);
+    ledger.consume(200);   // not billed yet
+
+    // Dashboard adds 5000 on top of the billed 9700
+    TEST_ASSERT_EQUAL_INT64(5000, ledger.reconcile(14700));
+    TEST_ASSERT_EQUAL_INT64(14500, ledger.balanceMws());
+    TEST_ASSERT_EQUAL_UINT64(200, ledger.unbilledMws());
+}
+
+void test_stale_value_heals_on_next_sync(void) {
+    ledger.reconcile(10000);
+    ledger.consume(300);
+    ledger.billed(300);
+
+    // A value from before the deduction landed arrives late...
+    TEST_ASSERT_EQUAL_INT64(300, ledger.reconcile(10000));
+    // ...and the next one puts the credit back where it belongs
+    TEST_ASSERT_EQUAL_INT64(-300, ledger.reconcile(9700));
+    TEST_ASSERT_EQUAL_INT64(9700, ledger.balanceMws());
+}
+
+void test_billing_never_passes_consumption(void) {
+    ledger.consume(100);
+    ledger.billed(500);
+    TEST_ASSERT_EQUAL_UINT64(100, ledger.state().billedMws);
+    TEST_ASSERT_EQUAL_UINT64(0, ledger.unbilledMws());
+
+    LedgerState corrupt;
+    corrupt.consumedMws = 10;
+    corrupt.billedMws = 20;
+    ledger.restore(corrupt);
+    TEST_ASSERT_EQUAL_UINT64(10, ledger.state().billedMws);
+}
+
+void test_state_survives_restore(void) {
+    ledger.reconcile(8000);
+    ledger.consume(1234);
+    ledger.billed(1000);
+    LedgerState saved = ledger.state();
+
+    CreditLedger rebooted;
+    rebooted.restore(saved);
+    TEST_ASSERT_EQUAL_INT64(ledger.balanceMws(), rebooted.balanceMws());
+    TEST_ASSERT_EQUAL_UINT64(234, rebooted.unbilledMws());
+}
+
+void test_kwh_conversion(void) {
+    TEST_ASSERT_EQUAL_INT64(5400000000LL, CreditLedger::toMws(1.5));
+    TEST_ASSERT_EQUAL_INT64(-3600, CreditLedger::toMws(-0.000001));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.25, CreditLedger::toKwh(900000000LL));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_first_sync_takes_server_balance);
+    RUN_TEST(test_consumption_runs_balance_to_zero_offline);
+    RUN_TEST(test_own_deduction_is_not_a_top_up);
+    RUN_TEST(test_top_up_found_by_delta);
+    RUN_TEST(test_stale_value_heals_on_next_sync);
+    RUN_TEST(test_billing_never_passes_consumption);
+    RUN_TEST(test_state_survives_restore);
+    RUN_TEST(test_kwh_conversion);
+
+    return UNITY_END();
+}
@@ -0,0 +1,117 @@
+#include <unity.h>
+#include <math.h>
+#include <EnergyCounter.h>
+#include <EnergyRollup.h>
+
+const uint32_t SECONDS_PER_MONTH = 30UL * 24 * 3600;
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_conversions(void) {
+    TEST_ASSERT_EQUAL_INT64(3600000000LL, kwhToMws(1.0));
+    TEST_ASSERT_EQUAL_INT64(0, kwhToMws(NAN));
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 0.5, mwsToKwh(1800000000LL));
+    TEST_ASSERT_EQUAL_UINT32(1, mwsToUwh(4));       // 3.6 mWs = 1 uWh, rounded
+    TEST_ASSERT_EQUAL_UINT32(1000, mwsToMwh(3600000));
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFFu, mwsToMwh(0xFFFFFFFFFFFFFFFFull / 2));
+}
+
+void test_quantizer_carries_fractions(void) {
+    EnergyQuantizer q;
+    TEST_ASSERT_EQUAL_UINT64(0, q.take(0.4));
+    TEST_ASSERT_EQUAL_UINT64(0, q.take(0.4));
+    TEST_ASSERT_EQUAL_UINT64(1, q.take(0.4));   // 1.2, 0.2 carried
+    TEST_ASSERT_EQUAL_UINT64(2, q.take(1.8));
+    TEST_ASSERT_EQUAL_UINT64(0, q.take(-5.0));
+    TEST_ASSERT_EQUAL_UINT64(0, q.take(NAN));
+}
+
+// A phone charger integrated one second at a time for a month, the way the
+// hourly buffer and the ledger add readings up
+void test_month_of_seconds_loses_nothing(void) {
+    const double watts = 2.3456789;
+    EnergyQuantizer q;
+    uint64_t hourMws = 0;
+    uint64_t monthMws = 0;
+    uint64_t hoursTotalMws = 0;
+    float floatKwh = 0;
+
+    for (uint32_t s = 1; s <= SECONDS_PER_MONTH; s++) {
+        uint64_t mws = q.take(watts * 1000.0);
+        hourMws += mws;
+        monthMws += mws;
+        floatKwh += (float)(watts / 3600000.0);
+        if (s % 3600 == 0) {
+            hoursTotalMws += hourMws;
+            hourMws = 0;
+        }
+    }
+
+    double exactMws = watts * 1000.0 * SECONDS_PER_MONTH;
+    TEST_ASSERT_TRUE(fabs((double)monthMws - exactMws) < 1.0);
+    TEST_ASSERT_EQUAL_UINT64(monthMws, hoursTotalMws);
+
+    // What the old float total would have reported
+    double exactKwh = exactMws / MWS_PER_KWH;
+    TEST_ASSERT_TRUE(fabs(mwsToKwh(monthMws) - exactKwh) < 1e-9);
+    TEST_ASSERT_TRUE(fabs(floatKwh - exactKwh) > exactKwh * 0.01);
+}
+
+void test_rollup_accumulates_hours(void) {
+    EnergyRollup day;
+    TEST_ASSERT_TRUE(day.add(20251104, 360000000, 3600, 2500, 1400, 60));   // 100 Wh
+    TEST_ASSERT_FALSE(day.add(20251104, 720000000, 3600, 1800, 1600, 60));
+
+    const RollupTotals &totals = day.current();
+    TEST_ASSERT_EQUAL_UINT32(20251104, totals.period);
+    TEST_ASSERT_EQUAL_UINT32(120, totals.samples);
+    TEST_ASSERT_EQUAL_UINT32(7200, totals.seconds);
+    TEST_ASSERT_EQUAL_UINT64(1080000000, totals.energyMws);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 0.3, totals.energyKwh());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 150.0, totals.avgPowerW());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 250.0, totals.peakPowerW());
+    // The busiest quarter of either hour, not of the reading peaks' hour
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 160.0, totals.peakDemandW());
+}
+
+// A quiet hour a reading a minute, a busy one every 10 s: each is an hour
+// of the day's average, whatever its reading count
+void test_rollup_average_is_time_weighted(void) {
+    EnergyRollup day;
+    day.add(20251104, 360000000, 3600, 1200, 1000, 60);        // 100 W
+    day.add(20251104, 3600000000ULL, 3600, 20000, 10000, 360); // 1 kW
+    TEST_ASSERT_EQUAL_UINT32(420, day.current().samples);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 550.0, day.current().avgPowerW());
+}
+
+void test_rollup_restarts_on_new_period(void) {
+    EnergyRollup month;
+    month.add(202510, 1000, 10, 10, 10, 60);
+
+    RollupTotals saved = month.current();
+    EnergyRollup rebooted;
+    rebooted.restore(saved);
+    TEST_ASSERT_FALSE(rebooted.add(202510, 500, 10, 40, 30, 60));
+    TEST_ASSERT_EQUAL_UINT64(1500, rebooted.current().energyMws);
+
+    TEST_ASSERT_TRUE(rebooted.add(202511, 200, 20, 20, 20, 30));
+    TEST_ASSERT_EQUAL_UINT32(202511, rebooted.current().period);
+    TEST_ASSERT_EQUAL_UINT64(200, rebooted.current().energyMws);
+    TEST_ASSERT_EQUAL_UINT32(30, rebooted.current().samples);
+    TEST_ASSERT_EQUAL_UINT32(20, rebooted.current().peakPowerDw);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_conversions);
+    RUN_TEST(test_quantizer_carries_fractions);
+    RUN_TEST(test_month_of_seconds_loses_nothing);
+    RUN_TEST(test_rollup_accumulates_hours);
+    RUN_TEST(test_rollup_average_is_time_weighted);
+    RUN_TEST(test_rollup_restarts_on_new_period);
+
+    return UNITY_END();
+}
@@ -0,0 +1,212 @@
+#include <unity.h>
+#include <math.h>
+#include <CreditLedger.h>
+#include <EnergyCounter.h>
+#include <FakeSampleSource.h>
+#include <MeterEngine.h>
+#include <MonitorApp.h>
+
+// The board's front end: ACS712 30A on a 3.3 V, 12-bit ADC
+const float ADC_VOLTAGE = 3.3;
+const int ADC_MAX = 4095;
+const float ACS712_SENSITIVITY = 0.066;
+const float VOLTAGE_FACTOR = 268.8471;
+const float CURRENT_FACTOR = 0.6767;
+
+RawSampleRing ring;
+FakeSampleSource source(1000);
+MeterEngine engine;
+
+static MeterConfig testConfig() {
+    MeterConfig config;
+    config.sampleRateHz = source.sampleRateHz();
+    config.adcCenter = 2048;
+    config.voltsPerCount = (ADC_VOLTAGE / ADC_MAX) * VOLTAGE_FACTOR;
+    config.ampsPerCount = (ADC_VOLTAGE / ADC_MAX) / ACS712_SENSITIVITY * CURRENT_FACTOR;
+    return config;
+}
+
+// Mains at 230 V with sensorAmps through the ACS712, before the current
+// factor: what the sensor sees, not what the meter reports
+static void setLoad(float sensorAmps, float volts = 230) {
+    FakeWaveform wave;
+    wave.voltageAmplitude = volts * 1.41421356f / testConfig().voltsPerCount;
+    wave.currentAmplitude = sensorAmps * 1.41421356f * ACS712_SENSITIVITY * ADC_MAX / ADC_VOLTAGE;
+    source.setWaveform(wave);
+}
+
+static MeterReading readFor(float seconds) {
+    size_t total = (size_t)(seconds * source.sampleRateHz());
+    while (total > 0) {
+        size_t chunk = total < 100 ? total : 100;
+        source.generate(chunk);
+        engine.drain(ring);
+        total -= chunk;
+    }
+    return engine.takeReading();
+}
+
+void setUp(void) {
+    RawSample discard;
+    while (ring.pop(discard)) {}
+    source.begin(ring);
+    engine.configure(testConfig());
+}
+
+void tearDown(void) {
+    source.end();
+}
+
+void test_zero_current_reading(void) {
+    setLoad(0);
+    MeterReading reading = readFor(2);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, reading.currentRms);
+    TEST_ASSERT_EQUAL_UINT64(0, reading.energyMws);
+}
+
+// 1 A at the sensor reads 1 A times the current factor
+void test_known_current_reading(void) {
+    setLoad(1.0f);
+    MeterReading reading = readFor(2);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, CURRENT_FACTOR, reading.currentRms);
+}
+
+void test_zero_voltage_reading(void) {
+    setLoad(0, 0);
+    MeterReading reading = readFor(2);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 0.0f, reading.voltageRms);
+}
+
+void test_energy_calculation_1_hour(void) {
+    // 100 W for an hour
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 0.1, mwsToKwh(100LL * 3600 * 1000));
+}
+
+// 60 W for a minute, measured
+void test_energy_calculation_1_minute(void) {
+    setLoad(60.0f / 230 / CURRENT_FACTOR);
+    MeterReading reading = readFor(60);
+    TEST_ASSERT_FLOAT_WITHIN(0.6f, 60.0f, reading.realPower);
+    TEST_ASSERT_FLOAT_WITHIN(0.00001, 0.001, reading.energyKwh);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, mwsToKwh(reading.energyMws), reading.energyKwh);
+}
+
+void test_cost_calculation(void) {
+    MonitorConfig config;
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 209.5, mwsToKwh(kwhToMws(1.0)) * config.costPerKwh);
+}
+
+// 10 A at the sensor: near the top of the ADC's swing, still linear
+void test_high_current_10A(void) {
+    setLoad(10.0f);
+    MeterReading reading = readFor(2);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 10 * CURRENT_FACTOR, reading.currentRms);
+}
+
+void test_power_calculation(void) {
+    setLoad(1.0f);
+    MeterReading reading = readFor(2);
+    TEST_ASSERT_TRUE(isfinite(reading.realPower));
+    TEST_ASSERT_TRUE(reading.realPower > 0);
+    TEST_ASSERT_FLOAT_WITHIN(reading.apparentPower * 0.01f, reading.voltageRms * reading.currentRms,
+                             reading.realPower);
+}
+
+// Ten one-minute readings of 100 W add up to 1000 W-minutes
+void test_cumulative_energy(void) {
+    setLoad(100.0f / 230 / CURRENT_FACTOR);
+    uint64_t totalMws = 0;
+    for (int i = 0; i < 10; i++) {
+        totalMws += readFor(60).energyMws;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.0002, 0.01667, mwsToKwh(totalMws));
+}
+
+// A tenth of a watt still counts: the sub-mWs remainder carries over
+void test_very_small_power(void) {
+    EnergyQuantizer quantizer;
+    uint64_t mws = 0;
+    for (int i = 0; i < 60; i++) {
+        mws += quantizer.take(0.1 * 0.02 * 1000);   // 0.1 W for 20 ms
+    }
+    // 0.1 W for 1.2 s
+    TEST_ASSERT_EQUAL_UINT64(120, mws);
+    TEST_ASSERT_TRUE(mwsToKwh(mws) < 0.001);
+}
+
+void test_very_large_power(void) {
+    // 5 kW for a minute
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 0.0833, mwsToKwh(5000LL * 60 * 1000));
+}
+
+void test_large_energy_cost(void) {
+    MonitorConfig config;
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 20950.0, mwsToKwh(kwhToMws(100.0)) * config.costPerKwh);
+}
+
+// The profile's current gain scales the reading
+void test_calibration_factor_applied(void) {
+    setLoad(1.0f);
+    engine.setCalibration(CalibrationProfile::flat(1.0f, 1.0f));
+    readFor(1);
+    float uncalibrated = readFor(2).currentRms;
+
+    engine.setCalibration(CalibrationProfile::flat(1.0f, 0.5f));
+    readFor(1);
+    float calibrated = readFor(2).currentRms;
+
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, uncalibrated * 0.5f, calibrated);
+}
+
+void test_rms_calculation_stability(void) {
+    setLoad(0.75f);
+    float reading1 = readFor(1).currentRms;
+    float reading2 = readFor(1).currentRms;
+    float reading3 = readFor(1).currentRms;
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, reading1, reading2);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, reading1, reading3);
+}
+
+void test_remaining_units_calculation(void) {
+    LedgerState state;
+    state.creditedMws = kwhToMws(10.0);
+    CreditLedger ledger;
+    ledger.restore(state);
+    ledger.consume(kwhToMws(0.5));
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 9.5, CreditLedger::toKwh(ledger.balanceMws()));
+    TEST_ASSERT_TRUE(ledger.hasCredit());
+}
+
+// Drawing past zero cuts the relay; the overdraw is owed, not forgotten
+void test_prevent_negative_units(void) {
+    LedgerState state;
+    state.creditedMws = kwhToMws(0.1);
+    CreditLedger ledger;
+    ledger.restore(state);
+    ledger.consume(kwhToMws(0.5));
+    TEST_ASSERT_FALSE(ledger.hasCredit());
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, -0.4, CreditLedger::toKwh(ledger.balanceMws()));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_zero_current_reading);
+    RUN_TEST(test_known_current_reading);
+    RUN_TEST(test_zero_voltage_reading);
+    RUN_TEST(test_energy_calculation_1_hour);
+    RUN_TEST(test_energy_calculation_1_minute);
+    RUN_TEST(test_cost_calculation);
+    RUN_TEST(test_high_current_10A);
+    RUN_TEST(test_power_calculation);
+    RUN_TEST(test_cumulative_energy);
+    RUN_TEST(test_very_small_power);
+    RUN_TEST(test_very_large_power);
+    RUN_TEST(test_large_energy_cost);
+    RUN_TEST(test_calibration_factor_applied);
+    RUN_TEST(test_rms_calculation_stability);
+    RUN_TEST(test_remaining_units_calculation);
+    RUN_TEST(test_prevent_negative_units);
+
+    return UNITY_END();
+}
@@ -0,0 +1,117 @@
+#include <unity.h>
+#include <string.h>
+
+// What a production build would compile in; DEBUG must vanish entirely
+#define EVENT_LOG_LEVEL EVENT_LOG_INFO
+#include <EventLog.h>
+
+EventLog eventLog;
+static uint32_t clockMs = 0;
+
+uint32_t eventLogClockMs() {
+    return clockMs;
+}
+
+static int evaluated = 0;
+
+static int sideEffect(void) {
+    return ++evaluated;
+}
+
+static char line[160];
+
+static const char *lastLine(void) {
+    EventLog::format(eventLog.at(eventLog.count() - 1), line, sizeof(line));
+    return line;
+}
+
+void setUp(void) {
+    eventLog.clear();
+    clockMs = 0;
+    evaluated = 0;
+}
+
+void tearDown(void) {}
+
+void test_formats_when_read_not_when_logged(void) {
+    clockMs = 12345;
+    LOG_INFO("Remaining units from %s: %.2f kWh", "stream", 4.5f);
+    TEST_ASSERT_EQUAL(1, eventLog.count());
+    TEST_ASSERT_EQUAL(2, eventLog.at(0).argc);
+    TEST_ASSERT_EQUAL_STRING("[   12.345] I Remaining units from stream: 4.50 kWh", lastLine());
+}
+
+void test_integer_conversions(void) {
+    LOG_WARN("Hour changed from %d to %d", 9, -1);
+    TEST_ASSERT_EQUAL_STRING("[    0.000] W Hour changed from 9 to -1", lastLine());
+
+    // Length modifiers are ignored: everything was packed as 32 bits
+    LOG_ERROR("%lu bytes, %02u:00, 0x%X, 100%%", (unsigned long)4000000000UL, 7u, 255u);
+    TEST_ASSERT_EQUAL_STRING("[    0.000] E 4000000000 bytes, 07:00, 0xFF, 100%", lastLine());
+}
+
+void test_missing_arguments_dont_crash(void) {
+    LOG_INFO("%s and %d", "one");
+    TEST_ASSERT_EQUAL_STRING("[    0.000] I one and 0", lastLine());
+}
+
+void test_output_is_truncated_to_the_buffer(void) {
+    LOG_INFO("A long message that goes on and on");
+    char small[20];
+    size_t length = EventLog::format(eventLog.at(0), small, sizeof(small));
+    TEST_ASSERT_EQUAL(19, length);
+    TEST_ASSERT_EQUAL_STRING("[    0.000] I A lon", small);
+}
+
+void test_ring_overwrites_oldest(void) {
+    for (uint32_t k = 0; k < EventLog::CAPACITY + 10; k++) {
+        LOG_INFO("entry %u", k);
+    }
+    TEST_ASSERT_EQUAL(EventLog::CAPACITY, eventLog.count());
+    TEST_ASSERT_EQUAL(EventLog::CAPACITY + 10, eventLog.total());
+
+    // Oldest kept is sequence total() - count()
+    EventLog::format(eventLog.at(0), line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("[    0.000] I entry 10", line);
+    TEST_ASSERT_EQUAL_STRING("[    0.000] I entry 73", lastLine());
+}
+
+void test_debug_compiles_to_nothing(void) {
+    LOG_DEBUG("never %d", sideEffect());
+    TEST_ASSERT_EQUAL(0, eventLog.count());
+    TEST_ASSERT_EQUAL(0, evaluated);
+
+    LOG_INFO("always %d", sideEffect());
+    TEST_ASSERT_EQUAL(1, eventLog.count());
+    TEST_ASSERT_EQUAL(1, evaluated);
+}
+
+static int echoed = 0;
+
+static void countEcho(const char *text) {
+    echoed++;
+    strncpy(line, text, sizeof(line) - 1);
+}
+
+void test_echo(void) {
+    eventLog.setEcho(countEcho);
+    LOG_WARN("Credit check timed out");
+    eventLog.setEcho(nullptr);
+    LOG_WARN("not echoed");
+    TEST_ASSERT_EQUAL(1, echoed);
+    TEST_ASSERT_EQUAL_STRING("[    0.000] W Credit check timed out", line);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_formats_when_read_not_when_logged);
+    RUN_TEST(test_integer_conversions);
+    RUN_TEST(test_missing_arguments_dont_crash);
+    RUN_TEST(test_output_is_truncated_to_the_buffer);
+    RUN_TEST(test_ring_overwrites_oldest);
+    RUN_TEST(test_debug_compiles_to_nothing);
+    RUN_TEST(test_echo);
+
+    return UNITY_END();
+}
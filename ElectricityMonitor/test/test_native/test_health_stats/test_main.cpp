@@ -0,0 +1,89 @@
+#include <unity.h>
+#include <HealthStats.h>
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_values_land_in_power_of_two_buckets(void) {
+    LatencyHistogram histogram;
+    histogram.add(0);
+    histogram.add(1);
+    histogram.add(2);
+    histogram.add(3);
+    histogram.add(1000);       // 512..1023
+    histogram.add(0xFFFFFFFFu); // past the last edge: the last bucket
+
+    TEST_ASSERT_EQUAL_UINT32(6, histogram.count());
+    TEST_ASSERT_EQUAL_UINT32(2, histogram.bucket(0));
+    TEST_ASSERT_EQUAL_UINT32(2, histogram.bucket(1));
+    TEST_ASSERT_EQUAL_UINT32(1, histogram.bucket(9));
+    TEST_ASSERT_EQUAL_UINT32(1, histogram.bucket(LatencyHistogram::BUCKETS - 1));
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFFu, histogram.max());
+}
+
+void test_percentiles_are_bucket_edges_capped_at_the_max(void) {
+    LatencyHistogram histogram;
+    // 90 fast passes of ~300 us, 9 at ~3 ms and one 40 ms stall
+    for (int k = 0; k < 90; k++) histogram.add(300);
+    for (int k = 0; k < 9; k++) histogram.add(3000);
+    histogram.add(40000);
+
+    TEST_ASSERT_EQUAL_UINT32(511, histogram.percentile(50));
+    TEST_ASSERT_EQUAL_UINT32(511, histogram.percentile(90));
+    TEST_ASSERT_EQUAL_UINT32(4095, histogram.percentile(99));
+    TEST_ASSERT_EQUAL_UINT32(40000, histogram.percentile(100));
+
+    // Never above what was actually seen
+    LatencyHistogram single;
+    single.add(600);
+    TEST_ASSERT_EQUAL_UINT32(600, single.percentile(50));
+
+    LatencySummary summary = histogram.summary();
+    TEST_ASSERT_EQUAL_UINT32(100, summary.count);
+    TEST_ASSERT_EQUAL_UINT32(511, summary.p50);
+    TEST_ASSERT_EQUAL_UINT32(4095, summary.p99);
+    TEST_ASSERT_EQUAL_UINT32(40000, summary.max);
+}
+
+void test_empty_histogram_reports_zero(void) {
+    LatencyHistogram histogram;
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.percentile(99));
+    histogram.add(5);
+    histogram.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.count());
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.max());
+}
+
+void test_round_trips_are_named_by_update_uid(void) {
+    TEST_ASSERT_EQUAL(RTT_CYCLE_UPDATE, roundTripKind("cycleUpdate"));
+    TEST_ASSERT_EQUAL(RTT_CYCLE_UPDATE, roundTripKind("stepUpdate"));
+    TEST_ASSERT_EQUAL(RTT_REPLAY_UPDATE, roundTripKind("replayUpdate"));
+    TEST_ASSERT_EQUAL(RTT_FORCE_HOURLY, roundTripKind("forceHourly"));
+    TEST_ASSERT_EQUAL(RTT_KINDS, roundTripKind("authTask"));
+    TEST_ASSERT_EQUAL_STRING("credit", roundTripName(RTT_CREDIT));
+}
+
+void test_reset_clears_every_stat(void) {
+    HealthStats stats;
+    stats.passUs.add(100);
+    stats.roundTripMs[RTT_CREDIT].add(250);
+    stats.firebaseErrors = 3;
+    stats.queueHighWater = 4;
+    stats.reset();
+
+    TEST_ASSERT_EQUAL_UINT32(0, stats.passUs.count());
+    TEST_ASSERT_EQUAL_UINT32(0, stats.roundTripMs[RTT_CREDIT].count());
+    TEST_ASSERT_EQUAL(0, stats.firebaseErrors);
+    TEST_ASSERT_EQUAL(0, stats.queueHighWater);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_values_land_in_power_of_two_buckets);
+    RUN_TEST(test_percentiles_are_bucket_edges_capped_at_the_max);
+    RUN_TEST(test_empty_histogram_reports_zero);
+    RUN_TEST(test_round_trips_are_named_by_update_uid);
+    RUN_TEST(test_reset_clears_every_stat);
+    return UNITY_END();
+}
@@ -0,0 +1,257 @@
+#include <unity.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <EnergyAggregator.h>
+#include <TelemetryPaths.h>
+
+// The hour buckets MonitorApp files history/hourly/ from, and the days
+class HourRecorder : public AggregateListener {
+public:
+    void bucketClosed(AggregateLevel level, const AggregateBucket &bucket) override {
+        if (level == AGG_HOUR) closed.push_back(bucket);
+        if (level == AGG_DAY) days.push_back(bucket);
+    }
+    std::vector<AggregateBucket> closed;
+    std::vector<AggregateBucket> days;
+};
+
+HourRecorder hours;
+EnergyAggregator aggregator(&hours);
+
+static uint32_t at(int year, int month, int day, int hour, int minute, int second) {
+    struct tm timeinfo;
+    memset(&timeinfo, 0, sizeof(timeinfo));
+    timeinfo.tm_year = year - 1900;
+    timeinfo.tm_mon = month - 1;
+    timeinfo.tm_mday = day;
+    timeinfo.tm_hour = hour;
+    timeinfo.tm_min = minute;
+    timeinfo.tm_sec = second;
+    timeinfo.tm_isdst = -1;
+    return (uint32_t)mktime(&timeinfo);
+}
+
+// A minute's reading closing at epoch
+static void accumulateReading(uint32_t epoch, float current, float power) {
+    MeterReading reading;
+    reading.voltageRms = current > 0 ? power / current : 230;
+    reading.currentRms = current;
+    reading.realPower = power;
+    reading.apparentPower = power;
+    reading.durationSec = 60;
+    reading.energyMws = (uint64_t)(power * 60 * 1000);
+    aggregator.add(epoch, reading, 0);
+}
+
+static const AggregateBucket &hourlyBuffer() {
+    return aggregator.current(AGG_HOUR);
+}
+
+static std::string timestamp(uint32_t epoch) {
+    char text[TIMESTAMP_CHARS];
+    formatTimestamp(epoch, text, sizeof(text));
+    return text;
+}
+
+void setUp(void) {
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    hours.closed.clear();
+    hours.days.clear();
+    aggregator.reset();
+}
+
+void tearDown(void) {}
+
+void test_initial_hour_tracking(void) {
+    accumulateReading(at(2025, 11, 4, 14, 30, 0), 1.0f, 230);
+    TEST_ASSERT_EQUAL_UINT32(at(2025, 11, 4, 14, 0, 0), hourlyBuffer().start);
+}
+
+void test_hour_change_detection(void) {
+    accumulateReading(at(2025, 11, 4, 10, 55, 0), 1.5f, 100);
+    TEST_ASSERT_EQUAL(1, hourlyBuffer().samples);
+    TEST_ASSERT_TRUE(hours.closed.empty());
+
+    accumulateReading(at(2025, 11, 4, 11, 5, 0), 1.5f, 100);
+    TEST_ASSERT_EQUAL(1, hours.closed.size());
+    TEST_ASSERT_EQUAL_UINT32(at(2025, 11, 4, 10, 0, 0), hours.closed[0].start);
+    TEST_ASSERT_EQUAL_UINT32(at(2025, 11, 4, 11, 0, 0), hourlyBuffer().start);
+}
+
+void test_data_accumulation_same_hour(void) {
+    accumulateReading(at(2025, 11, 4, 10, 1, 0), 1.0f, 230);
+    accumulateReading(at(2025, 11, 4, 10, 2, 0), 1.5f, 345);
+    accumulateReading(at(2025, 11, 4, 10, 3, 0), 0.8f, 184);
+
+    TEST_ASSERT_EQUAL(3, hourlyBuffer().samples);
+    TEST_ASSERT_EQUAL_UINT64((230 + 345 + 184) * 60 * 1000ULL, hourlyBuffer().energyMws);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 759.0f / 3, hourlyBuffer().avgPower());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 3.3f / 3, hourlyBuffer().avgCurrent());
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 345.0f, hourlyBuffer().peakPower);
+}
+
+void test_peak_power_tracking(void) {
+    accumulateReading(at(2025, 11, 4, 10, 1, 0), 1.0f, 100);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 100.0f, hourlyBuffer().peakPower);
+
+    accumulateReading(at(2025, 11, 4, 10, 2, 0), 2.0f, 500);   // new peak
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 500.0f, hourlyBuffer().peakPower);
+
+    accumulateReading(at(2025, 11, 4, 10, 3, 0), 0.5f, 50);    // lower than peak
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 500.0f, hourlyBuffer().peakPower);
+}
+
+void test_average_calculations(void) {
+    accumulateReading(at(2025, 11, 4, 10, 1, 0), 1.0f, 100);
+    accumulateReading(at(2025, 11, 4, 10, 2, 0), 2.0f, 200);
+    accumulateReading(at(2025, 11, 4, 10, 3, 0), 3.0f, 300);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 200.0f, hourlyBuffer().avgPower());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 2.0f, hourlyBuffer().avgCurrent());
+}
+
+// The hour closes with everything it had; the next starts from nothing
+void test_buffer_reset_on_hour_change(void) {
+    accumulateReading(at(2025, 11, 4, 10, 30, 0), 1.0f, 100);
+    accumulateReading(at(2025, 11, 4, 10, 31, 0), 1.0f, 100);
+    TEST_ASSERT_EQUAL(2, hourlyBuffer().samples);
+
+    accumulateReading(at(2025, 11, 4, 11, 1, 0), 1.0f, 100);
+    TEST_ASSERT_EQUAL(2, hours.closed[0].samples);
+    TEST_ASSERT_EQUAL(1, hourlyBuffer().samples);
+    TEST_ASSERT_EQUAL_UINT64(6000000, hourlyBuffer().energyMws);
+    TEST_ASSERT_EQUAL_UINT32(at(2025, 11, 4, 11, 0, 0), hourlyBuffer().start);
+}
+
+void test_date_formatting(void) {
+    TEST_ASSERT_EQUAL_STRING("2025-11-04 14:30:45", timestamp(at(2025, 11, 4, 14, 30, 45)).c_str());
+
+    char date[16];
+    formatDate(20251104, date, sizeof(date));
+    TEST_ASSERT_EQUAL_STRING("2025-11-04", date);
+}
+
+// Hour 23 is closed by a reading after midnight, and is still the 4th's.
+// So is the reading that closes at midnight, and the day closes with the
+// first one past it. Hour 22, without readings, closes too - empty.
+void test_midnight_transition(void) {
+    accumulateReading(at(2025, 11, 4, 21, 30, 0), 1.0f, 500);
+    accumulateReading(at(2025, 11, 4, 23, 55, 0), 1.0f, 100);
+    TEST_ASSERT_EQUAL_UINT32(at(2025, 11, 4, 23, 0, 0), hourlyBuffer().start);
+    TEST_ASSERT_EQUAL(2, hours.closed.size());
+    TEST_ASSERT_TRUE(hours.closed[1].empty());
+    TEST_ASSERT_EQUAL_STRING("2025-11-04 22:00:00", timestamp(hours.closed[1].start).c_str());
+
+    accumulateReading(at(2025, 11, 5, 0, 0, 0), 1.0f, 100);
+    TEST_ASSERT_EQUAL(2, hours.closed.size());
+    TEST_ASSERT_EQUAL(2, hourlyBuffer().samples);
+    TEST_ASSERT_TRUE(hours.days.empty());
+
+    accumulateReading(at(2025, 11, 5, 0, 5, 0), 1.0f, 100);
+    TEST_ASSERT_EQUAL(3, hours.closed.size());
+    TEST_ASSERT_EQUAL_STRING("2025-11-04 23:00:00", timestamp(hours.closed[2].start).c_str());
+    TEST_ASSERT_EQUAL(2, hours.closed[2].samples);
+    TEST_ASSERT_EQUAL_STRING("2025-11-05 00:00:00", timestamp(hourlyBuffer().start).c_str());
+    TEST_ASSERT_EQUAL(1, hourlyBuffer().samples);
+
+    TEST_ASSERT_EQUAL(1, hours.days.size());
+    TEST_ASSERT_EQUAL_UINT32(at(2025, 11, 4, 0, 0, 0), hours.days[0].start);
+    TEST_ASSERT_EQUAL_UINT32(at(2025, 11, 5, 0, 0, 0), hours.days[0].end);
+    TEST_ASSERT_EQUAL(3, hours.days[0].samples);
+    TEST_ASSERT_EQUAL_UINT64((500 + 100 + 100) * 60 * 1000ULL, hours.days[0].energyMws);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 500.0f, hours.days[0].peakPower);
+}
+
+void test_multiple_hour_transitions(void) {
+    int clockHours[] = { 10, 11, 12, 13 };
+    for (int i = 0; i < 4; i++) {
+        accumulateReading(at(2025, 11, 4, clockHours[i], 30, 0), 1.0f, 100);
+        TEST_ASSERT_EQUAL_UINT32(at(2025, 11, 4, clockHours[i], 0, 0), hourlyBuffer().start);
+        TEST_ASSERT_EQUAL(i, hours.closed.size());
+        if (i > 0) {
+            TEST_ASSERT_TRUE(hours.closed.back().samples > 0);
+        }
+    }
+}
+
+// 60 readings of 1 kW, one a minute
+void test_energy_accumulation_realistic(void) {
+    for (int i = 1; i <= 60; i++) {
+        accumulateReading(at(2025, 11, 4, 10, 0, 0) + i * 60, 4.35f, 1000);
+    }
+    TEST_ASSERT_EQUAL(60, hourlyBuffer().samples);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 1.0, mwsToKwh(hourlyBuffer().energyMws));
+}
+
+void test_no_samples_before_data(void) {
+    TEST_ASSERT_TRUE(hourlyBuffer().empty());
+    TEST_ASSERT_EQUAL_UINT32(0, hourlyBuffer().start);
+    TEST_ASSERT_EQUAL_UINT64(0, hourlyBuffer().energyMws);
+}
+
+// Clock not set: no timestamp, and the reading waits for the first hour
+void test_invalid_time_handling(void) {
+    TEST_ASSERT_EQUAL_STRING("", timestamp(0).c_str());
+
+    accumulateReading(0, 1.0f, 100);
+    TEST_ASSERT_EQUAL_UINT32(0, hourlyBuffer().start);
+    accumulateReading(at(2025, 11, 4, 10, 1, 0), 1.0f, 100);
+    TEST_ASSERT_EQUAL(2, hourlyBuffer().samples);
+}
+
+void test_zero_power_readings(void) {
+    accumulateReading(at(2025, 11, 4, 10, 1, 0), 0, 0);
+    accumulateReading(at(2025, 11, 4, 10, 2, 0), 0, 0);
+
+    TEST_ASSERT_EQUAL(2, hourlyBuffer().samples);
+    TEST_ASSERT_EQUAL_UINT64(0, hourlyBuffer().energyMws);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.0f, hourlyBuffer().peakPower);
+}
+
+void test_high_power_spike(void) {
+    accumulateReading(at(2025, 11, 4, 10, 1, 0), 1.0f, 100);
+    accumulateReading(at(2025, 11, 4, 10, 2, 0), 20.0f, 5000);   // 5 kW spike
+    accumulateReading(at(2025, 11, 4, 10, 3, 0), 1.0f, 100);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 5000.0f, hourlyBuffer().peakPower);
+    TEST_ASSERT_TRUE(hourlyBuffer().avgPower() < hourlyBuffer().peakPower);
+}
+
+void test_hourly_data_completeness(void) {
+    accumulateReading(at(2025, 11, 4, 10, 1, 0), 1.5f, 345);
+
+    const AggregateBucket &hour = hourlyBuffer();
+    TEST_ASSERT_TRUE(hour.energyMws > 0);
+    TEST_ASSERT_TRUE(hour.avgPower() > 0);
+    TEST_ASSERT_TRUE(hour.avgCurrent() > 0);
+    TEST_ASSERT_TRUE(hour.avgVoltage() > 0);
+    TEST_ASSERT_TRUE(hour.peakPower > 0);
+    TEST_ASSERT_TRUE(hour.samples > 0);
+    TEST_ASSERT_EQUAL_UINT32(hour.start + 3600, hour.end);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_initial_hour_tracking);
+    RUN_TEST(test_hour_change_detection);
+    RUN_TEST(test_data_accumulation_same_hour);
+    RUN_TEST(test_peak_power_tracking);
+    RUN_TEST(test_average_calculations);
+    RUN_TEST(test_buffer_reset_on_hour_change);
+    RUN_TEST(test_date_formatting);
+    RUN_TEST(test_midnight_transition);
+    RUN_TEST(test_multiple_hour_transitions);
+    RUN_TEST(test_energy_accumulation_realistic);
+    RUN_TEST(test_no_samples_before_data);
+    RUN_TEST(test_invalid_time_handling);
+    RUN_TEST(test_zero_power_readings);
+    RUN_TEST(test_high_power_spike);
+    RUN_TEST(test_hourly_data_completeness);
+
+    return UNITY_END();
+}
@@ -0,0 +1,133 @@
+#include <unity.h>
+#include <string.h>
+#include <Base64.h>
+#include <MinuteProfile.h>
+
+MinuteProfile profile;
+
+static MinuteSample sampleAt(uint8_t minute, uint16_t powerQw) {
+    MinuteSample s;
+    s.minute = minute;
+    s.flags = 1;
+    s.powerQw = powerQw;
+    s.currentMa = powerQw * 4 / 23;   // ~230 V
+    s.voltageDv = 2300 + minute % 3;
+    return s;
+}
+
+void setUp(void) {
+    profile.clear();
+}
+
+void tearDown(void) {}
+
+void test_sample_is_eight_bytes(void) {
+    TEST_ASSERT_EQUAL(8, sizeof(MinuteSample));
+}
+
+void test_ring_keeps_newest(void) {
+    for (int k = 0; k < MinuteProfile::CAPACITY + 5; k++) {
+        profile.add(sampleAt(k % 60, k));
+    }
+    TEST_ASSERT_EQUAL(MinuteProfile::CAPACITY, profile.count());
+    TEST_ASSERT_EQUAL(5, profile.overwritten());
+    TEST_ASSERT_EQUAL(5, profile.at(0).powerQw);
+    TEST_ASSERT_EQUAL(MinuteProfile::CAPACITY + 4, profile.at(MinuteProfile::CAPACITY - 1).powerQw);
+}
+
+void test_hour_round_trips(void) {
+    for (uint8_t m = 0; m < 60; m++) {
+        // Mostly steady with a spike and a gap
+        if (m == 30) continue;
+        profile.add(sampleAt(m, m == 42 ? 8000 : 400 + m % 2));
+    }
+
+    uint8_t buffer[600];
+    size_t length = 0;
+    TEST_ASSERT_EQUAL(59, encodeProfile(profile, 0, buffer, sizeof(buffer), &length));
+    TEST_ASSERT_LESS_THAN(59 * 6, length);
+
+    MinuteSample decoded[64];
+    TEST_ASSERT_EQUAL(59, decodeProfile(buffer, length, decoded, 64));
+    for (uint8_t k = 0; k < 59; k++) {
+        TEST_ASSERT_EQUAL(profile.at(k).minute, decoded[k].minute);
+        TEST_ASSERT_EQUAL(profile.at(k).flags, decoded[k].flags);
+        TEST_ASSERT_EQUAL(profile.at(k).powerQw, decoded[k].powerQw);
+        TEST_ASSERT_EQUAL(profile.at(k).currentMa, decoded[k].currentMa);
+        TEST_ASSERT_EQUAL(profile.at(k).voltageDv, decoded[k].voltageDv);
+    }
+}
+
+void test_steady_load_is_four_bytes_a_minute(void) {
+    for (uint8_t m = 0; m < 60; m++) {
+        MinuteSample s = sampleAt(m, 400);
+        s.voltageDv = 2300;
+        profile.add(s);
+    }
+    uint8_t buffer[600];
+    size_t length = 0;
+    encodeProfile(profile, 0, buffer, sizeof(buffer), &length);
+    // The first sample carries the absolute values
+    TEST_ASSERT_EQUAL(7 + 59 * 4, length);
+}
+
+void test_segments_decode_on_their_own(void) {
+    for (uint8_t m = 0; m < 60; m++) {
+        profile.add(sampleAt(m, 1000 + m * 37));
+    }
+
+    uint8_t buffer[64];
+    size_t length = 0;
+    uint8_t first = 0;
+    MinuteSample decoded[64];
+    while (first < profile.count()) {
+        uint8_t n = encodeProfile(profile, first, buffer, sizeof(buffer), &length);
+        TEST_ASSERT_GREATER_THAN(0, n);
+        TEST_ASSERT_LESS_OR_EQUAL(sizeof(buffer), length);
+        TEST_ASSERT_EQUAL(n, decodeProfile(buffer, length, decoded, 64));
+        TEST_ASSERT_EQUAL(profile.at(first).powerQw, decoded[0].powerQw);
+        TEST_ASSERT_EQUAL(profile.at(first + n - 1).minute, decoded[n - 1].minute);
+        first += n;
+    }
+}
+
+void test_truncated_data_is_rejected(void) {
+    profile.add(sampleAt(0, 9000));
+    uint8_t buffer[16];
+    size_t length = 0;
+    encodeProfile(profile, 0, buffer, sizeof(buffer), &length);
+    MinuteSample decoded[4];
+    TEST_ASSERT_EQUAL(0, decodeProfile(buffer, length - 1, decoded, 4));
+}
+
+void test_base64(void) {
+    char out[16];
+    const uint8_t text[] = { 'M', 'a', 'n', 'y' };
+    TEST_ASSERT_EQUAL(8, base64Encode(text, 4, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("TWFueQ==", out);
+    TEST_ASSERT_EQUAL(4, base64Encode(text, 3, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("TWFu", out);
+    TEST_ASSERT_EQUAL(0, base64Encode(text, 4, out, 8));   // no room for the terminator
+
+    uint8_t back[4];
+    TEST_ASSERT_EQUAL(4, base64Decode("TWFueQ==", back, sizeof(back)));
+    TEST_ASSERT_EQUAL_MEMORY(text, back, 4);
+    TEST_ASSERT_EQUAL(3, base64Decode("TWFu", back, sizeof(back)));
+    TEST_ASSERT_EQUAL(0, base64Decode("TWFueQ=", back, sizeof(back)));    // not padded
+    TEST_ASSERT_EQUAL(0, base64Decode("TW=ueQ==", back, sizeof(back)));   // padding inside
+    TEST_ASSERT_EQUAL(0, base64Decode("TWFueQ==", back, 3));              // no room
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_sample_is_eight_bytes);
+    RUN_TEST(test_ring_keeps_newest);
+    RUN_TEST(test_hour_round_trips);
+    RUN_TEST(test_steady_load_is_four_bytes_a_minute);
+    RUN_TEST(test_segments_decode_on_their_own);
+    RUN_TEST(test_truncated_data_is_rejected);
+    RUN_TEST(test_base64);
+
+    return UNITY_END();
+}
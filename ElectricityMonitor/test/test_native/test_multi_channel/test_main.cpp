@@ -0,0 +1,186 @@
+#include <unity.h>
+#include <math.h>
+#include <FakeSampleSource.h>
+#include <MeterEngine.h>
+#include <MultiChannelMeter.h>
+#include <ReadingQueue.h>
+
+const uint8_t CHANNELS = 3;
+
+ChannelFrameRing ring;
+FakeChannelFrameSource source(CHANNELS, 1000);
+MultiChannelMeter meter;
+
+static MeterConfig testConfig() {
+    MeterConfig config;
+    config.sampleRateHz = 1000;
+    config.voltsPerCount = 0.21665f;
+    config.ampsPerCount = 0.0082622f;
+    return config;
+}
+
+// 230 V mains with the given load on a channel, in ADC counts
+static FakeWaveform load(float amps, float powerFactor) {
+    FakeWaveform wave;
+    wave.voltageAmplitude = 230 * 1.41421356f / 0.21665f;
+    wave.currentAmplitude = amps * 1.41421356f / 0.0082622f;
+    wave.currentPhaseRad = acosf(powerFactor);
+    return wave;
+}
+
+static void runFor(float seconds) {
+    size_t total = (size_t)(seconds * source.sampleRateHz());
+    while (total > 0) {
+        size_t chunk = total < 100 ? total : 100;
+        source.generate(chunk);
+        meter.drain(ring);
+        total -= chunk;
+    }
+}
+
+void setUp(void) {
+    ChannelFrame discard;
+    while (ring.pop(discard)) {}
+    source.begin(ring);
+    meter.configure(testConfig(), CHANNELS);
+}
+
+void tearDown(void) {
+    source.end();
+}
+
+// Each channel reads what a single-channel engine reads off the same load
+void test_each_channel_matches_a_single_channel_engine(void) {
+    FakeWaveform waves[CHANNELS] = { load(4.0f, 0.9f), load(0.35f, 0.95f), load(8.4f, 1.0f) };
+    for (uint8_t c = 0; c < CHANNELS; c++) {
+        source.setWaveform(c, waves[c]);
+    }
+    runFor(60);
+    MeterReading readings[CHANNELS];
+    meter.takeReadings(readings);
+
+    for (uint8_t c = 0; c < CHANNELS; c++) {
+        static RawSampleRing single;
+        FakeSampleSource singleSource(1000);
+        MeterEngine engine;
+        engine.configure(testConfig());
+        singleSource.setWaveform(waves[c]);
+        singleSource.begin(single);
+        for (int k = 0; k < 600; k++) {
+            singleSource.generate(100);
+            engine.drain(single);
+        }
+        MeterReading expected = engine.takeReading();
+
+        TEST_ASSERT_EQUAL(expected.samples, readings[c].samples);
+        TEST_ASSERT_FLOAT_WITHIN(expected.realPower * 1e-4f, expected.realPower, readings[c].realPower);
+        TEST_ASSERT_FLOAT_WITHIN(expected.currentRms * 1e-4f, expected.currentRms, readings[c].currentRms);
+        TEST_ASSERT_FLOAT_WITHIN(expected.energyMws * 1e-6, expected.energyMws, readings[c].energyMws);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.0f, readings[c].lineFrequencyHz);
+    }
+}
+
+// One tenant's kettle is nobody else's energy
+void test_idle_channel_reads_zero(void) {
+    source.setWaveform(0, load(8.0f, 1.0f));
+    source.setWaveform(1, load(0, 1.0f));
+    source.setWaveform(2, load(2.0f, 0.9f));
+    runFor(10);
+    MeterReading readings[CHANNELS];
+    meter.takeReadings(readings);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0, readings[1].currentRms);
+    TEST_ASSERT_EQUAL(0, readings[1].energyMws);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 230, readings[1].voltageRms);
+    TEST_ASSERT_FLOAT_WITHIN(5, 1840, readings[0].realPower);
+}
+
+// Current tables are per channel; the voltage table is channel 0's
+void test_calibration_is_per_channel(void) {
+    for (uint8_t c = 0; c < CHANNELS; c++) {
+        source.setWaveform(c, load(4.0f, 1.0f));
+    }
+    meter.setCalibration(0, CalibrationProfile::flat(1.02f, 1.0f));
+    meter.setCalibration(1, CalibrationProfile::flat(1.5f, 1.1f));
+    runFor(10);
+    MeterReading readings[CHANNELS];
+    meter.takeReadings(readings);
+
+    // Channel 1's own voltage table is ignored: every channel sees channel 0's
+    double base = (double)readings[2].energyMws;
+    TEST_ASSERT_FLOAT_WITHIN(base * 0.001, base, (double)readings[0].energyMws);
+    TEST_ASSERT_FLOAT_WITHIN(base * 0.001, base * 1.1, (double)readings[1].energyMws);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 230 * 1.02f, readings[1].voltageRms);
+    TEST_ASSERT_EQUAL_FLOAT(readings[2].voltageRms, readings[1].voltageRms);
+    TEST_ASSERT_EQUAL_FLOAT(1.02f, meter.calibrationProfile(1).voltage.points[0].gain);
+}
+
+// Each channel's live power tracks its own load a second at a time,
+// between readings
+void test_live_power_per_channel(void) {
+    source.setWaveform(0, load(8.0f, 1.0f));
+    source.setWaveform(1, load(0, 1.0f));
+    source.setWaveform(2, load(2.0f, 0.5f));
+    runFor(2);
+    TEST_ASSERT_FLOAT_WITHIN(5, 1840, meter.recentPower(0));
+    TEST_ASSERT_FLOAT_WITHIN(1, 0, meter.recentPower(1));
+    TEST_ASSERT_FLOAT_WITHIN(3, 230, meter.recentPower(2));
+
+    source.setWaveform(1, load(4.0f, 1.0f));
+    runFor(2.1f);
+    TEST_ASSERT_FLOAT_WITHIN(3, 920, meter.recentPower(1));
+    TEST_ASSERT_FLOAT_WITHIN(5, 1840, meter.recentPower(0));
+
+    LivePower live[CHANNELS];
+    ReadingQueue queues[CHANNELS];
+    ReadingTimer timer(60000);
+    timer.start(0);
+    source.generate(20);
+    runMultiMeteringPeriod(meter, ring, queues, timer, 20, []() { return 0u; }, live);
+    TEST_ASSERT_EQUAL_FLOAT(meter.recentPower(1), live[1].load());
+}
+
+// A stalled tenant holds every channel's interval open, so nobody's energy
+// is lost and the readings stay aligned
+void test_readings_wait_for_every_queue(void) {
+    ReadingQueue queues[CHANNELS];
+    ReadingTimer timer(1000);
+    timer.start(0);
+    for (uint8_t c = 0; c < CHANNELS; c++) {
+        source.setWaveform(c, load(1.0f + c, 1.0f));
+    }
+
+    QueuedReading filler;
+    while (queues[1].size() < queues[1].capacity()) {
+        queues[1].push(filler);
+    }
+    source.generate(1000);
+    TEST_ASSERT_FALSE(runMultiMeteringPeriod(meter, ring, queues, timer, 1000, []() { return 1762214460u; }));
+    TEST_ASSERT_TRUE(queues[0].empty());
+
+    queues[1].pop(filler);
+    source.generate(1000);
+    TEST_ASSERT_TRUE(runMultiMeteringPeriod(meter, ring, queues, timer, 2000, []() { return 1762214461u; }));
+
+    QueuedReading first;
+    QueuedReading second;
+    TEST_ASSERT_TRUE(queues[0].pop(first));
+    TEST_ASSERT_TRUE(queues[2].pop(second));
+    TEST_ASSERT_EQUAL_UINT32(1762214461u, first.epoch);
+    TEST_ASSERT_EQUAL(first.reading.samples, second.reading.samples);
+    TEST_ASSERT_GREATER_OR_EQUAL(1900, first.reading.samples);
+    TEST_ASSERT_FLOAT_WITHIN(first.reading.energyMws * 0.01, first.reading.energyMws * 3.0,
+                             (double)second.reading.energyMws);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_each_channel_matches_a_single_channel_engine);
+    RUN_TEST(test_idle_channel_reads_zero);
+    RUN_TEST(test_calibration_is_per_channel);
+    RUN_TEST(test_live_power_per_channel);
+    RUN_TEST(test_readings_wait_for_every_queue);
+
+    return UNITY_END();
+}
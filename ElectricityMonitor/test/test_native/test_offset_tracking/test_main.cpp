@@ -0,0 +1,133 @@
+#include <unity.h>
+#include <math.h>
+#include <FakeSampleSource.h>
+#include <MeterEngine.h>
+#include <OffsetTracker.h>
+
+RawSampleRing ring;
+FakeSampleSource source(1000);
+MeterEngine engine;
+
+MeterConfig testConfig() {
+    MeterConfig config;
+    config.sampleRateHz = source.sampleRateHz();
+    config.voltsPerCount = 1.0;   // readings come back in ADC counts
+    config.ampsPerCount = 1.0;
+    return config;
+}
+
+// Run the waveform while its offsets drift linearly to the given end values
+void runDrifting(FakeWaveform &wave, float seconds, float currentEnd, float voltageEnd) {
+    const int steps = (int)(seconds * 10);
+    float currentStep = (currentEnd - wave.currentOffset) / steps;
+    float voltageStep = (voltageEnd - wave.voltageOffset) / steps;
+    for (int k = 0; k < steps; k++) {
+        wave.currentOffset += currentStep;
+        wave.voltageOffset += voltageStep;
+        source.setWaveform(wave);
+        source.generate(source.sampleRateHz() / 10);
+        engine.drain(ring);
+    }
+}
+
+void setUp(void) {
+    source.begin(ring);
+    engine.configure(testConfig());
+}
+
+void tearDown(void) {
+    source.end();
+}
+
+void test_tracker_converges_on_constant_input(void) {
+    OffsetTracker tracker(14, 2048);
+    for (int k = 0; k < 200000; k++) {
+        tracker.update(1900);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.1, 1900.0, tracker.value());
+}
+
+void test_tracker_ignores_symmetric_sine(void) {
+    OffsetTracker tracker(14, 1800);
+    for (int k = 0; k < 200000; k++) {
+        float sample = 1800 + 1500 * sin(2 * M_PI * 50 * k / 1000.0);
+        tracker.update((uint16_t)lround(sample));
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1.0, 1800.0, tracker.value());
+}
+
+void test_tracker_seed_round_trip(void) {
+    // What gets written to NVS must come back as the same offset
+    OffsetTracker tracker;
+    tracker.seed(1987.25);
+    OffsetTracker restored;
+    restored.seed(tracker.value());
+    TEST_ASSERT_EQUAL(tracker.valueQ16(), restored.valueQ16());
+}
+
+void test_engine_follows_drifting_offset(void) {
+    FakeWaveform wave;
+    wave.voltageAmplitude = 1200;
+    wave.currentAmplitude = 300;
+    source.setWaveform(wave);
+    runDrifting(wave, 60, 2048, 2048);
+
+    // Sensor bias wanders ~100 counts over ten minutes
+    runDrifting(wave, 600, 1950, 2110);
+
+    // A first-order tracker trails a ramp by rate * time constant (~3 counts here)
+    MeterReading reading = engine.takeReading();
+    TEST_ASSERT_FLOAT_WITHIN(4.0, 1950.0, reading.currentOffset);
+    TEST_ASSERT_FLOAT_WITHIN(4.0, 2110.0, reading.voltageOffset);
+}
+
+void test_low_current_not_inflated_by_bias(void) {
+    // A phone charger sits a few counts above the noise floor; a 60 count
+    // bias error would swamp it if the fixed 2048 centre were used
+    FakeWaveform wave;
+    wave.voltageAmplitude = 1200;
+    wave.voltageOffset = 1990;
+    wave.currentAmplitude = 8;
+    wave.currentOffset = 1988;
+    source.setWaveform(wave);
+    engine.seedOffsets(2048, 2048);
+
+    // Let the trackers settle, then measure
+    runDrifting(wave, 180, 1988, 1990);
+    engine.takeReading();
+    runDrifting(wave, 60, 1988, 1990);
+
+    MeterReading reading = engine.takeReading();
+    float expected = 8 / sqrtf(2);
+    TEST_ASSERT_FLOAT_WITHIN(expected * 0.05, expected, reading.currentRms);
+    TEST_ASSERT_FLOAT_WITHIN(0.5, 1988.0, reading.currentOffset);
+}
+
+void test_seeded_offset_is_used_immediately(void) {
+    FakeWaveform wave;
+    wave.voltageAmplitude = 1200;
+    wave.currentAmplitude = 20;
+    wave.currentOffset = 1930;
+    source.setWaveform(wave);
+    engine.seedOffsets(1930, 2048);
+
+    source.generate(1000);
+    engine.drain(ring);
+
+    MeterReading reading = engine.takeReading();
+    float expected = 20 / sqrtf(2);
+    TEST_ASSERT_FLOAT_WITHIN(expected * 0.05, expected, reading.currentRms);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_tracker_converges_on_constant_input);
+    RUN_TEST(test_tracker_ignores_symmetric_sine);
+    RUN_TEST(test_tracker_seed_round_trip);
+    RUN_TEST(test_engine_follows_drifting_offset);
+    RUN_TEST(test_low_current_not_inflated_by_bias);
+    RUN_TEST(test_seeded_offset_is_used_immediately);
+
+    return UNITY_END();
+}
@@ -0,0 +1,96 @@
+#include <unity.h>
+#include <PublishPolicy.h>
+
+PublishPolicy policy;
+
+void setUp(void) {
+    policy.configure(PublishPolicyConfig());
+}
+
+void tearDown(void) {}
+
+// Nothing published yet: the first reading always goes up
+void test_first_reading_is_due(void) {
+    TEST_ASSERT_TRUE(policy.readingDue(0, 0));
+    TEST_ASSERT_TRUE(policy.readingDue(1500, 60000));
+    TEST_ASSERT_FALSE(policy.stepDue(1500, 60000));
+}
+
+// 10 W or 5%, whichever is larger
+void test_deadband_is_absolute_or_relative(void) {
+    policy.published(80, 0);
+    TEST_ASSERT_FALSE(policy.readingDue(89, 60000));
+    TEST_ASSERT_TRUE(policy.readingDue(91, 60000));
+    TEST_ASSERT_TRUE(policy.readingDue(69, 60000));
+
+    policy.published(2000, 60000);
+    TEST_ASSERT_FALSE(policy.readingDue(2090, 120000));
+    TEST_ASSERT_FALSE(policy.readingDue(1910, 120000));
+    TEST_ASSERT_TRUE(policy.readingDue(2110, 120000));
+}
+
+// A steady load still goes up once per heartbeat
+void test_heartbeat_expires(void) {
+    policy.published(80, 1000);
+    TEST_ASSERT_FALSE(policy.readingDue(80, 1000 + 599999));
+    TEST_ASSERT_TRUE(policy.readingDue(80, 1000 + 600000));
+}
+
+// A step counts once it has held for stepSettleMs; the half-second the
+// load switched in doesn't restart the wait past the new level
+void test_step_waits_to_settle(void) {
+    policy.published(80, 0);
+    TEST_ASSERT_FALSE(policy.stepDue(300, 1000));     // under stepW
+    TEST_ASSERT_FALSE(policy.stepDue(1050, 2000));    // half the kettle
+    TEST_ASSERT_FALSE(policy.stepDue(2080, 3000));    // the kettle
+    TEST_ASSERT_FALSE(policy.stepDue(2070, 4000));
+    TEST_ASSERT_TRUE(policy.stepDue(2075, 4500));
+
+    policy.published(2075, 4600);
+    TEST_ASSERT_FALSE(policy.stepDue(2075, 10000));
+    TEST_ASSERT_FALSE(policy.readingDue(2060, 60000));
+}
+
+// A step that goes away before it settles is never sent
+void test_brief_step_is_ignored(void) {
+    policy.published(80, 0);
+    TEST_ASSERT_FALSE(policy.stepDue(1200, 1000));
+    TEST_ASSERT_FALSE(policy.stepDue(80, 2000));
+    TEST_ASSERT_FALSE(policy.stepDue(1200, 3000));
+    TEST_ASSERT_FALSE(policy.stepDue(1200, 4000));
+    TEST_ASSERT_TRUE(policy.stepDue(1200, 4500));
+}
+
+// Off: every reading is due and steps never are
+void test_disabled_publishes_every_reading(void) {
+    PublishPolicyConfig config;
+    config.enabled = false;
+    policy.configure(config);
+    policy.published(80, 0);
+    TEST_ASSERT_TRUE(policy.readingDue(80, 60000));
+    TEST_ASSERT_FALSE(policy.stepDue(3000, 61000));
+    TEST_ASSERT_FALSE(policy.stepDue(3000, 65000));
+}
+
+// After reset() (the link came back) the next reading goes up
+void test_reset_forgets_the_last_value(void) {
+    policy.published(80, 0);
+    TEST_ASSERT_FALSE(policy.readingDue(80, 60000));
+    policy.reset();
+    TEST_ASSERT_TRUE(policy.readingDue(80, 60000));
+    TEST_ASSERT_FALSE(policy.hasPublished());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_first_reading_is_due);
+    RUN_TEST(test_deadband_is_absolute_or_relative);
+    RUN_TEST(test_heartbeat_expires);
+    RUN_TEST(test_step_waits_to_settle);
+    RUN_TEST(test_brief_step_is_ignored);
+    RUN_TEST(test_disabled_publishes_every_reading);
+    RUN_TEST(test_reset_forgets_the_last_value);
+
+    return UNITY_END();
+}
@@ -0,0 +1,166 @@
+#include <unity.h>
+#include <math.h>
+#include <FakeSampleSource.h>
+#include <MeterEngine.h>
+#include <ReadingQueue.h>
+
+RawSampleRing ring;
+FakeSampleSource source(1000);
+MeterEngine engine;
+ReadingQueue queue;
+
+void setUp(void) {
+    MeterConfig config;
+    config.sampleRateHz = source.sampleRateHz();
+    config.voltsPerCount = 1.0;
+    config.ampsPerCount = 1.0;
+    engine.configure(config);
+
+    FakeWaveform wave;
+    wave.voltageAmplitude = 1000;
+    wave.currentAmplitude = 500;
+    source.setWaveform(wave);
+    source.begin(ring);
+
+    QueuedReading discard;
+    while (queue.pop(discard)) {}
+}
+
+void tearDown(void) {
+    source.end();
+}
+
+// One "minute" of metering in the producer task, scaled down to a second
+static void meterFor(int seconds) {
+    for (int k = 0; k < seconds * 10; k++) {
+        source.generate(100);
+        engine.drain(ring);
+    }
+}
+
+void test_readings_arrive_in_order(void) {
+    for (uint32_t t = 1; t <= 3; t++) {
+        meterFor(1);
+        TEST_ASSERT_TRUE(queueReading(engine, queue, 1000 + t));
+    }
+
+    QueuedReading item;
+    for (uint32_t t = 1; t <= 3; t++) {
+        TEST_ASSERT_TRUE(queue.pop(item));
+        TEST_ASSERT_EQUAL_UINT32(1000 + t, item.epoch);
+        TEST_ASSERT_GREATER_THAN(0, item.reading.samples);
+    }
+    TEST_ASSERT_FALSE(queue.pop(item));
+}
+
+void test_stalled_consumer_delays_instead_of_dropping(void) {
+    double expectedEnergy = 0;
+    for (size_t k = 0; k < READING_QUEUE_SIZE; k++) {
+        meterFor(1);
+        TEST_ASSERT_TRUE(queueReading(engine, queue, k));
+    }
+
+    // Queue full: the next two intervals stay open in the engine
+    meterFor(1);
+    TEST_ASSERT_FALSE(queueReading(engine, queue, 100));
+    meterFor(1);
+    TEST_ASSERT_FALSE(queueReading(engine, queue, 101));
+    TEST_ASSERT_EQUAL(0, queue.droppedCount());
+
+    QueuedReading item;
+    while (queue.pop(item)) {
+        expectedEnergy += item.reading.energyKwh;
+    }
+    TEST_ASSERT_TRUE(queueReading(engine, queue, 102));
+    TEST_ASSERT_TRUE(queue.pop(item));
+
+    // The delayed reading covers both open intervals
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 2.0, item.reading.durationSec);
+    double perSecond = expectedEnergy / READING_QUEUE_SIZE;
+    TEST_ASSERT_FLOAT_WITHIN(perSecond * 0.05, 2 * perSecond, item.reading.energyKwh);
+}
+
+// The cadence alone: a step shortens the next interval to fastestMs, and
+// each quiet reading after it doubles the interval back to steadyMs
+void test_cadence_tightens_on_a_step_and_relaxes(void) {
+    ReadingTimer timer = ReadingTimer(ReadingCadence());
+    timer.start(0);
+    timer.observe(80);
+    TEST_ASSERT_FALSE(timer.due(59999));
+    TEST_ASSERT_TRUE(timer.due(60000));
+    timer.taken(60000);
+
+    // 80 W to 2 kW: due once the interval is 10 s old
+    timer.observe(2080);
+    TEST_ASSERT_FALSE(timer.due(69999));
+    TEST_ASSERT_TRUE(timer.due(70000));
+    timer.taken(70000);
+    TEST_ASSERT_EQUAL_UINT32(10000, timer.interval());
+
+    uint32_t expected[] = { 20000, 40000, 60000, 60000 };
+    uint32_t now = 70000;
+    for (int k = 0; k < 4; k++) {
+        timer.observe(2100);   // inside 20% of 2080
+        now += timer.interval();
+        TEST_ASSERT_TRUE(timer.due(now));
+        timer.taken(now);
+        TEST_ASSERT_EQUAL_UINT32(expected[k], timer.interval());
+    }
+
+    // A fixed timer never tightens
+    ReadingTimer fixed(60000);
+    fixed.start(0);
+    fixed.observe(0);
+    fixed.observe(5000);
+    TEST_ASSERT_FALSE(fixed.due(30000));
+}
+
+// Metering periods through a step: the reading closes right after it, the
+// following ones come closer together, and the readings' energy still adds
+// up to the load's whatever their lengths
+void test_energy_is_exact_across_variable_intervals(void) {
+    ReadingTimer timer = ReadingTimer(ReadingCadence());
+    timer.start(0);
+    uint32_t closedAt[READING_QUEUE_SIZE];
+    size_t readings = 0;
+    uint64_t energyMws = 0;
+
+    for (uint32_t now = 20; now <= 150000; now += 20) {
+        if (now == 30000) {
+            FakeWaveform wave;
+            wave.voltageAmplitude = 1000;
+            wave.currentAmplitude = 1000;
+            source.setWaveform(wave);
+        }
+        source.generate(20);
+        if (runMeteringPeriod(engine, ring, queue, timer, now, [now]() { return now / 1000; })) {
+            QueuedReading item;
+            TEST_ASSERT_TRUE(queue.pop(item));
+            closedAt[readings++] = now;
+            energyMws += item.reading.energyMws;
+        }
+    }
+    energyMws += engine.takeReading().energyMws;
+
+    // 250 kW then 500 kW on this scale
+    double expected = (250000.0 * 30 + 500000.0 * 120) * 1000;
+    TEST_ASSERT_FLOAT_WITHIN(expected * 0.001, expected, (double)energyMws);
+
+    // 31 s, then 10, 20 and 40 s apart
+    TEST_ASSERT_EQUAL(4, readings);
+    TEST_ASSERT_TRUE(closedAt[0] > 30000 && closedAt[0] <= 32000);
+    for (size_t k = 2; k < readings; k++) {
+        TEST_ASSERT_TRUE(closedAt[k] - closedAt[k - 1] > closedAt[k - 1] - closedAt[k - 2]);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_readings_arrive_in_order);
+    RUN_TEST(test_stalled_consumer_delays_instead_of_dropping);
+    RUN_TEST(test_cadence_tightens_on_a_step_and_relaxes);
+    RUN_TEST(test_energy_is_exact_across_variable_intervals);
+
+    return UNITY_END();
+}
@@ -0,0 +1,90 @@
+#include <unity.h>
+#include <math.h>
+#include <RmsKernel.h>
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_no_integer_truncation_before_sqrt(void) {
+    // The old loops did sqrt(sum / samples) in integer maths: 7 / 2 -> 3
+    RmsKernel<int16_t, 2> kernel;
+    kernel.add(2);
+    kernel.add(-1);
+    TEST_ASSERT_EQUAL(5, kernel.sum());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 2.5, kernel.meanSquare());
+}
+
+void test_window_full_flag(void) {
+    RmsKernel<int16_t, 3> kernel;
+    TEST_ASSERT_FALSE(kernel.add(1));
+    TEST_ASSERT_FALSE(kernel.add(1));
+    TEST_ASSERT_TRUE(kernel.add(1));
+    TEST_ASSERT_TRUE(kernel.full());
+    kernel.reset();
+    TEST_ASSERT_EQUAL(0, kernel.count());
+}
+
+void test_rms_matches_float_reference(void) {
+    RmsKernel<int16_t, 1000> kernel;
+    double reference = 0;
+    for (int k = 0; k < 1000; k++) {
+        int16_t x = (int16_t)lround(4000 * sin(2 * M_PI * k / 20.0));
+        kernel.add(x);
+        reference += (double)x * x;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.01, sqrt(reference / 1000), kernel.rms());
+}
+
+void test_full_scale_long_window_does_not_overflow(void) {
+    // 2^20 full-scale samples: a 32-bit long would have wrapped long ago
+    const uint32_t window = 1u << 20;
+    RmsKernel<int16_t, window> kernel;
+    while (!kernel.add(-32767)) {}
+    TEST_ASSERT_FLOAT_WITHIN(1.0, 32767.0, kernel.rms());
+}
+
+void test_power_kernel_products(void) {
+    PowerKernel<int16_t, 4> kernel;
+    kernel.add(10, 2);
+    kernel.add(-10, -2);
+    kernel.add(10, -2);
+    kernel.add(-10, 2);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 100.0, kernel.meanSquareA());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 4.0, kernel.meanSquareB());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, kernel.meanProduct());
+}
+
+void test_power_kernel_merge(void) {
+    PowerKernel<int16_t, 2> shortWindow;
+    PowerKernel<int16_t, 100> longWindow;
+    shortWindow.add(3, 4);
+    shortWindow.add(3, 4);
+    longWindow.merge(shortWindow);
+    longWindow.merge(shortWindow);
+    TEST_ASSERT_EQUAL(4, longWindow.count());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 12.0, longWindow.meanProduct());
+}
+
+void test_wide_samples(void) {
+    RmsKernel<int32_t, 4> kernel;
+    kernel.add(100000);
+    kernel.add(-100000);
+    kernel.add(100000);
+    kernel.add(-100000);
+    TEST_ASSERT_FLOAT_WITHIN(1.0, 100000.0, kernel.rms());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_no_integer_truncation_before_sqrt);
+    RUN_TEST(test_window_full_flag);
+    RUN_TEST(test_rms_matches_float_reference);
+    RUN_TEST(test_full_scale_long_window_does_not_overflow);
+    RUN_TEST(test_power_kernel_products);
+    RUN_TEST(test_power_kernel_merge);
+    RUN_TEST(test_wide_samples);
+
+    return UNITY_END();
+}
@@ -0,0 +1,299 @@
+#include <unity.h>
+#include <math.h>
+#include <FakeSampleSource.h>
+#include <MeterEngine.h>
+
+const float ADC_VOLTAGE = 3.3;
+const int ADC_MAX = 4095;
+const float ACS712_SENSITIVITY = 0.066;
+const float VOLTAGE_FACTOR = 268.8471;
+const float CURRENT_FACTOR = 0.6767;
+
+RawSampleRing ring;
+FakeSampleSource source(1000);
+MeterEngine engine;
+
+MeterConfig testConfig() {
+    MeterConfig config;
+    config.sampleRateHz = source.sampleRateHz();
+    config.adcCenter = 2048;
+    config.voltsPerCount = (ADC_VOLTAGE / ADC_MAX) * VOLTAGE_FACTOR;
+    config.ampsPerCount = (ADC_VOLTAGE / ADC_MAX) / ACS712_SENSITIVITY * CURRENT_FACTOR;
+    return config;
+}
+
+// Feed seconds of waveform through the ring in DMA-sized chunks
+void runFor(float seconds) {
+    size_t total = (size_t)(seconds * source.sampleRateHz());
+    while (total > 0) {
+        size_t chunk = total < 100 ? total : 100;
+        source.generate(chunk);
+        engine.drain(ring);
+        total -= chunk;
+    }
+}
+
+void setUp(void) {
+    while (!ring.empty()) {
+        RawSample discard;
+        ring.pop(discard);
+    }
+    source.begin(ring);
+    engine.configure(testConfig());
+}
+
+void tearDown(void) {
+    source.end();
+}
+
+void test_ring_fifo_order(void) {
+    SampleRing<int, 4> small;
+    TEST_ASSERT_TRUE(small.push(1));
+    TEST_ASSERT_TRUE(small.push(2));
+    int value = 0;
+    TEST_ASSERT_TRUE(small.pop(value));
+    TEST_ASSERT_EQUAL(1, value);
+    TEST_ASSERT_TRUE(small.pop(value));
+    TEST_ASSERT_EQUAL(2, value);
+    TEST_ASSERT_FALSE(small.pop(value));
+}
+
+void test_ring_counts_overruns(void) {
+    SampleRing<int, 4> small;
+    for (int k = 0; k < 6; k++) {
+        small.push(k);
+    }
+    TEST_ASSERT_EQUAL(4, small.size());
+    TEST_ASSERT_EQUAL(2, small.droppedCount());
+}
+
+void test_zero_signal_reads_zero(void) {
+    FakeWaveform wave;
+    source.setWaveform(wave);
+    runFor(1.0);
+
+    MeterReading reading = engine.takeReading();
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.0, reading.currentRms);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.0, reading.voltageRms);
+    TEST_ASSERT_EQUAL(1000, reading.samples);
+}
+
+void test_rms_of_known_sine(void) {
+    MeterConfig config = testConfig();
+    FakeWaveform wave;
+    wave.voltageAmplitude = 1000;
+    wave.currentAmplitude = 200;
+    source.setWaveform(wave);
+    runFor(2.0);
+
+    MeterReading reading = engine.takeReading();
+    float expectedV = 1000 / sqrtf(2) * config.voltsPerCount;
+    float expectedI = 200 / sqrtf(2) * config.ampsPerCount;
+    TEST_ASSERT_FLOAT_WITHIN(expectedV * 0.01, expectedV, reading.voltageRms);
+    TEST_ASSERT_FLOAT_WITHIN(expectedI * 0.01, expectedI, reading.currentRms);
+}
+
+void test_energy_integrated_over_whole_interval(void) {
+    FakeWaveform wave;
+    wave.voltageAmplitude = 1000;
+    wave.currentAmplitude = 200;
+    source.setWaveform(wave);
+    runFor(60.0);
+
+    // The still-open RMS window (at most 5 cycles) carries into the next reading
+    MeterReading reading = engine.takeReading();
+    double expectedKwh = reading.realPower * reading.durationSec / 3600000.0;
+    TEST_ASSERT_GREATER_OR_EQUAL(59900, reading.samples);
+    TEST_ASSERT_LESS_OR_EQUAL(60000, reading.samples);
+    TEST_ASSERT_FLOAT_WITHIN(0.1, 60.0, reading.durationSec);
+    TEST_ASSERT_FLOAT_WITHIN(expectedKwh * 0.001, expectedKwh, reading.energyKwh);
+}
+
+// Meter 60 s of a small load from a fresh source, taking a reading every
+// readingSeconds, and add up the integer energy
+static uint64_t meterSmallLoad(int readingSeconds) {
+    RawSampleRing localRing;
+    FakeSampleSource localSource(1000);
+    MeterEngine localEngine;
+    localEngine.configure(testConfig());
+    FakeWaveform wave;
+    wave.voltageAmplitude = 1000;
+    wave.currentAmplitude = 7;   // a few watts
+    localSource.setWaveform(wave);
+    localSource.begin(localRing);
+
+    uint64_t totalMws = 0;
+    for (int s = 1; s <= 60; s++) {
+        for (int k = 0; k < 10; k++) {
+            localSource.generate(100);
+            localEngine.drain(localRing);
+        }
+        if (s % readingSeconds == 0) {
+            totalMws += localEngine.takeReading().energyMws;
+        }
+    }
+    return totalMws;
+}
+
+void test_split_readings_lose_no_energy(void) {
+    uint64_t once = meterSmallLoad(60);
+    uint64_t everySecond = meterSmallLoad(1);
+    TEST_ASSERT_GREATER_THAN(0, once);
+    // Sub-mWs remainders carry over rather than being dropped 60 times
+    TEST_ASSERT_TRUE(everySecond + 1 >= once && everySecond <= once + 1);
+}
+
+void test_reading_resets_interval(void) {
+    FakeWaveform wave;
+    wave.voltageAmplitude = 1000;
+    wave.currentAmplitude = 200;
+    source.setWaveform(wave);
+    runFor(1.0);
+    engine.takeReading();
+
+    // Let the window that straddles the load change close first
+    wave.currentAmplitude = 0;
+    source.setWaveform(wave);
+    runFor(0.2);
+    engine.takeReading();
+
+    runFor(1.0);
+    MeterReading reading = engine.takeReading();
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.0, reading.currentRms);
+    TEST_ASSERT_EQUAL_UINT64(0, reading.energyMws);
+}
+
+void test_load_change_between_readings_is_billed(void) {
+    // A 10 s burst in the middle of a quiet minute must still show up
+    MeterConfig config = testConfig();
+    FakeWaveform wave;
+    wave.voltageAmplitude = 1000;
+    source.setWaveform(wave);
+    runFor(25.0);
+
+    wave.currentAmplitude = 400;
+    source.setWaveform(wave);
+    runFor(10.0);
+    float burstPower = (1000 / sqrtf(2) * config.voltsPerCount) * (400 / sqrtf(2) * config.ampsPerCount);
+
+    wave.currentAmplitude = 0;
+    source.setWaveform(wave);
+    runFor(25.0);
+
+    MeterReading reading = engine.takeReading();
+    double expectedKwh = burstPower * 10.0 / 3600000.0;
+    TEST_ASSERT_FLOAT_WITHIN(expectedKwh * 0.02, expectedKwh, reading.energyKwh);
+}
+
+void test_resistive_load_has_unity_power_factor(void) {
+    FakeWaveform wave;
+    wave.voltageAmplitude = 1000;
+    wave.currentAmplitude = 200;
+    source.setWaveform(wave);
+    runFor(2.0);
+
+    MeterReading reading = engine.takeReading();
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 1.0, reading.powerFactor);
+    TEST_ASSERT_FLOAT_WITHIN(reading.apparentPower * 0.01, reading.apparentPower, reading.realPower);
+}
+
+void test_inductive_load_is_not_overbilled(void) {
+    // Fan/fridge style load: current lags voltage by 60 degrees, PF 0.5
+    MeterConfig config = testConfig();
+    FakeWaveform wave;
+    wave.voltageAmplitude = 1000;
+    wave.currentAmplitude = 300;
+    wave.currentPhaseRad = 60.0 * M_PI / 180.0;
+    source.setWaveform(wave);
+    runFor(60.0);
+
+    MeterReading reading = engine.takeReading();
+    float apparent = (1000 / sqrtf(2) * config.voltsPerCount) * (300 / sqrtf(2) * config.ampsPerCount);
+    TEST_ASSERT_FLOAT_WITHIN(apparent * 0.01, apparent, reading.apparentPower);
+    TEST_ASSERT_FLOAT_WITHIN(apparent * 0.01, apparent * 0.5, reading.realPower);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 0.5, reading.powerFactor);
+    TEST_ASSERT_FLOAT_WITHIN(1.0, 60.0, reading.phaseAngleDeg);
+
+    double expectedKwh = apparent * 0.5 * 60.0 / 3600000.0;
+    TEST_ASSERT_FLOAT_WITHIN(expectedKwh * 0.01, expectedKwh, reading.energyKwh);
+}
+
+void test_windows_lock_to_whole_cycles(void) {
+    FakeWaveform wave;
+    wave.voltageAmplitude = 1000;
+    wave.currentAmplitude = 200;
+    source.setWaveform(wave);
+    runFor(1.05);
+
+    // 50 Hz at 1 kHz: every synced window is exactly 5 cycles = 100 samples
+    MeterReading reading = engine.takeReading();
+    TEST_ASSERT_GREATER_THAN(0, reading.syncedWindows);
+    TEST_ASSERT_EQUAL(reading.windows - 1, reading.syncedWindows);  // start-up partial window
+    runFor(1.0);
+    reading = engine.takeReading();
+    TEST_ASSERT_EQUAL(reading.windows, reading.syncedWindows);
+    TEST_ASSERT_EQUAL(0, reading.samples % 100);
+}
+
+void test_line_frequency_measured(void) {
+    FakeWaveform wave;
+    wave.frequencyHz = 49.3;
+    wave.voltageAmplitude = 1000;
+    source.setWaveform(wave);
+    runFor(5.0);
+
+    MeterReading reading = engine.takeReading();
+    TEST_ASSERT_FLOAT_WITHIN(0.02, 49.3, reading.lineFrequencyHz);
+}
+
+void test_no_voltage_falls_back_to_fixed_windows(void) {
+    FakeWaveform wave;
+    wave.currentAmplitude = 200;
+    source.setWaveform(wave);
+    runFor(1.0);
+
+    MeterReading reading = engine.takeReading();
+    TEST_ASSERT_EQUAL(0, reading.syncedWindows);
+    TEST_ASSERT_GREATER_THAN(0, reading.windows);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.0, reading.lineFrequencyHz);
+}
+
+void test_short_readings_are_stable(void) {
+    // Off-nominal frequency so a fixed sample count would cut cycles
+    MeterConfig config = testConfig();
+    FakeWaveform wave;
+    wave.frequencyHz = 49.7;
+    wave.voltageAmplitude = 1000;
+    wave.currentAmplitude = 150;
+    source.setWaveform(wave);
+    runFor(0.5);
+    engine.takeReading();
+
+    float expected = 150 / sqrtf(2) * config.ampsPerCount;
+    for (int k = 0; k < 10; k++) {
+        runFor(0.333);
+        MeterReading reading = engine.takeReading();
+        TEST_ASSERT_FLOAT_WITHIN(expected * 0.0025, expected, reading.currentRms);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_ring_fifo_order);
+    RUN_TEST(test_ring_counts_overruns);
+    RUN_TEST(test_zero_signal_reads_zero);
+    RUN_TEST(test_rms_of_known_sine);
+    RUN_TEST(test_energy_integrated_over_whole_interval);
+    RUN_TEST(test_split_readings_lose_no_energy);
+    RUN_TEST(test_reading_resets_interval);
+    RUN_TEST(test_load_change_between_readings_is_billed);
+    RUN_TEST(test_resistive_load_has_unity_power_factor);
+    RUN_TEST(test_inductive_load_is_not_overbilled);
+    RUN_TEST(test_windows_lock_to_whole_cycles);
+    RUN_TEST(test_line_frequency_measured);
+    RUN_TEST(test_no_voltage_falls_back_to_fixed_windows);
+    RUN_TEST(test_short_readings_are_stable);
+
+    return UNITY_END();
+}
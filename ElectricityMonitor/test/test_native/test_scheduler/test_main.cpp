@@ -0,0 +1,215 @@
+#include <unity.h>
+#include <LedPattern.h>
+#include <MonitorScheduler.h>
+
+MonitorScheduler scheduler;
+SchedulerInputs online;
+SchedulerInputs offline;
+SchedulerInputs streaming;
+
+void setUp(void) {
+    online.wifiConnected = true;
+    online.firebaseReady = true;
+    online.creditCheckAllowed = true;
+    online.readingQueued = false;
+    offline = SchedulerInputs();
+    streaming = online;
+    streaming.creditStreamLive = true;
+    scheduler.configure(SchedulerConfig());
+    scheduler.begin(0);
+}
+
+void tearDown(void) {}
+
+// Poll every 10 ms like the network task does until something other than NONE comes back
+static MonitorAction nextAction(uint32_t &now, const SchedulerInputs &inputs, uint32_t limitMs) {
+    uint32_t end = now + limitMs;
+    for (; now <= end; now += 10) {
+        MonitorAction action = scheduler.poll(now, inputs);
+        if (action != ACTION_NONE) return action;
+    }
+    return ACTION_NONE;
+}
+
+void test_online_start_checks_credit_first(void) {
+    uint32_t now = 0;
+    TEST_ASSERT_EQUAL(ACTION_LINK_UP, scheduler.poll(now, online));
+    TEST_ASSERT_EQUAL(ACTION_CREDIT_REQUEST, scheduler.poll(now, online));
+    TEST_ASSERT_EQUAL(STATE_CREDIT_CHECK, scheduler.state());
+
+    // Waiting on the answer never blocks; the callback ends the wait
+    TEST_ASSERT_EQUAL(ACTION_NONE, scheduler.poll(500, online));
+    scheduler.creditAnswered();
+    TEST_ASSERT_EQUAL(ACTION_STREAM_OPEN, scheduler.poll(510, online));
+    TEST_ASSERT_EQUAL(STATE_IDLE, scheduler.state());
+}
+
+void test_credit_check_times_out(void) {
+    uint32_t now = 0;
+    scheduler.poll(now, online);
+    TEST_ASSERT_EQUAL(ACTION_CREDIT_REQUEST, scheduler.poll(now, online));
+    TEST_ASSERT_EQUAL(ACTION_CREDIT_TIMEOUT, nextAction(now, online, 5000));
+    TEST_ASSERT_EQUAL_UINT32(2000, now);
+    TEST_ASSERT_EQUAL(STATE_IDLE, scheduler.state());
+}
+
+void test_reading_cycle_runs_one_step_per_pass(void) {
+    uint32_t now = 0;
+    scheduler.poll(now, online);
+    scheduler.poll(now, online);
+    scheduler.creditAnswered();
+
+    SchedulerInputs queued = online;
+    queued.readingQueued = true;
+    now = 60000;
+    TEST_ASSERT_EQUAL(ACTION_SAMPLE, scheduler.poll(now, queued));
+    TEST_ASSERT_TRUE(scheduler.inReadingCycle());
+    TEST_ASSERT_EQUAL(ACTION_ROLLOVER, scheduler.poll(now + 10, online));
+    TEST_ASSERT_EQUAL(ACTION_PUBLISH, scheduler.poll(now + 20, online));
+    TEST_ASSERT_EQUAL(STATE_PUBLISH, scheduler.state());
+
+    // The credit check falls due at the same time and comes right after
+    TEST_ASSERT_EQUAL(ACTION_CREDIT_REQUEST, scheduler.poll(now + 30, online));
+}
+
+void test_readings_continue_offline(void) {
+    SchedulerInputs queued = offline;
+    uint32_t now = 0;
+    int samples = 0;
+    int connects = 0;
+    for (; now < 180000; now += 10) {
+        // The metering task queues one a minute
+        queued.readingQueued = now % 60000 == 0 && now > 0;
+        MonitorAction action = scheduler.poll(now, queued);
+        if (action == ACTION_SAMPLE) samples++;
+        if (action == ACTION_CONNECT) connects++;
+        TEST_ASSERT_NOT_EQUAL(ACTION_CREDIT_REQUEST, action);
+    }
+    TEST_ASSERT_EQUAL(2, samples);
+    TEST_ASSERT_EQUAL(17, connects);  // every 10 s, first one after setup()'s attempt
+    TEST_ASSERT_EQUAL(STATE_CONNECT, scheduler.state());
+}
+
+void test_link_changes_are_reported_once(void) {
+    uint32_t now = 0;
+    TEST_ASSERT_EQUAL(ACTION_LINK_UP, scheduler.poll(now, online));
+    scheduler.poll(now, online);
+    scheduler.creditAnswered();
+
+    TEST_ASSERT_EQUAL(ACTION_LINK_DOWN, scheduler.poll(100, offline));
+    TEST_ASSERT_EQUAL(ACTION_NONE, scheduler.poll(110, offline));
+
+    // The next retry waits a full interval after the drop
+    uint32_t t = 120;
+    TEST_ASSERT_EQUAL(ACTION_CONNECT, nextAction(t, offline, 20000));
+    TEST_ASSERT_EQUAL_UINT32(10100, t);
+
+    TEST_ASSERT_EQUAL(ACTION_LINK_UP, scheduler.poll(t + 10, online));
+}
+
+void test_credit_check_held_while_not_allowed(void) {
+    SchedulerInputs busy = streaming;
+    busy.creditCheckAllowed = false;
+    uint32_t now = 0;
+    scheduler.poll(now, busy);
+    TEST_ASSERT_EQUAL(ACTION_NONE, nextAction(now, busy, 30000));
+    TEST_ASSERT_EQUAL(ACTION_CREDIT_REQUEST, scheduler.poll(now, streaming));
+}
+
+void test_forced_credit_check(void) {
+    uint32_t now = 0;
+    scheduler.poll(now, online);
+    scheduler.poll(now, online);
+    scheduler.creditAnswered();
+    TEST_ASSERT_EQUAL(ACTION_NONE, scheduler.poll(1000, streaming));
+
+    scheduler.requestCreditCheck();
+    TEST_ASSERT_EQUAL(ACTION_CREDIT_REQUEST, scheduler.poll(1010, streaming));
+}
+
+void test_stream_retries_until_live(void) {
+    uint32_t now = 0;
+    scheduler.poll(now, online);
+    scheduler.poll(now, online);
+    scheduler.creditAnswered();
+    TEST_ASSERT_EQUAL(ACTION_STREAM_OPEN, scheduler.poll(10, online));
+
+    // No event yet: reopened every 30 s, with the minute poll still running
+    now = 20;
+    TEST_ASSERT_EQUAL(ACTION_STREAM_OPEN, nextAction(now, online, 40000));
+    TEST_ASSERT_EQUAL_UINT32(30010, now);
+
+    // Once events flow it is left alone
+    now += 10;
+    int opens = 0;
+    for (; now < 200000; now += 10) {
+        MonitorAction action = scheduler.poll(now, streaming);
+        if (action == ACTION_STREAM_OPEN) opens++;
+        if (action == ACTION_CREDIT_REQUEST) scheduler.creditAnswered();
+    }
+    TEST_ASSERT_EQUAL(0, opens);
+}
+
+void test_live_stream_slows_poll_to_fallback(void) {
+    uint32_t now = 0;
+    int checks = 0;
+    for (; now < 1800000; now += 10) {
+        if (scheduler.poll(now, streaming) == ACTION_CREDIT_REQUEST) {
+            checks++;
+            scheduler.creditAnswered();
+        }
+    }
+    TEST_ASSERT_EQUAL(3, checks);  // at start, then every 10 minutes
+}
+
+void test_link_up_reopens_stream(void) {
+    uint32_t now = 0;
+    scheduler.poll(now, streaming);
+    scheduler.poll(now, streaming);
+    scheduler.creditAnswered();
+    TEST_ASSERT_EQUAL(ACTION_NONE, scheduler.poll(10, streaming));
+
+    TEST_ASSERT_EQUAL(ACTION_LINK_DOWN, scheduler.poll(20, offline));
+    TEST_ASSERT_EQUAL(ACTION_LINK_UP, scheduler.poll(30, online));
+    TEST_ASSERT_EQUAL(ACTION_STREAM_OPEN, scheduler.poll(40, online));
+}
+
+void test_led_pattern_blinks_then_idles(void) {
+    LedPattern led(true);
+    TEST_ASSERT_TRUE(led.levelAt(0));
+
+    led.blink(2, 100, 1000);
+    TEST_ASSERT_TRUE(led.busy(1000));
+    TEST_ASSERT_FALSE(led.levelAt(1000));
+    TEST_ASSERT_FALSE(led.levelAt(1099));
+    TEST_ASSERT_TRUE(led.levelAt(1100));
+    TEST_ASSERT_FALSE(led.levelAt(1200));
+    TEST_ASSERT_TRUE(led.levelAt(1399));
+    TEST_ASSERT_FALSE(led.busy(1400));
+    TEST_ASSERT_TRUE(led.levelAt(5000));
+
+    // A new pattern replaces the running one
+    led.blink(3, 500, 2000);
+    led.blink(1, 50, 2100);
+    TEST_ASSERT_FALSE(led.levelAt(2120));
+    TEST_ASSERT_TRUE(led.levelAt(2160));
+    TEST_ASSERT_FALSE(led.busy(2200));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_online_start_checks_credit_first);
+    RUN_TEST(test_credit_check_times_out);
+    RUN_TEST(test_reading_cycle_runs_one_step_per_pass);
+    RUN_TEST(test_readings_continue_offline);
+    RUN_TEST(test_link_changes_are_reported_once);
+    RUN_TEST(test_credit_check_held_while_not_allowed);
+    RUN_TEST(test_forced_credit_check);
+    RUN_TEST(test_stream_retries_until_live);
+    RUN_TEST(test_live_stream_slows_poll_to_fallback);
+    RUN_TEST(test_link_up_reopens_stream);
+    RUN_TEST(test_led_pattern_blinks_then_idles);
+
+    return UNITY_END();
+}
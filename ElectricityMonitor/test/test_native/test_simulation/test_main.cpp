@@ -0,0 +1,468 @@
+#include <unity.h>
+#include <math.h>
+#include <stdlib.h>
+#include <time.h>
+#include <MonitorSim.h>
+#include <TelemetryPacket.h>
+
+// A household day: a small base load overnight, cooking in the morning and
+// evening, an air conditioner in the afternoon
+static std::vector<LoadStep> householdDay() {
+    std::vector<LoadStep> day;
+    LoadStep steps[] = {
+        { 0, 0.35f, 0.95f },
+        { 6 * 3600, 4.2f, 0.92f },
+        { 8 * 3600 + 1800, 1.1f, 0.90f },
+        { 13 * 3600, 6.5f, 0.82f },
+        { 17 * 3600, 2.0f, 0.88f },
+        { 19 * 3600, 8.4f, 0.93f },
+        { 21 * 3600 + 900, 0.9f, 0.95f },
+    };
+    day.assign(steps, steps + sizeof(steps) / sizeof(steps[0]));
+    return day;
+}
+
+static double serverUnits(MonitorSim &sim) {
+    return sim.rtdb().number(sim.unitPath() + "remaining_units");
+}
+
+static void giveCredit(MonitorSim &sim, double kwh) {
+    sim.rtdb().set(sim.unitPath() + "remaining_units", kwh);
+    sim.rtdb().set(sim.unitPath() + "remaining_credit", kwh * sim.config().monitor.costPerKwh);
+}
+
+void setUp(void) {
+    setenv("TZ", "UTC0", 1);
+    tzset();
+}
+
+void tearDown(void) {}
+
+void test_day_of_metering_matches_the_load(void) {
+    MonitorSim sim;
+    sim.setLoad(householdDay());
+    giveCredit(sim, 100);
+    sim.start();
+
+    // A reading belongs to the day its midpoint falls in; the first one
+    // past midnight closes the day
+    sim.run(86400);
+    double trueDay = sim.trueEnergyKwh();
+    sim.run(120);
+
+    const std::string daily = sim.unitPath() + "history/daily/2025-11-04/";
+    double metered = sim.rtdb().number(daily + "energy");
+    TEST_ASSERT_FLOAT_WITHIN(trueDay * 0.002, trueDay, metered);
+    // Booted at midnight: a reading a minute, but for the closer ones around
+    // the relay closing and the six steps
+    TEST_ASSERT_EQUAL(1453, (int)sim.rtdb().number(daily + "samples"));
+    // The day's busiest quarter hour: the evening's 8.4 A at 0.93, steady
+    // from 19:00 to 21:15
+    TEST_ASSERT_FLOAT_WITHIN(230 * 8.4 * 0.93 * 0.01, 230 * 8.4 * 0.93, sim.rtdb().number(daily + "peakDemand"));
+    TEST_ASSERT_TRUE(sim.rtdb().number(daily + "peakDemand") <= sim.rtdb().number(daily + "peakPower"));
+
+    // Every hour arrived, and they add up to the day
+    const std::string hourly = sim.unitPath() + "history/hourly/2025-11-04/";
+    for (int hour = 0; hour < 24; hour++) {
+        char leaf[16];
+        snprintf(leaf, sizeof(leaf), "%d/energy", hour);
+        TEST_ASSERT_TRUE(sim.rtdb().has(hourly + leaf));
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.001, metered, sim.rtdb().sumUnder(hourly, "energy"));
+
+    // And each hour's health record with it. 08:30 to 13:00 is a steady
+    // load, so hour 12's cycle updates are its heartbeats, the one that
+    // carried hour 11's records and the step at 13:00 (timed before the
+    // first reading past it closes the hour), not 60 readings.
+    const std::string health = sim.unitPath() + "diagnostics/health/2025-11-04/";
+    for (int hour = 0; hour < 24; hour++) {
+        char leaf[24];
+        snprintf(leaf, sizeof(leaf), "%d/passUs", hour);
+        TEST_ASSERT_TRUE(sim.rtdb().has(health + leaf));
+    }
+    TEST_ASSERT_EQUAL(0, (int)sim.rtdb().number(health + "12/firebaseErrors"));
+    TEST_ASSERT_TRUE(sim.rtdb().number(health + "12/wdtHeadroomMs") > 9000);
+    std::string cycles = sim.rtdb().text(health + "12/rttMs/cycleUpdate");
+    TEST_ASSERT_EQUAL(0, cycles.find("8,"));
+
+    // Billed with server-side increments: what's left on the server is what
+    // the ledger says, less anything not yet acknowledged
+    double ledgerKwh = CreditLedger::toKwh(sim.app().ledger().balanceMws());
+    double unbilledKwh = CreditLedger::toKwh(sim.app().ledger().unbilledMws());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, ledgerKwh + unbilledKwh, serverUnits(sim));
+    TEST_ASSERT_FLOAT_WITHIN(trueDay * 0.003, 100 - sim.trueEnergyKwh(), ledgerKwh);
+    TEST_ASSERT_TRUE(sim.platform().relay());
+}
+
+void test_outage_is_replayed_after_the_link_returns(void) {
+    MonitorSim sim;
+    sim.setLoad(householdDay());
+    giveCredit(sim, 100);
+    sim.start();
+
+    sim.run(2 * 3600);
+    uint32_t before = sim.readingsQueued();
+    sim.platform().setLinkUp(false);
+    sim.run(3 * 3600);
+    uint32_t offline = sim.readingsQueued() - before;
+    sim.platform().setLinkUp(true);
+    sim.run(1800);
+
+    // Each logged minute lands under history/minutes/ with four fields: the
+    // ones taken offline, and the one in flight when the link dropped
+    size_t minuteFields = sim.rtdb().countUnder(sim.unitPath() + "history/minutes/");
+    TEST_ASSERT_EQUAL((offline + 1) * 4, minuteFields);
+
+    // The hours closed while offline came up too
+    TEST_ASSERT_TRUE(sim.rtdb().has(sim.unitPath() + "history/hourly/2025-11-04/3/energy"));
+    TEST_ASSERT_TRUE(sim.rtdb().has(sim.unitPath() + "history/hourly/2025-11-04/4/energy"));
+
+    double ledgerKwh = CreditLedger::toKwh(sim.app().ledger().balanceMws());
+    double unbilledKwh = CreditLedger::toKwh(sim.app().ledger().unbilledMws());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, ledgerKwh + unbilledKwh, serverUnits(sim));
+}
+
+// No telemetry log to lean on (LittleFS didn't mount): an hour closed offline
+// is held in RAM, with its profile, rollups and health, until the link is back
+void test_hours_without_a_log_wait_for_the_link(void) {
+    SimConfig config;
+    config.logPath = "/nonexistent/emonitor_sim.log";
+    config.cursorPath = "/nonexistent/emonitor_sim.pos";
+    MonitorSim sim(config);
+    sim.setLoad(householdDay());
+    giveCredit(sim, 100);
+    sim.start();
+
+    sim.run(1800);
+    sim.platform().setLinkUp(false);
+    sim.run(3600);
+    TEST_ASSERT_EQUAL(0, sim.rtdb().countUnder(sim.unitPath() + "history/hourly/"));
+    sim.platform().setLinkUp(true);
+    sim.run(600);
+
+    TEST_ASSERT_TRUE(sim.rtdb().has(sim.unitPath() + "history/hourly/2025-11-04/0/energy"));
+    TEST_ASSERT_TRUE(sim.rtdb().has(sim.unitPath() + "history/daily/2025-11-04/energy"));
+    TEST_ASSERT_TRUE(sim.rtdb().has(sim.unitPath() + "diagnostics/health/2025-11-04/0/passUs"));
+}
+
+// Offline around a step the readings come seconds apart; each minute still
+// goes up as one history/minutes/ record, and none of their energy is lost
+// to two readings landing on the same key
+void test_offline_minutes_merge_closer_readings(void) {
+    MonitorSim sim;
+    std::vector<LoadStep> load;
+    LoadStep base = { 0, 0.35f, 0.95f };
+    LoadStep kettle = { 1800 + 30, 8.7f, 1.0f };
+    LoadStep off = { 1800 + 330, 0.35f, 0.95f };
+    load.push_back(base);
+    load.push_back(kettle);
+    load.push_back(off);
+    sim.setLoad(load);
+    giveCredit(sim, 100);
+    sim.start();
+
+    sim.run(1200);
+    double before = CreditLedger::toKwh(sim.app().ledger().balanceMws());
+    sim.platform().setLinkUp(false);
+    sim.run(1200);
+    double offlineKwh = before - CreditLedger::toKwh(sim.app().ledger().balanceMws());
+    sim.platform().setLinkUp(true);
+    sim.run(600);
+
+    // 20 minutes offline and the one in flight at the drop, however many
+    // readings they took
+    const std::string minutes = sim.unitPath() + "history/minutes/";
+    TEST_ASSERT_TRUE(sim.rtdb().countUnder(minutes) <= 21 * 4);
+    // The in-flight minute was taken off the ledger before the drop
+    TEST_ASSERT_FLOAT_WITHIN(0.002, offlineKwh, sim.rtdb().sumUnder(minutes, "energy"));
+    TEST_ASSERT_TRUE(offlineKwh > 0.15);
+}
+
+// Bytes sent in the ten minutes after a 90 minute outage across an hour
+static uint64_t runOutage(MonitorSim &sim) {
+    sim.setLoad(householdDay());
+    giveCredit(sim, 100);
+    sim.start();
+    sim.run(5400);
+    sim.platform().setLinkUp(false);
+    sim.run(5400);
+    sim.platform().setLinkUp(true);
+    uint64_t before = sim.rtdb().bytesReceived();
+    sim.run(600);
+    return sim.rtdb().bytesReceived() - before;
+}
+
+// The same outage replayed as TelemetryPackets: every minute and the hour
+// arrive, in a fraction of the bytes the JSON fields take
+void test_outage_replays_as_packets(void) {
+    MonitorSim plain;
+    uint64_t plainBytes = runOutage(plain);
+
+    SimConfig config;
+    config.monitor.packedHistory = true;
+    MonitorSim sim(config);
+    uint64_t packedBytes = runOutage(sim);
+
+    TEST_ASSERT_EQUAL(0, sim.rtdb().countUnder(sim.unitPath() + "history/minutes/"));
+    TEST_ASSERT_FALSE(sim.rtdb().has(sim.unitPath() + "history/hourly/2025-11-04/2/energy"));
+    std::vector<std::string> packets = sim.rtdb().pathsUnder(sim.unitPath() + "history/packed/2025-11-04/");
+    TEST_ASSERT_TRUE(packets.size() > 0);
+
+    size_t minutes = 0;
+    double minuteKwh = 0;
+    bool hourTwo = false;
+    for (size_t k = 0; k < packets.size(); k++) {
+        static TelemetryFrame frames[256];
+        size_t n = decodeTelemetryPacket(sim.rtdb().text(packets[k]).c_str(), frames, 256);
+        TEST_ASSERT_TRUE(n > 0);
+        for (size_t f = 0; f < n; f++) {
+            if (frames[f].type == RECORD_MINUTE) {
+                MinuteRecord minute;
+                TEST_ASSERT_TRUE(minute.decode(frames[f].payload, frames[f].length));
+                minutes++;
+                minuteKwh += minute.energyKwh();
+            } else if (frames[f].type == RECORD_HOURLY) {
+                HourlyRecord hour;
+                TEST_ASSERT_TRUE(hour.decode(frames[f].payload, frames[f].length));
+                hourTwo = hourTwo || hour.hour == 2;
+            }
+        }
+    }
+    // The offline minutes and the one in flight when the link dropped, as
+    // in test_outage_is_replayed_after_the_link_returns
+    TEST_ASSERT_EQUAL(plain.rtdb().countUnder(plain.unitPath() + "history/minutes/") / 4, minutes);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, plain.rtdb().sumUnder(plain.unitPath() + "history/minutes/", "energy"),
+                             minuteKwh);
+    TEST_ASSERT_TRUE(hourTwo);
+    // Health records, profiles, the event log and the live cycles go up as
+    // before, so the whole window shrinks less than the history does
+    TEST_ASSERT_TRUE(packedBytes * 2 < plainBytes);
+}
+
+// Report by exception: a steady overnight load goes up on its heartbeat,
+// and a kettle switching on shows within seconds instead of at the next
+// minute's reading
+void test_steady_load_publishes_only_changes(void) {
+    MonitorSim sim;
+    std::vector<LoadStep> night;
+    LoadStep base = { 0, 0.35f, 0.95f };
+    LoadStep kettle = { 4800 + 30, 8.7f, 1.0f };   // 2 kW at 01:20:30
+    night.push_back(base);
+    night.push_back(kettle);
+    sim.setLoad(night);
+    giveCredit(sim, 100);
+    sim.start();
+
+    sim.run(4800 + 30);
+    // 80 minutes of readings, and the first hour's records, in a handful
+    // of updates
+    uint32_t quiet = sim.platform().updatesSent();
+    TEST_ASSERT_TRUE(quiet < 20);
+    TEST_ASSERT_FLOAT_WITHIN(10, 230 * 0.35f * 0.95f, sim.rtdb().number(sim.unitPath() + "power"));
+
+    // The step closes the reading before it, which goes up too
+    sim.run(5);
+    TEST_ASSERT_FLOAT_WITHIN(20, 2001, sim.rtdb().number(sim.unitPath() + "power"));
+    TEST_ASSERT_EQUAL(quiet + 2, sim.platform().updatesSent());
+
+    // Everything consumed is still billed, with the updates that do go up
+    sim.run(1800);
+    double ledgerKwh = CreditLedger::toKwh(sim.app().ledger().balanceMws());
+    double unbilledKwh = CreditLedger::toKwh(sim.app().ledger().unbilledMws());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, ledgerKwh + unbilledKwh, serverUnits(sim));
+    TEST_ASSERT_TRUE(unbilledKwh < 100 - ledgerKwh);
+}
+
+// With the policy off every reading goes up, as it used to
+void test_publish_policy_off_sends_every_reading(void) {
+    SimConfig config;
+    config.monitor.publish.enabled = false;
+    MonitorSim sim(config);
+    LoadStep base = { 0, 0.35f, 0.95f };
+    sim.setLoad(std::vector<LoadStep>(1, base));
+    giveCredit(sim, 100);
+    sim.start();
+
+    sim.run(1800 + 5);
+    TEST_ASSERT_GREATER_OR_EQUAL(30, sim.platform().updatesSent());
+    // Billed in whole micro-kWh
+    TEST_ASSERT_LESS_THAN(3600, sim.app().ledger().unbilledMws());
+}
+
+// A few watts billed every minute is well under a kobo each time: the
+// server's units and credit still add up to what the ledger billed
+void test_small_bills_add_up_on_the_server(void) {
+    SimConfig config;
+    config.monitor.publish.enabled = false;
+    MonitorSim sim(config);
+    LoadStep charger = { 0, 0.02f, 1.0f };   // ~4.6 W
+    sim.setLoad(std::vector<LoadStep>(1, charger));
+    giveCredit(sim, 100);
+    sim.start();
+
+    sim.run(2 * 3600 + 5);
+    const CreditLedger &ledger = sim.app().ledger();
+    TEST_ASSERT_GREATER_OR_EQUAL(100, sim.platform().updatesSent());
+    TEST_ASSERT_LESS_THAN(3600, ledger.unbilledMws());
+
+    double billedKwh = CreditLedger::toKwh(ledger.state().billedMws);
+    double costPerKwh = sim.config().monitor.costPerKwh;
+    TEST_ASSERT_TRUE(billedKwh * costPerKwh > 0.2);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 100 - billedKwh, serverUnits(sim));
+    double serverCredit = sim.rtdb().number(sim.unitPath() + "remaining_credit");
+    TEST_ASSERT_FLOAT_WITHIN(0.0101, (100 - billedKwh) * costPerKwh, serverCredit);
+}
+
+// remaining_units past a float's seven digits: 50 kWh credited less
+// 12.345677 kWh billed is read back as exactly what the ledger expects,
+// so the poll is no top-up and saves nothing
+void test_remaining_units_reconcile_exactly(void) {
+    MonitorSim sim;
+    LoadStep off = { 0, 0, 1.0f };
+    sim.setLoad(std::vector<LoadStep>(1, off));
+    uint64_t credited = CreditLedger::toMws(50);
+    uint64_t billed = CreditLedger::toMws(12.345677);
+    sim.platform().saveU64("ldgCreditMws", credited);
+    sim.platform().saveU64("ldgConsumeMws", billed);
+    sim.platform().saveU64("ldgBilledMws", billed);
+    sim.rtdb().set(sim.unitPath() + "remaining_units", 50 - 12.345677);
+    sim.start();
+
+    sim.run(30);
+    TEST_ASSERT_GREATER_THAN(0, sim.platform().creditRequests());
+    TEST_ASSERT_EQUAL_UINT64(credited, sim.app().ledger().state().creditedMws);
+    TEST_ASSERT_EQUAL_UINT64(billed, sim.app().ledger().state().billedMws);
+}
+
+void test_credit_runs_out_and_a_top_up_restores_it(void) {
+    MonitorSim sim;
+    LoadStep heater = { 0, 8.0f, 1.0f };   // 1.84 kW
+    sim.setLoad(std::vector<LoadStep>(1, heater));
+    giveCredit(sim, 0.5);
+    sim.start();
+
+    sim.run(30 * 60);
+    TEST_ASSERT_FALSE(sim.platform().relay());
+    TEST_ASSERT_FALSE(sim.app().relayOn());
+    // Cut off at the first reading past zero: at most a minute's overdraw
+    TEST_ASSERT_GREATER_OR_EQUAL(-1.84 / 60 - 0.001, serverUnits(sim));
+    TEST_ASSERT_FLOAT_WITHIN(0.035, 0.5, sim.trueEnergyKwh());
+
+    // The dashboard top-up reaches the relay over the stream, not the next poll
+    sim.platform().topUp(sim.unitPath(), 2.0, sim.config().monitor.costPerKwh);
+    sim.run(2);
+    TEST_ASSERT_TRUE(sim.platform().relay());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, serverUnits(sim),
+                             CreditLedger::toKwh(sim.app().ledger().balanceMws()));
+}
+
+void test_reboot_keeps_the_ledger_and_totals(void) {
+    MonitorSim sim;
+    sim.setLoad(householdDay());
+    giveCredit(sim, 50);
+    sim.start();
+
+    sim.run(7 * 3600 + 30);
+    double dayBefore = sim.app().dailyTotals().energyKwh();
+    double balanceBefore = CreditLedger::toKwh(sim.app().ledger().balanceMws());
+    TEST_ASSERT_GREATER_THAN(0, dayBefore);
+
+    sim.reboot();
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, dayBefore, sim.app().dailyTotals().energyKwh());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, balanceBefore, CreditLedger::toKwh(sim.app().ledger().balanceMws()));
+    TEST_ASSERT_TRUE(sim.platform().relay());
+
+    // The reading timer restarts at boot, so hour 7 closes half a minute late
+    sim.run(3600 + 60);
+    TEST_ASSERT_GREATER_THAN(dayBefore, sim.app().dailyTotals().energyKwh());
+}
+
+// The clock stalls, and NTP puts it right two days on: the first reading
+// after closes hour 1 and the 46 empty hours behind it. Only hour 1 is
+// logged and saved, so the catch-up costs about an ordinary hour's writes.
+void test_stalled_clock_catches_up_cheaply(void) {
+    MonitorSim sim;
+    sim.setLoad(householdDay());
+    giveCredit(sim, 50);
+    sim.start();
+
+    sim.run(3600 + 30);
+    uint32_t before = sim.platform().nvsWrites();
+    sim.run(3600);
+    uint32_t hourWrites = sim.platform().nvsWrites() - before;
+
+    sim.platform().jumpClock(2 * 86400 - 7200);
+    before = sim.platform().nvsWrites();
+    sim.run(3600);
+    // The day rolls over too; each empty hour saved would have cost the
+    // rollups' two writes
+    TEST_ASSERT_LESS_THAN(hourWrites + 10, sim.platform().nvsWrites() - before);
+
+    sim.run(60);
+
+    const std::string hourly = sim.unitPath() + "history/hourly/";
+    TEST_ASSERT_TRUE(sim.rtdb().has(hourly + "2025-11-04/1/energy"));
+    TEST_ASSERT_EQUAL(0, sim.rtdb().countUnder(hourly + "2025-11-05/"));
+    TEST_ASSERT_TRUE(sim.rtdb().has(hourly + "2025-11-06/0/energy"));
+    TEST_ASSERT_EQUAL_UINT32(20251106, sim.app().dailyTotals().period);
+}
+
+void test_failed_updates_lose_nothing(void) {
+    MonitorSim sim;
+    sim.setLoad(householdDay());
+    giveCredit(sim, 100);
+    sim.start();
+
+    sim.run(600);
+    sim.platform().failUpdates(4);
+    sim.run(3600);
+
+    TEST_ASSERT_EQUAL(4, sim.platform().updatesFailed());
+    double ledgerKwh = CreditLedger::toKwh(sim.app().ledger().balanceMws());
+    double unbilledKwh = CreditLedger::toKwh(sim.app().ledger().unbilledMws());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, ledgerKwh + unbilledKwh, serverUnits(sim));
+    TEST_ASSERT_TRUE(sim.rtdb().has(sim.unitPath() + "history/hourly/2025-11-04/0/energy"));
+}
+
+void test_calibration_pushed_from_the_database(void) {
+    MonitorSim sim;
+    LoadStep heater = { 0, 4.0f, 1.0f };
+    sim.setLoad(std::vector<LoadStep>(1, heater));
+    giveCredit(sim, 100);
+    // The sensor reads 10% low on this unit
+    sim.rtdb().set(sim.unitPath() + "calibration", std::string("i 0 1.1"));
+    sim.start();
+
+    sim.run(1800);
+    double truth = sim.trueEnergyKwh();
+    sim.run(5);   // the reading at 00:30 reaches the ledger
+    double consumed = 100 - CreditLedger::toKwh(sim.app().ledger().balanceMws());
+    TEST_ASSERT_FLOAT_WITHIN(truth * 0.005, truth * 1.1, consumed);
+    TEST_ASSERT_EQUAL(1, sim.app().calibration().current.count);
+
+    // Kept in NVS, so it applies from the first sample after a reboot
+    sim.rtdb().set(sim.unitPath() + "calibration", std::string(""));
+    sim.reboot();
+    TEST_ASSERT_EQUAL_FLOAT(1.1f, sim.app().calibration().current.points[0].gain);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_day_of_metering_matches_the_load);
+    RUN_TEST(test_outage_is_replayed_after_the_link_returns);
+    RUN_TEST(test_hours_without_a_log_wait_for_the_link);
+    RUN_TEST(test_offline_minutes_merge_closer_readings);
+    RUN_TEST(test_outage_replays_as_packets);
+    RUN_TEST(test_steady_load_publishes_only_changes);
+    RUN_TEST(test_publish_policy_off_sends_every_reading);
+    RUN_TEST(test_small_bills_add_up_on_the_server);
+    RUN_TEST(test_remaining_units_reconcile_exactly);
+    RUN_TEST(test_credit_runs_out_and_a_top_up_restores_it);
+    RUN_TEST(test_reboot_keeps_the_ledger_and_totals);
+    RUN_TEST(test_stalled_clock_catches_up_cheaply);
+    RUN_TEST(test_failed_updates_lose_nothing);
+    RUN_TEST(test_calibration_pushed_from_the_database);
+
+    return UNITY_END();
+}
@@ -0,0 +1,341 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <TelemetryLog.h>
+#include <TelemetryRecord.h>
+
+static const char *LOG_PATH = "test_telemetry.log";
+static const char *CURSOR_PATH = "test_telemetry.pos";
+
+static void removeFiles(void) {
+    remove(LOG_PATH);
+    remove(CURSOR_PATH);
+}
+
+static MinuteRecord minuteAt(uint32_t epoch) {
+    MinuteRecord record;
+    record.epoch = epoch;
+    record.energyUwh = 1000 + epoch;
+    record.powerDw = 600;
+    record.flags = MINUTE_RELAY_ON;
+    return record;
+}
+
+static bool appendMinute(TelemetryLog &log, uint32_t epoch) {
+    uint8_t payload[MinuteRecord::ENCODED_SIZE];
+    uint8_t length = minuteAt(epoch).encode(payload);
+    return log.append(RECORD_MINUTE, payload, length);
+}
+
+// Replays everything pending and returns the epochs in order
+static size_t replayEpochs(TelemetryLog &log, uint32_t *epochs, size_t max) {
+    TelemetryFrame frame;
+    uint32_t offset = log.cursor();
+    size_t count = 0;
+    while (count < max && log.read(offset, &frame, 1) == 1) {
+        MinuteRecord record;
+        TEST_ASSERT_TRUE(record.decode(frame.payload, frame.length));
+        epochs[count++] = record.epoch;
+    }
+    return count;
+}
+
+static long sizeOnDisk(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr) return -1;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+void setUp(void) {
+    removeFiles();
+}
+
+void tearDown(void) {
+    removeFiles();
+    remove("test_telemetry.pos.tmp");
+}
+
+void test_records_round_trip(void) {
+    uint8_t buffer[TelemetryFrame::MAX_PAYLOAD];
+
+    MinuteRecord minute = minuteAt(1730728800);
+    minute.currentMa = 2710;
+    minute.voltageDv = 2301;
+    TEST_ASSERT_EQUAL(MinuteRecord::ENCODED_SIZE, minute.encode(buffer));
+    MinuteRecord minuteCopy;
+    TEST_ASSERT_TRUE(minuteCopy.decode(buffer, MinuteRecord::ENCODED_SIZE));
+    TEST_ASSERT_EQUAL_UINT32(minute.epoch, minuteCopy.epoch);
+    TEST_ASSERT_EQUAL_UINT32(minute.energyUwh, minuteCopy.energyUwh);
+    TEST_ASSERT_EQUAL(2710, minuteCopy.currentMa);
+    TEST_ASSERT_EQUAL(2301, minuteCopy.voltageDv);
+    TEST_ASSERT_EQUAL(MINUTE_RELAY_ON, minuteCopy.flags);
+
+    HourlyRecord hourly;
+    hourly.date = 20251104;
+    hourly.hour = 23;
+    hourly.samples = 60;
+    hourly.energyMwh = toFixedU32(0.4125f, 1e6f);
+    hourly.peakPowerDw = toFixedU32(1830.55f, 10);
+    hourly.powerFactorPermille = toFixedU16(0.915f, 1000);
+    TEST_ASSERT_EQUAL(HourlyRecord::ENCODED_SIZE, hourly.encode(buffer));
+    HourlyRecord hourlyCopy;
+    TEST_ASSERT_TRUE(hourlyCopy.decode(buffer, HourlyRecord::ENCODED_SIZE));
+    TEST_ASSERT_EQUAL_UINT32(20251104, hourlyCopy.date);
+    TEST_ASSERT_EQUAL(23, hourlyCopy.hour);
+    TEST_ASSERT_EQUAL(60, hourlyCopy.samples);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.4125, hourlyCopy.energyKwh());
+    TEST_ASSERT_EQUAL_UINT32(18306, hourlyCopy.peakPowerDw);
+    TEST_ASSERT_EQUAL(915, hourlyCopy.powerFactorPermille);
+
+    // Wrong length is rejected, not misread
+    TEST_ASSERT_FALSE(hourlyCopy.decode(buffer, MinuteRecord::ENCODED_SIZE));
+
+    RollupRecord month;
+    month.kind = ROLLUP_MONTH;
+    month.totals.period = 202511;
+    month.totals.samples = 43200;
+    month.totals.energyMws = 5000000000000ULL;   // ~1389 kWh, past 32 bits
+    month.totals.seconds = 2592000;
+    month.totals.peakPowerDw = 45210;
+    month.totals.peakDemandDw = 31870;
+    TEST_ASSERT_EQUAL(RollupRecord::ENCODED_SIZE, month.encode(buffer));
+    RollupRecord monthCopy;
+    TEST_ASSERT_TRUE(monthCopy.decode(buffer, RollupRecord::ENCODED_SIZE));
+    TEST_ASSERT_EQUAL(ROLLUP_MONTH, monthCopy.kind);
+    TEST_ASSERT_EQUAL_UINT32(202511, monthCopy.totals.period);
+    TEST_ASSERT_EQUAL_UINT64(5000000000000ULL, monthCopy.totals.energyMws);
+    TEST_ASSERT_EQUAL_UINT32(2592000, monthCopy.totals.seconds);
+    TEST_ASSERT_EQUAL_UINT32(45210, monthCopy.totals.peakPowerDw);
+    TEST_ASSERT_EQUAL_UINT32(31870, monthCopy.totals.peakDemandDw);
+
+    buffer[0] = 7;   // unknown period kind
+    TEST_ASSERT_FALSE(monthCopy.decode(buffer, RollupRecord::ENCODED_SIZE));
+
+    ProfileRecord profile;
+    profile.date = 20251104;
+    profile.hour = 9;
+    profile.part = 1;
+    profile.length = ProfileRecord::MAX_DATA;
+    for (uint8_t k = 0; k < profile.length; k++) profile.data[k] = k;
+    uint8_t length = profile.encode(buffer);
+    TEST_ASSERT_EQUAL(TelemetryFrame::MAX_PAYLOAD, length);
+    ProfileRecord profileCopy;
+    TEST_ASSERT_TRUE(profileCopy.decode(buffer, length));
+    TEST_ASSERT_EQUAL_UINT32(20251104, profileCopy.date);
+    TEST_ASSERT_EQUAL(1, profileCopy.part);
+    TEST_ASSERT_EQUAL(ProfileRecord::MAX_DATA, profileCopy.length);
+    TEST_ASSERT_EQUAL_MEMORY(profile.data, profileCopy.data, profile.length);
+
+    HealthRecord health;
+    health.date = 20251104;
+    health.hour = 23;
+    health.passUs.count = 12000;
+    health.passUs.p99 = 4095;
+    health.passUs.max = 38211;
+    health.roundTripMs[RTT_REPLAY_UPDATE].p90 = 1023;
+    health.heapLowWater = 91324;
+    health.maxConsecutiveErrors = 4;
+    health.queueHighWater = 3;
+    health.savedAt = 1762300800;
+    TEST_ASSERT_EQUAL(HealthRecord::ENCODED_SIZE, health.encode(buffer));
+    TEST_ASSERT_TRUE(HealthRecord::ENCODED_SIZE <= TelemetryFrame::MAX_PAYLOAD);
+    HealthRecord healthCopy;
+    TEST_ASSERT_TRUE(healthCopy.decode(buffer, HealthRecord::ENCODED_SIZE));
+    TEST_ASSERT_EQUAL(23, healthCopy.hour);
+    TEST_ASSERT_EQUAL_UINT32(12000, healthCopy.passUs.count);
+    TEST_ASSERT_EQUAL_UINT32(4095, healthCopy.passUs.p99);
+    TEST_ASSERT_EQUAL_UINT32(38211, healthCopy.passUs.max);
+    TEST_ASSERT_EQUAL_UINT32(1023, healthCopy.roundTripMs[RTT_REPLAY_UPDATE].p90);
+    TEST_ASSERT_EQUAL_UINT32(91324, healthCopy.heapLowWater);
+    TEST_ASSERT_EQUAL(4, healthCopy.maxConsecutiveErrors);
+    TEST_ASSERT_EQUAL(3, healthCopy.queueHighWater);
+    TEST_ASSERT_EQUAL_UINT32(1762300800, healthCopy.savedAt);
+}
+
+void test_fixed_point_clamps(void) {
+    TEST_ASSERT_EQUAL_UINT32(0, toFixedU32(-5.0f, 10));
+    TEST_ASSERT_EQUAL_UINT32(0, toFixedU32((float)NAN, 10));
+    TEST_ASSERT_EQUAL(0xFFFF, toFixedU16(100.0f, 1000));
+}
+
+void test_replay_in_append_order(void) {
+    TelemetryLog log(LOG_PATH, CURSOR_PATH);
+    TEST_ASSERT_TRUE(log.open());
+    for (uint32_t t = 1; t <= 5; t++) {
+        TEST_ASSERT_TRUE(appendMinute(log, t));
+    }
+
+    uint32_t epochs[8];
+    TEST_ASSERT_EQUAL(5, replayEpochs(log, epochs, 8));
+    for (uint32_t t = 1; t <= 5; t++) {
+        TEST_ASSERT_EQUAL_UINT32(t, epochs[t - 1]);
+    }
+}
+
+void test_cursor_survives_reboot(void) {
+    TelemetryLog log(LOG_PATH, CURSOR_PATH);
+    TEST_ASSERT_TRUE(log.open());
+    for (uint32_t t = 1; t <= 4; t++) {
+        appendMinute(log, t);
+    }
+
+    // Acknowledge the first two, then "reboot"
+    TelemetryFrame frames[2];
+    uint32_t offset = log.cursor();
+    TEST_ASSERT_EQUAL(2, log.read(offset, frames, 2));
+    TEST_ASSERT_TRUE(log.commit(offset));
+
+    TelemetryLog rebooted(LOG_PATH, CURSOR_PATH);
+    TEST_ASSERT_TRUE(rebooted.open());
+    uint32_t epochs[8];
+    TEST_ASSERT_EQUAL(2, replayEpochs(rebooted, epochs, 8));
+    TEST_ASSERT_EQUAL_UINT32(3, epochs[0]);
+    TEST_ASSERT_EQUAL_UINT32(4, epochs[1]);
+}
+
+void test_unacknowledged_records_replay_again(void) {
+    TelemetryLog log(LOG_PATH, CURSOR_PATH);
+    TEST_ASSERT_TRUE(log.open());
+    appendMinute(log, 1);
+    appendMinute(log, 2);
+
+    // Read but never committed (upload lost with the power)
+    TelemetryFrame frames[2];
+    uint32_t offset = log.cursor();
+    TEST_ASSERT_EQUAL(2, log.read(offset, frames, 2));
+
+    TelemetryLog rebooted(LOG_PATH, CURSOR_PATH);
+    TEST_ASSERT_TRUE(rebooted.open());
+    uint32_t epochs[8];
+    TEST_ASSERT_EQUAL(2, replayEpochs(rebooted, epochs, 8));
+    TEST_ASSERT_EQUAL_UINT32(1, epochs[0]);
+}
+
+void test_torn_tail_is_discarded(void) {
+    TelemetryLog log(LOG_PATH, CURSOR_PATH);
+    TEST_ASSERT_TRUE(log.open());
+    appendMinute(log, 1);
+    appendMinute(log, 2);
+    uint32_t goodSize = log.size();
+    appendMinute(log, 3);
+
+    // Power lost halfway through the third frame
+    TEST_ASSERT_EQUAL(0, truncate(LOG_PATH, goodSize + 7));
+
+    TelemetryLog rebooted(LOG_PATH, CURSOR_PATH);
+    TEST_ASSERT_TRUE(rebooted.open());
+    TEST_ASSERT_EQUAL_UINT32(goodSize, rebooted.size());
+    TEST_ASSERT_EQUAL_UINT32(7, rebooted.recoveredBytes());
+    TEST_ASSERT_EQUAL(goodSize, sizeOnDisk(LOG_PATH));
+
+    // New records go straight after the last good one
+    TEST_ASSERT_TRUE(appendMinute(rebooted, 4));
+    uint32_t epochs[8];
+    TEST_ASSERT_EQUAL(3, replayEpochs(rebooted, epochs, 8));
+    TEST_ASSERT_EQUAL_UINT32(1, epochs[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, epochs[1]);
+    TEST_ASSERT_EQUAL_UINT32(4, epochs[2]);
+}
+
+void test_corrupt_frame_fails_crc(void) {
+    TelemetryLog log(LOG_PATH, CURSOR_PATH);
+    TEST_ASSERT_TRUE(log.open());
+    appendMinute(log, 1);
+    uint32_t goodSize = log.size();
+    appendMinute(log, 2);
+
+    // Flip a payload bit in the last frame
+    FILE *file = fopen(LOG_PATH, "r+b");
+    fseek(file, goodSize + 5, SEEK_SET);
+    int byte = fgetc(file);
+    fseek(file, goodSize + 5, SEEK_SET);
+    fputc(byte ^ 0x10, file);
+    fclose(file);
+
+    TelemetryLog rebooted(LOG_PATH, CURSOR_PATH);
+    TEST_ASSERT_TRUE(rebooted.open());
+    TEST_ASSERT_EQUAL_UINT32(goodSize, rebooted.size());
+    uint32_t epochs[8];
+    TEST_ASSERT_EQUAL(1, replayEpochs(rebooted, epochs, 8));
+}
+
+void test_garbage_cursor_replays_everything(void) {
+    TelemetryLog log(LOG_PATH, CURSOR_PATH);
+    TEST_ASSERT_TRUE(log.open());
+    appendMinute(log, 1);
+    appendMinute(log, 2);
+
+    FILE *file = fopen(CURSOR_PATH, "wb");
+    fputs("junk!!!!", file);
+    fclose(file);
+
+    TelemetryLog rebooted(LOG_PATH, CURSOR_PATH);
+    TEST_ASSERT_TRUE(rebooted.open());
+    TEST_ASSERT_EQUAL_UINT32(0, rebooted.cursor());
+    uint32_t epochs[8];
+    TEST_ASSERT_EQUAL(2, replayEpochs(rebooted, epochs, 8));
+}
+
+void test_drained_log_is_compacted(void) {
+    TelemetryLog log(LOG_PATH, CURSOR_PATH);
+    TEST_ASSERT_TRUE(log.open());
+    appendMinute(log, 1);
+    appendMinute(log, 2);
+
+    TelemetryFrame frames[4];
+    uint32_t offset = log.cursor();
+    TEST_ASSERT_EQUAL(2, log.read(offset, frames, 4));
+    TEST_ASSERT_TRUE(log.commit(offset));
+
+    TEST_ASSERT_TRUE(log.empty());
+    TEST_ASSERT_EQUAL_UINT32(0, log.size());
+    TEST_ASSERT_EQUAL(0, sizeOnDisk(LOG_PATH));
+
+    // Power lost between the truncate and the cursor reset
+    TelemetryLog stale(LOG_PATH, CURSOR_PATH);
+    TEST_ASSERT_TRUE(stale.open());
+    appendMinute(stale, 3);
+    FILE *file = fopen(CURSOR_PATH, "wb");
+    uint8_t raw[8] = { 200, 0, 0, 0, 55, 255, 255, 255 };  // offset 200, valid check
+    fwrite(raw, 1, sizeof(raw), file);
+    fclose(file);
+
+    TelemetryLog rebooted(LOG_PATH, CURSOR_PATH);
+    TEST_ASSERT_TRUE(rebooted.open());
+    uint32_t epochs[4];
+    TEST_ASSERT_EQUAL(1, replayEpochs(rebooted, epochs, 4));
+    TEST_ASSERT_EQUAL_UINT32(3, epochs[0]);
+}
+
+void test_full_log_refuses_appends(void) {
+    const uint32_t frameSize = TelemetryLog::FRAME_OVERHEAD + MinuteRecord::ENCODED_SIZE;
+    TelemetryLog log(LOG_PATH, CURSOR_PATH, 3 * frameSize);
+    TEST_ASSERT_TRUE(log.open());
+    TEST_ASSERT_TRUE(appendMinute(log, 1));
+    TEST_ASSERT_TRUE(appendMinute(log, 2));
+    TEST_ASSERT_TRUE(appendMinute(log, 3));
+    TEST_ASSERT_FALSE(appendMinute(log, 4));
+    TEST_ASSERT_EQUAL_UINT32(3 * frameSize, log.size());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_records_round_trip);
+    RUN_TEST(test_fixed_point_clamps);
+    RUN_TEST(test_replay_in_append_order);
+    RUN_TEST(test_cursor_survives_reboot);
+    RUN_TEST(test_unacknowledged_records_replay_again);
+    RUN_TEST(test_torn_tail_is_discarded);
+    RUN_TEST(test_corrupt_frame_fails_crc);
+    RUN_TEST(test_garbage_cursor_replays_everything);
+    RUN_TEST(test_drained_log_is_compacted);
+    RUN_TEST(test_full_log_refuses_appends);
+
+    return UNITY_END();
+}
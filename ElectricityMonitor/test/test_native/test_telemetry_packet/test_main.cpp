@@ -0,0 +1,216 @@
+#include <unity.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <Base64.h>
+#include <TelemetryPacket.h>
+#include <TelemetryPaths.h>
+#include <TelemetryRecord.h>
+#include <UpdateBatch.h>
+
+static const uint32_t NOV_4_2025_1430 = 1762266600;
+
+static MinuteRecord minuteAt(uint32_t epoch) {
+    MinuteRecord record;
+    record.epoch = epoch;
+    record.energyUwh = 6133 + epoch % 7;
+    record.powerDw = 3680;
+    record.currentMa = 1712;
+    record.voltageDv = 2302;
+    record.flags = MINUTE_RELAY_ON;
+    return record;
+}
+
+static HourlyRecord hourAt(uint32_t epoch) {
+    HourlyRecord record;
+    record.date = 20251104;
+    record.hour = 14;
+    record.samples = 60;
+    record.energyMwh = 368012;
+    record.avgPowerDw = 3680;
+    record.peakPowerDw = 19320;
+    record.avgApparentDva = 4000;
+    record.avgCurrentMa = 1712;
+    record.powerFactorPermille = 920;
+    record.savedAt = epoch;
+    return record;
+}
+
+template <typename Record>
+static bool addRecord(TelemetryPacketWriter &packet, uint8_t type, const Record &record) {
+    uint8_t payload[TelemetryFrame::MAX_PAYLOAD];
+    uint8_t length = record.encode(payload);
+    return packet.add(type, payload, length);
+}
+
+void setUp(void) {
+    setenv("TZ", "UTC0", 1);
+    tzset();
+}
+
+void tearDown(void) {}
+
+// Minutes, an hour and its day rollup go in and come back field for field
+void test_records_round_trip(void) {
+    TelemetryPacketWriter packet;
+    for (uint32_t k = 0; k < 3; k++) {
+        TEST_ASSERT_TRUE(addRecord(packet, RECORD_MINUTE, minuteAt(NOV_4_2025_1430 + 60 * k)));
+    }
+    TEST_ASSERT_TRUE(addRecord(packet, RECORD_HOURLY, hourAt(NOV_4_2025_1430 + 1800)));
+    RollupRecord day;
+    day.kind = ROLLUP_DAY;
+    day.totals.period = 20251104;
+    day.totals.energyMws = 8123456789ull;
+    day.totals.samples = 870;
+    day.savedAt = NOV_4_2025_1430 + 1800;
+    TEST_ASSERT_TRUE(addRecord(packet, RECORD_ROLLUP, day));
+    // A new run of minutes, taken against zero again
+    TEST_ASSERT_TRUE(addRecord(packet, RECORD_MINUTE, minuteAt(NOV_4_2025_1430 + 180)));
+    TEST_ASSERT_EQUAL(6, packet.records());
+
+    char text[TelemetryPacketWriter::ENCODED_CAPACITY];
+    TEST_ASSERT_TRUE(packet.encode(text, sizeof(text)) > 0);
+
+    TelemetryFrame frames[8];
+    TEST_ASSERT_EQUAL(6, decodeTelemetryPacket(text, frames, 8));
+    for (uint32_t k = 0; k < 3; k++) {
+        MinuteRecord minute;
+        TEST_ASSERT_EQUAL(RECORD_MINUTE, frames[k].type);
+        TEST_ASSERT_TRUE(minute.decode(frames[k].payload, frames[k].length));
+        MinuteRecord expected = minuteAt(NOV_4_2025_1430 + 60 * k);
+        TEST_ASSERT_EQUAL_UINT32(expected.epoch, minute.epoch);
+        TEST_ASSERT_EQUAL_UINT32(expected.energyUwh, minute.energyUwh);
+        TEST_ASSERT_EQUAL_UINT32(expected.powerDw, minute.powerDw);
+        TEST_ASSERT_EQUAL(expected.currentMa, minute.currentMa);
+        TEST_ASSERT_EQUAL(expected.voltageDv, minute.voltageDv);
+        TEST_ASSERT_EQUAL(expected.flags, minute.flags);
+    }
+    HourlyRecord hour;
+    TEST_ASSERT_EQUAL(RECORD_HOURLY, frames[3].type);
+    TEST_ASSERT_TRUE(hour.decode(frames[3].payload, frames[3].length));
+    TEST_ASSERT_EQUAL_UINT32(368012, hour.energyMwh);
+    TEST_ASSERT_EQUAL_UINT32(19320, hour.peakPowerDw);
+    TEST_ASSERT_EQUAL(920, hour.powerFactorPermille);
+    TEST_ASSERT_EQUAL_UINT32(NOV_4_2025_1430 + 1800, hour.savedAt);
+    RollupRecord rollup;
+    TEST_ASSERT_EQUAL(RECORD_ROLLUP, frames[4].type);
+    TEST_ASSERT_TRUE(rollup.decode(frames[4].payload, frames[4].length));
+    TEST_ASSERT_EQUAL(ROLLUP_DAY, rollup.kind);
+    TEST_ASSERT_TRUE(rollup.totals.energyMws == 8123456789ull);
+    TEST_ASSERT_EQUAL_UINT32(870, rollup.totals.samples);
+    MinuteRecord after;
+    TEST_ASSERT_TRUE(after.decode(frames[5].payload, frames[5].length));
+    TEST_ASSERT_EQUAL_UINT32(NOV_4_2025_1430 + 180, after.epoch);
+    TEST_ASSERT_EQUAL_UINT32(minuteAt(NOV_4_2025_1430 + 180).energyUwh, after.energyUwh);
+}
+
+// A packet takes whole records up to CAPACITY and no further
+void test_full_packet_refuses_records(void) {
+    TelemetryPacketWriter packet;
+    uint32_t added = 0;
+    while (addRecord(packet, RECORD_MINUTE, minuteAt(NOV_4_2025_1430 + 60 * added))) {
+        added++;
+    }
+    TEST_ASSERT_TRUE(added > 60);
+    TEST_ASSERT_TRUE(packet.length() <= TelemetryPacketWriter::CAPACITY);
+    TEST_ASSERT_FALSE(packet.fits(RECORD_MINUTE, MinuteRecord::ENCODED_SIZE));
+
+    char text[TelemetryPacketWriter::ENCODED_CAPACITY];
+    TEST_ASSERT_TRUE(packet.encode(text, sizeof(text)) > 0);
+    static TelemetryFrame frames[256];
+    TEST_ASSERT_EQUAL(added, decodeTelemetryPacket(text, frames, 256));
+    MinuteRecord last;
+    TEST_ASSERT_TRUE(last.decode(frames[added - 1].payload, frames[added - 1].length));
+    TEST_ASSERT_EQUAL_UINT32(NOV_4_2025_1430 + 60 * (added - 1), last.epoch);
+
+    packet.clear();
+    TEST_ASSERT_TRUE(packet.empty());
+    TEST_ASSERT_EQUAL(1, packet.length());   // just the version
+}
+
+// Another version, a record cut short or bad base64 decode to nothing
+void test_malformed_packets_are_rejected(void) {
+    TelemetryPacketWriter packet;
+    addRecord(packet, RECORD_MINUTE, minuteAt(NOV_4_2025_1430));
+    addRecord(packet, RECORD_MINUTE, minuteAt(NOV_4_2025_1430 + 60));
+    uint8_t bytes[TelemetryPacketWriter::CAPACITY];
+    memcpy(bytes, packet.data(), packet.length());
+    char text[TelemetryPacketWriter::ENCODED_CAPACITY];
+    TelemetryFrame frames[4];
+
+    bytes[0] = TELEMETRY_PACKET_VERSION + 1;
+    base64Encode(bytes, packet.length(), text, sizeof(text));
+    TEST_ASSERT_EQUAL(0, decodeTelemetryPacket(text, frames, 4));
+
+    bytes[0] = TELEMETRY_PACKET_VERSION;
+    base64Encode(bytes, packet.length() - 1, text, sizeof(text));
+    TEST_ASSERT_EQUAL(0, decodeTelemetryPacket(text, frames, 4));
+
+    TelemetryPacketReader reader(bytes, packet.length() - 1);
+    TEST_ASSERT_TRUE(reader.valid());
+    TEST_ASSERT_TRUE(reader.next(frames[0]));
+    TEST_ASSERT_FALSE(reader.next(frames[1]));
+    TEST_ASSERT_TRUE(reader.malformed());
+
+    TEST_ASSERT_EQUAL(0, decodeTelemetryPacket("not base64!", frames, 4));
+    TEST_ASSERT_EQUAL(0, decodeTelemetryPacket("", frames, 4));
+}
+
+// 25 offline minutes and the hour closed in them: the fields the replay
+// would otherwise write (more than one batch holds) against one packed field
+void test_packet_is_a_tenth_of_the_fields(void) {
+    size_t json = 0;
+    UpdateBatch fields;
+    TelemetryPacketWriter packet;
+    char path[PATH_CHARS];
+    for (uint32_t k = 0; k < 25; k++) {
+        MinuteRecord record = minuteAt(NOV_4_2025_1430 + 60 * k);
+        minutePath(record.epoch, path, sizeof(path));
+        fields.clear();
+        fields.setPrefix(path);
+        fields.add("energy", record.energyKwh(), 6);
+        fields.add("power", record.powerDw / 10.0f, 1);
+        fields.add("current", record.currentMa / 1000.0f, 3);
+        fields.add("voltage", record.voltageDv / 10.0f, 1);
+        json += fields.length();
+        TEST_ASSERT_TRUE(addRecord(packet, RECORD_MINUTE, record));
+    }
+
+    HourlyRecord hour = hourAt(NOV_4_2025_1430 + 1800);
+    char savedAt[TIMESTAMP_CHARS];
+    formatTimestamp(hour.savedAt, savedAt, sizeof(savedAt));
+    hourlyPath(hour.date, hour.hour, path, sizeof(path));
+    UpdateBatch hourFields;
+    hourFields.setPrefix(path);
+    hourFields.add("energy", hour.energyKwh(), 6);
+    hourFields.add("avgPower", 368.0f, 2);
+    hourFields.add("peakPower", 1932.0f, 2);
+    hourFields.add("avgCurrent", 1.712f, 3);
+    hourFields.add("samples", (int32_t)hour.samples);
+    hourFields.add("avgApparentPower", 400.0f, 2);
+    hourFields.add("powerFactor", 0.92f, 3);
+    hourFields.add("phaseAngle", 23.1f, 1);
+    hourFields.add("savedAt", savedAt);
+    TEST_ASSERT_TRUE(addRecord(packet, RECORD_HOURLY, hour));
+
+    char text[TelemetryPacketWriter::ENCODED_CAPACITY];
+    packet.encode(text, sizeof(text));
+    UpdateBatch packed;
+    packedPath(NOV_4_2025_1430, path, sizeof(path));
+    packed.setPrefix(path);
+    packed.add("1762266600-0", text);
+
+    json += hourFields.length();
+    TEST_ASSERT_TRUE(packed.length() * 10 < json);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_records_round_trip);
+    RUN_TEST(test_full_packet_refuses_records);
+    RUN_TEST(test_malformed_packets_are_rejected);
+    RUN_TEST(test_packet_is_a_tenth_of_the_fields);
+
+    return UNITY_END();
+}
@@ -0,0 +1,151 @@
+#include <unity.h>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#include <TelemetryPaths.h>
+#include <TelemetryRecord.h>
+#include <UpdateBatch.h>
+
+// Count every C++ heap allocation the publish path makes
+static size_t heapAllocations = 0;
+
+void *operator new(size_t size) {
+    heapAllocations++;
+    void *p = malloc(size ? size : 1);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+// Bytes the C allocator has handed out and not got back, where we can ask
+static long heapInUse(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return (long)mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+const uint32_t NOV_4_2025_1430 = 1762266600;   // 2025-11-04 14:30:00 UTC
+
+UpdateBatch batch;
+
+void setUp(void) {
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    batch.clear();
+}
+
+void tearDown(void) {}
+
+void test_timestamps(void) {
+    char out[TIMESTAMP_CHARS];
+    TEST_ASSERT_EQUAL(19, formatTimestamp(NOV_4_2025_1430 + 45, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("2025-11-04 14:30:45", out);
+    TEST_ASSERT_EQUAL(0, formatTimestamp(0, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("", out);
+    TEST_ASSERT_EQUAL(0, formatTimestamp(NOV_4_2025_1430, out, 10));
+}
+
+void test_history_paths(void) {
+    char out[PATH_CHARS];
+    minutePath(NOV_4_2025_1430 + 60, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("history/minutes/2025-11-04/14/31/", out);
+    hourlyPath(20251104, 9, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("history/hourly/2025-11-04/9/", out);
+    packedPath(NOV_4_2025_1430, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("history/packed/2025-11-04/", out);
+    profilePath(20251104, 23, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("history/hourly/2025-11-04/23/profile/", out);
+    rollupPath(ROLLUP_DAY, 20251104, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("history/daily/2025-11-04/", out);
+    rollupPath(ROLLUP_MONTH, 202511, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("history/monthly/2025-11/", out);
+}
+
+void test_unit_paths(void) {
+    char out[64];
+    TEST_ASSERT_GREATER_THAN(0, unitPath("building_002", "unit_002", "", out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("/buildings/building_002/units/unit_002/", out);
+    unitPath("building_002", "unit_002", "remaining_units", out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("/buildings/building_002/units/unit_002/remaining_units", out);
+
+    // Too long is an empty path, never a truncated one
+    TEST_ASSERT_EQUAL(0, unitPath("building_002", "unit_002", "remaining_units", out, 20));
+    TEST_ASSERT_EQUAL_STRING("", out);
+
+    // A building's board: its path plus the unit's root is the unit's path
+    buildingPath("building_002", out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("/buildings/building_002/", out);
+    unitKeyRoot("unit_003", out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("units/unit_003/", out);
+}
+
+// One publish cycle as the firmware builds it: realtime fields, a replayed
+// minute, and at the top of the hour the hourly, profile and rollup nodes
+static void buildCycle(uint32_t epoch) {
+    char timestamp[TIMESTAMP_CHARS];
+    char path[PATH_CHARS];
+    batch.clear();
+    formatTimestamp(epoch, timestamp, sizeof(timestamp));
+    batch.add("power", 412.5f, 2);
+    batch.add("timestamp", timestamp);
+
+    minutePath(epoch - 60, path, sizeof(path));
+    batch.setPrefix(path);
+    batch.add("energy", 0.0069f, 6);
+    batch.add("power", 412.5f, 1);
+
+    if (epoch % 3600 == 0) {
+        uint32_t date = 20251104 + epoch / 86400 % 20;
+        hourlyPath(date, (uint8_t)(epoch / 3600 % 24), path, sizeof(path));
+        batch.setPrefix(path);
+        batch.add("energy", 0.41f, 6);
+        profilePath(date, (uint8_t)(epoch / 3600 % 24), path, sizeof(path));
+        batch.setPrefix(path);
+        batch.add("0", "AAECAwQF");
+        rollupPath(ROLLUP_DAY, date, path, sizeof(path));
+        batch.setPrefix(path);
+        batch.add("energy", 9.8f, 6);
+        rollupPath(ROLLUP_MONTH, date / 100, path, sizeof(path));
+        batch.setPrefix(path);
+        batch.add("energy", 301.2f, 6);
+    }
+    batch.setPrefix("");
+}
+
+void test_publish_cycles_never_touch_the_heap(void) {
+    // The first localtime_r may load zone data; that's a one-off
+    buildCycle(NOV_4_2025_1430);
+
+    size_t allocationsBefore = heapAllocations;
+    long inUseBefore = heapInUse();
+    for (uint32_t k = 1; k <= 20000; k++) {
+        buildCycle(NOV_4_2025_1430 + k * 60);
+        TEST_ASSERT_FALSE(batch.overflowed());
+    }
+    TEST_ASSERT_EQUAL(allocationsBefore, heapAllocations);
+    TEST_ASSERT_EQUAL(inUseBefore, heapInUse());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_timestamps);
+    RUN_TEST(test_history_paths);
+    RUN_TEST(test_unit_paths);
+    RUN_TEST(test_publish_cycles_never_touch_the_heap);
+
+    return UNITY_END();
+}
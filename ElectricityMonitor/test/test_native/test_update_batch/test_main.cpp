@@ -0,0 +1,108 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <UpdateBatch.h>
+
+UpdateBatch batch;
+
+void setUp(void) {
+    batch.clear();
+}
+
+void tearDown(void) {}
+
+void test_empty_batch_is_empty_object(void) {
+    TEST_ASSERT_TRUE(batch.empty());
+    TEST_ASSERT_EQUAL_STRING("{}", batch.json());
+}
+
+void test_realtime_fields(void) {
+    batch.add("power", 412.5f, 2);
+    batch.add("timestamp", "2025-11-04 14:30:45");
+    batch.add("samples", (int32_t)60);
+    TEST_ASSERT_EQUAL(3, batch.fieldCount());
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"power\":412.50,\"timestamp\":\"2025-11-04 14:30:45\",\"samples\":60}",
+        batch.json());
+}
+
+void test_prefixed_keys_stay_flat(void) {
+    // Slashes must stay inside the key so the update touches only these leaves
+    batch.add("power", 100.0f, 1);
+    batch.setPrefix("history/hourly/2025-11-04/10/");
+    batch.add("energy", 0.125f, 3);
+    batch.setPrefix("");
+    batch.add("remaining_units", 9.5f, 1);
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"power\":100.0,\"history/hourly/2025-11-04/10/energy\":0.125,\"remaining_units\":9.5}",
+        batch.json());
+}
+
+void test_strings_are_escaped(void) {
+    batch.add("note", "say \"hi\"\\");
+    TEST_ASSERT_EQUAL_STRING("{\"note\":\"say \\\"hi\\\"\\\\\"}", batch.json());
+}
+
+void test_increment_is_a_server_value(void) {
+    batch.add("power", 100.0f, 1);
+    batch.addIncrement("remaining_units", -0.0125f, 6);
+    TEST_ASSERT_EQUAL(2, batch.fieldCount());
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"power\":100.0,\"remaining_units\":{\".sv\":{\"increment\":-0.012500}}}",
+        batch.json());
+}
+
+void test_non_finite_values_become_zero(void) {
+    batch.add("power", (float)NAN, 1);
+    TEST_ASSERT_EQUAL_STRING("{\"power\":0.0}", batch.json());
+}
+
+void test_overflow_keeps_json_valid(void) {
+    char key[32];
+    for (int k = 0; k < 500; k++) {
+        snprintf(key, sizeof(key), "history/field_%d", k);
+        batch.add(key, 1.0f, 1);
+    }
+    TEST_ASSERT_TRUE(batch.overflowed());
+    TEST_ASSERT_LESS_THAN(UpdateBatch::CAPACITY, batch.length());
+    TEST_ASSERT_EQUAL('{', batch.json()[0]);
+    TEST_ASSERT_EQUAL('}', batch.json()[batch.length() - 1]);
+    TEST_ASSERT_EQUAL(strlen(batch.json()), batch.length());
+}
+
+void test_clear_resets_everything(void) {
+    batch.setPrefix("history/");
+    batch.add("x", (int32_t)1);
+    batch.clear();
+    batch.add("y", (int32_t)2);
+    TEST_ASSERT_EQUAL_STRING("{\"y\":2}", batch.json());
+    TEST_ASSERT_FALSE(batch.overflowed());
+}
+
+void test_root_goes_ahead_of_the_prefix_and_survives_clear(void) {
+    batch.setRoot("units/unit_003/");
+    batch.add("power", 100.0f, 1);
+    batch.clear();
+    batch.setPrefix("history/hourly/2025-11-04/10/");
+    batch.add("energy", 0.125f, 3);
+    TEST_ASSERT_EQUAL(15, batch.rootLength());
+    TEST_ASSERT_EQUAL_STRING("{\"units/unit_003/history/hourly/2025-11-04/10/energy\":0.125}", batch.json());
+    batch.setRoot("");
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_empty_batch_is_empty_object);
+    RUN_TEST(test_realtime_fields);
+    RUN_TEST(test_prefixed_keys_stay_flat);
+    RUN_TEST(test_strings_are_escaped);
+    RUN_TEST(test_increment_is_a_server_value);
+    RUN_TEST(test_non_finite_values_become_zero);
+    RUN_TEST(test_overflow_keeps_json_valid);
+    RUN_TEST(test_clear_resets_everything);
+    RUN_TEST(test_root_goes_ahead_of_the_prefix_and_survives_clear);
+
+    return UNITY_END();
+}